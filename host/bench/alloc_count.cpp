@@ -0,0 +1,114 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+
+#include "alloc_count.h"
+
+static std::atomic<uint64_t> s_allocs{0};
+static std::atomic<uint64_t> s_frees{0};
+static std::atomic<uint64_t> s_bytes{0};
+
+static inline void count_alloc(void *ptr, size_t size)
+{
+    if (ptr) {
+        s_allocs.fetch_add(1, std::memory_order_relaxed);
+        s_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+static inline void count_free(void *ptr)
+{
+    if (ptr) {
+        s_frees.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void alloc_count_get(alloc_count_t *count)
+{
+    count->allocs = s_allocs.load(std::memory_order_relaxed);
+    count->frees = s_frees.load(std::memory_order_relaxed);
+    count->bytes = s_bytes.load(std::memory_order_relaxed);
+}
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size)
+{
+    void *ptr = __real_malloc(size);
+    count_alloc(ptr, size);
+    return ptr;
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+    void *ptr = __real_calloc(nmemb, size);
+    count_alloc(ptr, nmemb * size);
+    return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    void *out = __real_realloc(ptr, size);
+    count_alloc(out, size);
+    if (out && ptr) {
+        count_free(ptr);
+    }
+    return out;
+}
+
+void __wrap_free(void *ptr)
+{
+    count_free(ptr);
+    __real_free(ptr);
+}
+}
+
+void *operator new(size_t size)
+{
+    void *ptr = __real_malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    count_alloc(ptr, size);
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    count_free(ptr);
+    __real_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete(void *ptr, size_t size) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void *ptr, size_t size) noexcept
+{
+    operator delete(ptr);
+}
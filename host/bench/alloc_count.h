@@ -0,0 +1,25 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Heap allocation counters for the benchmark. operator new/delete are replaced and
+ * malloc/calloc/realloc/free are wrapped at link time (-Wl,--wrap), so every allocation
+ * made by the driver layer, the stand-ins and the C++ runtime on their behalf is counted.
+ */
+
+typedef struct {
+    uint64_t allocs; /* successful allocations, realloc included */
+    uint64_t frees;
+    uint64_t bytes;  /* bytes requested */
+} alloc_count_t;
+
+void alloc_count_get(alloc_count_t *count);
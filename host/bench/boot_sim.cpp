@@ -0,0 +1,409 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Simulation of the startup sequence on the host.
+ *
+ *     boot_sim [-v] [-t step_us] [-p phase=us]...
+ *
+ * Replays the app_main() sequence against the host stand-ins, with every phase taking a
+ * modelled time on the simulation clock, while the door contact changes level at some point
+ * of the boot. The edge time is swept over the whole boot in `step_us` steps, once with the
+ * door closing and once opening. Each boot runs in a forked child, so the driver state
+ * starts from reset every time.
+ *
+ * Two orders are compared:
+ *     legacy  contact inputs created with the other drivers, endpoints start from the
+ *             cluster default (the order before the early latch)
+ *     fast    contact inputs latched first, endpoints seeded with the latched level (app_main)
+ *
+ * For each order: how many transitions reached the event log, how many boots had the wrong
+ * StateValue in the data model when esp_matter::start() returned, how long the data model
+ * was wrong and how long after the edge it settled on the right level.
+ *
+ * Phase durations default to a commissioned ESP32-C6 Thread node; measure a board with
+ * `matter esp sensor boot` and pass them with -p, e.g. -p matter-start=240000.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <esp_log.h>
+#include <esp_matter.h>
+#include <esp_timer.h>
+
+#include <app_priv.h>
+#include "boot_trace.h"
+#include "host_sim.h"
+
+using namespace chip::app::Clusters;
+using namespace esp_matter;
+
+/* Defined by app_main.cpp on target */
+uint16_t light_endpoint_id = 0;
+uint16_t contact_endpoint_ids[APP_CONTACT_MAX_CHANNEL_COUNT];
+
+/* Time each phase takes on the simulation clock, indexed by boot_phase_t. The first report
+ * is the Matter event loop latency to the first work item. */
+static int64_t s_phase_us[BOOT_PHASE_MAX] = {
+    30000,  /* startup */
+    400,    /* contact-latch */
+    12000,  /* nvs */
+    45000,  /* drivers */
+    25000,  /* node-create */
+    180000, /* matter-start */
+    2000,   /* first-report */
+    900000, /* network-attach */
+};
+
+typedef enum {
+    BOOT_ORDER_LEGACY = 0,
+    BOOT_ORDER_FAST,
+    BOOT_ORDER_MAX,
+} boot_order_t;
+
+static const char *const k_order_names[BOOT_ORDER_MAX] = { "legacy", "fast" };
+
+/* Result of one boot, written by the child to the parent */
+typedef struct {
+    bool logged;           /* the transition reached the event log */
+    bool right_at_start;   /* StateValue matched the door when esp_matter::start() returned */
+    int64_t wrong_us;      /* time the data model disagreed with the door, from node create */
+    int64_t settle_us;     /* edge (or node create, if later) -> data model right for good */
+    int64_t ends_us[BOOT_PHASE_MAX];
+} boot_result_t;
+
+/* State of one simulated boot */
+typedef struct {
+    int64_t edge_us;
+    bool closed_after;      /* door level after the edge */
+    bool edge_done;
+    bool matter_running;    /* the Matter thread runs queued work */
+    bool model_exists;
+    bool model_right;
+    int64_t checked_us;     /* last time model_right was evaluated */
+    int64_t right_since_us; /* start of the current stretch of model_right */
+    int64_t node_create_us;
+    boot_result_t result;
+} boot_sim_t;
+
+/* Same as app_attribute_update_cb() in app_main.cpp */
+static esp_err_t sim_attribute_update_cb(attribute::callback_type_t type, uint16_t endpoint_id, uint32_t cluster_id,
+                                         uint32_t attribute_id, esp_matter_attr_val_t *val, void *priv_data)
+{
+    if (type == attribute::PRE_UPDATE) {
+        return app_driver_attribute_update((app_driver_handle_t)priv_data, endpoint_id, cluster_id, attribute_id, val);
+    }
+    return ESP_OK;
+}
+
+static bool sim_door_level(const boot_sim_t *sim)
+{
+    return sim->edge_done ? sim->closed_after : !sim->closed_after;
+}
+
+static bool sim_model_level()
+{
+    endpoint_t *endpoint = endpoint::get(node::get(), contact_endpoint_ids[APP_CONTACT_DOOR]);
+    attribute_t *attribute = attribute::get(cluster::get(endpoint, BooleanState::Id),
+                                            BooleanState::Attributes::StateValue::Id);
+    esp_matter_attr_val_t val = esp_matter_invalid(NULL);
+    attribute::get_val(attribute, &val);
+    return val.val.b;
+}
+
+/* Account the time since the last check, then look at the data model again */
+static void sim_check_model(boot_sim_t *sim)
+{
+    int64_t now = esp_timer_get_time();
+    if (sim->model_exists && !sim->model_right) {
+        sim->result.wrong_us += now - sim->checked_us;
+    }
+    sim->checked_us = now;
+    if (!sim->model_exists) {
+        return;
+    }
+    bool right = sim_model_level() == sim_door_level(sim);
+    if (right && !sim->model_right) {
+        sim->right_since_us = now;
+    }
+    sim->model_right = right;
+}
+
+/* Run the door edge, debounce timers and Matter turns up to `target_us`, then move the clock there */
+static void sim_advance(boot_sim_t *sim, int64_t target_us)
+{
+    while (true) {
+        int64_t next = std::min(host_contact_next_deadline(), host_timer_next_deadline(false));
+        if (!sim->edge_done) {
+            next = std::min(next, sim->edge_us);
+        }
+        if (next > target_us) {
+            break;
+        }
+        if (next > esp_timer_get_time()) {
+            sim_check_model(sim);
+            latency_fake_clock_set(next);
+        }
+        if (!sim->edge_done && sim->edge_us <= esp_timer_get_time()) {
+            sim->edge_done = true;
+            host_contact_set_input(APP_CONTACT_DOOR, sim->closed_after);
+        }
+        host_contact_run_timers();
+        host_timer_run();
+        if (sim->matter_running) {
+            host_platform_run_work();
+        }
+        sim_check_model(sim);
+    }
+    if (target_us > esp_timer_get_time()) {
+        sim_check_model(sim);
+        latency_fake_clock_set(target_us);
+    }
+    sim_check_model(sim);
+}
+
+/* Let a phase take its time, then mark its end as app_main() does */
+static void sim_phase(boot_sim_t *sim, boot_phase_t phase)
+{
+    sim_advance(sim, esp_timer_get_time() + s_phase_us[phase]);
+    boot_trace_mark(phase, esp_timer_get_time());
+}
+
+static void sim_create_endpoints(boot_sim_t *sim, boot_order_t order, app_driver_handle_t light_handle)
+{
+    host_matter_init(sim_attribute_update_cb);
+    light_endpoint_id = host_matter_create_light(light_handle);
+    for (uint16_t i = 0; i < APP_CONTACT_CHANNEL_COUNT; i++) {
+        /* The legacy order left the cluster default in place */
+        bool state_value = order == BOOT_ORDER_FAST ? app_driver_contact_get_closed(i) : false;
+        contact_endpoint_ids[i] = host_matter_create_contact(state_value);
+    }
+    sim->node_create_us = esp_timer_get_time();
+    sim->checked_us = sim->node_create_us;
+    sim->right_since_us = sim->node_create_us;
+    sim->model_exists = true;
+    sim->model_right = sim_model_level() == sim_door_level(sim);
+}
+
+/* app_main() in either order, then the background network attach */
+static void sim_boot(boot_sim_t *sim, boot_order_t order)
+{
+    latency_fake_clock_set(0);
+    host_contact_set_input(APP_CONTACT_DOOR, !sim->closed_after);
+
+    sim_phase(sim, BOOT_PHASE_STARTUP);
+    if (order == BOOT_ORDER_FAST) {
+        ESP_ERROR_CHECK(app_driver_contact_init());
+        sim_phase(sim, BOOT_PHASE_CONTACT_LATCH);
+    }
+    sim_phase(sim, BOOT_PHASE_NVS);
+
+    app_driver_handle_t light_handle = app_driver_light_init();
+    app_driver_button_init();
+    if (order == BOOT_ORDER_LEGACY) {
+        /* The other drivers come first, the inputs are latched at the end of the phase */
+        sim_advance(sim, esp_timer_get_time() + s_phase_us[BOOT_PHASE_DRIVERS]);
+        ESP_ERROR_CHECK(app_driver_contact_init());
+        sim_phase(sim, BOOT_PHASE_CONTACT_LATCH);
+        boot_trace_mark(BOOT_PHASE_DRIVERS, esp_timer_get_time());
+    } else {
+        sim_phase(sim, BOOT_PHASE_DRIVERS);
+    }
+
+    /* The data model is built from the state at the start of the phase */
+    sim_create_endpoints(sim, order, light_handle);
+    sim_phase(sim, BOOT_PHASE_NODE_CREATE);
+    sim_phase(sim, BOOT_PHASE_MATTER_START);
+    sim->result.right_at_start = sim->model_right;
+
+    app_driver_contact_start_reporting();
+    ESP_ERROR_CHECK(app_driver_attribute_cache_init());
+    app_driver_light_set_defaults(light_endpoint_id);
+    /* The first work item runs one event loop latency later, and marks the first report */
+    sim_advance(sim, esp_timer_get_time() + s_phase_us[BOOT_PHASE_FIRST_REPORT]);
+    sim->matter_running = true;
+    host_platform_run_work();
+    sim_check_model(sim);
+
+    /* The attach runs in the background from esp_matter::start(); the sweep ends before it
+     * does, so every edge has settled by then */
+    sim_advance(sim, boot_trace_end(BOOT_PHASE_MATTER_START) + s_phase_us[BOOT_PHASE_NETWORK_ATTACH]);
+    boot_trace_mark(BOOT_PHASE_NETWORK_ATTACH, esp_timer_get_time());
+
+    host_app_stats_t app;
+    host_app_get_stats(&app);
+    sim->result.logged = app.evlog_records > 0;
+    sim->result.settle_us = sim->right_since_us - std::max(sim->edge_us, sim->node_create_us);
+    for (int phase = 0; phase < BOOT_PHASE_MAX; phase++) {
+        sim->result.ends_us[phase] = boot_trace_end((boot_phase_t)phase);
+    }
+}
+
+/* Boot in a child process, so every boot starts from the reset state of the driver */
+static bool sim_boot_forked(boot_order_t order, int64_t edge_us, bool closed_after, boot_result_t *result)
+{
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return false;
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        static boot_sim_t sim;
+        sim.edge_us = edge_us;
+        sim.closed_after = closed_after;
+        sim_boot(&sim, order);
+        ssize_t written = write(fds[1], &sim.result, sizeof(sim.result));
+        _exit(written == (ssize_t)sizeof(sim.result) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], result, sizeof(*result));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return got == (ssize_t)sizeof(*result) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static int64_t percentile(std::vector<int64_t> *values, uint32_t percent)
+{
+    if (values->empty()) {
+        return 0;
+    }
+    std::sort(values->begin(), values->end());
+    return (*values)[(values->size() - 1) * percent / 100];
+}
+
+static void print_phases(const boot_result_t *result)
+{
+    printf("== boot phases, fast order (simulation time)\n");
+    printf("  %-16s %10s %10s %10s\n", "phase (us)", "start", "duration", "end");
+    for (int phase = 0; phase < BOOT_PHASE_MAX; phase++) {
+        int64_t start = phase == 0 ? 0 : result->ends_us[phase - 1];
+        if (phase == BOOT_PHASE_NETWORK_ATTACH) {
+            start = result->ends_us[BOOT_PHASE_MATTER_START];
+        }
+        printf("  %-16s %10" PRId64 " %10" PRId64 " %10" PRId64 "\n", boot_trace_phase_name((boot_phase_t)phase),
+               start, result->ends_us[phase] - start, result->ends_us[phase]);
+    }
+}
+
+static int sim_sweep(int64_t step_us)
+{
+    boot_result_t reference;
+    if (!sim_boot_forked(BOOT_ORDER_FAST, INT64_MAX / 2, true, &reference)) {
+        fprintf(stderr, "boot failed\n");
+        return 1;
+    }
+    print_phases(&reference);
+
+    int64_t window_us = reference.ends_us[BOOT_PHASE_FIRST_REPORT] + step_us;
+    printf("== door edge during boot, every %" PRId64 " us from 0 to %" PRId64 " us\n", step_us, window_us);
+    printf("  %-7s %-7s %6s %8s %14s %12s %12s %12s\n", "order", "door", "boots", "logged", "wrong at start",
+           "wrong max", "settle p50", "settle max");
+    for (int order = 0; order < BOOT_ORDER_MAX; order++) {
+        for (bool closed_after : { true, false }) {
+            uint32_t boots = 0;
+            uint32_t logged = 0;
+            uint32_t wrong_at_start = 0;
+            int64_t wrong_max = 0;
+            std::vector<int64_t> settle;
+            for (int64_t edge_us = 0; edge_us <= window_us; edge_us += step_us) {
+                boot_result_t result;
+                if (!sim_boot_forked((boot_order_t)order, edge_us, closed_after, &result)) {
+                    fprintf(stderr, "boot with an edge at %" PRId64 " us failed\n", edge_us);
+                    return 1;
+                }
+                boots++;
+                logged += result.logged;
+                wrong_at_start += !result.right_at_start;
+                wrong_max = std::max(wrong_max, result.wrong_us);
+                settle.push_back(result.settle_us);
+            }
+            int64_t settle_max = percentile(&settle, 100);
+            printf("  %-7s %-7s %6" PRIu32 " %8" PRIu32 " %14" PRIu32 " %12" PRId64 " %12" PRId64 " %12" PRId64 "\n",
+                   k_order_names[order], closed_after ? "closes" : "opens", boots, logged, wrong_at_start,
+                   wrong_max, percentile(&settle, 50), settle_max);
+        }
+    }
+    printf("  (us; settle: edge, or node create if later, -> data model right for good)\n");
+    return 0;
+}
+
+static bool parse_phase(const char *arg)
+{
+    const char *eq = strchr(arg, '=');
+    if (!eq) {
+        return false;
+    }
+    for (int phase = 0; phase < BOOT_PHASE_MAX; phase++) {
+        const char *name = boot_trace_phase_name((boot_phase_t)phase);
+        if (strlen(name) == (size_t)(eq - arg) && strncmp(name, arg, eq - arg) == 0) {
+            s_phase_us[phase] = strtoll(eq + 1, NULL, 10);
+            return s_phase_us[phase] >= 0;
+        }
+    }
+    return false;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "Usage: %s [-v] [-t step_us] [-p phase=us]...\n", argv0);
+    fprintf(stderr, "  -t us     step of the edge time sweep (default 2000)\n");
+    fprintf(stderr, "  -p p=us   duration of a phase:");
+    for (int phase = 0; phase < BOOT_PHASE_MAX; phase++) {
+        fprintf(stderr, " %s", boot_trace_phase_name((boot_phase_t)phase));
+    }
+    fprintf(stderr, "\n  -v        print the driver logs\n");
+}
+
+int main(int argc, char **argv)
+{
+    int64_t step_us = 2000;
+    host_log_level = ESP_LOG_NONE;
+    int opt;
+    while ((opt = getopt(argc, argv, "vt:p:h")) != -1) {
+        switch (opt) {
+        case 'v':
+            host_log_level = ESP_LOG_INFO;
+            break;
+        case 't':
+            step_us = strtoll(optarg, NULL, 10);
+            break;
+        case 'p':
+            if (!parse_phase(optarg)) {
+                fprintf(stderr, "invalid phase duration: %s\n", optarg);
+                return 2;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc || step_us <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    return sim_sweep(step_us);
+}
@@ -0,0 +1,690 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Benchmark of the driver layer on the host.
+ *
+ *     driver_bench[_fleet] [-v] [-c] [-m matter_period_us] [-n fleet_inputs] [-s seed] [-l led_ns]
+ *                          [-p min_ms,holdoff_ms,max_reports,window_s] [-b hop_us] [scenario | trace file]...
+ *
+ * Scenarios: burst, chatter, fleet, light, transition, binding, storm (all of them by default). Any other argument is
+ * loaded as a recorded edge trace (see edge_trace.h, e.g. host/traces/reed_switch.trace).
+ * driver_bench has the firmware contact channels, driver_bench_fleet adds 4096 synthetic
+ * inputs for the fleet scenario.
+ *
+ * Edge traces are replayed through the real app_driver.cpp contact path: debounce, event
+ * ring, drain and attribute::update() on the Matter work queue. The simulation clock
+ * jumps from event to event, so a replay runs as fast as the host allows; events/sec and
+ * call latencies are wall clock, edge-to-report latencies are simulation time. The report
+ * policy starts from the firmware defaults; `-p 0,0,0,1` turns it off to measure every
+ * debounced transition through to attribute::update().
+ *
+ * The binding scenario binds the door channel to stand-in lights on the same node, one by
+ * unicast and two through a group, and checks they follow the door; edge->command and
+ * edge->response are the direct binding latencies, the latter with a modelled one-way hop
+ * delay to the lights (`-b`, 10 ms by default).
+ *
+ * With `-c` a wrong result makes the exit status 1, for CTest: transitions dropped, Matter
+ * work rejected, bound lights out of step with the door, and with `-p 0,0,0,1 -m 0` a
+ * debounced transition that did not reach attribute::update().
+ *
+ * The storm scenario runs the `sensor storm` load generator of the firmware (app_storm.cpp)
+ * at rising rates, steady and in bursts; `-m 1000 -p 0,0,0,1 storm` shows where the drain
+ * saturates. Free heap is not modelled on the host: the allocation column stands for it.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <esp_log.h>
+#include <esp_matter.h>
+#include <esp_timer.h>
+
+#include <app_priv.h>
+#include "alloc_count.h"
+#include "edge_trace.h"
+#include "host_sim.h"
+#include "latency_trace.h"
+#include "storm_gen.h"
+
+using namespace chip::app::Clusters;
+using namespace esp_matter;
+
+static const char *TAG = "driver_bench";
+
+/* Defined by app_main.cpp on target */
+uint16_t light_endpoint_id = 0;
+uint16_t contact_endpoint_ids[APP_CONTACT_MAX_CHANNEL_COUNT];
+
+typedef struct {
+    int64_t matter_period_us; /* 0: the Matter thread runs right after every timer expiry */
+    uint32_t led_cost_ns;     /* modelled cost of one LED driver write */
+    uint16_t fleet_inputs;
+    uint32_t seed;
+    const char *policy;       /* report policy of every channel, NULL for the defaults */
+    uint32_t hop_us;          /* one-way delay to the bound devices of the binding scenario */
+    bool check;               /* fail on a wrong result, see bench_fail() */
+    bool policy_off;          /* every transition reported on its own */
+} bench_options_t;
+
+typedef struct {
+    app_contact_queue_stats_t queue;
+    host_matter_stats_t matter;
+    host_work_stats_t work;
+    host_app_stats_t app;
+    host_led_state_t led;
+    alloc_count_t alloc;
+    uint32_t suppressed; /* report policy, all channels */
+    uint32_t contact_reports;
+} bench_counters_t;
+
+static bool s_failed = false;
+
+/* A result no configuration should give: with `-c` the exit status is 1 */
+static void bench_fail(const bench_options_t *options, const char *scenario, const char *what)
+{
+    if (options->check) {
+        printf("  FAILED %s: %s\n", scenario, what);
+        s_failed = true;
+    }
+}
+
+static const char *const k_sample_names[HOST_SAMPLE_MAX] = {
+    "contact cb",
+    "matter work",
+    "attribute cb",
+    "led",
+};
+
+/* Same as app_attribute_update_cb() in app_main.cpp */
+static esp_err_t bench_attribute_update_cb(attribute::callback_type_t type, uint16_t endpoint_id, uint32_t cluster_id,
+                                           uint32_t attribute_id, esp_matter_attr_val_t *val, void *priv_data)
+{
+    esp_err_t err = ESP_OK;
+
+    if (type == attribute::PRE_UPDATE) {
+        /* Driver update */
+        app_driver_handle_t driver_handle = (app_driver_handle_t)priv_data;
+        err = app_driver_attribute_update(driver_handle, endpoint_id, cluster_id, attribute_id, val);
+    }
+
+    return err;
+}
+
+/* Same order as app_main() */
+static void bench_app_init()
+{
+    latency_fake_clock_set(0);
+
+    app_driver_handle_t light_handle = app_driver_light_init();
+    app_driver_button_init();
+    ESP_ERROR_CHECK(app_driver_contact_init());
+#if HOST_FLEET
+    /* Room for a saved policy per fleet input */
+    host_nvs_reset(0x100000);
+#endif
+    ESP_ERROR_CHECK(app_persist_init());
+    app_driver_contact_restore_policies();
+
+    host_matter_init(bench_attribute_update_cb);
+    ESP_ERROR_CHECK(app_binding_init());
+    light_endpoint_id = host_matter_create_light(light_handle);
+    for (uint16_t i = 0; i < APP_CONTACT_CHANNEL_COUNT; i++) {
+        contact_endpoint_ids[i] = host_matter_create_contact(app_driver_contact_get_closed(i));
+    }
+
+    ESP_ERROR_CHECK(app_driver_attribute_cache_init());
+    app_driver_light_set_defaults(light_endpoint_id);
+    app_driver_contact_start_reporting();
+    host_platform_run_work();
+}
+
+static void bench_counters_get(bench_counters_t *counters)
+{
+    app_driver_contact_get_queue_stats(&counters->queue);
+    host_matter_get_stats(&counters->matter);
+    host_platform_get_stats(&counters->work);
+    host_app_get_stats(&counters->app);
+    host_led_get_state(&counters->led);
+    alloc_count_get(&counters->alloc);
+    counters->suppressed = 0;
+    counters->contact_reports = 0;
+    for (uint16_t i = 0; i < app_driver_contact_channel_count(); i++) {
+        app_contact_policy_t policy;
+        app_driver_contact_get_policy(i, &policy);
+        counters->suppressed += policy.suppressed;
+        counters->contact_reports += policy.reports;
+    }
+}
+
+static void bench_matter_turn(const bench_options_t *options, int64_t *next_turn_us)
+{
+    if (options->matter_period_us == 0) {
+        host_platform_run_work();
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    if (now >= *next_turn_us) {
+        host_platform_run_work();
+        *next_turn_us += ((now - *next_turn_us) / options->matter_period_us + 1) * options->matter_period_us;
+    }
+}
+
+/* Run every timer expiry and Matter turn up to `target_us`, then move the clock there */
+static void bench_advance(int64_t target_us, const bench_options_t *options, int64_t *next_turn_us)
+{
+    while (true) {
+        int64_t next = std::min(host_contact_next_deadline(), host_timer_next_deadline(true));
+        if (options->matter_period_us > 0 && *next_turn_us < next) {
+            next = *next_turn_us;
+        }
+        if (next > target_us) {
+            break;
+        }
+        if (next > esp_timer_get_time()) {
+            latency_fake_clock_set(next);
+        }
+        host_contact_run_timers();
+        host_timer_run();
+        bench_matter_turn(options, next_turn_us);
+    }
+    if (target_us > esp_timer_get_time()) {
+        latency_fake_clock_set(target_us);
+    }
+}
+
+/* Let every armed one-shot timer expire and the Matter thread catch up */
+static void bench_settle(const bench_options_t *options, int64_t *next_turn_us)
+{
+    while (true) {
+        int64_t next = std::min(host_contact_next_deadline(), host_timer_next_deadline(false));
+        if (next == INT64_MAX) {
+            break;
+        }
+        bench_advance(next, options, next_turn_us);
+        host_platform_run_work();
+    }
+    host_platform_run_work();
+}
+
+static void bench_print_samples()
+{
+    printf("  %-14s %9s %9s %9s %9s %9s %9s  (ns)\n", "call", "count", "p50", "p90", "p99", "p99.9", "max");
+    for (int kind = 0; kind < HOST_SAMPLE_MAX; kind++) {
+        host_samples_t *samples = host_samples((host_sample_kind_t)kind);
+        if (samples->count == 0) {
+            continue;
+        }
+        std::sort(samples->ns, samples->ns + samples->count);
+        auto at = [samples](uint32_t permille) { return samples->ns[(samples->count - 1) * permille / 1000]; };
+        printf("  %-14s %9zu %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 "%s\n",
+               k_sample_names[kind], samples->count, at(500), at(900), at(990), at(999), at(1000),
+               samples->overflow ? " (buffer overflow)" : "");
+    }
+}
+
+static void bench_print_spans()
+{
+    printf("  %-16s %9s %9s %9s %9s  (us, simulation time)\n", "span", "count", "p50", "p99", "max");
+    for (int span = 0; span < TRACE_SPAN_MAX; span++) {
+        latency_hist_snapshot_t snapshot;
+        latency_trace_snapshot((trace_span_t)span, &snapshot);
+        if (snapshot.count == 0) {
+            continue;
+        }
+        printf("  %-16s %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 "\n",
+               latency_trace_span_name((trace_span_t)span), snapshot.count,
+               latency_trace_percentile(&snapshot, 50), latency_trace_percentile(&snapshot, 99), snapshot.max_us);
+    }
+}
+
+static void bench_print_allocs(const bench_counters_t *before, const bench_counters_t *after, uint64_t events,
+                               const char *unit)
+{
+    uint64_t allocs = after->alloc.allocs - before->alloc.allocs;
+    printf("  allocations %" PRIu64 " (%.3f per %s), %" PRIu64 " bytes\n", allocs,
+           events ? (double)allocs / events : 0.0, unit, after->alloc.bytes - before->alloc.bytes);
+}
+
+static void bench_replay(const char *name, const edge_trace_t &trace, const bench_options_t *options)
+{
+    uint16_t inputs = 0;
+    for (const edge_t &edge : trace) {
+        if (edge.channel >= APP_CONTACT_CHANNEL_COUNT) {
+            ESP_LOGE(TAG, "%s: channel %u out of range, %u inputs available", name, edge.channel,
+                     (unsigned)APP_CONTACT_CHANNEL_COUNT);
+            return;
+        }
+        inputs = std::max<uint16_t>(inputs, edge.channel + 1);
+    }
+
+    /* Start from quiet inputs, each at the opposite of its first traced level */
+    static bool s_initial[APP_CONTACT_CHANNEL_COUNT];
+    static bool s_seen[APP_CONTACT_CHANNEL_COUNT];
+    memset(s_seen, 0, sizeof(s_seen));
+    for (const edge_t &edge : trace) {
+        if (!s_seen[edge.channel]) {
+            s_seen[edge.channel] = true;
+            s_initial[edge.channel] = !edge.closed;
+        }
+    }
+    int64_t next_turn_us = esp_timer_get_time();
+    for (uint16_t channel = 0; channel < APP_CONTACT_CHANNEL_COUNT; channel++) {
+        host_contact_set_input(channel, s_seen[channel] ? s_initial[channel] : false);
+    }
+    bench_settle(options, &next_turn_us);
+    host_samples_reserve(trace.size() * 2 + 1024);
+    latency_trace_reset();
+
+    int64_t base_us = esp_timer_get_time() + 1000000 - (trace.empty() ? 0 : trace.front().time_us);
+    next_turn_us = esp_timer_get_time();
+    bench_counters_t before;
+    bench_counters_get(&before);
+    uint64_t start_ns = host_wall_ns();
+
+    for (const edge_t &edge : trace) {
+        bench_advance(base_us + edge.time_us, options, &next_turn_us);
+        host_contact_set_input(edge.channel, edge.closed);
+    }
+    bench_settle(options, &next_turn_us);
+
+    uint64_t wall_ns = host_wall_ns() - start_ns;
+    bench_counters_t after;
+    bench_counters_get(&after);
+
+    uint32_t reports = after.matter.updates - before.matter.updates;
+    double wall_s = wall_ns / 1e9;
+    printf("== %s: %u inputs, %zu edges, matter turn %s", name, inputs, trace.size(),
+           options->matter_period_us ? "" : "after every expiry\n");
+    if (options->matter_period_us) {
+        printf("every %" PRId64 " us\n", options->matter_period_us);
+    }
+    printf("  wall %.3f ms, %.0f edges/s, %" PRIu32 " reports (%.0f reports/s)\n", wall_ns / 1e6,
+           trace.size() / wall_s, reports, reports / wall_s);
+    printf("  debounced %" PRIu32 ", dropped %" PRIu32 ", coalesced %" PRIu32 ", drains %" PRIu32
+           ", queue high-water %" PRIu32 ", work rejected %" PRIu32 ", policy suppressed %" PRIu32 "\n",
+           after.app.contact_edges - before.app.contact_edges, after.queue.dropped - before.queue.dropped,
+           after.queue.coalesced - before.queue.coalesced, after.queue.batches - before.queue.batches,
+           after.queue.high_water, after.work.rejected - before.work.rejected, after.suppressed - before.suppressed);
+    printf("  log records %" PRIu32 " (%.2f per report)\n", after.app.log_records - before.app.log_records,
+           reports ? (double)(after.app.log_records - before.app.log_records) / reports : 0.0);
+    bench_print_allocs(&before, &after, trace.size(), "edge");
+    bench_print_samples();
+    bench_print_spans();
+
+    if (after.queue.dropped != before.queue.dropped || after.work.rejected != before.work.rejected) {
+        bench_fail(options, name, "transitions dropped or Matter work rejected");
+    }
+    /* The Matter thread runs after every expiry: nothing to merge, every change reported */
+    if (options->policy_off && options->matter_period_us == 0 &&
+        after.contact_reports - before.contact_reports != after.app.contact_edges - before.app.contact_edges) {
+        bench_fail(options, name, "a debounced transition without its report");
+    }
+}
+
+/* Attribute writes to the light endpoint and button toggles, through the node callback */
+static void bench_light(uint32_t writes, const bench_options_t *options)
+{
+    static const struct {
+        uint32_t cluster_id;
+        uint32_t attribute_id;
+    } k_targets[] = {
+        { OnOff::Id, OnOff::Attributes::OnOff::Id },
+        { LevelControl::Id, LevelControl::Attributes::CurrentLevel::Id },
+        { ColorControl::Id, ColorControl::Attributes::CurrentHue::Id },
+        { ColorControl::Id, ColorControl::Attributes::CurrentSaturation::Id },
+        { ColorControl::Id, ColorControl::Attributes::ColorTemperatureMireds::Id },
+    };
+    host_samples_reserve(writes * 2 + 1024);
+
+    bench_counters_t before;
+    bench_counters_get(&before);
+    uint64_t start_ns = host_wall_ns();
+
+    uint32_t toggles = 0;
+    for (uint32_t i = 0; i < writes; i++) {
+        size_t target = i % (sizeof(k_targets) / sizeof(k_targets[0]));
+        esp_matter_attr_val_t val;
+        if (target == 0) {
+            val = esp_matter_bool(i & 1);
+        } else if (target == 4) {
+            val = esp_matter_uint16(153 + i % 347);
+        } else {
+            val = esp_matter_uint8(1 + i % 254);
+        }
+        attribute::update(light_endpoint_id, k_targets[target].cluster_id, k_targets[target].attribute_id, &val);
+        if (i % 16 == 15) {
+            host_button_fire(BUTTON_PRESS_DOWN);
+            toggles++;
+        }
+    }
+
+    uint64_t wall_ns = host_wall_ns() - start_ns;
+    /* The writes all land at one simulation instant; let the pending render tick run */
+    int64_t next_turn_us = esp_timer_get_time();
+    bench_settle(options, &next_turn_us);
+    bench_counters_t after;
+    bench_counters_get(&after);
+
+    uint32_t updates = after.matter.updates - before.matter.updates;
+    printf("== light: %" PRIu32 " attribute writes, %" PRIu32 " button toggles\n", writes, toggles);
+    printf("  wall %.3f ms, %.0f updates/s, %" PRIu32 " LED calls\n", wall_ns / 1e6, updates / (wall_ns / 1e9),
+           after.led.calls - before.led.calls);
+    bench_print_allocs(&before, &after, updates, "update");
+    bench_print_samples();
+}
+
+/* A 2 s MoveToLevel and MoveToHueAndSaturation from a controller, as the cluster servers
+ * write them: CurrentLevel every 10 ms, hue and saturation every 100 ms. Runs once per
+ * render rate, 0 being one LED write per attribute write. */
+static void bench_transition(const bench_options_t *options)
+{
+    static const uint32_t k_rates_hz[] = { 0, 100, 50, 25 };
+    static const int64_t k_duration_us = 2000000;
+    static const int64_t k_level_step_us = 10000;
+    static const int64_t k_color_step_us = 100000;
+
+    printf("== transition: 2 s level + hue/saturation, LED write cost %" PRIu32 " ns\n", options->led_cost_ns);
+    printf("  %-8s %8s %8s %8s %10s %12s %12s\n", "rate", "writes", "renders", "led", "led/write", "cpu us",
+           "cpu us/s");
+    host_samples_reserve(4096);
+    for (uint32_t rate : k_rates_hz) {
+        int64_t next_turn_us = esp_timer_get_time();
+        app_driver_light_set_render_rate(rate);
+        bench_settle(options, &next_turn_us);
+        host_samples_reset();
+
+        app_light_render_stats_t before;
+        app_driver_light_get_render_stats(&before);
+        int64_t base_us = esp_timer_get_time() + 1000;
+        for (int64_t t = 0; t <= k_duration_us; t += k_level_step_us) {
+            bench_advance(base_us + t, options, &next_turn_us);
+            esp_matter_attr_val_t val = esp_matter_uint8(1 + t * 253 / k_duration_us);
+            attribute::update(light_endpoint_id, LevelControl::Id, LevelControl::Attributes::CurrentLevel::Id, &val);
+            if (t % k_color_step_us == 0) {
+                val = esp_matter_uint8(t * 254 / k_duration_us);
+                attribute::update(light_endpoint_id, ColorControl::Id, ColorControl::Attributes::CurrentHue::Id, &val);
+                val = esp_matter_uint8(254 - t * 127 / k_duration_us);
+                attribute::update(light_endpoint_id, ColorControl::Id,
+                                  ColorControl::Attributes::CurrentSaturation::Id, &val);
+            }
+        }
+        bench_settle(options, &next_turn_us);
+        app_light_render_stats_t after;
+        app_driver_light_get_render_stats(&after);
+
+        /* Attribute callbacks (shadow updates, immediate renders) and render work items */
+        uint64_t cpu_ns = 0;
+        for (host_sample_kind_t kind : { HOST_SAMPLE_ATTRIBUTE_CB, HOST_SAMPLE_MATTER_WORK }) {
+            host_samples_t *samples = host_samples(kind);
+            for (size_t i = 0; i < samples->count; i++) {
+                cpu_ns += samples->ns[i];
+            }
+        }
+        uint32_t writes = after.writes - before.writes;
+        uint32_t led_writes = after.led_writes - before.led_writes;
+        char rate_name[16];
+        snprintf(rate_name, sizeof(rate_name), rate ? "%" PRIu32 " Hz" : "every", rate);
+        printf("  %-8s %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %10.2f %12.1f %12.1f\n", rate_name, writes,
+               after.renders - before.renders, led_writes, writes ? (double)led_writes / writes : 0.0,
+               cpu_ns / 1e3, cpu_ns / 1e3 / (k_duration_us / 1e6));
+    }
+    app_driver_light_set_render_rate(CONFIG_APP_LIGHT_RENDER_HZ);
+}
+
+/* Door opens: lights on, door closes: lights off, through one unicast and one group binding */
+static void bench_binding(const bench_options_t *options)
+{
+    static const uint16_t k_group_id = 0x0101;
+    static uint16_t s_lights[3] = { chip::kInvalidEndpointId };
+    if (s_lights[0] == chip::kInvalidEndpointId) {
+        for (uint16_t &light : s_lights) {
+            light = host_matter_create_light(NULL);
+        }
+    }
+    uint16_t door_endpoint_id = contact_endpoint_ids[APP_CONTACT_DOOR];
+    ESP_ERROR_CHECK(host_matter_bind(door_endpoint_id, s_lights[0]));
+    ESP_ERROR_CHECK(host_matter_bind_group(door_endpoint_id, k_group_id));
+    ESP_ERROR_CHECK(host_matter_group_add(k_group_id, s_lights[1]));
+    ESP_ERROR_CHECK(host_matter_group_add(k_group_id, s_lights[2]));
+    app_binding_action_t on_open, on_close;
+    app_binding_get_actions(APP_CONTACT_DOOR, &on_open, &on_close);
+    app_binding_set_actions(APP_CONTACT_DOOR, APP_BINDING_ACTION_ON, APP_BINDING_ACTION_OFF);
+    host_matter_set_hop_delay(options->hop_us);
+
+    /* A door opened and closed every 2 s, with contact bounce */
+    edge_trace_t trace;
+    edge_trace_chatter(&trace, 1, 200, 8, 3000, 2000000, options->seed);
+    app_binding_stats_t before;
+    app_binding_get_stats(&before);
+    host_binding_stats_t host_before;
+    host_matter_get_binding_stats(&host_before);
+    bench_replay("binding", trace, options);
+    app_binding_stats_t after;
+    app_binding_get_stats(&after);
+    host_binding_stats_t host_after;
+    host_matter_get_binding_stats(&host_after);
+
+    bool open = !trace.back().closed;
+    int in_sync = 0;
+    for (uint16_t light : s_lights) {
+        esp_matter_attr_val_t val = esp_matter_invalid(NULL);
+        attribute::get_val(attribute::get(cluster::get(endpoint::get(node::get(), light), OnOff::Id),
+                                          OnOff::Attributes::OnOff::Id),
+                           &val);
+        in_sync += val.val.b == open;
+    }
+    printf("  binding: %" PRIu32 " transitions, %" PRIu32 " unicast, %" PRIu32 " group, %" PRIu32
+           " responses, %" PRIu32 " errors; %" PRIu32 " commands applied, %" PRIu32 " rejected\n",
+           after.transitions - before.transitions, after.unicast - before.unicast, after.group - before.group,
+           after.responses - before.responses, after.errors - before.errors,
+           host_after.delivered - host_before.delivered, host_after.rejected - host_before.rejected);
+    printf("  lights following the door: %d of %zu\n", in_sync, sizeof(s_lights) / sizeof(s_lights[0]));
+    if (in_sync != (int)(sizeof(s_lights) / sizeof(s_lights[0])) || after.errors != before.errors) {
+        bench_fail(options, "binding", "lights not following the door");
+    }
+
+    app_binding_set_actions(APP_CONTACT_DOOR, on_open, on_close);
+    host_matter_set_hop_delay(0);
+    host_matter_unbind_all();
+}
+
+/* Synthetic transitions on every channel through app_storm.cpp, one simulated second per
+ * rate, for a saturation curve of the contact path; `-m` and `-p 0,0,0,1` make the Matter
+ * thread the bottleneck */
+static void bench_storm(const bench_options_t *options)
+{
+    static const uint32_t k_rates_hz[] = { 100, 1000, 2000, 5000, 10000, 20000, 50000 };
+    static const struct {
+        storm_pattern_t pattern;
+        uint16_t burst_len;
+    } k_patterns[] = { { STORM_STEADY, 0 }, { STORM_BURST, 15 } };
+
+    printf("== storm: 1 s per rate on %u channels, batches of %d, matter turn", app_driver_contact_channel_count(),
+           CONFIG_APP_STORM_BATCH);
+    if (options->matter_period_us) {
+        printf(" every %" PRId64 " us\n", options->matter_period_us);
+    } else {
+        printf(" after every expiry\n");
+    }
+    printf("  %-9s %7s %8s %8s %8s %8s %8s %8s %6s %8s %8s %8s %8s %8s %10s\n", "pattern", "rate", "injected", "/s",
+           "lag us", "restored", "dropped", "coalesc", "hw", "reports", "suppr", "p50 us", "p99 us", "allocs",
+           "wall ev/s");
+    for (const auto &pattern : k_patterns) {
+        for (uint32_t rate : k_rates_hz) {
+            int64_t next_turn_us = esp_timer_get_time();
+            bench_settle(options, &next_turn_us);
+            app_storm_config_t config = {};
+            config.rate_hz = rate;
+            config.duration_ms = 1000;
+            config.pattern = pattern.pattern;
+            config.burst_len = pattern.burst_len;
+            config.seed = options->seed;
+
+            bench_counters_t before;
+            bench_counters_get(&before);
+            uint64_t start_ns = host_wall_ns();
+            int64_t end_us = esp_timer_get_time() + config.duration_ms * 1000;
+            ESP_ERROR_CHECK(app_storm_start(&config));
+            /* Not bench_settle(): it turns the Matter thread after every expiry */
+            next_turn_us = esp_timer_get_time();
+            bench_advance(end_us + 1, options, &next_turn_us);
+            bench_settle(options, &next_turn_us);
+            uint64_t wall_ns = host_wall_ns() - start_ns;
+            bench_counters_t after;
+            bench_counters_get(&after);
+            app_storm_stats_t stats;
+            app_storm_get_stats(&stats);
+
+            char pattern_name[16];
+            snprintf(pattern_name, sizeof(pattern_name), pattern.pattern == STORM_BURST ? "%s/%u" : "%s",
+                     storm_pattern_name(pattern.pattern), pattern.burst_len);
+            printf("  %-9s %7" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32
+                   " %6" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu64 " %10.0f\n",
+                   pattern_name, rate, stats.injected, stats.achieved_hz, stats.max_lag_us, stats.restored, stats.dropped,
+                   stats.coalesced, stats.queue_high_water, stats.reports, stats.suppressed, stats.report_p50_us,
+                   stats.report_p99_us, after.alloc.allocs - before.alloc.allocs, stats.injected / (wall_ns / 1e9));
+            /* Bursts round the count up to whole bursts */
+            if (stats.running || stats.injected < rate || stats.dropped != 0 ||
+                after.work.rejected != before.work.rejected) {
+                bench_fail(options, "storm", "transitions missing or dropped");
+            }
+        }
+    }
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Usage: %s [-v] [-c] [-m matter_period_us] [-n fleet_inputs] [-s seed] [-l led_ns] [-p policy] [-b hop_us]\n"
+            "          [scenario | trace]...\n",
+            argv0);
+    fprintf(stderr, "  scenarios: burst chatter fleet light transition binding storm (default: all)\n");
+    fprintf(stderr, "  -m us     run the Matter work queue every `us` of simulation time (default 0: immediately)\n");
+    fprintf(stderr, "  -n count  inputs of the fleet scenario, up to %u (default: all)\n",
+            (unsigned)APP_CONTACT_CHANNEL_COUNT);
+    fprintf(stderr, "  -s seed   seed of the synthetic traces\n");
+    fprintf(stderr, "  -l ns     time spent in every LED driver write (default 0)\n");
+    fprintf(stderr, "  -p list   report policy of every channel: min_ms,holdoff_ms,max_reports,window_s\n");
+    fprintf(stderr, "            (default: the firmware defaults, 0,0,0,1 reports every transition)\n");
+    fprintf(stderr, "  -b us     one-way delay to the bound lights of the binding scenario (default 10000)\n");
+    fprintf(stderr, "  -c        exit with 1 on a wrong result: drops, rejected Matter work, lights out of sync,\n");
+    fprintf(stderr, "            and with the policy off and -m 0 a debounced transition without its report\n");
+    fprintf(stderr, "  -v        print the driver logs\n");
+}
+
+static void bench_run(const char *scenario, const bench_options_t *options)
+{
+    edge_trace_t trace;
+    if (strcmp(scenario, "burst") == 0) {
+        /* Faster than the settle time: the debouncer and the drain have to absorb it */
+        edge_trace_burst(&trace, APP_CONTACT_CHANNEL_COUNT < 8 ? APP_CONTACT_CHANNEL_COUNT : 8, 20000,
+                         CONFIG_APP_CONTACT_SETTLE_MS * 1000 + 1000);
+    } else if (strcmp(scenario, "chatter") == 0) {
+        edge_trace_chatter(&trace, APP_CONTACT_CHANNEL_COUNT < 8 ? APP_CONTACT_CHANNEL_COUNT : 8, 2000, 8, 3000, 50000, options->seed);
+    } else if (strcmp(scenario, "fleet") == 0) {
+        edge_trace_fleet(&trace, options->fleet_inputs, 20, 10000000, options->seed);
+    } else if (strcmp(scenario, "light") == 0) {
+        bench_light(200000, options);
+        return;
+    } else if (strcmp(scenario, "transition") == 0) {
+        bench_transition(options);
+        return;
+    } else if (strcmp(scenario, "binding") == 0) {
+        bench_binding(options);
+        return;
+    } else if (strcmp(scenario, "storm") == 0) {
+        bench_storm(options);
+        return;
+    } else if (edge_trace_load(scenario, &trace) != 0) {
+        fprintf(stderr, "%s: %s\n", scenario, strerror(errno));
+        s_failed = true;
+        return;
+    }
+    bench_replay(scenario, trace, options);
+}
+
+int main(int argc, char **argv)
+{
+    bench_options_t options = {
+        .matter_period_us = 0,
+        .led_cost_ns = 0,
+        .fleet_inputs = APP_CONTACT_CHANNEL_COUNT,
+        .seed = 1,
+        .policy = NULL,
+        .hop_us = 10000,
+        .check = false,
+        .policy_off = false,
+    };
+    int opt;
+    while ((opt = getopt(argc, argv, "vcm:n:s:l:p:b:h")) != -1) {
+        switch (opt) {
+        case 'v':
+            host_log_level = ESP_LOG_INFO;
+            break;
+        case 'c':
+            options.check = true;
+            break;
+        case 'm':
+            options.matter_period_us = strtoll(optarg, NULL, 10);
+            break;
+        case 'n':
+            options.fleet_inputs = (uint16_t)std::min<unsigned long>(strtoul(optarg, NULL, 10),
+                                                                     APP_CONTACT_CHANNEL_COUNT);
+            break;
+        case 's':
+            options.seed = strtoul(optarg, NULL, 10);
+            break;
+        case 'l':
+            options.led_cost_ns = strtoul(optarg, NULL, 10);
+            host_led_set_write_cost(options.led_cost_ns);
+            break;
+        case 'p':
+            options.policy = optarg;
+            break;
+        case 'b':
+            options.hop_us = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    bench_app_init();
+    if (options.policy) {
+        app_contact_policy_t policy = {};
+        if (sscanf(options.policy, "%" SCNu32 ",%" SCNu32 ",%hu,%" SCNu32, &policy.min_interval_ms,
+                   &policy.holdoff_ms, &policy.max_reports, &policy.window_sec) != 4 ||
+            policy.window_sec == 0) {
+            usage(argv[0]);
+            return 2;
+        }
+        for (uint16_t i = 0; i < app_driver_contact_channel_count(); i++) {
+            app_driver_contact_set_policy(i, &policy);
+        }
+        options.policy_off = policy.min_interval_ms == 0 && policy.holdoff_ms == 0 && policy.max_reports == 0;
+    }
+    if (optind == argc) {
+        static const char *const k_defaults[] = { "burst", "chatter", "fleet", "light", "transition", "binding",
+                                                  "storm" };
+        for (const char *scenario : k_defaults) {
+            bench_run(scenario, &options);
+        }
+    }
+    for (int i = optind; i < argc; i++) {
+        bench_run(argv[i], &options);
+    }
+    return s_failed ? 1 : 0;
+}
@@ -0,0 +1,517 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Benchmark of the fixed-point kernels in main/dsp_kernels.h.
+ *
+ *     dsp_bench [-b block] [-r repeat]
+ *
+ * Runs every kernel over a synthetic three axis accelerometer recording (400 Hz, milli-g,
+ * with a gyro rate channel) in blocks, and reports for each:
+ *     ns/sample, cycles/sample  best of `repeat` runs, per channel sample; cycles are host
+ *                               TSC cycles, a relative figure for the target
+ *     max err, rms err          against the same algorithm in double precision on the same
+ *                               quantized input, in output units (LSB or degrees)
+ *
+ * Then the features the kernels give on three scenarios a door node has to tell apart: a
+ * tilting window leaf, knocks on the frame, and a building vibrating at a few Hz.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#endif
+
+#include "dsp_kernels.h"
+
+#define BENCH_FS_HZ 400
+#define BENCH_AXES 3
+#define BENCH_GYRO_UDPS_PER_LSB 8750 /* 250 dps full scale, 16 bit */
+
+static size_t s_block = 32;
+static int s_repeat = 50;
+
+/* Structure of arrays: one vector per axis */
+typedef struct {
+    std::vector<int16_t> axis[BENCH_AXES]; /* x, y, z in milli-g */
+    std::vector<int16_t> gyro_y;           /* rate around y in gyro counts */
+} bench_signal_t;
+
+static uint32_t s_seed = 15;
+
+static double bench_noise(double sigma)
+{
+    /* Sum of uniforms, deterministic across hosts */
+    double sum = 0;
+    for (int i = 0; i < 4; i++) {
+        s_seed = s_seed * 1664525u + 1013904223u;
+        sum += (s_seed >> 8) / 16777216.0 - 0.5;
+    }
+    return sum * sigma * 1.732;
+}
+
+static int16_t bench_quantize(double value)
+{
+    return (int16_t)(value > 32767 ? 32767 : value < -32768 ? -32768 : lround(value));
+}
+
+typedef enum {
+    SCENARIO_TILT = 0,
+    SCENARIO_KNOCK,
+    SCENARIO_BUILDING,
+    SCENARIO_MAX,
+} scenario_t;
+
+static const char *const k_scenario_names[SCENARIO_MAX] = { "tilt", "knock", "building" };
+
+/* Sensor flat, z up, x along the leaf. 4 s per scenario. */
+static void bench_generate(scenario_t scenario, bench_signal_t *signal)
+{
+    const size_t n = 4 * BENCH_FS_HZ;
+    for (int axis = 0; axis < BENCH_AXES; axis++) {
+        signal->axis[axis].resize(n);
+    }
+    signal->gyro_y.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / BENCH_FS_HZ;
+        double pitch_deg = 0;
+        double rate_dps = 0;
+        double dyn[BENCH_AXES] = { 0, 0, 0 };
+        switch (scenario) {
+        case SCENARIO_TILT:
+            /* Leaf tilts open by 30 degrees over a second, smoothly */
+            if (t >= 1.0 && t < 2.0) {
+                pitch_deg = 15 * (1 - cos(M_PI * (t - 1.0)));
+                rate_dps = 15 * M_PI * sin(M_PI * (t - 1.0));
+            } else if (t >= 2.0) {
+                pitch_deg = 30;
+            }
+            break;
+        case SCENARIO_KNOCK:
+            /* Three knocks, ringing at 120 Hz for a few tens of ms */
+            for (double k : { 1.0, 1.35, 1.7 }) {
+                double dt = t - k;
+                if (dt >= 0 && dt < 0.08) {
+                    double ring = 900 * exp(-dt / 0.012) * sin(2 * M_PI * 120 * dt);
+                    dyn[0] += 0.4 * ring;
+                    dyn[1] += 0.3 * ring;
+                    dyn[2] += ring;
+                }
+            }
+            break;
+        default:
+            /* Building sway and traffic: 4 Hz, 25 mg, for the whole capture */
+            dyn[0] = 10 * sin(2 * M_PI * 4 * t);
+            dyn[1] = 8 * sin(2 * M_PI * 4 * t + 0.5);
+            dyn[2] = 25 * sin(2 * M_PI * 4 * t + 1.0);
+            break;
+        }
+        double pitch = pitch_deg * M_PI / 180;
+        signal->axis[0][i] = bench_quantize(1000 * sin(pitch) + dyn[0] + bench_noise(4));
+        signal->axis[1][i] = bench_quantize(dyn[1] + bench_noise(4));
+        signal->axis[2][i] = bench_quantize(1000 * cos(pitch) + dyn[2] + bench_noise(4));
+        signal->gyro_y[i] = bench_quantize(rate_dps * 1e6 / BENCH_GYRO_UDPS_PER_LSB + bench_noise(2));
+    }
+}
+
+static int64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t bench_cycles(void)
+{
+#ifdef BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+typedef struct {
+    double ns;
+    double cycles;
+} bench_cost_t;
+
+/* Best of s_repeat runs of `run(offset, count)` over `n` samples in blocks, per channel sample */
+template <typename Reset, typename Run>
+static bench_cost_t bench_time(size_t n, size_t channels, Reset reset, Run run)
+{
+    bench_cost_t best = { 1e30, 1e30 };
+    for (int r = 0; r < s_repeat; r++) {
+        reset();
+        int64_t start_ns = bench_now_ns();
+        uint64_t start_cycles = bench_cycles();
+        for (size_t offset = 0; offset < n; offset += s_block) {
+            run(offset, offset + s_block <= n ? s_block : n - offset);
+        }
+        uint64_t cycles = bench_cycles() - start_cycles;
+        int64_t ns = bench_now_ns() - start_ns;
+        double samples = (double)n * channels;
+        if (ns / samples < best.ns) {
+            best.ns = ns / samples;
+        }
+        if (cycles / samples < best.cycles) {
+            best.cycles = cycles / samples;
+        }
+    }
+    return best;
+}
+
+typedef struct {
+    double max;
+    double sum_sq;
+    size_t count;
+} bench_error_t;
+
+static void bench_error_add(bench_error_t *error, double diff)
+{
+    diff = fabs(diff);
+    if (diff > error->max) {
+        error->max = diff;
+    }
+    error->sum_sq += diff * diff;
+    error->count++;
+}
+
+static void bench_print(const char *name, const bench_cost_t &cost, const bench_error_t &error, const char *unit)
+{
+#ifdef BENCH_HAVE_TSC
+    printf("  %-30s %7.2f %8.1f", name, cost.ns, cost.cycles);
+#else
+    printf("  %-30s %7.2f %8s", name, cost.ns, "n/a");
+#endif
+    printf("  %10.4f %10.4f %s\n", error.max, error.count ? sqrt(error.sum_sq / error.count) : 0.0, unit);
+}
+
+/* Double precision references */
+static void ref_biquad(const dsp_biquad_design_t &d, const std::vector<int16_t> &in, double scale,
+                       std::vector<double> *out)
+{
+    double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+    out->resize(in.size());
+    for (size_t i = 0; i < in.size(); i++) {
+        double x0 = in[i] * scale;
+        double y0 = d.b0 * x0 + d.b1 * x1 + d.b2 * x2 - d.a1 * y1 - d.a2 * y2;
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+        (*out)[i] = y0;
+    }
+}
+
+template <typename T>
+static void bench_biquad(const char *name, const bench_signal_t &signal, const dsp_biquad_design_t &design, int shift)
+{
+    const size_t n = signal.axis[0].size();
+    std::vector<T> in[BENCH_AXES];
+    std::vector<T> out[BENCH_AXES];
+    for (int axis = 0; axis < BENCH_AXES; axis++) {
+        for (int16_t sample : signal.axis[axis]) {
+            in[axis].push_back((T)((int32_t)sample * (1 << shift)));
+        }
+        out[axis].resize(n);
+    }
+    dsp_biquad<T, BENCH_AXES> filter(design);
+    bench_cost_t cost = bench_time(n, BENCH_AXES, [&]() { filter.reset(); }, [&](size_t offset, size_t count) {
+        const T *src[BENCH_AXES] = { &in[0][offset], &in[1][offset], &in[2][offset] };
+        T *dst[BENCH_AXES] = { &out[0][offset], &out[1][offset], &out[2][offset] };
+        filter.process(src, dst, count);
+    });
+
+    bench_error_t error = {};
+    for (int axis = 0; axis < BENCH_AXES; axis++) {
+        std::vector<double> ref;
+        ref_biquad(design, signal.axis[axis], 1.0, &ref);
+        for (size_t i = 0; i < n; i++) {
+            bench_error_add(&error, out[axis][i] / (double)(1 << shift) - ref[i]);
+        }
+    }
+    bench_print(name, cost, error, "mg");
+}
+
+static void bench_rms(const bench_signal_t &signal)
+{
+    constexpr size_t window = 32;
+    const size_t n = signal.axis[0].size();
+    std::vector<int16_t> out[BENCH_AXES];
+    for (int axis = 0; axis < BENCH_AXES; axis++) {
+        out[axis].resize(n);
+    }
+    dsp_moving_rms<int16_t, BENCH_AXES, window> rms;
+    bench_cost_t cost = bench_time(n, BENCH_AXES, [&]() { rms.reset(); }, [&](size_t offset, size_t count) {
+        const int16_t *src[BENCH_AXES] = { &signal.axis[0][offset], &signal.axis[1][offset], &signal.axis[2][offset] };
+        int16_t *dst[BENCH_AXES] = { &out[0][offset], &out[1][offset], &out[2][offset] };
+        rms.process(src, dst, count);
+    });
+
+    bench_error_t error = {};
+    for (int axis = 0; axis < BENCH_AXES; axis++) {
+        double sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum += (double)signal.axis[axis][i] * signal.axis[axis][i];
+            if (i >= window) {
+                sum -= (double)signal.axis[axis][i - window] * signal.axis[axis][i - window];
+            }
+            bench_error_add(&error, out[axis][i] - sqrt(sum / window));
+        }
+    }
+    bench_print("moving rms int16 x3, N=32", cost, error, "mg");
+}
+
+static void bench_crossings(const bench_signal_t &signal)
+{
+    const size_t n = signal.axis[0].size();
+    /* Crossings of the dynamic part: high-passed first, outside the timed loop */
+    std::vector<int16_t> hp[BENCH_AXES];
+    dsp_biquad<int16_t, BENCH_AXES> filter(dsp_biquad_design(DSP_BIQUAD_HIGHPASS, BENCH_FS_HZ, 20, 0.7071));
+    for (int axis = 0; axis < BENCH_AXES; axis++) {
+        hp[axis].resize(n);
+    }
+    const int16_t *src[BENCH_AXES] = { signal.axis[0].data(), signal.axis[1].data(), signal.axis[2].data() };
+    int16_t *dst[BENCH_AXES] = { hp[0].data(), hp[1].data(), hp[2].data() };
+    filter.process(src, dst, n);
+
+    const int16_t hysteresis = 20;
+    dsp_crossings<int16_t, BENCH_AXES> crossings(hysteresis);
+    bench_cost_t cost = bench_time(n, BENCH_AXES, [&]() { crossings.reset(); }, [&](size_t offset, size_t count) {
+        const int16_t *block[BENCH_AXES] = { &hp[0][offset], &hp[1][offset], &hp[2][offset] };
+        crossings.process(block, count);
+    });
+
+    /* Reference: count of half cycles, which must match exactly */
+    bench_error_t error = {};
+    for (int axis = 0; axis < BENCH_AXES; axis++) {
+        int sign = 0;
+        uint32_t half_cycles = 0;
+        for (size_t i = 0; i < n; i++) {
+            int side = hp[axis][i] > hysteresis ? 1 : hp[axis][i] < -hysteresis ? -1 : 0;
+            if (side != 0 && side != sign) {
+                half_cycles += sign != 0;
+                sign = side;
+            }
+        }
+        bench_error_add(&error, (double)crossings.half_cycles[axis] - half_cycles);
+    }
+    bench_print("crossings int16 x3", cost, error, "half cycles");
+}
+
+static double bench_angle_deg(dsp_angle_t angle)
+{
+    return (int32_t)angle / DSP_ANGLE_PER_DEGREE;
+}
+
+static double bench_wrap_deg(double deg)
+{
+    while (deg > 180) {
+        deg -= 360;
+    }
+    while (deg < -180) {
+        deg += 360;
+    }
+    return deg;
+}
+
+static void bench_atan2(void)
+{
+    /* Every direction of a 1 g vector in 0.01 degree steps */
+    std::vector<int16_t> ys;
+    std::vector<int16_t> xs;
+    for (int i = 0; i < 36000; i++) {
+        double a = i * M_PI / 18000;
+        ys.push_back(bench_quantize(1000 * sin(a)));
+        xs.push_back(bench_quantize(1000 * cos(a)));
+    }
+    volatile dsp_angle_t sink = 0;
+    bench_cost_t cost = bench_time(xs.size(), 1, []() {}, [&](size_t offset, size_t count) {
+        for (size_t i = offset; i < offset + count; i++) {
+            sink = sink + dsp_atan2(ys[i], xs[i]);
+        }
+    });
+    bench_error_t error = {};
+    for (size_t i = 0; i < xs.size(); i++) {
+        double ref = atan2((double)ys[i], (double)xs[i]) * 180 / M_PI;
+        bench_error_add(&error, bench_wrap_deg(bench_angle_deg(dsp_atan2(ys[i], xs[i])) - ref));
+    }
+    bench_print("atan2", cost, error, "deg");
+}
+
+static const dsp_complementary_config_t k_comp_config = {
+    .fs_hz = BENCH_FS_HZ,
+    .accel_weight_q15 = 655, /* 2% per sample: 0.125 s time constant at 400 Hz */
+    .gyro_udps_per_lsb = BENCH_GYRO_UDPS_PER_LSB,
+};
+
+/* Pitch from (x, z) with the gyro, and roll from (y, z) without */
+static void bench_complementary(const bench_signal_t &signal, std::vector<dsp_angle_t> *pitch_out)
+{
+    const size_t n = signal.axis[0].size();
+    std::vector<dsp_angle_t> out[2];
+    out[0].resize(n);
+    out[1].resize(n);
+    dsp_complementary<int16_t, 1> pitch(k_comp_config);
+    dsp_complementary<int16_t, 1> roll(k_comp_config);
+    bench_cost_t cost = bench_time(n, 2, [&]() {
+        pitch.reset();
+        roll.reset();
+    }, [&](size_t offset, size_t count) {
+        const int16_t *x[1] = { &signal.axis[0][offset] };
+        const int16_t *y[1] = { &signal.axis[1][offset] };
+        const int16_t *z[1] = { &signal.axis[2][offset] };
+        const int16_t *rate[1] = { &signal.gyro_y[offset] };
+        dsp_angle_t *pitch_dst[1] = { &out[0][offset] };
+        dsp_angle_t *roll_dst[1] = { &out[1][offset] };
+        pitch.process(x, z, rate, pitch_dst, count);
+        roll.process(y, z, NULL, roll_dst, count);
+    });
+
+    bench_error_t error = {};
+    double weight = k_comp_config.accel_weight_q15 / 32768.0;
+    for (int channel = 0; channel < 2; channel++) {
+        const std::vector<int16_t> &a = signal.axis[channel];
+        const std::vector<int16_t> &b = signal.axis[2];
+        double angle = atan2((double)a[0], (double)b[0]) * 180 / M_PI;
+        for (size_t i = 0; i < n; i++) {
+            if (channel == 0) {
+                angle += signal.gyro_y[i] * (BENCH_GYRO_UDPS_PER_LSB / 1e6) / BENCH_FS_HZ;
+            }
+            double accel = atan2((double)a[i], (double)b[i]) * 180 / M_PI;
+            angle += weight * bench_wrap_deg(accel - angle);
+            bench_error_add(&error, bench_wrap_deg(bench_angle_deg(out[channel][i]) - angle));
+        }
+    }
+    bench_print("complementary int16 x2", cost, error, "deg");
+    if (pitch_out) {
+        *pitch_out = out[0];
+    }
+}
+
+/* What the kernels tell about a scenario */
+static void bench_features(scenario_t scenario)
+{
+    bench_signal_t signal;
+    bench_generate(scenario, &signal);
+    const size_t n = signal.axis[0].size();
+    /* The filters start from zero against 1 g: skip their settling */
+    const size_t settle = BENCH_FS_HZ / 2;
+
+    /* Orientation change: complementary filter pitch, max - min */
+    dsp_complementary<int16_t, 1> pitch(k_comp_config);
+    std::vector<dsp_angle_t> angles(n);
+    const int16_t *x[1] = { signal.axis[0].data() };
+    const int16_t *z[1] = { signal.axis[2].data() };
+    const int16_t *rate[1] = { signal.gyro_y.data() };
+    dsp_angle_t *angle_dst[1] = { angles.data() };
+    pitch.process(x, z, rate, angle_dst, n);
+    double lo = 1e9, hi = -1e9;
+    for (size_t i = settle; i < n; i++) {
+        lo = fmin(lo, bench_angle_deg(angles[i]));
+        hi = fmax(hi, bench_angle_deg(angles[i]));
+    }
+
+    /* Impacts: RMS over 80 ms of the z axis above 20 Hz, peak */
+    std::vector<int16_t> high(n);
+    dsp_biquad<int16_t, 1> highpass(dsp_biquad_design(DSP_BIQUAD_HIGHPASS, BENCH_FS_HZ, 20, 0.7071));
+    int16_t *high_dst[1] = { high.data() };
+    highpass.process(z, high_dst, n);
+    std::vector<int16_t> rms_out(n);
+    dsp_moving_rms<int16_t, 1, 32> rms;
+    const int16_t *high_src[1] = { high.data() };
+    int16_t *rms_dst[1] = { rms_out.data() };
+    rms.process(high_src, rms_dst, n);
+    int16_t rms_peak = 0;
+    for (size_t i = settle; i < n; i++) {
+        rms_peak = rms_out[i] > rms_peak ? rms_out[i] : rms_peak;
+    }
+
+    /* Sustained low frequency motion: half cycles per second of the z axis in 1-10 Hz */
+    dsp_biquad<int32_t, 1> bandpass(dsp_biquad_design(DSP_BIQUAD_BANDPASS, BENCH_FS_HZ, 3.2, 0.5));
+    std::vector<int32_t> z32(signal.axis[2].begin(), signal.axis[2].end());
+    std::vector<int32_t> band32(n);
+    const int32_t *z32_src[1] = { z32.data() };
+    int32_t *band32_dst[1] = { band32.data() };
+    bandpass.process(z32_src, band32_dst, n);
+    dsp_crossings<int32_t, 1> crossings(12);
+    const int32_t *band32_src[1] = { band32.data() + settle };
+    crossings.process(band32_src, n - settle);
+
+    printf("  %-10s %10.1f %12d %14.1f\n", k_scenario_names[scenario], hi - lo, rms_peak,
+           crossings.half_cycles[0] * (double)BENCH_FS_HZ / (n - settle));
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "Usage: %s [-b block] [-r repeat]\n", argv0);
+    fprintf(stderr, "  -b n      samples per channel per process() call (default 32)\n");
+    fprintf(stderr, "  -r n      timed runs per kernel, the best is kept (default 50)\n");
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "b:r:h")) != -1) {
+        switch (opt) {
+        case 'b':
+            s_block = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            s_repeat = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc || s_block == 0 || s_repeat <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    /* Accuracy and cost on a mix of everything: the three scenarios back to back */
+    bench_signal_t signal;
+    for (int scenario = 0; scenario < SCENARIO_MAX; scenario++) {
+        bench_signal_t part;
+        bench_generate((scenario_t)scenario, &part);
+        for (int axis = 0; axis < BENCH_AXES; axis++) {
+            signal.axis[axis].insert(signal.axis[axis].end(), part.axis[axis].begin(), part.axis[axis].end());
+        }
+        signal.gyro_y.insert(signal.gyro_y.end(), part.gyro_y.begin(), part.gyro_y.end());
+    }
+
+    printf("%zu samples per channel at %d Hz, blocks of %zu\n\n", signal.axis[0].size(), BENCH_FS_HZ, s_block);
+    printf("  %-30s %7s %8s  %10s %10s\n", "kernel", "ns/smp", "cyc/smp", "max err", "rms err");
+    dsp_biquad_design_t lowpass = dsp_biquad_design(DSP_BIQUAD_LOWPASS, BENCH_FS_HZ, 20, 0.7071);
+    dsp_biquad_design_t highpass = dsp_biquad_design(DSP_BIQUAD_HIGHPASS, BENCH_FS_HZ, 20, 0.7071);
+    dsp_biquad_design_t slow = dsp_biquad_design(DSP_BIQUAD_LOWPASS, BENCH_FS_HZ, 2, 0.7071);
+    bench_biquad<int16_t>("biquad int16 x3, lp 20 Hz", signal, lowpass, 0);
+    bench_biquad<int16_t>("biquad int16 x3, hp 20 Hz", signal, highpass, 0);
+    bench_biquad<int16_t>("biquad int16 x3, lp 2 Hz", signal, slow, 0);
+    bench_biquad<int32_t>("biquad int32 x3, lp 2 Hz", signal, slow, 8);
+    bench_rms(signal);
+    bench_crossings(signal);
+    bench_atan2();
+    bench_complementary(signal, NULL);
+
+    printf("\n  %-10s %10s %12s %14s\n", "scenario", "tilt deg", "hf rms mg", "lf half-cyc/s");
+    for (int scenario = 0; scenario < SCENARIO_MAX; scenario++) {
+        bench_features((scenario_t)scenario);
+    }
+    return 0;
+}
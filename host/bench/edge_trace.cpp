@@ -0,0 +1,126 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "edge_trace.h"
+
+/* Deterministic across hosts, unlike rand() */
+static uint32_t xorshift32(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static void edge_trace_sort(edge_trace_t *trace)
+{
+    std::stable_sort(trace->begin(), trace->end(),
+                     [](const edge_t &a, const edge_t &b) { return a.time_us < b.time_us; });
+}
+
+int edge_trace_load(const char *path, edge_trace_t *trace)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return -1;
+    }
+    trace->clear();
+    char line[256];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        long long time_us;
+        unsigned channel;
+        int level;
+        int fields = sscanf(line, "%lld %u %d", &time_us, &channel, &level);
+        if (fields <= 0) {
+            continue;
+        }
+        if (fields != 3 || channel > UINT16_MAX) {
+            fprintf(stderr, "%s:%d: expected <time_us> <channel> <level>\n", path, lineno);
+            fclose(f);
+            errno = EINVAL;
+            return -1;
+        }
+        trace->push_back({ (int64_t)time_us, (uint16_t)channel, level != 0 });
+    }
+    fclose(f);
+    edge_trace_sort(trace);
+    return 0;
+}
+
+void edge_trace_burst(edge_trace_t *trace, uint16_t channels, uint32_t transitions, uint32_t period_us)
+{
+    trace->clear();
+    trace->reserve((size_t)channels * transitions);
+    for (uint32_t i = 0; i < transitions; i++) {
+        for (uint16_t channel = 0; channel < channels; channel++) {
+            trace->push_back({ (int64_t)(i + 1) * period_us, channel, (i & 1) == 0 });
+        }
+    }
+}
+
+void edge_trace_chatter(edge_trace_t *trace, uint16_t channels, uint32_t transitions, uint32_t bounces,
+                        uint32_t bounce_us, uint32_t gap_us, uint32_t seed)
+{
+    uint32_t state = seed ? seed : 1;
+    trace->clear();
+    trace->reserve((size_t)channels * transitions * (2 * bounces + 1));
+    for (uint16_t channel = 0; channel < channels; channel++) {
+        int64_t t = 1000 + channel * 37;
+        for (uint32_t i = 0; i < transitions; i++) {
+            bool closed = (i & 1) == 0;
+            trace->push_back({ t, channel, closed });
+            /* Each bounce flips the input back and forth before it settles on `closed` */
+            int64_t b = t;
+            for (uint32_t j = 0; j < bounces; j++) {
+                b += 1 + xorshift32(&state) % (bounce_us / (2 * bounces) + 1);
+                trace->push_back({ b, channel, !closed });
+                b += 1 + xorshift32(&state) % (bounce_us / (2 * bounces) + 1);
+                trace->push_back({ b, channel, closed });
+            }
+            t += gap_us;
+        }
+    }
+    edge_trace_sort(trace);
+}
+
+void edge_trace_fleet(edge_trace_t *trace, uint16_t channels, uint32_t transitions_per_channel, int64_t window_us,
+                      uint32_t seed)
+{
+    uint32_t state = seed ? seed : 1;
+    trace->clear();
+    trace->reserve((size_t)channels * transitions_per_channel * 3);
+    int64_t slot_us = window_us / (transitions_per_channel ? transitions_per_channel : 1);
+    for (uint16_t channel = 0; channel < channels; channel++) {
+        for (uint32_t i = 0; i < transitions_per_channel; i++) {
+            /* One transition per slot keeps the levels of a channel alternating */
+            int64_t t = i * slot_us + xorshift32(&state) % (slot_us / 2 + 1);
+            bool closed = (i & 1) == 0;
+            trace->push_back({ t, channel, closed });
+            if (xorshift32(&state) % 4 == 0) {
+                int64_t bounce = 50 + xorshift32(&state) % 400;
+                trace->push_back({ t + bounce, channel, !closed });
+                trace->push_back({ t + 2 * bounce, channel, closed });
+            }
+        }
+    }
+    edge_trace_sort(trace);
+}
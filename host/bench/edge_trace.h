@@ -0,0 +1,46 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+/*
+ * Raw input edge traces: what the contact GPIOs see, bounce included.
+ *
+ * Recorded traces are text files, one edge per line, `#` starts a comment:
+ *     <time_us> <channel> <level>
+ * where level is 1 (closed) or 0 (open), e.g. a logic analyser export of the reed switches.
+ */
+
+typedef struct {
+    int64_t time_us;
+    uint16_t channel;
+    bool closed;
+} edge_t;
+
+typedef std::vector<edge_t> edge_trace_t;
+
+/** Load a recorded trace, edges are sorted by time
+ *
+ * @return 0 on success, -1 on error (errno set).
+ */
+int edge_trace_load(const char *path, edge_trace_t *trace);
+
+/** Clean transitions on `channels` inputs, `period_us` apart, no bounce */
+void edge_trace_burst(edge_trace_t *trace, uint16_t channels, uint32_t transitions, uint32_t period_us);
+
+/** Transitions `gap_us` apart, each followed by `bounces` bounce edges within `bounce_us` */
+void edge_trace_chatter(edge_trace_t *trace, uint16_t channels, uint32_t transitions, uint32_t bounces,
+                        uint32_t bounce_us, uint32_t gap_us, uint32_t seed);
+
+/** `channels` independent inputs with random transition times over `window_us`, with bounce */
+void edge_trace_fleet(edge_trace_t *trace, uint16_t channels, uint32_t transitions_per_channel, int64_t window_us,
+                      uint32_t seed);
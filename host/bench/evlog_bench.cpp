@@ -0,0 +1,384 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Contact event log (main/event_log.cpp) on a file-backed flash simulator, under millions of
+ * appends.
+ *
+ *     evlog_bench [-n appends] [-s sectors] [-b batch] [-p power_cut_every] [-r seed] [-d dir] [-c]
+ *
+ * The flash is a file with NOR semantics: an erase sets a 4 KB sector to 0xFF, a write can
+ * only clear bits. The workload alternates online stretches, where each event is
+ * acknowledged as soon as it is appended (app_evlog_record()), and offline stretches that
+ * end with the replay of app_evlog_set_online(); some offline stretches are longer than the
+ * ring holds. One append in 8 is followed by a flush (the flush timer), and about every
+ * `power_cut_every` appends the power is cut: the RAM batch is lost and the log is mounted
+ * again from the file. Defaults: 2000000 appends, 16 sectors (the 64 KB `evlog` partition),
+ * a 32 record batch (CONFIG_APP_EVLOG_BATCH_RECORDS), a power cut every 20000 appends.
+ *
+ * Prints the append rate on the host, the flash traffic per event, the erase count spread
+ * across sectors and the unacknowledged events overwritten. With -c, exits 1 if a flushed
+ * event is lost, reordered or changed, if the log resumes at the wrong sequence number or
+ * ack after a power cut, if an unacknowledged event disappears without being counted as
+ * overwritten, or if the erases are not spread evenly.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "event_log.h"
+
+#define BENCH_SECTOR_SIZE 4096
+
+typedef struct {
+    uint32_t appends;
+    uint32_t sectors;
+    uint32_t batch;
+    uint32_t power_cut_every;
+    bool check;
+} bench_options_t;
+
+/* NOR flash in a file */
+typedef struct {
+    int fd;
+    uint32_t size;
+    std::vector<uint32_t> erases; /* per sector */
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t bytes_written;
+    uint32_t bit_sets;            /* writes that tried to turn a 0 bit back to 1 */
+} bench_flash_t;
+
+static uint64_t s_rng = 1;
+static int s_failed = 0;
+
+static uint32_t bench_rand(uint32_t n)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return (uint32_t)(s_rng % n);
+}
+
+static uint64_t bench_wall_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void bench_fail(const bench_options_t *options, const char *what, uint32_t seq)
+{
+    s_failed++;
+    if (options->check) {
+        printf("  FAILED %s (seq %" PRIu32 ")\n", what, seq);
+    }
+}
+
+static int bench_flash_read(void *ctx, uint32_t offset, void *dst, size_t len)
+{
+    bench_flash_t *flash = (bench_flash_t *)ctx;
+    flash->reads++;
+    if (offset + len > flash->size) {
+        return -1;
+    }
+    return pread(flash->fd, dst, len, offset) == (ssize_t)len ? 0 : -1;
+}
+
+static int bench_flash_write(void *ctx, uint32_t offset, const void *src, size_t len)
+{
+    bench_flash_t *flash = (bench_flash_t *)ctx;
+    uint8_t cur[BENCH_SECTOR_SIZE];
+    if (offset + len > flash->size || len > sizeof(cur) || pread(flash->fd, cur, len, offset) != (ssize_t)len) {
+        return -1;
+    }
+    const uint8_t *data = (const uint8_t *)src;
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] & ~cur[i]) {
+            flash->bit_sets++;
+        }
+        cur[i] &= data[i];
+    }
+    flash->writes++;
+    flash->bytes_written += len;
+    return pwrite(flash->fd, cur, len, offset) == (ssize_t)len ? 0 : -1;
+}
+
+static int bench_flash_erase(void *ctx, uint32_t offset)
+{
+    bench_flash_t *flash = (bench_flash_t *)ctx;
+    uint8_t erased[BENCH_SECTOR_SIZE];
+    if (offset % BENCH_SECTOR_SIZE != 0 || offset >= flash->size) {
+        return -1;
+    }
+    memset(erased, 0xFF, sizeof(erased));
+    flash->erases[offset / BENCH_SECTOR_SIZE]++;
+    return pwrite(flash->fd, erased, sizeof(erased), offset) == (ssize_t)sizeof(erased) ? 0 : -1;
+}
+
+/* What an event holds is a function of its sequence number, so any entry can be checked */
+static void bench_event(uint32_t seq, uint32_t *time_ms, uint16_t *endpoint, uint8_t *value)
+{
+    *time_ms = seq * 1000;
+    *endpoint = 1 + seq % 4;
+    *value = (uint8_t)(seq * 7);
+}
+
+typedef struct {
+    const bench_options_t *options;
+    uint32_t first;
+    uint32_t last;
+    uint32_t count;
+    bool ok;
+} bench_walk_t;
+
+static bool bench_walk_cb(const event_log_entry_t *entry, void *arg)
+{
+    bench_walk_t *walk = (bench_walk_t *)arg;
+    uint32_t time_ms;
+    uint16_t endpoint;
+    uint8_t value;
+    bench_event(entry->seq, &time_ms, &endpoint, &value);
+    if (entry->time_ms != time_ms || entry->endpoint != endpoint || entry->value != value) {
+        bench_fail(walk->options, "event read back changed", entry->seq);
+        walk->ok = false;
+    }
+    if (walk->count > 0 && entry->seq != walk->last + 1) {
+        bench_fail(walk->options, "events missing or out of order", entry->seq);
+        walk->ok = false;
+    }
+    if (walk->count == 0) {
+        walk->first = entry->seq;
+    }
+    walk->last = entry->seq;
+    walk->count++;
+    return walk->ok;
+}
+
+/* Events above `after_seq` on flash and in the RAM batch, checked along the way */
+static uint32_t bench_walk(event_log_t *log, uint32_t after_seq, const bench_options_t *options, uint32_t *last)
+{
+    bench_walk_t walk = { options, 0, after_seq, 0, true };
+    event_log_for_each(log, after_seq, bench_walk_cb, &walk);
+    if (walk.count > 0 && walk.last != log->next_seq - 1) {
+        bench_fail(options, "newest event missing", walk.last);
+    }
+    if (last) {
+        *last = walk.last;
+    }
+    return walk.count;
+}
+
+static bool bench_mount(event_log_t *log, bench_flash_t *flash, std::vector<uint8_t> *buf)
+{
+    event_log_flash_t backend = {
+        .read = bench_flash_read,
+        .write = bench_flash_write,
+        .erase_sector = bench_flash_erase,
+        .ctx = flash,
+        .size = flash->size,
+        .sector_size = BENCH_SECTOR_SIZE,
+    };
+    int err = event_log_mount(log, &backend, buf->data(), buf->size());
+    if (err != EVENT_LOG_OK) {
+        printf("  mount failed, err %d\n", err);
+        return false;
+    }
+    return true;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-n appends] [-s sectors] [-b batch] [-p power_cut_every] [-r seed] [-d dir] [-c]\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    bench_options_t options = { 2000000, 16, 32, 20000, false };
+    const char *dir = NULL;
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:b:p:r:d:ch")) != -1) {
+        switch (opt) {
+        case 'n':
+            options.appends = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            options.sectors = strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            options.batch = strtoul(optarg, NULL, 0);
+            break;
+        case 'p':
+            options.power_cut_every = strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'd':
+            dir = optarg;
+            break;
+        case 'c':
+            options.check = true;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc || options.sectors < 2 || options.sectors > EVENT_LOG_MAX_SECTORS || options.batch == 0 ||
+        seed == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    s_rng = seed;
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/evlog_bench.XXXXXX", dir ? dir : "/tmp");
+    bench_flash_t flash = {};
+    flash.fd = mkstemp(path);
+    if (flash.fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    unlink(path);
+    flash.size = options.sectors * BENCH_SECTOR_SIZE;
+    flash.erases.assign(options.sectors, 0);
+    std::vector<uint8_t> erased(flash.size, 0xFF);
+    if (pwrite(flash.fd, erased.data(), erased.size(), 0) != (ssize_t)erased.size()) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    /* Same layout as app_evlog.cpp: the batch plus one record for the ack */
+    std::vector<uint8_t> buf((options.batch + 1) * EVENT_LOG_RECORD_SIZE);
+    event_log_t log;
+    if (!bench_mount(&log, &flash, &buf)) {
+        return 1;
+    }
+    uint32_t ring_events = options.sectors * (BENCH_SECTOR_SIZE - EVENT_LOG_HEADER_SIZE) / EVENT_LOG_RECORD_SIZE;
+    printf("%" PRIu32 " appends, %" PRIu32 " x %d byte sectors (%" PRIu32 " records), batch %" PRIu32
+           ", power cut every ~%" PRIu32 " appends\n",
+           options.appends, options.sectors, BENCH_SECTOR_SIZE, ring_events, options.batch, options.power_cut_every);
+
+    bool online = true;
+    uint32_t stretch = 0;
+    uint32_t offline_stretches = 0, long_stretches = 0, power_cuts = 0, replayed = 0;
+    uint64_t overwritten = 0, log_flash_writes = 0;
+    /* Unacked events not readable any more, and the overwritten counter, when the offline stretch started */
+    uint32_t lost_base = 0, overwritten_base = 0;
+    uint64_t log_ns = 0;
+
+    for (uint32_t i = 0; i < options.appends; i++) {
+        if (stretch == 0) {
+            if (online) {
+                stretch = 1 + bench_rand(3 * ring_events);
+                long_stretches += stretch > ring_events;
+                offline_stretches++;
+                lost_base = event_log_unacked(&log) - bench_walk(&log, log.acked_seq, &options, NULL);
+                overwritten_base = log.stats.overwritten;
+            } else {
+                /* Back online: every unacked event still readable is replayed, whatever was lost is accounted for */
+                uint32_t last;
+                uint32_t readable = bench_walk(&log, log.acked_seq, &options, &last);
+                if (event_log_unacked(&log) - readable - lost_base != log.stats.overwritten - overwritten_base) {
+                    bench_fail(&options, "unacked events lost without being counted", log.next_seq);
+                }
+                replayed += readable;
+                uint64_t start_ns = bench_wall_ns();
+                if (readable) {
+                    event_log_ack(&log, last);
+                }
+                event_log_flush(&log);
+                log_ns += bench_wall_ns() - start_ns;
+                stretch = 1 + bench_rand(2000);
+            }
+            online = !online;
+        }
+        stretch--;
+
+        uint32_t time_ms;
+        uint16_t endpoint;
+        uint8_t value;
+        bench_event(log.next_seq, &time_ms, &endpoint, &value);
+        uint64_t start_ns = bench_wall_ns();
+        uint32_t seq = event_log_append(&log, time_ms, endpoint, value);
+        if (seq != 0 && online) {
+            event_log_ack(&log, seq);
+        }
+        if (bench_rand(8) == 0) {
+            event_log_flush(&log);
+        }
+        log_ns += bench_wall_ns() - start_ns;
+        if (seq == 0) {
+            bench_fail(&options, "append failed", log.next_seq);
+            break;
+        }
+
+        if (bench_rand(options.power_cut_every) == 0) {
+            /* What made it to flash comes back, the RAM batch does not */
+            uint32_t next_seq = log.next_seq - (uint32_t)(log.buf_len / EVENT_LOG_RECORD_SIZE);
+            uint32_t acked_seq = log.persisted_ack;
+            overwritten += log.stats.overwritten;
+            log_flash_writes += log.stats.flash_writes;
+            power_cuts++;
+            if (!bench_mount(&log, &flash, &buf)) {
+                s_failed++;
+                break;
+            }
+            if (log.next_seq != next_seq || log.acked_seq != acked_seq || log.stats.crc_errors != 0) {
+                bench_fail(&options, "wrong state after a power cut", log.next_seq);
+            }
+            lost_base = event_log_unacked(&log) - bench_walk(&log, log.acked_seq, &options, NULL);
+            overwritten_base = 0;
+        }
+    }
+    event_log_flush(&log);
+    overwritten += log.stats.overwritten;
+    log_flash_writes += log.stats.flash_writes;
+    uint32_t last;
+    uint32_t kept = bench_walk(&log, 0, &options, &last);
+
+    uint32_t min_erases = UINT32_MAX, max_erases = 0;
+    uint64_t erases = 0;
+    for (uint32_t count : flash.erases) {
+        min_erases = count < min_erases ? count : min_erases;
+        max_erases = count > max_erases ? count : max_erases;
+        erases += count;
+    }
+    if (max_erases - min_erases > 1) {
+        bench_fail(&options, "uneven wear", log.next_seq);
+    }
+    if (flash.bit_sets != 0) {
+        bench_fail(&options, "write over programmed bits", log.next_seq);
+    }
+
+    printf("  host time      %.3f s, %.2f M appends/s\n", log_ns / 1e9, options.appends / (log_ns / 1e3));
+    printf("  flash          %" PRIu64 " writes (%.3f per event, log counted %" PRIu64 "), %.1f bytes per event\n",
+           flash.writes, (double)flash.writes / options.appends, log_flash_writes,
+           (double)flash.bytes_written / options.appends);
+    printf("  erases         %" PRIu64 ", %" PRIu32 "-%" PRIu32 " per sector\n", erases, min_erases, max_erases);
+    printf("  offline        %" PRIu32 " stretches, %" PRIu32 " longer than the ring, %" PRIu32 " events replayed\n",
+           offline_stretches, long_stretches, replayed);
+    printf("  overwritten    %" PRIu64 " unacked events\n", overwritten);
+    printf("  power cuts     %" PRIu32 "\n", power_cuts);
+    printf("  on flash       %" PRIu32 " events, seq %" PRIu32 "-%" PRIu32 "\n", kept, kept ? last - kept + 1 : 0,
+           last);
+    printf("%s\n", s_failed ? "FAILED" : "ok");
+    close(flash.fd);
+    return options.check && s_failed ? 1 : 0;
+}
@@ -0,0 +1,454 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Scan cost of contact inputs on I2C GPIO expanders.
+ *
+ *     expander_bench [-n expanders] [-c mcp23017|pca9555] [-m bulk|pin] [-t seconds]
+ *                    [-e events_per_s] [-b bounce_us] [-s seed] [-i iterations]
+ *
+ * Up to eight simulated expanders (16 channels each, 128 by default) on one bus model with
+ * a shared interrupt line. Random contacts open and close with reed switch bounce; the
+ * driver scans like the firmware (main/app_expander.cpp): every expander on the interrupt,
+ * the ones that are due at their settle deadline. Two ways of reading the pins are
+ * compared:
+ *     bulk   both ports in one transaction, changed pins found by XOR (the firmware)
+ *     pin    one transaction per pin, as a per-input driver would do
+ * The simulated clock advances by the wire time of every transaction at 400 kHz, so a slow
+ * scan shows up as report latency and as bounce it misses.
+ *
+ * Prints the bus traffic per scan and per reported change, the latency from the contact
+ * moving to the report, whether every change was reported and the final levels match, and
+ * the host CPU throughput of full scans.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "expander_sim.h"
+#include "gpio_expander.h"
+
+#define BENCH_I2C_HZ 400000
+#define BENCH_NS_PER_BIT (1000000000 / BENCH_I2C_HZ)
+#define BENCH_MIN_GAP_US 50000 /* a contact stays put at least this long between changes */
+#define BENCH_MCP23017_GPIOA 0x12
+#define BENCH_PCA9555_INPUT0 0x00
+
+typedef enum {
+    BENCH_MODE_BULK = 0,
+    BENCH_MODE_PIN,
+} bench_mode_t;
+
+typedef struct {
+    int64_t time_ns;
+    uint16_t channel;
+    bool level;
+    bool first; /* first edge of a contact change, the rest is bounce */
+} bench_change_t;
+
+typedef struct {
+    uint8_t expanders;
+    expander_sim_chip_t chip;
+    bench_mode_t mode;
+    uint32_t duration_s;
+    uint32_t events_per_s;
+    uint32_t bounce_us;
+    uint32_t seed;
+    uint32_t iterations;
+} bench_options_t;
+
+/* Simulated world: the clock, the pending pin changes and the chips */
+static expander_sim_t s_sim;
+static int64_t s_now_ns = 0;
+static const std::vector<bench_change_t> *s_changes = NULL;
+static size_t s_next_change = 0;
+static uint16_t s_pins[EXPANDER_SIM_MAX];
+static int64_t s_change_start_ns[EXPANDER_SIM_MAX * EXPANDER_PINS];
+
+/* Results */
+static uint32_t s_reports = 0;
+static int64_t s_latency_sum_ns = 0;
+static int64_t s_latency_max_ns = 0;
+
+static uint32_t xorshift32(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static int64_t bench_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Every contact changes at random, at least BENCH_MIN_GAP_US apart; each change is its
+ * first edge and an even number of bounce edges within `bounce_us` */
+static void bench_generate(std::vector<bench_change_t> *changes, uint16_t channels, const bench_options_t *options)
+{
+    uint32_t state = options->seed ? options->seed : 1;
+    int64_t duration_us = (int64_t)options->duration_s * 1000000;
+    /* Mean gap per channel for the requested total rate */
+    int64_t mean_gap_us = options->events_per_s ? (int64_t)channels * 1000000 / options->events_per_s : duration_us;
+    int64_t spread_us = std::max<int64_t>(2 * (mean_gap_us - BENCH_MIN_GAP_US), 1);
+    for (uint16_t channel = 0; channel < channels; channel++) {
+        bool level = true;
+        int64_t t = xorshift32(&state) % (mean_gap_us + 1);
+        while (t < duration_us) {
+            level = !level;
+            changes->push_back({ t * 1000, channel, level, true });
+            uint32_t bounces = options->bounce_us ? xorshift32(&state) % 4 : 0;
+            int64_t b = t;
+            for (uint32_t i = 0; i < bounces; i++) {
+                b += 1 + xorshift32(&state) % (options->bounce_us / (2 * bounces) + 1);
+                changes->push_back({ b * 1000, channel, !level, false });
+                b += 1 + xorshift32(&state) % (options->bounce_us / (2 * bounces) + 1);
+                changes->push_back({ b * 1000, channel, level, false });
+            }
+            t += BENCH_MIN_GAP_US + xorshift32(&state) % spread_us;
+        }
+    }
+    std::stable_sort(changes->begin(), changes->end(),
+                     [](const bench_change_t &a, const bench_change_t &b) { return a.time_ns < b.time_ns; });
+}
+
+/* Apply the pin changes up to the current time */
+static void bench_advance(void)
+{
+    uint8_t touched = 0;
+    while (s_next_change < s_changes->size() && (*s_changes)[s_next_change].time_ns <= s_now_ns) {
+        const bench_change_t &change = (*s_changes)[s_next_change++];
+        uint8_t index = change.channel / EXPANDER_PINS;
+        uint16_t bit = 1u << (change.channel % EXPANDER_PINS);
+        s_pins[index] = change.level ? s_pins[index] | bit : s_pins[index] & ~bit;
+        touched |= 1u << index;
+        if (change.first) {
+            s_change_start_ns[change.channel] = change.time_ns;
+        }
+    }
+    for (uint8_t i = 0; i < s_sim.count; i++) {
+        if (touched & (1u << i)) {
+            expander_sim_set_pins(&s_sim, i, s_pins[i]);
+        }
+    }
+}
+
+/* Bus in front of the simulated chips: every transaction takes its wire time, and the pins
+ * keep moving meanwhile */
+static int bench_bus_read(void *ctx, uint8_t address, uint8_t reg, uint8_t *buf, size_t len)
+{
+    uint64_t bits = s_sim.bus_bits;
+    expander_bus_t bus = expander_sim_bus(&s_sim);
+    /* The chip samples the port while the register address goes out */
+    s_now_ns += 3 * 9 * BENCH_NS_PER_BIT;
+    bench_advance();
+    int err = bus.read(bus.ctx, address, reg, buf, len);
+    s_now_ns += (int64_t)(s_sim.bus_bits - bits - 3 * 9) * BENCH_NS_PER_BIT;
+    return err;
+}
+
+static int bench_bus_write(void *ctx, uint8_t address, uint8_t reg, const uint8_t *buf, size_t len)
+{
+    uint64_t bits = s_sim.bus_bits;
+    expander_bus_t bus = expander_sim_bus(&s_sim);
+    int err = bus.write(bus.ctx, address, reg, buf, len);
+    s_now_ns += (int64_t)(s_sim.bus_bits - bits) * BENCH_NS_PER_BIT;
+    bench_advance();
+    return err;
+}
+
+/* The per-pin reader: same chip, one transaction per input */
+static const expander_regmap_t *s_chip_map = NULL;
+
+static expander_err_t bench_read_per_pin(const expander_bus_t *bus, uint8_t address, uint16_t *levels)
+{
+    uint8_t port_reg = s_chip_map == &expander_regmap_mcp23017 ? BENCH_MCP23017_GPIOA : BENCH_PCA9555_INPUT0;
+    uint16_t value = 0;
+    for (uint8_t pin = 0; pin < EXPANDER_PINS; pin++) {
+        uint8_t port = 0;
+        if (bus->read(bus->ctx, address, port_reg + pin / 8, &port, 1) != 0) {
+            return EXPANDER_ERR_BUS;
+        }
+        value |= ((port >> (pin % 8)) & 1) << pin;
+    }
+    *levels = value;
+    return EXPANDER_OK;
+}
+
+static expander_err_t bench_configure(const expander_bus_t *bus, uint8_t address)
+{
+    return s_chip_map->configure(bus, address);
+}
+
+static const expander_regmap_t k_per_pin_map = {
+    .name = "per pin",
+    .configure = bench_configure,
+    .read_inputs = bench_read_per_pin,
+};
+
+static void bench_report(void *arg, uint8_t pin, bool closed, int64_t edge_us)
+{
+    uint16_t channel = (uint16_t)(uintptr_t)arg * EXPANDER_PINS + pin;
+    int64_t latency = s_now_ns - s_change_start_ns[channel];
+    s_reports++;
+    s_latency_sum_ns += latency;
+    s_latency_max_ns = std::max(s_latency_max_ns, latency);
+}
+
+/* Host CPU cost of full scans with a few pins moving, on a bus that takes no time */
+static void bench_throughput(expander_t *expanders, const bench_options_t *options)
+{
+    if (options->iterations == 0) {
+        return;
+    }
+    std::vector<bench_change_t> none;
+    s_changes = &none;
+    s_next_change = 0;
+    uint32_t state = options->seed ? options->seed : 1;
+    uint16_t channels = options->expanders * EXPANDER_PINS;
+    uint64_t transfers = 0;
+    for (uint8_t i = 0; i < options->expanders; i++) {
+        transfers -= expanders[i].stats.transfers;
+    }
+    int64_t start = bench_cpu_ns();
+    for (uint32_t n = 0; n < options->iterations; n++) {
+        /* One pin in eight scans moves */
+        if (xorshift32(&state) % 8 == 0) {
+            uint16_t channel = xorshift32(&state) % channels;
+            uint8_t index = channel / EXPANDER_PINS;
+            s_pins[index] ^= 1u << (channel % EXPANDER_PINS);
+            expander_sim_set_pins(&s_sim, index, s_pins[index]);
+            s_change_start_ns[channel] = s_now_ns;
+        }
+        s_now_ns += 1000000;
+        for (uint8_t i = 0; i < options->expanders; i++) {
+            expander_scan(&expanders[i], s_now_ns / 1000, bench_report, (void *)(uintptr_t)i);
+        }
+    }
+    int64_t cpu_ns = bench_cpu_ns() - start;
+    for (uint8_t i = 0; i < options->expanders; i++) {
+        transfers += expanders[i].stats.transfers;
+    }
+    double per_scan = cpu_ns / (double)options->iterations;
+    printf("\nthroughput, %" PRIu32 " full scans of %u channels (bus model included)\n", options->iterations,
+           channels);
+    printf("  host cpu       %.0f ns per scan, %.1f ns per channel\n", per_scan, per_scan / channels);
+    printf("  scan rate      %.0f scans/s, %.1f M channels/s\n", 1e9 / per_scan, channels * 1e3 / per_scan);
+    printf("  transactions   %.1f per scan\n", transfers / (double)options->iterations);
+}
+
+static int bench_run(const bench_options_t *options)
+{
+    uint16_t channels = options->expanders * EXPANDER_PINS;
+    std::vector<bench_change_t> changes;
+    bench_generate(&changes, channels, options);
+    uint32_t expected = 0;
+    for (const bench_change_t &change : changes) {
+        expected += change.first;
+    }
+
+    expander_sim_init(&s_sim, options->chip, options->expanders);
+    s_chip_map = options->chip == EXPANDER_SIM_MCP23017 ? &expander_regmap_mcp23017 : &expander_regmap_pca9555;
+    const expander_regmap_t *map = options->mode == BENCH_MODE_BULK ? s_chip_map : &k_per_pin_map;
+    for (uint8_t i = 0; i < options->expanders; i++) {
+        s_pins[i] = 0xFFFF;
+    }
+    s_changes = &changes;
+    s_next_change = 0;
+    s_now_ns = 0;
+
+    /* The firmware defaults, see Kconfig: 5 ms settle, leading edge */
+    contact_debounce_config_t db_config = { .settle_us = 5000, .leading_edge = true };
+    expander_bus_t bus = { NULL, bench_bus_read, bench_bus_write };
+    expander_t expanders[EXPANDER_SIM_MAX];
+    for (uint8_t i = 0; i < options->expanders; i++) {
+        expander_err_t err = expander_init(&expanders[i], &bus, map, EXPANDER_SIM_BASE_ADDRESS + i, 0, &db_config,
+                                           s_now_ns / 1000);
+        if (err != EXPANDER_OK) {
+            fprintf(stderr, "expander_init 0x%02x: %s\n", EXPANDER_SIM_BASE_ADDRESS + i, expander_err_name(err));
+            return 1;
+        }
+    }
+    uint32_t setup_reads = s_sim.reads;
+    uint32_t setup_writes = s_sim.writes;
+    uint64_t setup_bits = s_sim.bus_bits;
+    uint64_t setup_bytes = s_sim.bytes;
+
+    /* Event loop: the interrupt line, the earliest settle deadline or the next pin change,
+     * whichever comes first */
+    uint32_t interrupt_scans = 0;
+    uint32_t deadline_scans = 0;
+    uint32_t scans = 0;
+    int64_t cpu_ns = 0;
+    while (true) {
+        int64_t deadline_ns = INT64_MAX;
+        for (uint8_t i = 0; i < options->expanders; i++) {
+            if (expanders[i].settling) {
+                deadline_ns = std::min(deadline_ns, expanders[i].deadline_us * 1000);
+            }
+        }
+        int64_t change_ns = s_next_change < changes.size() ? changes[s_next_change].time_ns : INT64_MAX;
+        bool interrupt = expander_sim_int(&s_sim);
+        if (!interrupt && deadline_ns > s_now_ns && change_ns == INT64_MAX && deadline_ns == INT64_MAX) {
+            break;
+        }
+        if (!interrupt && deadline_ns > s_now_ns) {
+            if (change_ns < deadline_ns) {
+                s_now_ns = std::max(s_now_ns, change_ns);
+                bench_advance();
+                continue;
+            }
+            s_now_ns = std::max(s_now_ns, deadline_ns);
+        }
+
+        int64_t now_us = s_now_ns / 1000;
+        int64_t start = bench_cpu_ns();
+        for (uint8_t i = 0; i < options->expanders; i++) {
+            bool due = expanders[i].settling && expanders[i].deadline_us <= now_us;
+            if (interrupt || due) {
+                expander_scan(&expanders[i], now_us, bench_report, (void *)(uintptr_t)i);
+                scans++;
+            }
+        }
+        cpu_ns += bench_cpu_ns() - start;
+        if (interrupt) {
+            interrupt_scans++;
+        } else {
+            deadline_scans++;
+        }
+    }
+
+    uint32_t mismatched = 0;
+    for (uint16_t channel = 0; channel < channels; channel++) {
+        bool closed = !((s_pins[channel / EXPANDER_PINS] >> (channel % EXPANDER_PINS)) & 1);
+        if (expander_get_closed(&expanders[channel / EXPANDER_PINS], channel % EXPANDER_PINS) != closed) {
+            mismatched++;
+        }
+    }
+    uint32_t changed_bits = 0;
+    for (uint8_t i = 0; i < options->expanders; i++) {
+        changed_bits += expanders[i].stats.changed_bits;
+    }
+
+    uint32_t transactions = s_sim.reads + s_sim.writes - setup_reads - setup_writes;
+    uint64_t bits = s_sim.bus_bits - setup_bits;
+    double duration_s = options->duration_s;
+    printf("mode %s, %u x %s, %u channels, %.0f s, %" PRIu32 " contact changes (%zu edges)\n",
+           options->mode == BENCH_MODE_BULK ? "bulk" : "pin", options->expanders, s_chip_map->name, channels,
+           duration_s, expected, changes.size());
+    printf("  wakeups        %" PRIu32 " interrupt, %" PRIu32 " settle deadline\n", interrupt_scans,
+           deadline_scans);
+    printf("  scans          %" PRIu32 " expander reads, %" PRIu32 " pin changes seen\n", scans, changed_bits);
+    printf("  transactions   %" PRIu32 " (%.1f per expander read, %.1f per reported change)\n", transactions,
+           scans ? transactions / (double)scans : 0.0, s_reports ? transactions / (double)s_reports : 0.0);
+    printf("  bytes read     %" PRIu64 "\n", s_sim.bytes - setup_bytes);
+    printf("  bus time       %.1f ms (%.2f%% of the run at %d kHz)\n", bits * BENCH_NS_PER_BIT / 1e6,
+           bits * BENCH_NS_PER_BIT / 1e7 / duration_s, BENCH_I2C_HZ / 1000);
+    printf("  latency        %.0f us mean, %.0f us max, change to report\n",
+           s_reports ? s_latency_sum_ns / 1e3 / s_reports : 0.0, s_latency_max_ns / 1e3);
+    printf("  reports        %" PRIu32 " of %" PRIu32 " changes, %" PRIu32 " channels wrong at the end\n", s_reports,
+           expected, mismatched);
+    printf("  host cpu       %.0f ns per expander read\n", scans ? cpu_ns / (double)scans : 0.0);
+
+    bench_throughput(expanders, options);
+    return mismatched == 0 ? 0 : 1;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Usage: %s [-n expanders] [-c mcp23017|pca9555] [-m bulk|pin] [-t seconds] [-e events_per_s]\n"
+            "          [-b bounce_us] [-s seed] [-i iterations]\n",
+            argv0);
+    fprintf(stderr, "  -n n      expanders, 16 channels each, 1 to %d (default 8)\n", EXPANDER_SIM_MAX);
+    fprintf(stderr, "  -c chip   simulated chip (default mcp23017)\n");
+    fprintf(stderr, "  -m mode   bulk: both ports in one transaction (default)\n");
+    fprintf(stderr, "            pin: one transaction per pin\n");
+    fprintf(stderr, "  -t s      simulated time (default 60)\n");
+    fprintf(stderr, "  -e n      contact changes per second over all channels (default 50)\n");
+    fprintf(stderr, "  -b us     bounce duration, 0 for clean edges (default 2000)\n");
+    fprintf(stderr, "  -s n      random seed (default 1)\n");
+    fprintf(stderr, "  -i n      full scans of the throughput run, 0 to skip (default 100000)\n");
+}
+
+int main(int argc, char **argv)
+{
+    bench_options_t options = {
+        .expanders = 8,
+        .chip = EXPANDER_SIM_MCP23017,
+        .mode = BENCH_MODE_BULK,
+        .duration_s = 60,
+        .events_per_s = 50,
+        .bounce_us = 2000,
+        .seed = 1,
+        .iterations = 100000,
+    };
+    int opt;
+    while ((opt = getopt(argc, argv, "n:c:m:t:e:b:s:i:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            options.expanders = (uint8_t)atoi(optarg);
+            break;
+        case 'c':
+            if (strcmp(optarg, "mcp23017") == 0) {
+                options.chip = EXPANDER_SIM_MCP23017;
+            } else if (strcmp(optarg, "pca9555") == 0) {
+                options.chip = EXPANDER_SIM_PCA9555;
+            } else {
+                fprintf(stderr, "invalid chip: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'm':
+            if (strcmp(optarg, "bulk") == 0) {
+                options.mode = BENCH_MODE_BULK;
+            } else if (strcmp(optarg, "pin") == 0) {
+                options.mode = BENCH_MODE_PIN;
+            } else {
+                fprintf(stderr, "invalid mode: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 't':
+            options.duration_s = (uint32_t)atoi(optarg);
+            break;
+        case 'e':
+            options.events_per_s = (uint32_t)atoi(optarg);
+            break;
+        case 'b':
+            options.bounce_us = (uint32_t)atoi(optarg);
+            break;
+        case 's':
+            options.seed = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'i':
+            options.iterations = (uint32_t)atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc || options.expanders < 1 || options.expanders > EXPANDER_SIM_MAX || options.duration_s < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+    return bench_run(&options);
+}
@@ -0,0 +1,182 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "expander_sim.h"
+
+/* MCP23017, IOCON.BANK = 0: port A register at even, port B at odd addresses */
+#define SIM_MCP_IODIRA 0x00
+#define SIM_MCP_IPOLA 0x02
+#define SIM_MCP_GPINTENA 0x04
+#define SIM_MCP_IOCON 0x0A
+#define SIM_MCP_IOCON_B 0x0B
+#define SIM_MCP_INTFA 0x0E
+#define SIM_MCP_INTCAPA 0x10
+#define SIM_MCP_GPIOA 0x12
+#define SIM_MCP_OLATA 0x14
+
+/* PCA9555: registers in pairs, the address wraps inside the pair */
+#define SIM_PCA_INPUT0 0x00
+#define SIM_PCA_OUTPUT0 0x02
+#define SIM_PCA_POLARITY0 0x04
+#define SIM_PCA_CONFIG0 0x06
+
+void expander_sim_init(expander_sim_t *sim, expander_sim_chip_t chip, uint8_t count)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->chip = chip;
+    sim->count = count > EXPANDER_SIM_MAX ? EXPANDER_SIM_MAX : count;
+    for (uint8_t i = 0; i < sim->count; i++) {
+        expander_sim_device_t *dev = &sim->devices[i];
+        dev->pins = 0xFFFF;
+        dev->reference = 0xFFFF;
+        if (chip == EXPANDER_SIM_MCP23017) {
+            dev->regs[SIM_MCP_IODIRA] = 0xFF;
+            dev->regs[SIM_MCP_IODIRA + 1] = 0xFF;
+        } else {
+            dev->regs[SIM_PCA_OUTPUT0] = 0xFF;
+            dev->regs[SIM_PCA_OUTPUT0 + 1] = 0xFF;
+            dev->regs[SIM_PCA_CONFIG0] = 0xFF;
+            dev->regs[SIM_PCA_CONFIG0 + 1] = 0xFF;
+        }
+    }
+}
+
+static expander_sim_device_t *sim_device(expander_sim_t *sim, uint8_t address)
+{
+    uint8_t index = address - EXPANDER_SIM_BASE_ADDRESS;
+    return address >= EXPANDER_SIM_BASE_ADDRESS && index < sim->count ? &sim->devices[index] : NULL;
+}
+
+static uint16_t sim_pair(const expander_sim_device_t *dev, uint8_t reg)
+{
+    return dev->regs[reg] | (dev->regs[reg + 1] << 8);
+}
+
+/* Pins changed since the last port read, among those with the interrupt enabled */
+static uint16_t sim_pending(const expander_sim_t *sim, const expander_sim_device_t *dev)
+{
+    uint16_t changed = dev->pins ^ dev->reference;
+    if (sim->chip == EXPANDER_SIM_MCP23017) {
+        return changed & sim_pair(dev, SIM_MCP_GPINTENA) & sim_pair(dev, SIM_MCP_IODIRA);
+    }
+    return changed & sim_pair(dev, SIM_PCA_CONFIG0);
+}
+
+void expander_sim_set_pins(expander_sim_t *sim, uint8_t index, uint16_t pins)
+{
+    expander_sim_device_t *dev = &sim->devices[index];
+    uint16_t before = sim_pending(sim, dev);
+    dev->pins = pins;
+    if (sim->chip == EXPANDER_SIM_MCP23017 && !before) {
+        /* The first change captures the port and the pins that caused it */
+        uint16_t flags = sim_pending(sim, dev);
+        dev->regs[SIM_MCP_INTFA] = flags & 0xFF;
+        dev->regs[SIM_MCP_INTFA + 1] = flags >> 8;
+        dev->regs[SIM_MCP_INTCAPA] = pins & 0xFF;
+        dev->regs[SIM_MCP_INTCAPA + 1] = pins >> 8;
+    }
+}
+
+bool expander_sim_int(const expander_sim_t *sim)
+{
+    for (uint8_t i = 0; i < sim->count; i++) {
+        /* The PCA9555 drops the interrupt when the input goes back, the MCP23017 holds it
+         * until the port is read */
+        if (sim->chip == EXPANDER_SIM_MCP23017 ? sim_pair(&sim->devices[i], SIM_MCP_INTFA) != 0
+                                                : sim_pending(sim, &sim->devices[i]) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint8_t sim_read_register(expander_sim_t *sim, expander_sim_device_t *dev, uint8_t reg)
+{
+    if (sim->chip == EXPANDER_SIM_MCP23017) {
+        if (reg == SIM_MCP_GPIOA || reg == SIM_MCP_GPIOA + 1 || reg == SIM_MCP_INTCAPA ||
+            reg == SIM_MCP_INTCAPA + 1) {
+            /* Reading either port or capture register clears the interrupt */
+            uint16_t polarity = sim_pair(dev, SIM_MCP_IPOLA);
+            uint16_t value = reg >= SIM_MCP_GPIOA ? dev->pins : sim_pair(dev, SIM_MCP_INTCAPA);
+            dev->reference = dev->pins;
+            dev->regs[SIM_MCP_INTFA] = 0;
+            dev->regs[SIM_MCP_INTFA + 1] = 0;
+            value ^= polarity;
+            return (reg & 1) ? value >> 8 : value & 0xFF;
+        }
+        return dev->regs[reg];
+    }
+    if (reg == SIM_PCA_INPUT0 || reg == SIM_PCA_INPUT0 + 1) {
+        uint16_t value = dev->pins ^ sim_pair(dev, SIM_PCA_POLARITY0);
+        dev->reference = dev->pins;
+        return (reg & 1) ? value >> 8 : value & 0xFF;
+    }
+    return dev->regs[reg];
+}
+
+static uint8_t sim_next_register(const expander_sim_t *sim, uint8_t reg)
+{
+    if (sim->chip == EXPANDER_SIM_MCP23017) {
+        /* Sequential mode (IOCON.SEQOP = 0), wrapping after the last register */
+        return (reg + 1) % (SIM_MCP_OLATA + 2);
+    }
+    return reg ^ 1;
+}
+
+static int sim_bus_read(void *ctx, uint8_t address, uint8_t reg, uint8_t *buf, size_t len)
+{
+    expander_sim_t *sim = (expander_sim_t *)ctx;
+    sim->reads++;
+    /* start, address+W, register, repeated start, address+R, data, stop */
+    sim->bus_bits += 3 + 9 * 3 + 9 * len;
+    expander_sim_device_t *dev = sim_device(sim, address);
+    uint8_t size = sim->chip == EXPANDER_SIM_MCP23017 ? SIM_MCP_OLATA + 2 : SIM_PCA_CONFIG0 + 2;
+    if (!dev || reg >= size) {
+        return -1;
+    }
+    sim->bytes += len;
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = sim_read_register(sim, dev, reg);
+        reg = sim_next_register(sim, reg);
+    }
+    return 0;
+}
+
+static int sim_bus_write(void *ctx, uint8_t address, uint8_t reg, const uint8_t *buf, size_t len)
+{
+    expander_sim_t *sim = (expander_sim_t *)ctx;
+    sim->writes++;
+    sim->bus_bits += 2 + 9 * (2 + len);
+    expander_sim_device_t *dev = sim_device(sim, address);
+    uint8_t size = sim->chip == EXPANDER_SIM_MCP23017 ? SIM_MCP_OLATA + 2 : SIM_PCA_CONFIG0 + 2;
+    if (!dev || reg >= size) {
+        return -1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (sim->chip == EXPANDER_SIM_MCP23017) {
+            if (reg == SIM_MCP_IOCON || reg == SIM_MCP_IOCON_B) {
+                /* One register at two addresses; BANK = 1 is not modelled */
+                dev->regs[SIM_MCP_IOCON] = dev->regs[SIM_MCP_IOCON_B] = buf[i] & 0x7E;
+            } else if (reg != SIM_MCP_INTFA && reg != SIM_MCP_INTFA + 1 && reg != SIM_MCP_INTCAPA &&
+                       reg != SIM_MCP_INTCAPA + 1 && reg != SIM_MCP_GPIOA && reg != SIM_MCP_GPIOA + 1) {
+                dev->regs[reg] = buf[i];
+            }
+        } else if (reg != SIM_PCA_INPUT0 && reg != SIM_PCA_INPUT0 + 1) {
+            dev->regs[reg] = buf[i];
+        }
+        reg = sim_next_register(sim, reg);
+    }
+    return 0;
+}
+
+expander_bus_t expander_sim_bus(expander_sim_t *sim)
+{
+    return { sim, sim_bus_read, sim_bus_write };
+}
@@ -0,0 +1,57 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gpio_expander.h"
+
+/*
+ * Simulated I2C GPIO expanders behind an expander_bus_t: up to eight MCP23017 or PCA9555
+ * at consecutive addresses, their register files, the interrupt on change (cleared by
+ * reading the port, wired-OR on one line) and bus traffic accounting (transactions, bytes,
+ * bit times on the wire).
+ */
+
+#define EXPANDER_SIM_MAX 8
+#define EXPANDER_SIM_BASE_ADDRESS 0x20
+
+typedef enum {
+    EXPANDER_SIM_MCP23017 = 0,
+    EXPANDER_SIM_PCA9555,
+} expander_sim_chip_t;
+
+typedef struct {
+    uint8_t regs[0x16];
+    uint16_t pins;      /* levels applied to the pins */
+    uint16_t reference; /* levels the interrupt compares against, latched by a port read */
+} expander_sim_device_t;
+
+typedef struct {
+    expander_sim_chip_t chip;
+    uint8_t count;
+    expander_sim_device_t devices[EXPANDER_SIM_MAX];
+    uint32_t reads;
+    uint32_t writes;
+    uint64_t bytes;
+    uint64_t bus_bits; /* SCL cycles, start/stop conditions included */
+} expander_sim_t;
+
+/** Power on `count` chips, every pin pulled high */
+void expander_sim_init(expander_sim_t *sim, expander_sim_chip_t chip, uint8_t count);
+
+/** Drive the pins of one chip */
+void expander_sim_set_pins(expander_sim_t *sim, uint8_t index, uint16_t pins);
+
+/** Level of the shared interrupt line, true while a chip pulls it */
+bool expander_sim_int(const expander_sim_t *sim);
+
+/** Bus backed by the simulated chips */
+expander_bus_t expander_sim_bus(expander_sim_t *sim);
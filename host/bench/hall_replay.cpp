@@ -0,0 +1,259 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Replays a magnetic field recording through the Hall sensor position detector.
+ *
+ *     hall_replay [-v] [-f type1|type2] [-r sample_hz] [-d decimation] [-b frame_bytes] <recording>
+ *
+ * The recording is rendered into the conversion words the ADC continuous driver leaves in its
+ * DMA frames (sensor offset and gain, noise, 50 Hz pickup, 12-bit clipping), then handed to
+ * the detector one frame at a time as the firmware task does (main/app_hall.cpp).
+ *
+ * Prints the state and position events with their recording time and how well the state
+ * follows the labels of the recording, then the host CPU time per conversion for a range of
+ * frame sizes: one word per call is what reading the ADC sample by sample would cost.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hall_sense.h"
+#include "hall_sim.h"
+
+/* TYPE2 words of the ESP32-C3/C6/H2: data(12) reserved(1) channel(3) unit(1) */
+static const hall_frame_format_t k_frame_type2 = {
+    .word_bytes = 4,
+    .channel_shift = 13,
+    .channel_mask = 0x7,
+    .data_mask = 0xFFF,
+};
+
+/* Sensor of the firmware defaults, see Kconfig: DRV5055A3 at 3.3 V (15 mV/mT, 1650 mV at
+ * zero field) on ADC1 channel 3 at 12 dB, about 0.806 mV per count */
+#define REPLAY_CHANNEL 3
+#define REPLAY_ZERO_COUNTS 2048
+#define REPLAY_UT_PER_COUNT (0.806 / 15 * 1000)
+#define REPLAY_NOISE_COUNTS 2.0
+#define REPLAY_HUM_COUNTS 3.0
+
+/* Labels are not scored this long after they change: dwell plus the decimation window */
+#define REPLAY_SETTLE_MS 500
+
+static bool s_verbose = false;
+
+static int64_t replay_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void replay_print_gap(uint16_t gap_mm)
+{
+    if (gap_mm == HALL_GAP_UNKNOWN) {
+        printf("out of range");
+    } else {
+        printf("%u mm", gap_mm);
+    }
+}
+
+static void replay_report(const hall_sense_t *hs, uint8_t events, double time_ms)
+{
+    if (events & HALL_EVENT_STATE) {
+        printf("%9.1f ms  %-7s field %" PRId32 " uT, gap ", time_ms, hall_state_name(hs->state), hs->field_ut);
+        replay_print_gap(hs->gap_mm);
+        printf("\n");
+    } else if ((events & HALL_EVENT_POSITION) && s_verbose) {
+        printf("%9.1f ms  position ", time_ms);
+        replay_print_gap(hs->reported_gap_mm);
+        printf("\n");
+    }
+}
+
+static int replay(const hall_recording_t *recording, const hall_frame_format_t *format, uint32_t sample_hz,
+                  uint16_t decimation, size_t frame_bytes)
+{
+    hall_sim_config_t sim = {
+        .format = *format,
+        .channel = REPLAY_CHANNEL,
+        .sample_hz = sample_hz,
+        .zero_counts = REPLAY_ZERO_COUNTS,
+        .ut_per_count = REPLAY_UT_PER_COUNT,
+        .noise_counts = REPLAY_NOISE_COUNTS,
+        .hum_counts = REPLAY_HUM_COUNTS,
+        .seed = 1,
+    };
+    std::vector<uint8_t> stream;
+    hall_sim_render(&sim, recording, &stream);
+    if (stream.empty()) {
+        fprintf(stderr, "recording too short\n");
+        return 1;
+    }
+
+    /* The thresholds of the firmware defaults, see Kconfig */
+    hall_config_t config = {
+        .format = *format,
+        .channel = REPLAY_CHANNEL,
+        .sample_hz = sample_hz,
+        .decimation = decimation,
+        .zero_counts = REPLAY_ZERO_COUNTS,
+        .ut_per_count_q8 = (int32_t)(REPLAY_UT_PER_COUNT * 256 + 0.5),
+        .closed_ut = 20000,
+        .magnet_mm = 10,
+        .closed_mm = 3,
+        .open_mm = 40,
+        .hysteresis_mm = 2,
+        .tamper_pct = 150,
+        .dwell_ms = 200,
+        .report_step_mm = 2,
+    };
+    hall_sense_t hs;
+    if (!hall_sense_init(&hs, &config)) {
+        fprintf(stderr, "invalid detector configuration\n");
+        return 1;
+    }
+
+    /* Label changes, for scoring */
+    std::vector<double> changes;
+    for (size_t i = 1; i < recording->size(); i++) {
+        if ((*recording)[i].label != (*recording)[i - 1].label) {
+            changes.push_back((*recording)[i].time_ms);
+        }
+    }
+
+    double start_ms = recording->front().time_ms;
+    size_t words = stream.size() / format->word_bytes;
+    double ms_per_word = 1000.0 / sample_hz;
+    uint32_t state_events = 0;
+    uint32_t position_events = 0;
+    uint32_t scored = 0;
+    uint32_t agreed = 0;
+    uint32_t frames = 0;
+    size_t change = 0;
+    for (size_t offset = 0; offset < stream.size(); offset += frame_bytes) {
+        size_t len = stream.size() - offset < frame_bytes ? stream.size() - offset : frame_bytes;
+        uint8_t events = hall_sense_feed(&hs, stream.data() + offset, len);
+        frames++;
+        double time_ms = start_ms + (offset + len) / format->word_bytes * ms_per_word;
+        if (events) {
+            replay_report(&hs, events, time_ms);
+            state_events += (events & HALL_EVENT_STATE) ? 1 : 0;
+            position_events += (events & HALL_EVENT_POSITION) ? 1 : 0;
+        }
+        while (change < changes.size() && changes[change] + REPLAY_SETTLE_MS <= time_ms) {
+            change++;
+        }
+        bool settling = change < changes.size() && changes[change] <= time_ms;
+        int8_t label = hall_recording_label_at(recording, time_ms);
+        if (hs.started && label >= 0 && !settling) {
+            scored++;
+            agreed += label == hs.state ? 1 : 0;
+        }
+    }
+
+    double duration_s = words / (double)sample_hz;
+    printf("\n%s words, %" PRIu32 " Hz, decimation %u (%.1f ms window), %zu byte frames, %.1f s of conversions\n",
+           format->word_bytes == 2 ? "type1" : "type2", sample_hz, decimation, decimation * ms_per_word, frame_bytes,
+           duration_s);
+    printf("  conversions    %" PRIu32 ", %" PRIu32 " of another channel\n", hs.words, hs.foreign);
+    printf("  field samples  %" PRIu32 " (%.1f per second)\n", hs.samples, hs.samples / duration_s);
+    printf("  frames         %" PRIu32 " (%.1f task wakeups per second)\n", frames, frames / duration_s);
+    printf("  events         %" PRIu32 " state, %" PRIu32 " position\n", state_events, position_events);
+    if (scored) {
+        printf("  agreement      %.2f%% of %" PRIu32 " frames (%d ms after each label change not scored)\n",
+               agreed * 100.0 / scored, scored, REPLAY_SETTLE_MS);
+    }
+
+    /* Throughput: the same stream in frames of every size, repeated for a stable figure */
+    printf("\n  frame bytes  ns per conversion  conversions/s   x realtime\n");
+    const size_t sizes[] = { format->word_bytes, 64, 256, 1024, 4096 };
+    for (size_t size : sizes) {
+        uint64_t converted = 0;
+        int64_t cpu_ns = 0;
+        volatile uint8_t sink = 0;
+        while (cpu_ns < 200000000) {
+            hall_sense_init(&hs, &config);
+            int64_t start = replay_now_ns();
+            for (size_t offset = 0; offset < stream.size(); offset += size) {
+                size_t len = stream.size() - offset < size ? stream.size() - offset : size;
+                sink = sink + hall_sense_feed(&hs, stream.data() + offset, len);
+            }
+            cpu_ns += replay_now_ns() - start;
+            converted += words;
+        }
+        double ns = cpu_ns / (double)converted;
+        printf("  %11zu  %17.2f  %13.0f  %11.0f\n", size, ns, 1e9 / ns, 1e9 / ns / sample_hz);
+    }
+    return 0;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "Usage: %s [-v] [-f type1|type2] [-r sample_hz] [-d decimation] [-b frame_bytes] <recording>\n",
+            argv0);
+    fprintf(stderr, "  -f fmt    DMA word format: type1 (ESP32, ESP32-S2, default) or type2\n");
+    fprintf(stderr, "  -r hz     conversion rate (default 20000)\n");
+    fprintf(stderr, "  -d n      conversions per field sample, 1 to %d (default 400)\n", HALL_MAX_DECIMATION);
+    fprintf(stderr, "  -b bytes  DMA frame size (default 1024)\n");
+    fprintf(stderr, "  -v        print position events too\n");
+}
+
+int main(int argc, char **argv)
+{
+    const hall_frame_format_t *format = &hall_frame_type1;
+    int sample_hz = 20000;
+    int decimation = 400;
+    int frame_bytes = 1024;
+    int opt;
+    while ((opt = getopt(argc, argv, "vf:r:d:b:h")) != -1) {
+        switch (opt) {
+        case 'v':
+            s_verbose = true;
+            break;
+        case 'f':
+            if (strcmp(optarg, "type1") == 0) {
+                format = &hall_frame_type1;
+            } else if (strcmp(optarg, "type2") == 0) {
+                format = &k_frame_type2;
+            } else {
+                fprintf(stderr, "invalid format: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'r':
+            sample_hz = atoi(optarg);
+            break;
+        case 'd':
+            decimation = atoi(optarg);
+            break;
+        case 'b':
+            frame_bytes = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc - 1 || sample_hz < 1000 || sample_hz > 2000000 || decimation < 1 ||
+        decimation > HALL_MAX_DECIMATION || frame_bytes < format->word_bytes || frame_bytes % format->word_bytes) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    hall_recording_t recording;
+    if (hall_recording_load(argv[optind], &recording) != 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+    return replay(&recording, format, (uint32_t)sample_hz, (uint16_t)decimation, (size_t)frame_bytes);
+}
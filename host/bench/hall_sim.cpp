@@ -0,0 +1,114 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "hall_sim.h"
+
+int hall_recording_load(const char *path, hall_recording_t *recording)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return -1;
+    }
+    recording->clear();
+    char line[256];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        double time_ms;
+        int field;
+        char label[16];
+        int fields = sscanf(line, "%lf %d %15s", &time_ms, &field, label);
+        if (fields <= 0) {
+            continue;
+        }
+        int8_t state = -1;
+        if (fields == 3) {
+            for (int i = 0; i < HALL_STATE_MAX; i++) {
+                if (strcmp(label, hall_state_name((hall_state_t)i)) == 0) {
+                    state = (int8_t)i;
+                }
+            }
+        }
+        if (fields < 2 || (fields == 3 && state < 0)) {
+            fprintf(stderr, "%s:%d: expected <time_ms> <field_ut> [closed|ajar|open|tamper]\n", path, lineno);
+            fclose(f);
+            errno = EINVAL;
+            return -1;
+        }
+        recording->push_back({ time_ms, field, state });
+    }
+    fclose(f);
+    return 0;
+}
+
+int8_t hall_recording_label_at(const hall_recording_t *recording, double time_ms)
+{
+    auto it = std::upper_bound(recording->begin(), recording->end(), time_ms,
+                               [](double t, const hall_record_t &record) { return t < record.time_ms; });
+    return it == recording->begin() ? -1 : (it - 1)->label;
+}
+
+/* xorshift32 and Box-Muller: the same noise for the same seed on every host */
+static uint32_t sim_next(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static double sim_gaussian(uint32_t *state)
+{
+    double u1 = (sim_next(state) + 1.0) / 4294967297.0;
+    double u2 = sim_next(state) / 4294967296.0;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+void hall_sim_render(const hall_sim_config_t *config, const hall_recording_t *recording, std::vector<uint8_t> *stream)
+{
+    stream->clear();
+    if (recording->size() < 2) {
+        return;
+    }
+    const hall_frame_format_t *format = &config->format;
+    double start_ms = recording->front().time_ms;
+    double span_ms = recording->back().time_ms - start_ms;
+    size_t conversions = (size_t)(span_ms * config->sample_hz / 1000.0);
+    stream->resize(conversions * format->word_bytes);
+    uint32_t seed = config->seed ? config->seed : 1;
+    size_t record = 0;
+    for (size_t i = 0; i < conversions; i++) {
+        double t = start_ms + i * 1000.0 / config->sample_hz;
+        while (record + 2 < recording->size() && (*recording)[record + 1].time_ms <= t) {
+            record++;
+        }
+        const hall_record_t &a = (*recording)[record];
+        const hall_record_t &b = (*recording)[record + 1];
+        double f = b.time_ms > a.time_ms ? (t - a.time_ms) / (b.time_ms - a.time_ms) : 0.0;
+        double field = a.field_ut + (b.field_ut - a.field_ut) * std::min(std::max(f, 0.0), 1.0);
+        double counts = config->zero_counts + field / config->ut_per_count + config->noise_counts * sim_gaussian(&seed) +
+                        config->hum_counts * sin(2.0 * M_PI * 50.0 * t / 1000.0);
+        long data = lround(counts);
+        data = std::min<long>(std::max<long>(data, 0), format->data_mask);
+        uint32_t word = (uint32_t)data | ((uint32_t)config->channel << format->channel_shift);
+        memcpy(stream->data() + i * format->word_bytes, &word, format->word_bytes);
+    }
+}
@@ -0,0 +1,62 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "hall_sense.h"
+
+/*
+ * Simulated Hall sensor behind the ADC continuous driver: a field recording is resampled to
+ * the conversion rate, turned into 12-bit conversions (sensor gain and offset, Gaussian
+ * noise, mains hum, clipping) and packed into DMA words as the driver leaves them.
+ *
+ * Recordings are text files, one field sample per line, `#` starts a comment:
+ *     <time_ms> <field_ut> [closed|ajar|open|tamper]
+ * The optional label is the true door state, used to score the classification.
+ */
+
+typedef struct {
+    double time_ms;
+    int32_t field_ut;
+    int8_t label; /* hall_state_t, -1 without a label */
+} hall_record_t;
+
+typedef std::vector<hall_record_t> hall_recording_t;
+
+/** Load a recording
+ *
+ * @return 0 on success, -1 on error (errno set).
+ */
+int hall_recording_load(const char *path, hall_recording_t *recording);
+
+typedef struct {
+    hall_frame_format_t format;
+    uint8_t channel;
+    uint32_t sample_hz;
+    int32_t zero_counts;   /* conversion at zero field */
+    double ut_per_count;
+    double noise_counts;   /* standard deviation */
+    double hum_counts;     /* amplitude of the 50 Hz pickup */
+    uint32_t seed;
+} hall_sim_config_t;
+
+/** Render the conversions of a whole recording
+ *
+ * @param[in] config Sensor and ADC.
+ * @param[in] recording Field samples.
+ * @param[out] stream DMA words, `config->format.word_bytes` each, from the first record on.
+ */
+void hall_sim_render(const hall_sim_config_t *config, const hall_recording_t *recording, std::vector<uint8_t> *stream);
+
+/** Label of the recording at a time: the one of the last record at or before it, -1 if none */
+int8_t hall_recording_label_at(const hall_recording_t *recording, double time_ms);
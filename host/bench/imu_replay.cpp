@@ -0,0 +1,244 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Replays an accelerometer recording through the IMU driver and the motion detector.
+ *
+ *     imu_replay [-v] [-w watermark] [-m burst|poll] [-r range_g] <recording>
+ *
+ * The samples are pushed into a simulated LIS3DH at the recording rate. Two ways of reading
+ * them are compared on the same bus model:
+ *     burst  FIFO in stream mode, drained with one level read and one burst read each time
+ *            the watermark interrupt rises (the firmware driver, main/app_imu.cpp)
+ *     poll   FIFO off, the status register and then the output registers read for every
+ *            sample
+ *
+ * Prints the detector events with their recording time, then the bus traffic: transactions
+ * per sample, bytes, time on a 400 kHz I2C bus (what keeps the radio and the CPU from sleeping)
+ * and the host CPU time per sample.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "imu_sim.h"
+#include "motion_detect.h"
+
+#define REPLAY_I2C_HZ 400000
+#define REPLAY_STATUS_REG 0x27
+#define REPLAY_STATUS_ZYXDA 0x08
+#define REPLAY_OUT_X_L 0x28
+#define REPLAY_AUTO_INCREMENT 0x80
+#define REPLAY_CTRL_REG5 0x24
+#define REPLAY_FIFO_CTRL_REG 0x2E
+
+typedef enum {
+    REPLAY_MODE_BURST = 0,
+    REPLAY_MODE_POLL,
+} replay_mode_t;
+
+static bool s_verbose = false;
+
+static int64_t replay_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void replay_report(const motion_detect_t *md, uint8_t events, double time_ms, uint32_t *event_count)
+{
+    if (events & MOTION_EVENT_KNOCK) {
+        printf("%9.1f ms  knock (peak %u mg, %" PRIu32 " total)\n", time_ms, md->peak_mg, md->knocks);
+        (*event_count)++;
+    }
+    if (events & MOTION_EVENT_VIBRATION) {
+        if (md->vibrating) {
+            printf("%9.1f ms  vibration start\n", time_ms);
+        } else {
+            printf("%9.1f ms  vibration end (peak %u mg)\n", time_ms, md->peak_mg);
+        }
+        (*event_count)++;
+    }
+    if (events & MOTION_EVENT_TILT) {
+        printf("%9.1f ms  tilt %s\n", time_ms, md->tilted ? "start" : "end");
+        (*event_count)++;
+    }
+}
+
+/* One sample read without the FIFO: wait for data ready, then the six output registers */
+static bool replay_poll_sample(imu_t *imu, imu_sample_t *sample)
+{
+    uint8_t status = 0;
+    imu->stats.transfers++;
+    if (imu->bus.read(imu->bus.ctx, REPLAY_STATUS_REG, &status, 1) != 0 || !(status & REPLAY_STATUS_ZYXDA)) {
+        return false;
+    }
+    uint8_t raw[6];
+    imu->stats.transfers++;
+    if (imu->bus.read(imu->bus.ctx, REPLAY_OUT_X_L | REPLAY_AUTO_INCREMENT, raw, sizeof(raw)) != 0) {
+        return false;
+    }
+    imu->stats.bytes += 1 + sizeof(raw);
+    int16_t counts[3];
+    imu->map->decode(raw, counts);
+    sample->x = counts[0] * imu->mg_per_lsb;
+    sample->y = counts[1] * imu->mg_per_lsb;
+    sample->z = counts[2] * imu->mg_per_lsb;
+    imu->stats.samples++;
+    return true;
+}
+
+static int replay(const imu_recording_t *recording, replay_mode_t mode, uint8_t watermark, uint8_t range_g)
+{
+    uint16_t odr = imu_recording_rate_hz(recording);
+    if (odr == 0) {
+        fprintf(stderr, "recording too short\n");
+        return 1;
+    }
+
+    imu_sim_t sim;
+    imu_sim_init(&sim);
+    imu_bus_t bus = imu_sim_bus(&sim);
+    imu_config_t config = { .odr_hz = odr, .range_g = range_g, .watermark = watermark };
+    imu_t imu;
+    imu_err_t err = imu_init(&imu, &bus, &imu_regmap_lis3dh, &config);
+    if (err != IMU_OK) {
+        fprintf(stderr, "imu_init: %s\n", imu_err_name(err));
+        return 1;
+    }
+    if (mode == REPLAY_MODE_POLL) {
+        bus.write(bus.ctx, REPLAY_FIFO_CTRL_REG, 0);
+        bus.write(bus.ctx, REPLAY_CTRL_REG5, 0);
+    }
+    if (imu.config.odr_hz != odr) {
+        printf("recording at %u Hz, sensor at %u Hz: samples are pushed at the recording rate\n", odr,
+               imu.config.odr_hz);
+    }
+
+    /* The detector thresholds of the firmware defaults, see Kconfig */
+    motion_config_t motion = {
+        .odr_hz = odr,
+        .knock_mg = 400,
+        .knock_max_ms = 150,
+        .vibration_mg = 60,
+        .vibration_ms = 1000,
+        .tilt_deg = 20,
+    };
+    motion_detect_t md;
+    motion_detect_init(&md, &motion);
+
+    uint32_t setup_reads = sim.reads;
+    uint32_t setup_writes = sim.writes;
+    uint64_t setup_bits = sim.bus_bits;
+    uint64_t setup_bytes = sim.bytes;
+
+    uint32_t events = 0;
+    uint32_t wakeups = 0;
+    imu_sample_t batch[32];
+    int64_t cpu_ns = 0;
+    for (const imu_record_t &record : *recording) {
+        imu_sim_push(&sim, &record.mg);
+        int64_t start = replay_now_ns();
+        size_t count = 0;
+        if (mode == REPLAY_MODE_BURST) {
+            if (imu_sim_int1(&sim)) {
+                count = imu_drain(&imu, batch, sizeof(batch) / sizeof(batch[0]));
+                wakeups++;
+            }
+        } else if (replay_poll_sample(&imu, &batch[0])) {
+            count = 1;
+            wakeups++;
+        }
+        uint8_t flags = count > 0 ? motion_detect_feed(&md, batch, count) : 0;
+        cpu_ns += replay_now_ns() - start;
+        if (flags) {
+            replay_report(&md, flags, record.time_ms, &events);
+        }
+        if (s_verbose && count > 0) {
+            printf("%9.1f ms  %zu samples, envelope %" PRIu32 "\n", record.time_ms, count, md.envelope);
+        }
+    }
+
+    uint32_t samples = imu.stats.samples;
+    uint32_t transactions = sim.reads + sim.writes - setup_reads - setup_writes;
+    uint64_t bits = sim.bus_bits - setup_bits;
+    double duration_s = recording->size() / (double)odr;
+    printf("\nmode %s, %u Hz, %u g, watermark %u, %.1f s of samples\n", mode == REPLAY_MODE_BURST ? "burst" : "poll",
+           imu.config.odr_hz, imu.config.range_g, mode == REPLAY_MODE_BURST ? watermark : 0, duration_s);
+    printf("  samples        %" PRIu32 " of %zu pushed, %" PRIu32 " overruns\n", samples, recording->size(),
+           imu.stats.overruns);
+    printf("  wakeups        %" PRIu32 " (%.1f per second)\n", wakeups, wakeups / duration_s);
+    printf("  transactions   %" PRIu32 " (%.2f per sample)\n", transactions,
+           samples ? transactions / (double)samples : 0.0);
+    printf("  bytes read     %" PRIu64 "\n", sim.bytes - setup_bytes);
+    printf("  bus time       %.1f ms (%.2f%% of the recording at %d kHz)\n", bits * 1000.0 / REPLAY_I2C_HZ,
+           bits * 100.0 / REPLAY_I2C_HZ / duration_s, REPLAY_I2C_HZ / 1000);
+    printf("  host cpu       %.0f ns per sample\n", samples ? cpu_ns / (double)samples : 0.0);
+    printf("  events         %" PRIu32 " (knocks %" PRIu32 ")\n", events, md.knocks);
+    return 0;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "Usage: %s [-v] [-w watermark] [-m burst|poll] [-r range_g] <recording>\n", argv0);
+    fprintf(stderr, "  -w n      FIFO watermark in samples, 1 to 31 (default 25)\n");
+    fprintf(stderr, "  -m mode   burst: FIFO drained on the watermark interrupt (default)\n");
+    fprintf(stderr, "            poll: output registers read for every sample\n");
+    fprintf(stderr, "  -r g      full scale (default 4)\n");
+    fprintf(stderr, "  -v        print every drain\n");
+}
+
+int main(int argc, char **argv)
+{
+    replay_mode_t mode = REPLAY_MODE_BURST;
+    int watermark = 25;
+    int range_g = 4;
+    int opt;
+    while ((opt = getopt(argc, argv, "vw:m:r:h")) != -1) {
+        switch (opt) {
+        case 'v':
+            s_verbose = true;
+            break;
+        case 'w':
+            watermark = atoi(optarg);
+            break;
+        case 'm':
+            if (strcmp(optarg, "burst") == 0) {
+                mode = REPLAY_MODE_BURST;
+            } else if (strcmp(optarg, "poll") == 0) {
+                mode = REPLAY_MODE_POLL;
+            } else {
+                fprintf(stderr, "invalid mode: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'r':
+            range_g = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc - 1 || watermark < 1 || watermark > 31 || range_g < 1 || range_g > 16) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    imu_recording_t recording;
+    if (imu_recording_load(argv[optind], &recording) != 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+    return replay(&recording, mode, (uint8_t)watermark, (uint8_t)range_g);
+}
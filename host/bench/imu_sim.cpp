@@ -0,0 +1,196 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "imu_sim.h"
+
+#define SIM_WHO_AM_I 0x0F
+#define SIM_CTRL_REG1 0x20
+#define SIM_CTRL_REG3 0x22
+#define SIM_CTRL_REG4 0x23
+#define SIM_CTRL_REG5 0x24
+#define SIM_STATUS_REG 0x27
+#define SIM_OUT_X_L 0x28
+#define SIM_OUT_Z_H 0x2D
+#define SIM_FIFO_CTRL_REG 0x2E
+#define SIM_FIFO_SRC_REG 0x2F
+#define SIM_AUTO_INCREMENT 0x80
+#define SIM_FIFO_DEPTH 32
+
+int imu_recording_load(const char *path, imu_recording_t *recording)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return -1;
+    }
+    recording->clear();
+    char line[256];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        double time_ms;
+        int x, y, z;
+        int fields = sscanf(line, "%lf %d %d %d", &time_ms, &x, &y, &z);
+        if (fields <= 0) {
+            continue;
+        }
+        if (fields != 4) {
+            fprintf(stderr, "%s:%d: expected <time_ms> <x_mg> <y_mg> <z_mg>\n", path, lineno);
+            fclose(f);
+            errno = EINVAL;
+            return -1;
+        }
+        recording->push_back({ time_ms, { (int16_t)x, (int16_t)y, (int16_t)z } });
+    }
+    fclose(f);
+    return 0;
+}
+
+uint16_t imu_recording_rate_hz(const imu_recording_t *recording)
+{
+    if (recording->size() < 2) {
+        return 0;
+    }
+    std::vector<double> intervals;
+    for (size_t i = 1; i < recording->size(); i++) {
+        intervals.push_back((*recording)[i].time_ms - (*recording)[i - 1].time_ms);
+    }
+    std::nth_element(intervals.begin(), intervals.begin() + intervals.size() / 2, intervals.end());
+    double interval = intervals[intervals.size() / 2];
+    return interval > 0 ? (uint16_t)(1000.0 / interval + 0.5) : 0;
+}
+
+void imu_sim_init(imu_sim_t *sim)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->regs[SIM_WHO_AM_I] = 0x33;
+    sim->regs[SIM_CTRL_REG1] = 0x07; /* power-down, axes enabled */
+}
+
+static bool sim_fifo_enabled(const imu_sim_t *sim)
+{
+    return (sim->regs[SIM_CTRL_REG5] & 0x40) && (sim->regs[SIM_FIFO_CTRL_REG] & 0xC0);
+}
+
+static uint16_t sim_mg_per_lsb(const imu_sim_t *sim)
+{
+    static const uint16_t k_mg_per_lsb[] = { 1, 2, 4, 12 };
+    return k_mg_per_lsb[(sim->regs[SIM_CTRL_REG4] >> 4) & 0x03];
+}
+
+void imu_sim_push(imu_sim_t *sim, const imu_sample_t *mg)
+{
+    if ((sim->regs[SIM_CTRL_REG1] >> 4) == 0) {
+        return;
+    }
+    int16_t counts[3];
+    const int32_t values[3] = { mg->x, mg->y, mg->z };
+    for (int axis = 0; axis < 3; axis++) {
+        int32_t value = values[axis] / sim_mg_per_lsb(sim);
+        value = std::max(-2048, std::min(2047, value));
+        counts[axis] = (int16_t)(value * 16);
+    }
+    memcpy(sim->latest, counts, sizeof(counts));
+    sim->regs[SIM_STATUS_REG] |= 0x08;
+    if (!sim_fifo_enabled(sim)) {
+        return;
+    }
+    /* Stream mode: the oldest sample makes room */
+    if (sim->count == SIM_FIFO_DEPTH) {
+        sim->head = (sim->head + 1) % SIM_FIFO_DEPTH;
+        sim->count--;
+        sim->overrun = true;
+    }
+    memcpy(sim->fifo[(sim->head + sim->count) % SIM_FIFO_DEPTH], counts, sizeof(counts));
+    sim->count++;
+}
+
+bool imu_sim_int1(const imu_sim_t *sim)
+{
+    return (sim->regs[SIM_CTRL_REG3] & 0x04) && sim_fifo_enabled(sim) &&
+           sim->count >= (sim->regs[SIM_FIFO_CTRL_REG] & 0x1F);
+}
+
+static uint8_t sim_read_register(imu_sim_t *sim, uint8_t reg)
+{
+    if (reg >= SIM_OUT_X_L && reg <= SIM_OUT_Z_H) {
+        const int16_t *sample = sim_fifo_enabled(sim) ? sim->fifo[sim->head] : sim->latest;
+        int16_t value = sample[(reg - SIM_OUT_X_L) / 2];
+        uint8_t byte = (reg & 1) ? (uint8_t)((uint16_t)value >> 8) : (uint8_t)value;
+        /* Reading OUT_Z_H consumes the sample */
+        if (reg == SIM_OUT_Z_H) {
+            sim->regs[SIM_STATUS_REG] &= ~0x08;
+            if (sim_fifo_enabled(sim) && sim->count > 0) {
+                sim->head = (sim->head + 1) % SIM_FIFO_DEPTH;
+                sim->count--;
+                sim->overrun = false;
+            }
+        }
+        return byte;
+    }
+    if (reg == SIM_FIFO_SRC_REG) {
+        uint8_t wtm = sim->count >= (sim->regs[SIM_FIFO_CTRL_REG] & 0x1F) ? 0x80 : 0;
+        uint8_t empty = sim->count == 0 ? 0x20 : 0;
+        uint8_t fss = sim->count < SIM_FIFO_DEPTH ? sim->count : SIM_FIFO_DEPTH - 1;
+        return wtm | (sim->overrun ? 0x40 : 0) | empty | fss;
+    }
+    return sim->regs[reg & 0x3F];
+}
+
+static int sim_bus_read(void *ctx, uint8_t reg, uint8_t *buf, size_t len)
+{
+    imu_sim_t *sim = (imu_sim_t *)ctx;
+    sim->reads++;
+    sim->bytes += len;
+    /* start, address+W, sub-address, repeated start, address+R, data, stop */
+    sim->bus_bits += 3 + 9 * 3 + 9 * len;
+    bool increment = reg & SIM_AUTO_INCREMENT;
+    uint8_t addr = reg & 0x7F;
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = sim_read_register(sim, addr);
+        if (!increment) {
+            continue;
+        }
+        addr = addr == SIM_OUT_Z_H && sim_fifo_enabled(sim) ? SIM_OUT_X_L : (addr + 1) & 0x7F;
+    }
+    return 0;
+}
+
+static int sim_bus_write(void *ctx, uint8_t reg, uint8_t value)
+{
+    imu_sim_t *sim = (imu_sim_t *)ctx;
+    sim->writes++;
+    sim->bus_bits += 2 + 9 * 3;
+    reg &= 0x7F;
+    if (reg == SIM_WHO_AM_I || reg == SIM_STATUS_REG || (reg >= SIM_OUT_X_L && reg <= SIM_OUT_Z_H) ||
+        reg == SIM_FIFO_SRC_REG || reg >= sizeof(sim->regs)) {
+        return -1;
+    }
+    sim->regs[reg] = value;
+    /* Bypass mode empties the FIFO */
+    if (reg == SIM_FIFO_CTRL_REG && (value & 0xC0) == 0) {
+        sim->head = 0;
+        sim->count = 0;
+        sim->overrun = false;
+    }
+    return 0;
+}
+
+imu_bus_t imu_sim_bus(imu_sim_t *sim)
+{
+    return { sim, sim_bus_read, sim_bus_write };
+}
@@ -0,0 +1,65 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "imu.h"
+
+/*
+ * Simulated LIS3DH behind an imu_bus_t: register file, 32 sample FIFO in stream mode with
+ * the watermark interrupt, auto-increment reads rolling over the output registers, and bus
+ * traffic accounting (transactions, bytes, bit times on the wire).
+ *
+ * Recordings are text files, one sample per line, `#` starts a comment:
+ *     <time_ms> <x_mg> <y_mg> <z_mg>
+ */
+
+typedef struct {
+    double time_ms;
+    imu_sample_t mg;
+} imu_record_t;
+
+typedef std::vector<imu_record_t> imu_recording_t;
+
+/** Load a recording
+ *
+ * @return 0 on success, -1 on error (errno set).
+ */
+int imu_recording_load(const char *path, imu_recording_t *recording);
+
+/** Sample rate of a recording, from the median sample interval */
+uint16_t imu_recording_rate_hz(const imu_recording_t *recording);
+
+typedef struct {
+    uint8_t regs[0x40];
+    int16_t fifo[32][3]; /* left justified counts, oldest at `head` */
+    uint8_t head;
+    uint8_t count;
+    bool overrun;
+    int16_t latest[3];   /* output registers with the FIFO disabled */
+    uint32_t reads;
+    uint32_t writes;
+    uint64_t bytes;
+    uint64_t bus_bits;   /* SCL cycles, start/stop conditions included */
+} imu_sim_t;
+
+void imu_sim_init(imu_sim_t *sim);
+
+/** The sensor produced one sample; ignored while powered down */
+void imu_sim_push(imu_sim_t *sim, const imu_sample_t *mg);
+
+/** Level of the INT1 pin (FIFO watermark) */
+bool imu_sim_int1(const imu_sim_t *sim);
+
+/** Bus backed by the simulated device, at the usual address */
+imu_bus_t imu_sim_bus(imu_sim_t *sim);
@@ -0,0 +1,206 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Cost of a log call seen by the caller, ESP_LOGI against APP_LOGI (deferred, dlog.h).
+ *
+ *     log_bench [-n calls] [-o file]
+ *
+ * Times the log lines of the driver callbacks one call at a time: ESP_LOGI formats and
+ * writes the line in the call, APP_LOGI only queues the record in a ring the way
+ * app_dlog.cpp does, and the records are formatted and written afterwards, as the log task
+ * would (timed separately). Output goes to /dev/null, or to `file`.
+ *
+ * The host writes to a buffered file, the device to a UART at 115200 baud, which blocks
+ * the caller once its FIFO is full: the last column is that wire time for the line, the
+ * floor of an ESP_LOGI call on the device when the console is busy. Device numbers come
+ * from `matter esp sensor logbench`.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <esp_log.h>
+
+#include "dlog.h"
+#include "spsc_ring.h"
+
+#define BENCH_RING_LEN 64 /* CONFIG_APP_DLOG_RING_LEN */
+#define BENCH_LINE_LEN 160
+#define BENCH_UART_BAUD 115200
+
+static const char *TAG = "app_driver";
+
+esp_log_level_t host_log_level = ESP_LOG_INFO;
+static FILE *s_sink = NULL;
+static spsc_ring<dlog_record_t, BENCH_RING_LEN> s_ring;
+static uint32_t s_dropped = 0;
+static size_t s_line_bytes = 0;
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int len = vfprintf(s_sink, format, args);
+    va_end(args);
+    s_line_bytes = len > 0 ? (size_t)len : 0;
+}
+
+static uint32_t bench_timestamp_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/* app_dlog.cpp without the per-core lock and the task notification */
+void dlog_commit(dlog_record_t *record)
+{
+    record->timestamp_ms = bench_timestamp_ms();
+    if (!s_ring.push(*record)) {
+        s_dropped++;
+    }
+}
+
+/* What the log task does with the records */
+static void bench_drain()
+{
+    static const dlog_abi_t abi = DLOG_ABI_NATIVE;
+    dlog_record_t record;
+    while (s_ring.pop(&record)) {
+        char text[BENCH_LINE_LEN];
+        dlog_format(&abi, record.desc->fmt, record.words, record.nwords, NULL, NULL, text, sizeof(text));
+        esp_log_write((esp_log_level_t)record.desc->level, record.tag, "%s (%" PRIu32 ") %s: %s%s\n",
+                      dlog_level_letter(record.desc->level), record.timestamp_ms, record.tag, text,
+                      record.truncated ? " [args truncated]" : "");
+    }
+}
+
+static inline uint64_t bench_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static const char *const k_names[] = { "door", "window", "garage" };
+
+/* The log lines of app_driver.cpp */
+static void bench_site(int site, bool deferred, uint32_t i)
+{
+    switch (site) {
+    case 0:
+        if (deferred) {
+            DLOGI(TAG, "Contact %s %s", k_names[i % 3], i & 1 ? "closed" : "opened");
+        } else {
+            ESP_LOGI(TAG, "Contact %s %s", k_names[i % 3], i & 1 ? "closed" : "opened");
+        }
+        break;
+    case 1:
+        if (deferred) {
+            DLOGI(TAG, "Contact %s: %" PRIu32 " transitions coalesced", k_names[i % 3], i % 50);
+        } else {
+            ESP_LOGI(TAG, "Contact %s: %" PRIu32 " transitions coalesced", k_names[i % 3], i % 50);
+        }
+        break;
+    default:
+        if (deferred) {
+            DLOGI(TAG, "LED render: power %d, brightness %d, hue %d, saturation %d, temperature %" PRIu32,
+                  (int)(i & 1), (int)(i % 255), (int)(i % 360), (int)(i % 100), 2700 + i % 3800);
+        } else {
+            ESP_LOGI(TAG, "LED render: power %d, brightness %d, hue %d, saturation %d, temperature %" PRIu32,
+                     (int)(i & 1), (int)(i % 255), (int)(i % 360), (int)(i % 100), 2700 + i % 3800);
+        }
+        break;
+    }
+}
+
+static void bench_print(const char *name, std::vector<uint32_t> *samples, const char *extra)
+{
+    std::sort(samples->begin(), samples->end());
+    auto at = [samples](uint32_t permille) { return (*samples)[(samples->size() - 1) * permille / 1000]; };
+    printf("  %-16s %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 "  %s\n", name, at(500), at(990), at(999),
+           at(1000), extra);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t calls = 200000;
+    const char *path = "/dev/null";
+    int opt;
+    while ((opt = getopt(argc, argv, "n:o:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            calls = strtoul(optarg, NULL, 0);
+            break;
+        case 'o':
+            path = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n calls] [-o file]\n", argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    s_sink = fopen(path, "w");
+    if (!s_sink || calls == 0) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return 1;
+    }
+
+    static const char *const k_sites[] = { "contact", "coalesced", "led render" };
+    std::vector<uint32_t> samples(calls);
+    printf("%" PRIu32 " calls per line, output to %s\n", calls, path);
+    printf("  %-16s %9s %9s %9s %9s  (ns per call)\n", "call", "p50", "p99", "p99.9", "max");
+    for (int site = 0; site < 3; site++) {
+        printf("%s\n", k_sites[site]);
+
+        for (uint32_t i = 0; i < calls; i++) {
+            uint64_t start = bench_ns();
+            bench_site(site, false, i);
+            samples[i] = (uint32_t)(bench_ns() - start);
+        }
+        char uart[64];
+        snprintf(uart, sizeof(uart), "%zu bytes, %" PRIu64 " us on the UART", s_line_bytes,
+                 (uint64_t)s_line_bytes * 10 * 1000000 / BENCH_UART_BAUD);
+        bench_print("ESP_LOGI", &samples, uart);
+
+        /* The log task keeps up: the ring is drained before it fills */
+        std::vector<uint32_t> drains;
+        for (uint32_t i = 0; i < calls; i++) {
+            uint64_t start = bench_ns();
+            bench_site(site, true, i);
+            samples[i] = (uint32_t)(bench_ns() - start);
+            if (s_ring.size() == BENCH_RING_LEN / 2) {
+                start = bench_ns();
+                bench_drain();
+                drains.push_back((uint32_t)((bench_ns() - start) / (BENCH_RING_LEN / 2)));
+            }
+        }
+        bench_drain();
+        bench_print("APP_LOGI", &samples, "");
+        if (!drains.empty()) {
+            bench_print("  log task", &drains, "per record, off the caller");
+        }
+    }
+
+    std::vector<uint32_t> empty(calls);
+    for (uint32_t i = 0; i < calls; i++) {
+        uint64_t start = bench_ns();
+        empty[i] = (uint32_t)(bench_ns() - start);
+    }
+    bench_print("timer overhead", &empty, "");
+    printf("dropped %" PRIu32 "\n", s_dropped);
+    fclose(s_sink);
+    return s_dropped ? 1 : 0;
+}
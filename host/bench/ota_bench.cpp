@@ -0,0 +1,191 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * OTA update of the update slot from a full image and from a delta patch.
+ *
+ *     ota_bench [-b block] [-r kbit_s] [-d dir] <old.bin> <new.bin> <patch.bin>
+ *
+ * `patch.bin` comes from `tools/delta_ota diff old.bin new.bin patch.bin`. The app slots
+ * are files (host/stubs/host_ota.cpp), ota_0 holding old.bin. Each image is written the
+ * way the Matter OTA image processor does, one BDX block at a time through esp_ota_begin(),
+ * esp_ota_write() and esp_ota_end(), and those calls go through main/app_ota.cpp as in the
+ * firmware (linker --wrap). A patch with one corrupted byte must then be rejected.
+ *
+ * Prints the bytes to send and their transfer time at the given rate, the time to write
+ * the update slot on the host, the flash traffic, and whether the slot holds new.bin.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <esp_ota_ops.h>
+
+#include <app_priv.h>
+#include "host_sim.h"
+
+/* ota_0 and ota_1 in partitions.csv */
+#define BENCH_SLOT_SIZE 0x1E0000
+
+typedef std::vector<uint8_t> bytes_t;
+
+typedef struct {
+    uint32_t block;
+    uint32_t rate_kbit;
+} bench_options_t;
+
+static int read_file(const char *path, bytes_t *data)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    uint8_t buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        data->insert(data->end(), buf, buf + n);
+    }
+    fclose(f);
+    return 0;
+}
+
+/* What the OTA image processor does with a download, block by block */
+static esp_err_t bench_update(const bytes_t &image, uint32_t block)
+{
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    esp_ota_handle_t handle;
+    esp_err_t err = esp_ota_begin(partition, OTA_WITH_SEQUENTIAL_WRITES, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    for (size_t offset = 0; offset < image.size(); offset += block) {
+        size_t len = image.size() - offset < block ? image.size() - offset : block;
+        err = esp_ota_write(handle, image.data() + offset, len);
+        if (err != ESP_OK) {
+            esp_ota_abort(handle);
+            return err;
+        }
+    }
+    err = esp_ota_end(handle);
+    if (err == ESP_OK) {
+        err = esp_ota_set_boot_partition(partition);
+    }
+    return err;
+}
+
+static bool bench_slot_matches(const bytes_t &expected)
+{
+    bytes_t slot(expected.size());
+    if (esp_partition_read(esp_ota_get_next_update_partition(NULL), 0, slot.data(), slot.size()) != ESP_OK) {
+        return false;
+    }
+    return slot == expected;
+}
+
+static bool bench_run(const char *name, const bytes_t &image, const bytes_t &expected, const bench_options_t *options)
+{
+    host_ota_reset_flash_stats();
+    uint64_t start = host_wall_ns();
+    esp_err_t err = bench_update(image, options->block);
+    uint64_t elapsed = host_wall_ns() - start;
+    host_flash_stats_t flash;
+    host_ota_get_flash_stats(&flash);
+    bool match = err == ESP_OK && bench_slot_matches(expected);
+
+    printf("%s image\n", name);
+    printf("  sent           %zu bytes (%.1f%% of the full image), %.1f s at %" PRIu32 " kbit/s\n", image.size(),
+           100.0 * image.size() / expected.size(), image.size() * 8.0 / (options->rate_kbit * 1000.0),
+           options->rate_kbit);
+    printf("  update         %.1f ms on the host, %.1f MB/s of image\n", elapsed / 1e6,
+           expected.size() * 1e3 / (elapsed ? elapsed : 1));
+    printf("  flash          %" PRIu64 " bytes read in %" PRIu32 " reads, %" PRIu64 " bytes written in %" PRIu32
+           " writes, %" PRIu32 " sectors erased\n",
+           flash.read_bytes, flash.reads, flash.write_bytes, flash.writes, flash.erases);
+    printf("  result         err 0x%x, update slot %s new image\n", err, match ? "holds the" : "does not hold the");
+    return match;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "Usage: %s [-b block] [-r kbit_s] [-d dir] <old.bin> <new.bin> <patch.bin>\n", argv0);
+    fprintf(stderr, "  -b bytes  OTA block size (default 1024, the BDX block of the requestor)\n");
+    fprintf(stderr, "  -r kbit/s transfer rate for the airtime estimate (default 250, the 802.15.4 PHY rate)\n");
+    fprintf(stderr, "  -d dir    directory for the slot files (default: a new one in /tmp)\n");
+}
+
+int main(int argc, char **argv)
+{
+    bench_options_t options = { 1024, 250 };
+    const char *dir = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:r:d:h")) != -1) {
+        switch (opt) {
+        case 'b':
+            options.block = strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            options.rate_kbit = strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            dir = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (argc - optind != 3 || options.block == 0 || options.rate_kbit == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    bytes_t old_image, new_image, patch;
+    if (read_file(argv[optind], &old_image) != 0 || read_file(argv[optind + 1], &new_image) != 0 ||
+        read_file(argv[optind + 2], &patch) != 0) {
+        return 1;
+    }
+    char tmp[] = "/tmp/ota_bench.XXXXXX";
+    if (!dir && !(dir = mkdtemp(tmp))) {
+        fprintf(stderr, "mkdtemp: %s\n", strerror(errno));
+        return 1;
+    }
+    if (host_ota_init(dir, BENCH_SLOT_SIZE) != ESP_OK || host_ota_flash_running(old_image.data(), old_image.size())) {
+        fprintf(stderr, "cannot set up the slots in %s\n", dir);
+        return 1;
+    }
+    printf("slots in %s, ota_0 runs %zu bytes, update to %zu bytes in %" PRIu32 " byte blocks\n\n", dir,
+           old_image.size(), new_image.size(), options.block);
+
+    bool ok = bench_run("full", new_image, new_image, &options);
+    ok &= bench_run("delta", patch, new_image, &options);
+
+    app_ota_stats_t stats;
+    app_ota_get_stats(&stats);
+    printf("  applier ram    %" PRIu32 " bytes, while the patch is applied\n", stats.ram_bytes);
+
+    /* Past the header, so it is the body that is wrong */
+    bytes_t corrupt = patch;
+    corrupt[corrupt.size() / 2] ^= 0x5A;
+    host_ota_init(dir, BENCH_SLOT_SIZE);
+    host_ota_flash_running(old_image.data(), old_image.size());
+    esp_err_t err = bench_update(corrupt, options.block);
+    bool rejected = err != ESP_OK && host_ota_get_boot_partition() == NULL;
+    printf("\ncorrupted patch %s (err 0x%x)\n", rejected ? "rejected" : "NOT rejected", err);
+    ok &= rejected;
+
+    app_ota_get_stats(&stats);
+    printf("app_ota: full %" PRIu32 " delta %" PRIu32 " failed %" PRIu32 "\n", stats.full_images, stats.delta_images,
+           stats.failures);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,390 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * NVS writes of the settings cache under controller traffic.
+ *
+ *     persist_bench [-n days] [-s seed] [delay_ms]...
+ *
+ * Days of synthetic traffic go through main/app_persist.cpp into the NVS page simulator
+ * (host/stubs/host_nvs.cpp), once per write-behind delay (default 0, the write-through
+ * baseline, then 1, 5, 30 and 60 s), each in a fresh process:
+ * - evening dimmer and color temperature drags, one set per 100 ms step, and on/off
+ *   following the door; the light state is saved under its own keys the way esp_matter
+ *   saves the deferred attributes;
+ * - report policy tuning and binding action changes through the driver API, in short
+ *   sessions of a few sets, and a Hall calibration now and then;
+ * - a restart (OTA) every week, which flushes through the shutdown handler.
+ * The partition starts with 256 entries of fabric data that the collection has to move.
+ *
+ * Prints the sets and what reached NVS, the page erases of the simulator, the flash
+ * lifetime projected from the entry count (as `sensor persist` does) and from the most
+ * worn simulated page, the share of time with unsaved values, and whether NVS holds the
+ * last value of every key after the final restart.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <esp_timer.h>
+#include <nvs.h>
+
+#include <app_priv.h>
+#include "host_sim.h"
+#include "persist_cache.h"
+#include "report_policy.h"
+
+#define BENCH_PARTITION_BYTES 0xC000
+#define BENCH_FABRIC_BLOBS 64 /* 4 entries each */
+#define BENCH_DAY_US (86400LL * 1000000)
+#define BENCH_STEP_US 100000
+#define BENCH_RESTART_DAYS 7
+
+/* Defined by app_main.cpp on target */
+uint16_t light_endpoint_id = 0;
+uint16_t contact_endpoint_ids[APP_CONTACT_MAX_CHANNEL_COUNT];
+
+typedef enum {
+    BENCH_LEVEL,
+    BENCH_COLOR_TEMP,
+    BENCH_ON_OFF,
+    BENCH_POLICY,
+    BENCH_BINDING,
+    BENCH_CALIBRATION,
+    BENCH_RESTART,
+} bench_kind_t;
+
+typedef struct {
+    int64_t t_us;
+    bench_kind_t kind;
+    uint32_t value;
+} bench_event_t;
+
+typedef struct {
+    uint64_t dirty_us;  /* time with at least one value not on flash */
+    uint16_t max_dirty;
+} bench_exposure_t;
+
+typedef std::map<std::pair<std::string, std::string>, std::vector<uint8_t>> bench_expected_t;
+
+static uint64_t s_rng = 1;
+
+static uint32_t bench_rand(uint32_t n)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return (uint32_t)(s_rng % n);
+}
+
+static void bench_drag(std::vector<bench_event_t> *events, int64_t start, bench_kind_t kind, uint32_t from,
+                       uint32_t steps, int32_t step)
+{
+    int64_t value = from;
+    for (uint32_t i = 0; i < steps; i++) {
+        value += step;
+        events->push_back({ start + (int64_t)i * BENCH_STEP_US, kind, (uint32_t)value });
+    }
+}
+
+static std::vector<bench_event_t> bench_traffic(uint32_t days)
+{
+    std::vector<bench_event_t> events;
+    uint32_t level = 128;
+    uint32_t mireds = 300;
+    for (uint32_t day = 0; day < days; day++) {
+        int64_t base = day * BENCH_DAY_US;
+        int64_t evening = base + 18 * 3600LL * 1000000;
+        /* Dimmer: four drags between 18:00 and 23:00 */
+        for (int i = 0; i < 4; i++) {
+            int64_t start = evening + (int64_t)bench_rand(5 * 3600) * 1000000;
+            uint32_t steps = 20 + bench_rand(11);
+            int32_t step = level > 128 ? -(int32_t)(1 + bench_rand(4)) : (int32_t)(1 + bench_rand(4));
+            bench_drag(&events, start, BENCH_LEVEL, level, steps, step);
+            level += step * (int32_t)steps;
+        }
+        /* Color temperature: two drags */
+        for (int i = 0; i < 2; i++) {
+            int64_t start = evening + (int64_t)bench_rand(5 * 3600) * 1000000;
+            uint32_t steps = 10 + bench_rand(11);
+            int32_t step = mireds > 300 ? -(int32_t)(5 + bench_rand(6)) : (int32_t)(5 + bench_rand(6));
+            bench_drag(&events, start, BENCH_COLOR_TEMP, mireds, steps, step);
+            mireds += step * (int32_t)steps;
+        }
+        /* On/off following the door: 15 visits, open then closed 5 to 60 s later */
+        for (int i = 0; i < 15; i++) {
+            int64_t open = base + 7 * 3600LL * 1000000 + (int64_t)bench_rand(16 * 3600) * 1000000;
+            events.push_back({ open, BENCH_ON_OFF, 1 });
+            events.push_back({ open + (5 + (int64_t)bench_rand(56)) * 1000000, BENCH_ON_OFF, 0 });
+        }
+        /* Policy tuning: a slider session of 6 sets over 8 s, once a week */
+        if (day % 7 == 3) {
+            int64_t start = base + 20 * 3600LL * 1000000;
+            for (int i = 0; i < 6; i++) {
+                events.push_back({ start + i * 1600000LL, BENCH_POLICY, 500 + bench_rand(20) * 100 });
+            }
+        }
+        /* Binding actions: tried, reverted, set again within 20 s, every ten days */
+        if (day % 10 == 5) {
+            int64_t start = base + 21 * 3600LL * 1000000;
+            for (int i = 0; i < 3; i++) {
+                events.push_back({ start + i * 7000000LL, BENCH_BINDING, (uint32_t)(i & 1) });
+            }
+        }
+        if (day % 14 == 9) {
+            events.push_back({ base + 12 * 3600LL * 1000000, BENCH_CALIBRATION, 19000 + bench_rand(2000) });
+        }
+        if (day % BENCH_RESTART_DAYS == BENCH_RESTART_DAYS - 1) {
+            events.push_back({ base + 3 * 3600LL * 1000000, BENCH_RESTART, 0 });
+        }
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const bench_event_t &a, const bench_event_t &b) { return a.t_us < b.t_us; });
+    return events;
+}
+
+/* Fire the persist timer and run the flush work up to `target_us`, counting the time with
+ * unsaved values */
+static void bench_advance(int64_t target_us, bench_exposure_t *exposure)
+{
+    while (true) {
+        int64_t next = host_timer_next_deadline(true);
+        int64_t stop = std::min(next, target_us);
+        int64_t now = esp_timer_get_time();
+        app_persist_stats_t stats;
+        app_persist_get_stats(&stats);
+        exposure->max_dirty = std::max(exposure->max_dirty, stats.dirty);
+        if (stop > now) {
+            if (stats.dirty > 0) {
+                exposure->dirty_us += stop - now;
+            }
+            latency_fake_clock_set(stop);
+        }
+        if (next > target_us) {
+            break;
+        }
+        host_timer_run();
+        host_platform_run_work();
+    }
+}
+
+static void bench_set(const char *ns, const char *key, const void *data, size_t len, bench_expected_t *expected)
+{
+    app_persist_set(ns, key, data, len);
+    const uint8_t *bytes = (const uint8_t *)data;
+    (*expected)[{ ns, key }] = std::vector<uint8_t>(bytes, bytes + len);
+}
+
+static void bench_apply(const bench_event_t *event, bench_expected_t *expected)
+{
+    switch (event->kind) {
+    case BENCH_LEVEL: {
+        uint8_t level = (uint8_t)event->value;
+        bench_set("light", "level", &level, sizeof(level), expected);
+        break;
+    }
+    case BENCH_COLOR_TEMP: {
+        uint16_t mireds = (uint16_t)event->value;
+        bench_set("light", "ct", &mireds, sizeof(mireds), expected);
+        break;
+    }
+    case BENCH_ON_OFF: {
+        uint8_t on = (uint8_t)event->value;
+        bench_set("light", "onoff", &on, sizeof(on), expected);
+        break;
+    }
+    case BENCH_POLICY: {
+        app_contact_policy_t policy = {};
+        policy.holdoff_ms = event->value;
+        policy.max_reports = CONFIG_APP_REPORT_MAX_PER_WINDOW;
+        policy.window_sec = CONFIG_APP_REPORT_WINDOW_SEC;
+        app_driver_contact_set_policy(APP_CONTACT_DOOR, &policy);
+        /* As app_driver.cpp saves it */
+        report_policy_config_t config;
+        memset(&config, 0, sizeof(config));
+        config.holdoff_ms = policy.holdoff_ms;
+        config.max_reports = policy.max_reports;
+        config.window_ms = policy.window_sec * 1000;
+        const uint8_t *bytes = (const uint8_t *)&config;
+        (*expected)[{ "policy", "ch0" }] = std::vector<uint8_t>(bytes, bytes + sizeof(config));
+        break;
+    }
+    case BENCH_BINDING: {
+        app_binding_action_t on_open = event->value ? APP_BINDING_ACTION_TOGGLE : APP_BINDING_ACTION_ON;
+        app_binding_set_actions(APP_CONTACT_DOOR, on_open, APP_BINDING_ACTION_OFF);
+        /* app_binding_map_t */
+        (*expected)[{ "binding", "ch0" }] = { (uint8_t)on_open, (uint8_t)APP_BINDING_ACTION_OFF };
+        break;
+    }
+    case BENCH_CALIBRATION: {
+        int32_t closed_ut = (int32_t)event->value;
+        bench_set("hall", "closed_ut", &closed_ut, sizeof(closed_ut), expected);
+        break;
+    }
+    case BENCH_RESTART:
+        host_system_restart();
+        break;
+    }
+}
+
+static bool bench_check_nvs(const bench_expected_t *expected)
+{
+    bool ok = true;
+    for (const auto &it : *expected) {
+        nvs_handle_t handle;
+        uint8_t value[PERSIST_VALUE_MAX];
+        size_t len = sizeof(value);
+        if (nvs_open(it.first.first.c_str(), NVS_READONLY, &handle) != ESP_OK ||
+            nvs_get_blob(handle, it.first.second.c_str(), value, &len) != ESP_OK || len != it.second.size() ||
+            memcmp(value, it.second.data(), len) != 0) {
+            fprintf(stderr, "%s/%s: not the last value set\n", it.first.first.c_str(), it.first.second.c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static void bench_print_header()
+{
+    printf("%8s %7s %7s %9s %7s %9s %9s %8s %7s %8s %10s %10s %7s %5s %7s\n", "delay_ms", "sets", "writes",
+           "coalesced", "flushes", "entries", "sim_ent", "reloc", "erases", "max_page", "years_est", "years_sim",
+           "dirty%", "max", "restart");
+}
+
+static double bench_years(double days)
+{
+    return days / 365.0;
+}
+
+static int bench_run(uint32_t delay_ms, uint32_t days, uint64_t seed)
+{
+    s_rng = seed;
+    latency_fake_clock_set(0);
+    host_nvs_reset(BENCH_PARTITION_BYTES);
+
+    /* Fabric tables, certificates: written once, moved by every collection of their page */
+    nvs_handle_t handle;
+    ESP_ERROR_CHECK(nvs_open("chip", NVS_READWRITE, &handle));
+    for (int i = 0; i < BENCH_FABRIC_BLOBS; i++) {
+        char key[16];
+        uint8_t blob[PERSIST_VALUE_MAX];
+        snprintf(key, sizeof(key), "fabric%d", i);
+        memset(blob, i, sizeof(blob));
+        ESP_ERROR_CHECK(nvs_set_blob(handle, key, blob, sizeof(blob)));
+    }
+    nvs_close(handle);
+    host_nvs_stats_t before;
+    host_nvs_get_stats(&before);
+
+    ESP_ERROR_CHECK(app_driver_contact_init());
+    ESP_ERROR_CHECK(app_persist_init());
+    app_persist_set_delay(delay_ms);
+    app_driver_contact_restore_policies();
+    ESP_ERROR_CHECK(app_binding_init());
+
+    std::vector<bench_event_t> events = bench_traffic(days);
+    bench_expected_t expected;
+    bench_exposure_t exposure = {};
+    for (const bench_event_t &event : events) {
+        bench_advance(event.t_us, &exposure);
+        bench_apply(&event, &expected);
+    }
+    int64_t end_us = (int64_t)days * BENCH_DAY_US;
+    bench_advance(end_us, &exposure);
+    host_system_restart();
+
+    app_persist_stats_t stats;
+    app_persist_get_stats(&stats);
+    host_nvs_stats_t nvs;
+    host_nvs_get_stats(&nvs);
+    bool ok = stats.dirty == 0 && stats.errors == 0 && bench_check_nvs(&expected);
+
+    uint64_t elapsed_s = (uint64_t)end_us / 1000000;
+    uint32_t est_days = persist_projected_days(stats.nvs_entries, elapsed_s, BENCH_PARTITION_BYTES);
+    double sim_days = nvs.max_page_erases ? (double)PERSIST_FLASH_ENDURANCE * days / nvs.max_page_erases : 0;
+    char est[16];
+    char sim[16];
+    snprintf(est, sizeof(est), est_days == UINT32_MAX ? "-" : "%.0f", bench_years(est_days));
+    snprintf(sim, sizeof(sim), nvs.max_page_erases ? "%.0f" : "-", bench_years(sim_days));
+    printf("%8" PRIu32 " %7" PRIu32 " %7" PRIu32 " %9" PRIu32 " %7" PRIu32 " %9" PRIu64 " %9" PRIu64 " %8" PRIu64
+           " %7" PRIu32 " %8" PRIu32 " %10s %10s %6.2f%% %5u %7s\n",
+           delay_ms, stats.sets, stats.writes, stats.coalesced, stats.flushes, stats.nvs_entries,
+           nvs.entry_writes - before.entry_writes, nvs.relocated_entries, nvs.page_erases, nvs.max_page_erases, est,
+           sim, 100.0 * exposure.dirty_us / end_us, exposure.max_dirty, ok ? "ok" : "LOST");
+    return ok ? 0 : 1;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Usage: %s [-n days] [-s seed] [delay_ms]...\n"
+            "  -n days   simulated days of traffic (default 365)\n"
+            "  -s seed   seed of the traffic\n"
+            "  delay_ms  write-behind delays to compare (default: 0 1000 5000 30000 60000)\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t days = 365;
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            days = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (days == 0 || seed == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    std::vector<uint32_t> delays;
+    for (int i = optind; i < argc; i++) {
+        delays.push_back(strtoul(argv[i], NULL, 10));
+    }
+    if (delays.empty()) {
+        delays = { 0, 1000, 5000, 30000, 60000 };
+    }
+
+    printf("%" PRIu32 " days, %d KB partition, %d erase cycles\n", days, BENCH_PARTITION_BYTES / 1024,
+           PERSIST_FLASH_ENDURANCE);
+    bench_print_header();
+    int failures = 0;
+    for (uint32_t delay_ms : delays) {
+        /* The cache and the driver are single instances: one process per run */
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            int result = bench_run(delay_ms, days, seed);
+            fflush(stdout);
+            _exit(result);
+        }
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,422 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Pass/fail checks of the pure firmware modules, run by CTest.
+ *
+ *     host_check [group]...
+ *
+ * Groups: debounce, ring, policy, persist, telemetry, storm, latency (all of them by default). Each
+ * failed expectation prints its file and line; the exit status is 1 if any failed.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "contact_debounce.h"
+#include "contact_events.h"
+#include "latency_trace.h"
+#include "persist_cache.h"
+#include "report_policy.h"
+#include "spsc_ring.h"
+#include "storm_gen.h"
+#include "telemetry.h"
+
+static int s_failures = 0;
+
+#define CHECK(cond)                                                                                                    \
+    do {                                                                                                               \
+        if (!(cond)) {                                                                                                 \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);                                   \
+            s_failures++;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                                                 \
+    do {                                                                                                               \
+        long long _a = (long long)(a);                                                                                 \
+        long long _b = (long long)(b);                                                                                 \
+        if (_a != _b) {                                                                                                \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b);     \
+            s_failures++;                                                                                              \
+        }                                                                                                              \
+    } while (0)
+
+/* Bounce on one edge is filtered, the level is reported once it held for the settle time */
+static void check_debounce()
+{
+    contact_debounce_config_t config = { .settle_us = 20000, .leading_edge = false };
+    contact_debounce_t db;
+    contact_debounce_init(&db, &config, false);
+
+    CHECK_EQ(contact_debounce_on_edge(&db, 1000, true), CONTACT_DEBOUNCE_ARM);
+    CHECK_EQ(db.deadline_us, 21000);
+    CHECK_EQ(contact_debounce_on_edge(&db, 2000, false), CONTACT_DEBOUNCE_NONE);
+    CHECK_EQ(contact_debounce_on_edge(&db, 3000, true), CONTACT_DEBOUNCE_NONE);
+    /* Not quiet long enough: re-armed from the last edge */
+    CHECK_EQ(contact_debounce_on_timer(&db, 21000, true), CONTACT_DEBOUNCE_ARM);
+    CHECK_EQ(db.deadline_us, 23000);
+    CHECK_EQ(contact_debounce_on_timer(&db, 23000, true), CONTACT_DEBOUNCE_REPORT);
+    CHECK(db.stable_level);
+    CHECK_EQ(db.first_edge_us, 1000);
+    CHECK_EQ(db.edges, 3);
+    CHECK_EQ(db.reports, 1);
+
+    /* A glitch that goes back to the stable level reports nothing */
+    CHECK_EQ(contact_debounce_on_edge(&db, 50000, false), CONTACT_DEBOUNCE_ARM);
+    CHECK_EQ(contact_debounce_on_edge(&db, 50100, true), CONTACT_DEBOUNCE_NONE);
+    CHECK_EQ(contact_debounce_on_timer(&db, 70100, true), CONTACT_DEBOUNCE_NONE);
+    CHECK_EQ(db.state, CONTACT_DEBOUNCE_STABLE);
+
+    /* Leading edge: reported at once, then the bounce is only filtered */
+    config.leading_edge = true;
+    contact_debounce_init(&db, &config, false);
+    CHECK_EQ(contact_debounce_on_edge(&db, 1000, true), CONTACT_DEBOUNCE_ARM);
+    CHECK_EQ(db.deadline_us, 1000);
+    CHECK_EQ(contact_debounce_on_timer(&db, 1000, true), CONTACT_DEBOUNCE_REPORT | CONTACT_DEBOUNCE_ARM);
+    CHECK(db.stable_level);
+    CHECK_EQ(contact_debounce_on_edge(&db, 1500, false), CONTACT_DEBOUNCE_NONE);
+    /* Settled on the opposite level: corrected */
+    CHECK_EQ(contact_debounce_on_timer(&db, 21500, false), CONTACT_DEBOUNCE_REPORT);
+    CHECK(!db.stable_level);
+}
+
+/* Drops and high-water of the ring, then per channel merging in the drain */
+static void check_ring()
+{
+    spsc_ring<contact_event_t, 4> ring;
+    for (int i = 0; i < 6; i++) {
+        contact_event_t event = { (uint16_t)(i % 2), (i & 2) != 0, i * 10, i * 10 + 5 };
+        CHECK_EQ(ring.push(event), i < 4);
+    }
+    CHECK_EQ(ring.size(), 4);
+    CHECK_EQ(ring.pushed(), 4);
+    CHECK_EQ(ring.dropped(), 2);
+    CHECK_EQ(ring.high_water(), 4);
+
+    contact_pending_t pending[2] = {};
+    contact_drain_stats_t stats = {};
+    CHECK_EQ(contact_events_drain(&ring, pending, 2, 3, &stats), 3);
+    CHECK_EQ(contact_events_drain(&ring, pending, 2, 3, &stats), 1);
+    CHECK_EQ(contact_events_drain(&ring, pending, 2, 3, &stats), 0);
+    CHECK_EQ(stats.batches, 2);
+    CHECK_EQ(stats.events, 4);
+    CHECK_EQ(stats.coalesced, 2);
+    /* Channel 0 got events 0 and 2, channel 1 events 1 and 3 */
+    CHECK(pending[0].pending && pending[0].closed);
+    CHECK_EQ(pending[0].transitions, 2);
+    CHECK_EQ(pending[0].first_us, 5);
+    CHECK_EQ(pending[0].last_edge_us, 20);
+    CHECK(pending[1].pending && pending[1].closed);
+    CHECK_EQ(pending[1].last_us, 35);
+
+    /* Indexes wrap past UINT32_MAX without losing items */
+    spsc_ring<uint32_t, 8> counter;
+    for (uint32_t i = 0; i < 100000; i++) {
+        uint32_t item = 0;
+        CHECK(counter.push(i));
+        CHECK(counter.pop(&item));
+        if (item != i) {
+            CHECK_EQ(item, i);
+            break;
+        }
+    }
+}
+
+static void check_policy()
+{
+    /* Off: every change is reported right away */
+    report_policy_config_t off = { 0, 0, 0, 1000 };
+    report_policy_t rp;
+    report_policy_init(&rp, &off, false);
+    CHECK_EQ(report_policy_on_change(&rp, 1000, true, 1), REPORT_POLICY_REPORT);
+    CHECK_EQ(report_policy_on_change(&rp, 2000, false, 1), REPORT_POLICY_REPORT);
+    CHECK_EQ(rp.reports, 2);
+    CHECK_EQ(rp.suppressed, 0);
+
+    /* Hold-off: a change that goes back within it is never reported */
+    report_policy_config_t holdoff = { 0, 100, 0, 1000 };
+    report_policy_init(&rp, &holdoff, false);
+    CHECK_EQ(report_policy_on_change(&rp, 0, true, 1), REPORT_POLICY_ARM);
+    CHECK_EQ(rp.deadline_us, 100000);
+    CHECK_EQ(report_policy_on_change(&rp, 50000, false, 1), REPORT_POLICY_NONE);
+    CHECK_EQ(report_policy_on_timer(&rp, 100000), REPORT_POLICY_NONE);
+    CHECK_EQ(rp.suppressed, 2);
+    CHECK_EQ(report_policy_on_change(&rp, 200000, true, 3), REPORT_POLICY_ARM);
+    CHECK_EQ(report_policy_on_timer(&rp, 300000), REPORT_POLICY_REPORT);
+    CHECK_EQ(rp.report_transitions, 3);
+    CHECK(rp.reported);
+
+    /* Cap of 2 per 1 s window: the third change waits for the window end, with a summary */
+    report_policy_config_t cap = { 0, 0, 2, 1000 };
+    report_policy_init(&rp, &cap, false);
+    CHECK_EQ(report_policy_on_change(&rp, 0, true, 1), REPORT_POLICY_REPORT);
+    CHECK_EQ(report_policy_on_change(&rp, 100000, false, 1), REPORT_POLICY_REPORT);
+    CHECK_EQ(report_policy_on_change(&rp, 200000, true, 1), REPORT_POLICY_ARM);
+    CHECK_EQ(rp.deadline_us, 1000000);
+    CHECK_EQ(report_policy_on_timer(&rp, 1000000), REPORT_POLICY_REPORT | REPORT_POLICY_SUMMARY);
+    CHECK_EQ(rp.summary_held, 1);
+    CHECK_EQ(rp.reports, 3);
+}
+
+/* Backend recording what reaches "flash" */
+typedef struct {
+    std::map<std::string, std::vector<uint8_t>> values;
+    uint32_t writes;
+    uint32_t commits;
+} check_store_t;
+
+static int check_store_write(void *ctx, const char *ns, const char *key, const void *data, size_t len)
+{
+    check_store_t *store = (check_store_t *)ctx;
+    const uint8_t *bytes = (const uint8_t *)data;
+    store->values[std::string(ns) + "/" + key].assign(bytes, bytes + len);
+    store->writes++;
+    return 0;
+}
+
+static int check_store_commit(void *ctx, const char *ns)
+{
+    ((check_store_t *)ctx)->commits++;
+    return 0;
+}
+
+static void check_persist()
+{
+    check_store_t store = {};
+    persist_backend_t backend = { &store, check_store_write, check_store_commit };
+    persist_entry_t entries[4];
+    persist_cache_t pc;
+    persist_cache_init(&pc, &backend, entries, 4, 1000);
+
+    uint32_t value = 1;
+    CHECK_EQ(persist_cache_set(&pc, "policy", "ch0", &value, sizeof(value), 0), 0);
+    value = 2;
+    CHECK_EQ(persist_cache_set(&pc, "policy", "ch0", &value, sizeof(value), 100000), 0);
+    CHECK_EQ(persist_cache_set(&pc, "binding", "ch0", &value, sizeof(value), 200000), 0);
+    CHECK_EQ(store.writes, 0);
+    CHECK_EQ(pc.stats.coalesced, 1);
+    /* Due one delay after the oldest dirty value */
+    CHECK_EQ(persist_cache_deadline(&pc), 1000000);
+
+    uint32_t cached = 0;
+    size_t len = sizeof(cached);
+    CHECK(persist_cache_get(&pc, "policy", "ch0", &cached, &len));
+    CHECK_EQ(cached, 2);
+
+    CHECK_EQ(persist_cache_flush(&pc, 1000000), 0);
+    CHECK_EQ(store.writes, 2);
+    CHECK_EQ(store.commits, 2);
+    CHECK_EQ(persist_cache_deadline(&pc), INT64_MAX);
+    CHECK(store.values["policy/ch0"] == std::vector<uint8_t>({ 2, 0, 0, 0 }));
+
+    /* The value already on flash costs nothing */
+    CHECK_EQ(persist_cache_set(&pc, "policy", "ch0", &value, sizeof(value), 2000000), 0);
+    CHECK_EQ(pc.stats.unchanged, 1);
+    CHECK_EQ(persist_cache_deadline(&pc), INT64_MAX);
+
+    /* Names and values past the NVS limits are refused */
+    uint8_t big[PERSIST_VALUE_MAX + 1] = {};
+    CHECK_EQ(persist_cache_set(&pc, "policy", "ch0", big, sizeof(big), 0), -1);
+    CHECK_EQ(persist_cache_set(&pc, "a_namespace_too_long", "k", &value, sizeof(value), 0), -1);
+
+    /* No delay: written through */
+    persist_cache_set_delay(&pc, 0);
+    value = 3;
+    CHECK_EQ(persist_cache_set(&pc, "policy", "ch1", &value, sizeof(value), 3000000), 0);
+    CHECK_EQ(store.writes, 3);
+
+    /* Index + header + one data entry per 32 bytes */
+    CHECK_EQ(persist_nvs_blob_entries(1), 3);
+    CHECK_EQ(persist_nvs_blob_entries(32), 3);
+    CHECK_EQ(persist_nvs_blob_entries(33), 4);
+}
+
+/* Frames out of the ring, through the deframer and the decoder, with zeros to stuff */
+static void check_telemetry()
+{
+    static uint8_t buf[1024];
+    telemetry_t tm;
+    CHECK_EQ(telemetry_init(&tm, buf, sizeof(buf)), TELEMETRY_OK);
+    CHECK(telemetry_contact_edge(&tm, 0x01000000, 3, true, 0));
+    CHECK(telemetry_latency(&tm, 0, 4, 0x00ABCD00));
+    const uint32_t words[3] = { 0, 0xFFFFFFFF, 0x00010000 };
+    CHECK(telemetry_log(&tm, 42, 0x12345678, 0, words, 3));
+
+    std::vector<uint8_t> stream;
+    const uint8_t *data;
+    size_t len;
+    while ((len = telemetry_peek(&tm, &data)) > 0) {
+        stream.insert(stream.end(), data, data + len);
+        telemetry_consume(&tm, len);
+    }
+
+    telemetry_deframer_t deframer;
+    telemetry_deframer_init(&deframer);
+    std::vector<telemetry_record_t> records;
+    std::vector<std::vector<uint8_t>> frames;
+    for (uint8_t byte : stream) {
+        const uint8_t *frame;
+        size_t frame_len;
+        if (telemetry_deframer_push(&deframer, byte, &frame, &frame_len)) {
+            frames.emplace_back(frame, frame + frame_len);
+            telemetry_record_t record;
+            CHECK_EQ(telemetry_decode(frame, frame_len, &record), TELEMETRY_OK);
+            records.push_back(record);
+        }
+    }
+    CHECK_EQ(records.size(), 3);
+    if (records.size() != 3) {
+        return;
+    }
+    CHECK_EQ(records[0].type, TELEMETRY_CONTACT_EDGE);
+    CHECK_EQ(records[0].seq, 0);
+    CHECK_EQ(records[0].timestamp_us, 0x01000000);
+    CHECK_EQ(records[0].contact.channel, 3);
+    CHECK(records[0].contact.closed);
+    CHECK_EQ(records[1].latency.value_us, 0x00ABCD00);
+    CHECK_EQ(records[2].seq, 2);
+    CHECK_EQ(records[2].log.format_id, 0x12345678);
+    CHECK_EQ(records[2].log.nwords, 3);
+    CHECK_EQ(records[2].log.words[1], 0xFFFFFFFF);
+    CHECK_EQ(records[2].log.words[2], 0x00010000);
+
+    /* A flipped bit fails the CRC or the framing, never decodes */
+    std::vector<uint8_t> corrupt = frames[1];
+    corrupt[corrupt.size() / 2] ^= 0x10;
+    if (corrupt[corrupt.size() / 2] == 0) {
+        corrupt[corrupt.size() / 2] = 0x10;
+    }
+    telemetry_record_t record;
+    CHECK(telemetry_decode(corrupt.data(), corrupt.size(), &record) != TELEMETRY_OK);
+}
+
+static void check_storm()
+{
+    storm_config_t config = { .rate_hz = 1000, .duration_ms = 100, .pattern = STORM_STEADY, .burst_len = 0,
+                              .seed = 1 };
+    storm_gen_t gen;
+    CHECK(storm_gen_init(&gen, &config, 5000));
+    int64_t at_us;
+    int64_t last_us = 0;
+    uint32_t count = 0;
+    while (storm_gen_next(&gen) != INT64_MAX) {
+        int64_t now = storm_gen_next(&gen);
+        while (storm_gen_pop(&gen, now, &at_us)) {
+            if (count > 0) {
+                CHECK_EQ(at_us - last_us, 1000);
+            }
+            last_us = at_us;
+            count++;
+        }
+    }
+    CHECK_EQ(count, 100);
+
+    /* Bursts of 10 at the same instant, 10 ms apart */
+    config.pattern = STORM_BURST;
+    config.burst_len = 10;
+    CHECK(storm_gen_init(&gen, &config, 0));
+    CHECK(!storm_gen_pop(&gen, -1, &at_us));
+    for (int i = 0; i < 10; i++) {
+        CHECK(storm_gen_pop(&gen, 0, &at_us));
+        CHECK_EQ(at_us, 0);
+    }
+    CHECK(!storm_gen_pop(&gen, 9999, &at_us));
+    CHECK_EQ(storm_gen_next(&gen), 10000);
+
+    config.rate_hz = STORM_MAX_RATE_HZ + 1;
+    CHECK(!storm_gen_init(&gen, &config, 0));
+    config.rate_hz = 1000;
+    config.burst_len = 0;
+    CHECK(!storm_gen_init(&gen, &config, 0));
+}
+
+/* Power-of-two buckets, percentiles report the bucket upper bound capped at the max */
+static void check_latency()
+{
+    latency_trace_reset();
+    const int64_t durations[] = { 0, 1, 2, 3, 1000, 5000 };
+    for (int64_t duration : durations) {
+        latency_trace_record(TRACE_SPAN_UPDATE, 100, 100 + duration);
+    }
+    latency_trace_record(TRACE_SPAN_UPDATE, 10, 5); /* negative, ignored */
+    latency_trace_record(TRACE_SPAN_MAX, 0, 1);     /* out of range, ignored */
+
+    latency_hist_snapshot_t snapshot;
+    latency_trace_snapshot(TRACE_SPAN_UPDATE, &snapshot);
+    CHECK_EQ(snapshot.count, 6);
+    CHECK_EQ(snapshot.min_us, 0);
+    CHECK_EQ(snapshot.max_us, 5000);
+    CHECK_EQ(snapshot.buckets[0], 2);
+    CHECK_EQ(snapshot.buckets[1], 2);
+    CHECK_EQ(snapshot.buckets[9], 1);  /* [512, 1024) */
+    CHECK_EQ(snapshot.buckets[12], 1); /* [4096, 8192) */
+    CHECK_EQ(latency_trace_percentile(&snapshot, 0), 1);
+    CHECK_EQ(latency_trace_percentile(&snapshot, 50), 3);
+    CHECK_EQ(latency_trace_percentile(&snapshot, 67), 1023);
+    CHECK_EQ(latency_trace_percentile(&snapshot, 100), 5000);
+
+    /* The last bucket is open ended */
+    latency_trace_record(TRACE_SPAN_UPDATE, 0, 1ll << 30);
+    latency_trace_record(TRACE_SPAN_UPDATE, 0, 1ll << 40);
+    latency_trace_snapshot(TRACE_SPAN_UPDATE, &snapshot);
+    CHECK_EQ(snapshot.buckets[LATENCY_TRACE_BUCKETS - 1], 2);
+    CHECK_EQ(snapshot.max_us, UINT32_MAX);
+    CHECK_EQ(latency_trace_percentile(&snapshot, 100), UINT32_MAX);
+
+    latency_trace_snapshot(TRACE_SPAN_EDGE_TO_REPORT, &snapshot);
+    CHECK_EQ(snapshot.count, 0);
+    CHECK_EQ(latency_trace_percentile(&snapshot, 99), 0);
+
+    latency_trace_reset();
+    latency_trace_snapshot(TRACE_SPAN_UPDATE, &snapshot);
+    CHECK_EQ(snapshot.count, 0);
+    CHECK_EQ(snapshot.min_us, 0);
+    CHECK_EQ(snapshot.max_us, 0);
+}
+
+static const struct {
+    const char *name;
+    void (*run)();
+} k_groups[] = {
+    { "debounce", check_debounce },
+    { "ring", check_ring },
+    { "policy", check_policy },
+    { "persist", check_persist },
+    { "telemetry", check_telemetry },
+    { "storm", check_storm },
+    { "latency", check_latency },
+};
+
+int main(int argc, char **argv)
+{
+    int run = 0;
+    for (const auto &group : k_groups) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; i++) {
+            selected |= strcmp(argv[i], group.name) == 0;
+        }
+        if (!selected) {
+            continue;
+        }
+        int before = s_failures;
+        group.run();
+        printf("%-10s %s\n", group.name, s_failures == before ? "ok" : "FAILED");
+        run++;
+    }
+    if (run == 0) {
+        fprintf(stderr, "Usage: %s [group]...\n", argv[0]);
+        return 2;
+    }
+    return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+#!/bin/sh
+# Delta OTA round trip for CTest: two generated images (app image magic, then pseudo-random
+# bytes, the new one with changed, inserted and removed runs), a patch between them from
+# delta_ota, and ota_bench applying it through main/app_ota.cpp.
+#
+#     ota_delta.sh <delta_ota> <ota_bench> <work_dir>
+set -e
+delta_ota=$1
+ota_bench=$2
+dir=$3
+mkdir -p "$dir"
+export LC_ALL=C
+
+# 256 KB from a fixed seed; a second seed for the runs the new image changes
+gen() {
+    awk -v seed="$1" -v n="$2" 'BEGIN { srand(seed); for (i = 0; i < n; i++) printf "%c", int(rand() * 255) + 1 }'
+}
+{ printf '\351'; gen 1 262143; } > "$dir/old.bin"
+{
+    head -c 65536 "$dir/old.bin"
+    gen 2 300
+    tail -c +65537 "$dir/old.bin" | head -c 100000
+    tail -c +170000 "$dir/old.bin"
+} > "$dir/new.bin"
+
+"$delta_ota" diff "$dir/old.bin" "$dir/new.bin" "$dir/patch.bin"
+"$ota_bench" -d "$dir" "$dir/old.bin" "$dir/new.bin" "$dir/patch.bin"
@@ -0,0 +1,24 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+/* Host stand-in for the generic BSP: one button and one LED */
+
+#include <iot_button.h>
+#include <led_indicator.h>
+
+#define BSP_BUTTON_NUM 1
+
+enum {
+    BSP_LED_ON = 0,
+    BSP_LED_OFF,
+};
+
+esp_err_t bsp_iot_button_create(button_handle_t btn_array[], int *btn_cnt, int btn_array_size);
+esp_err_t bsp_led_indicator_create(led_indicator_handle_t led_array[], int *led_cnt, int led_array_size);
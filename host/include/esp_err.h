@@ -0,0 +1,38 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+/* Host stand-in for the ESP-IDF error codes */
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_INVALID_SIZE 0x104
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_NOT_SUPPORTED 0x106
+#define ESP_ERR_TIMEOUT 0x107
+
+#define ESP_ERROR_CHECK(x)                                                                       \
+    do {                                                                                         \
+        esp_err_t _err = (x);                                                                    \
+        if (_err != ESP_OK) {                                                                    \
+            host_error_check_failed(_err, __FILE__, __LINE__, #x);                               \
+        }                                                                                        \
+    } while (0)
+
+/** Abort the host program with a message, like the firmware does on ESP_ERROR_CHECK */
+[[noreturn]] void host_error_check_failed(esp_err_t err, const char *file, int line, const char *expr);
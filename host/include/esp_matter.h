@@ -0,0 +1,273 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+/*
+ * Host stand-in for the subset of the esp_matter data model API used by the driver layer.
+ *
+ * Endpoints and attributes live in fixed tables created by host_matter_* (host_sim.h);
+ * attribute::update() runs the node attribute callback (PRE_UPDATE, store, POST_UPDATE)
+ * synchronously like esp_matter does, and counts and timestamps every update. The client
+ * API (bindings, invoke) targets endpoints of the same node, see host_matter_bind().
+ */
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+#include <lib/core/CHIPError.h>
+
+namespace chip {
+typedef uint16_t EndpointId;
+typedef uint32_t ClusterId;
+typedef uint32_t AttributeId;
+typedef uint32_t CommandId;
+typedef uint16_t GroupId;
+typedef uint8_t FabricIndex;
+
+static constexpr EndpointId kInvalidEndpointId = 0xFFFF;
+
+struct NullOptionalType {
+};
+static constexpr NullOptionalType NullOptional{};
+
+template <typename T>
+class Optional {
+public:
+    Optional() : mHasValue(false), mValue() {}
+    Optional(NullOptionalType) : mHasValue(false), mValue() {}
+    explicit Optional(const T &value) : mHasValue(true), mValue(value) {}
+    bool HasValue() const { return mHasValue; }
+    const T &Value() const { return mValue; }
+
+private:
+    bool mHasValue;
+    T mValue;
+};
+
+namespace TLV {
+class TLVReader;
+} // namespace TLV
+
+namespace app {
+
+struct CommandPathParams {
+    EndpointId mEndpointId = 0;
+    GroupId mGroupId = 0;
+    ClusterId mClusterId = 0;
+    CommandId mCommandId = 0;
+};
+
+struct ConcreteCommandPath {
+    EndpointId mEndpointId;
+    ClusterId mClusterId;
+    CommandId mCommandId;
+};
+
+/* Command response status, success or a Protocols::InteractionModel::Status code */
+struct StatusIB {
+    uint8_t mStatus = 0;
+    bool IsSuccess() const { return mStatus == 0; }
+};
+
+namespace Clusters {
+
+namespace OnOff {
+static constexpr ClusterId Id = 0x0006;
+namespace Attributes {
+namespace OnOff {
+static constexpr AttributeId Id = 0x0000;
+} // namespace OnOff
+} // namespace Attributes
+namespace Commands {
+namespace Off {
+static constexpr CommandId Id = 0x00;
+} // namespace Off
+namespace On {
+static constexpr CommandId Id = 0x01;
+} // namespace On
+namespace Toggle {
+static constexpr CommandId Id = 0x02;
+} // namespace Toggle
+} // namespace Commands
+} // namespace OnOff
+
+namespace LevelControl {
+static constexpr ClusterId Id = 0x0008;
+namespace Attributes {
+namespace CurrentLevel {
+static constexpr AttributeId Id = 0x0000;
+} // namespace CurrentLevel
+} // namespace Attributes
+} // namespace LevelControl
+
+namespace BooleanState {
+static constexpr ClusterId Id = 0x0045;
+namespace Attributes {
+namespace StateValue {
+static constexpr AttributeId Id = 0x0000;
+} // namespace StateValue
+} // namespace Attributes
+} // namespace BooleanState
+
+namespace ColorControl {
+static constexpr ClusterId Id = 0x0300;
+enum class ColorMode : uint8_t {
+    kCurrentHueAndCurrentSaturation = 0,
+    kCurrentXAndCurrentY = 1,
+    kColorTemperature = 2,
+};
+namespace Attributes {
+namespace CurrentHue {
+static constexpr AttributeId Id = 0x0000;
+} // namespace CurrentHue
+namespace CurrentSaturation {
+static constexpr AttributeId Id = 0x0001;
+} // namespace CurrentSaturation
+namespace CurrentX {
+static constexpr AttributeId Id = 0x0003;
+} // namespace CurrentX
+namespace CurrentY {
+static constexpr AttributeId Id = 0x0004;
+} // namespace CurrentY
+namespace ColorTemperatureMireds {
+static constexpr AttributeId Id = 0x0007;
+} // namespace ColorTemperatureMireds
+namespace ColorMode {
+static constexpr AttributeId Id = 0x0008;
+} // namespace ColorMode
+} // namespace Attributes
+} // namespace ColorControl
+
+} // namespace Clusters
+} // namespace app
+} // namespace chip
+
+#define REMAP_TO_RANGE(value, from, to) ((value * to) / from)
+#define REMAP_TO_RANGE_INVERSE(value, factor) (factor / (value ? value : 1))
+
+typedef enum {
+    ESP_MATTER_VAL_TYPE_INVALID = 0,
+    ESP_MATTER_VAL_TYPE_BOOLEAN,
+    ESP_MATTER_VAL_TYPE_UINT8,
+    ESP_MATTER_VAL_TYPE_UINT16,
+    ESP_MATTER_VAL_TYPE_UINT32,
+    ESP_MATTER_VAL_TYPE_ENUM8,
+} esp_matter_val_type_t;
+
+typedef struct {
+    esp_matter_val_type_t type;
+    union {
+        bool b;
+        uint8_t u8;
+        uint16_t u16;
+        uint32_t u32;
+        void *p;
+    } val;
+} esp_matter_attr_val_t;
+
+esp_matter_attr_val_t esp_matter_invalid(void *val);
+esp_matter_attr_val_t esp_matter_bool(bool val);
+esp_matter_attr_val_t esp_matter_uint8(uint8_t val);
+esp_matter_attr_val_t esp_matter_uint16(uint16_t val);
+esp_matter_attr_val_t esp_matter_enum8(uint8_t val);
+
+/* Defined by the stand-in, opaque to the application like the esp_matter handles */
+struct host_node;
+struct host_endpoint;
+struct host_cluster;
+struct host_attribute;
+struct host_peer;
+
+namespace esp_matter {
+
+typedef ::host_node node_t;
+typedef ::host_endpoint endpoint_t;
+typedef ::host_cluster cluster_t;
+typedef ::host_attribute attribute_t;
+
+namespace node {
+node_t *get();
+} // namespace node
+
+namespace endpoint {
+endpoint_t *get(node_t *node, uint16_t endpoint_id);
+uint16_t get_id(endpoint_t *endpoint);
+void *get_priv_data(uint16_t endpoint_id);
+} // namespace endpoint
+
+namespace cluster {
+cluster_t *get(endpoint_t *endpoint, uint32_t cluster_id);
+} // namespace cluster
+
+namespace attribute {
+typedef enum {
+    PRE_UPDATE = 0,
+    POST_UPDATE,
+    READ,
+    WRITE,
+} callback_type_t;
+
+typedef esp_err_t (*callback_t)(callback_type_t type, uint16_t endpoint_id, uint32_t cluster_id,
+                                uint32_t attribute_id, esp_matter_attr_val_t *val, void *priv_data);
+
+attribute_t *get(cluster_t *cluster, uint32_t attribute_id);
+esp_err_t get_val(attribute_t *attribute, esp_matter_attr_val_t *val);
+esp_err_t update(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id, esp_matter_attr_val_t *val);
+} // namespace attribute
+
+namespace client {
+/* Bound peer: an endpoint of this node on the host */
+typedef ::host_peer peer_device_t;
+
+typedef enum {
+    INVOKE_CMD = 0,
+    WRITE_ATTR,
+    READ_ATTR,
+    SUBSCRIBE_ATTR,
+} request_type_t;
+
+typedef struct request_handle {
+    request_type_t type = INVOKE_CMD;
+    chip::app::CommandPathParams command_path;
+    void *request_data = NULL;
+} request_handle_t;
+
+typedef void (*request_callback_t)(peer_device_t *peer_device, request_handle_t *req_handle, void *priv_data);
+typedef void (*group_request_callback_t)(uint8_t fabric_index, request_handle_t *req_handle, void *priv_data);
+
+esp_err_t set_request_callback(request_callback_t callback, group_request_callback_t g_callback, void *priv_data);
+
+/** Run the request callback for every binding of the local endpoint matching the cluster */
+esp_err_t cluster_update(uint16_t local_endpoint_id, request_handle_t *req_handle);
+
+namespace interaction {
+namespace custom_command_callback {
+typedef void (*on_success_callback_t)(void *ctx, const chip::app::ConcreteCommandPath &command_path,
+                                      const chip::app::StatusIB &status, chip::TLV::TLVReader *response_data);
+typedef void (*on_error_callback_t)(void *ctx, CHIP_ERROR error);
+} // namespace custom_command_callback
+
+namespace invoke {
+/** Queue the command to the peer endpoint; it is applied and answered on the next Matter turn */
+esp_err_t send_request(void *ctx, peer_device_t *remote_device, const chip::app::CommandPathParams &command_path,
+                       const char *command_data_json_str,
+                       custom_command_callback::on_success_callback_t on_success,
+                       custom_command_callback::on_error_callback_t on_error,
+                       const chip::Optional<uint16_t> &timed_invoke_timeout_ms);
+
+/** Queue the command to every member endpoint of the group, no response */
+esp_err_t send_group_request(uint8_t fabric_index, const chip::app::CommandPathParams &command_path,
+                             const char *command_data_json_str);
+} // namespace invoke
+} // namespace interaction
+} // namespace client
+
+} // namespace esp_matter
@@ -0,0 +1,23 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+/* Host stand-in for the shutdown handlers, run by host_system_restart() (host_sim.h), and
+ * the heap size */
+
+#include <stdint.h>
+
+#include <esp_err.h>
+
+typedef void (*shutdown_handler_t)(void);
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handle);
+
+/** A fixed HOST_FREE_HEAP: the host has no device heap, driver_bench counts the allocations */
+uint32_t esp_get_free_heap_size(void);
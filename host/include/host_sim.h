@@ -0,0 +1,234 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_matter.h>
+#include <esp_partition.h>
+#include <iot_button.h>
+
+/*
+ * Control side of the host stand-ins.
+ *
+ * The host build runs the driver layer in one thread against a simulated clock
+ * (latency_fake_clock_*, which esp_timer_get_time() returns). The replay loop plays the
+ * roles of the GPIO interrupt and esp_timer task (host_contact_*, host_timer_run()) and of
+ * the Matter thread (host_platform_run_work()). Call durations are measured on the wall clock and kept as
+ * samples for percentiles.
+ */
+
+/** Wall clock, in nanoseconds */
+uint64_t host_wall_ns();
+
+/** Timed call sites */
+typedef enum {
+    HOST_SAMPLE_CONTACT_CB = 0, /* debounce timer expiry, including the driver contact callback */
+    HOST_SAMPLE_MATTER_WORK,    /* one ScheduleWork() item on the Matter thread */
+    HOST_SAMPLE_ATTRIBUTE_CB,   /* node attribute callback (driver dispatch) */
+    HOST_SAMPLE_LED,            /* led_indicator call */
+    HOST_SAMPLE_MAX,
+} host_sample_kind_t;
+
+typedef struct {
+    uint32_t *ns;      /* durations, in call order */
+    size_t count;
+    size_t capacity;
+    uint64_t overflow; /* samples lost because the buffer was full */
+} host_samples_t;
+
+/** Allocate the sample buffers, before the measured section */
+void host_samples_reserve(size_t capacity);
+void host_samples_reset();
+host_samples_t *host_samples(host_sample_kind_t kind);
+void host_samples_add(host_sample_kind_t kind, uint64_t ns);
+
+/** esp_timer stand-in */
+
+/** Manually driven clock, which esp_timer_get_time() returns; step it from the replay */
+int64_t latency_fake_clock_now(void);
+void latency_fake_clock_set(int64_t now_us);
+void latency_fake_clock_advance(int64_t delta_us);
+
+/** Simulation time of the earliest armed esp_timer, INT64_MAX if none
+ *
+ * @param[in] include_periodic false to only look at one-shot timers, e.g. to let pending
+ *            work settle without running forever.
+ */
+int64_t host_timer_next_deadline(bool include_periodic);
+
+/** Fire every esp_timer due at the current simulation time */
+void host_timer_run();
+
+/** Matter work queue, bounded like CHIP_DEVICE_CONFIG_MAX_EVENT_QUEUE_SIZE on target */
+#define HOST_WORK_QUEUE_LEN 40
+
+typedef struct {
+    uint32_t scheduled;  /* items accepted */
+    uint32_t rejected;   /* items refused on a full queue */
+    uint32_t run;        /* items executed */
+    uint32_t high_water; /* deepest the queue has been */
+} host_work_stats_t;
+
+/** Run queued work until the queue is empty, as one Matter event loop turn
+ *
+ * @return number of items run.
+ */
+size_t host_platform_run_work();
+void host_platform_get_stats(host_work_stats_t *stats);
+
+/** Data model */
+typedef struct {
+    uint32_t updates;   /* attribute::update() calls */
+    uint32_t unchanged; /* updates that did not change the stored value */
+    uint32_t not_found; /* updates of an unknown attribute */
+} host_matter_stats_t;
+
+/** Create the node, with the attribute callback the application registers in app_main */
+void host_matter_init(esp_matter::attribute::callback_t attribute_cb);
+
+/** Add an extended color light endpoint, returns its ID */
+uint16_t host_matter_create_light(void *priv_data);
+
+/** Add a contact sensor endpoint, returns its ID
+ *
+ * @param[in] state_value Initial BooleanState StateValue.
+ */
+uint16_t host_matter_create_contact(bool state_value);
+
+void host_matter_get_stats(host_matter_stats_t *stats);
+
+/** Bindings (Binding cluster and OnOff client stand-in)
+ *
+ * Targets are endpoints of this node, e.g. stand-in lights from host_matter_create_light().
+ * Commands sent through the esp_matter client API are applied to them with
+ * attribute::update() one hop delay later, on the Matter thread; unicast commands are
+ * answered after one more hop.
+ */
+typedef struct {
+    uint32_t unicast;   /* commands sent to a bound endpoint */
+    uint32_t group;     /* group commands sent */
+    uint32_t delivered; /* commands applied to an endpoint, one per group member */
+    uint32_t rejected;  /* commands refused: queue full, or no OnOff cluster on the target */
+} host_binding_stats_t;
+
+/** Add a unicast binding from a local endpoint to a target endpoint */
+esp_err_t host_matter_bind(uint16_t local_endpoint_id, uint16_t target_endpoint_id);
+
+/** Add a group binding from a local endpoint */
+esp_err_t host_matter_bind_group(uint16_t local_endpoint_id, uint16_t group_id);
+
+/** Make an endpoint a member of a group */
+esp_err_t host_matter_group_add(uint16_t group_id, uint16_t endpoint_id);
+
+/** Remove every binding and group membership */
+void host_matter_unbind_all();
+
+void host_matter_get_binding_stats(host_binding_stats_t *stats);
+
+/** One-way delay between the node and its bound devices, in simulation time (default 0) */
+void host_matter_set_hop_delay(uint32_t hop_us);
+
+/** Contact inputs (app_contact_create() stand-in) */
+
+/** Drive the input of a channel, as the GPIO interrupt would see it
+ *
+ * Before the channel is created this only sets the pin level it will latch.
+ *
+ * @param[in] channel Channel index, in creation order.
+ * @param[in] closed New input level.
+ */
+void host_contact_set_input(uint16_t channel, bool closed);
+
+/** Simulation time of the earliest armed debounce timer, INT64_MAX if none */
+int64_t host_contact_next_deadline();
+
+/** Fire every debounce timer due at the current simulation time */
+void host_contact_run_timers();
+
+/** Button and LED */
+void host_button_fire(button_event_t event);
+
+typedef struct {
+    uint32_t calls;
+    bool on;
+    uint32_t brightness;
+    uint32_t hsv;
+    uint32_t temperature;
+} host_led_state_t;
+
+void host_led_get_state(host_led_state_t *state);
+
+/** Busy-wait this long in every LED write, to model the cost of the real driver transaction */
+void host_led_set_write_cost(uint32_t ns);
+
+/** Application stand-ins (telemetry, event log, deferred log) */
+typedef struct {
+    uint32_t contact_edges; /* app_telemetry_contact_edge() */
+    uint32_t latencies;     /* app_telemetry_latency() */
+    uint32_t evlog_records; /* app_evlog_record() */
+    uint32_t log_records;   /* deferred log records committed */
+} host_app_stats_t;
+
+void host_app_get_stats(host_app_stats_t *stats);
+
+/** App slots (esp_partition and esp_ota_ops stand-ins)
+ *
+ * ota_0 runs, ota_1 takes updates. Each slot is a file in a directory of the caller, so a
+ * run leaves the rebuilt image behind to inspect.
+ */
+typedef struct {
+    uint32_t reads;
+    uint64_t read_bytes;
+    uint32_t writes;
+    uint64_t write_bytes;
+    uint32_t erases;     /* 4 KB sectors */
+} host_flash_stats_t;
+
+/** Create both slot files, erased
+ *
+ * @param[in] dir Existing directory.
+ * @param[in] slot_size Slot size, a multiple of 4 KB.
+ */
+esp_err_t host_ota_init(const char *dir, uint32_t slot_size);
+
+/** Flash the image the node runs into ota_0 */
+esp_err_t host_ota_flash_running(const uint8_t *image, size_t len);
+
+/** Slot the last esp_ota_set_boot_partition() selected, NULL if none */
+const esp_partition_t *host_ota_get_boot_partition();
+
+void host_ota_get_flash_stats(host_flash_stats_t *stats);
+void host_ota_reset_flash_stats();
+
+/** NVS (nvs stand-in), see stubs/host_nvs.cpp */
+typedef struct {
+    uint32_t pages;
+    uint32_t sets;              /* nvs_set_blob() calls */
+    uint32_t unchanged;         /* sets of the stored value, not written */
+    uint32_t commits;
+    uint32_t full;              /* writes refused, no entry left after collection */
+    uint64_t entry_writes;      /* 32 byte entries written, relocations included */
+    uint64_t relocated_entries; /* live entries copied out of a page before its erase */
+    uint32_t page_erases;
+    uint32_t max_page_erases;   /* erases of the most worn page */
+} host_nvs_stats_t;
+
+/** Erase the partition and the counters
+ *
+ * @param[in] partition_bytes Partition size, a multiple of 4 KB. Without a reset the first
+ *            call sets up the 48 KB nvs partition of the firmware.
+ */
+void host_nvs_reset(uint32_t partition_bytes);
+
+void host_nvs_get_stats(host_nvs_stats_t *stats);
+
+/** Run the handlers of esp_register_shutdown_handler(), as esp_restart() does */
+void host_system_restart();
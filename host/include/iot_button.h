@@ -0,0 +1,26 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+/* Host stand-in for espressif/button: callbacks are recorded and fired by the bench */
+
+#include <esp_err.h>
+
+typedef void *button_handle_t;
+typedef void (*button_cb_t)(void *button_handle, void *usr_data);
+
+typedef enum {
+    BUTTON_PRESS_DOWN = 0,
+    BUTTON_PRESS_UP,
+    BUTTON_SINGLE_CLICK,
+    BUTTON_LONG_PRESS_START,
+    BUTTON_EVENT_MAX,
+} button_event_t;
+
+esp_err_t iot_button_register_cb(button_handle_t btn_handle, button_event_t event, button_cb_t cb, void *usr_data);
@@ -0,0 +1,35 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+/* Host stand-in for espressif/led_indicator: every call is counted and timed */
+
+#include <stdint.h>
+
+#include <esp_err.h>
+
+typedef void *led_indicator_handle_t;
+
+typedef union {
+    struct {
+        uint32_t v : 8;
+        uint32_t s : 8;
+        uint32_t h : 9;
+        uint32_t i : 7;
+    };
+    uint32_t value;
+} led_indicator_ihsv_t;
+
+#define SET_HSV(h, s, v) ((((h) & 0x1FF) << 16) | (((s) & 0xFF) << 8) | ((v) & 0xFF))
+
+esp_err_t led_indicator_start(led_indicator_handle_t handle, int blink_type);
+esp_err_t led_indicator_set_brightness(led_indicator_handle_t handle, uint32_t brightness);
+esp_err_t led_indicator_set_hsv(led_indicator_handle_t handle, uint32_t ihsv_value);
+uint32_t led_indicator_get_hsv(led_indicator_handle_t handle);
+esp_err_t led_indicator_set_color_temperature(led_indicator_handle_t handle, uint32_t temperature);
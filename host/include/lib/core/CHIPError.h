@@ -0,0 +1,30 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+/* Host stand-in for the CHIP error type, compared and formatted as on target */
+
+#include <inttypes.h>
+#include <stdint.h>
+
+namespace chip {
+
+struct ChipError {
+    uint32_t mCode;
+    uint32_t Format() const { return mCode; }
+    bool operator==(const ChipError &other) const { return mCode == other.mCode; }
+    bool operator!=(const ChipError &other) const { return mCode != other.mCode; }
+};
+
+} // namespace chip
+
+using CHIP_ERROR = ::chip::ChipError;
+#define CHIP_NO_ERROR (::chip::ChipError{ 0 })
+#define CHIP_ERROR_NO_MEMORY (::chip::ChipError{ 0x0b })
+#define CHIP_ERROR_FORMAT PRIx32
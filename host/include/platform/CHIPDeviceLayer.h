@@ -0,0 +1,37 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+/*
+ * Host stand-in for the Matter platform manager: ScheduleWork() queues into a bounded
+ * work queue, run by the simulation loop as the Matter thread.
+ */
+
+#include <stdint.h>
+
+#include <lib/core/CHIPError.h>
+
+namespace chip {
+namespace DeviceLayer {
+
+typedef void (*AsyncWorkFunct)(intptr_t arg);
+
+class PlatformManager {
+public:
+    /** Returns CHIP_ERROR_NO_MEMORY when the queue is full */
+    CHIP_ERROR ScheduleWork(AsyncWorkFunct workFunct, intptr_t arg = 0);
+    /* The host runs the Matter work in the caller's thread, there is nothing to lock */
+    void LockChipStack() {}
+    void UnlockChipStack() {}
+};
+
+PlatformManager &PlatformMgr();
+
+} // namespace DeviceLayer
+} // namespace chip
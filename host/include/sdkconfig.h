@@ -0,0 +1,67 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+/*
+ * Configuration of the host build: the menuconfig defaults of the firmware (full light
+ * profile). Built with HOST_FLEET, a fleet of synthetic contact inputs follows the door and
+ * window channels.
+ */
+
+#define CONFIG_APP_PROFILE_FULL_LIGHT 1
+#define CONFIG_APP_HAS_LIGHT 1
+#define CONFIG_APP_LIGHT_RENDER_HZ 50
+#define CONFIG_APP_HAS_COLOR_LIGHT 1
+#define CONFIG_BSP_LEDS_NUM 1
+
+#define CONFIG_APP_CONTACT_MAX_CHANNELS 16
+#define CONFIG_APP_CONTACT_SETTLE_MS 5
+#define CONFIG_APP_CONTACT_LEADING_EDGE 1
+#define CONFIG_APP_CONTACT_QUEUE_LEN 64
+#define CONFIG_APP_CONTACT_DRAIN_BATCH 32
+#define CONFIG_APP_REPORT_MIN_INTERVAL_MS 0
+#define CONFIG_APP_REPORT_HOLDOFF_MS 0
+#define CONFIG_APP_REPORT_MAX_PER_WINDOW 0
+#define CONFIG_APP_REPORT_WINDOW_SEC 60
+
+#define CONFIG_APP_BINDING_ENABLE 1
+#define CONFIG_APP_BINDING_OPEN_ACTION 1
+#define CONFIG_APP_BINDING_CLOSE_ACTION 0
+
+#define CONFIG_APP_STORM_ENABLE 1
+#define CONFIG_APP_STORM_BATCH 32
+
+#define CONFIG_APP_PERSIST_DELAY_MS 5000
+#define CONFIG_APP_PERSIST_CACHE_ENTRIES 32
+
+#define CONFIG_APP_DELTA_OTA 1
+#define CONFIG_APP_DELTA_OTA_WINDOW_BITS 12
+
+#define CONFIG_APP_DEFERRED_LOG 1
+#define CONFIG_APP_DLOG_RING_LEN 64
+#define CONFIG_APP_DLOG_LINE_LEN 160
+#define CONFIG_LOG_MAXIMUM_LEVEL 3
+
+#define CONFIG_ESP_MATTER_MAX_DYNAMIC_ENDPOINT_COUNT 16
+
+#if HOST_FLEET
+/* Synthetic contact inputs appended to k_contact_channels, channel 2 onwards */
+#define HOST_FLEET_ROW { .name = "fleet", .gpio_num = GPIO_NUM_NC, .active_level = 0 },
+#define HOST_FLEET_ROWS_8 HOST_FLEET_ROW HOST_FLEET_ROW HOST_FLEET_ROW HOST_FLEET_ROW \
+                          HOST_FLEET_ROW HOST_FLEET_ROW HOST_FLEET_ROW HOST_FLEET_ROW
+#define HOST_FLEET_ROWS_64 HOST_FLEET_ROWS_8 HOST_FLEET_ROWS_8 HOST_FLEET_ROWS_8 HOST_FLEET_ROWS_8 \
+                           HOST_FLEET_ROWS_8 HOST_FLEET_ROWS_8 HOST_FLEET_ROWS_8 HOST_FLEET_ROWS_8
+#define HOST_FLEET_ROWS_512 HOST_FLEET_ROWS_64 HOST_FLEET_ROWS_64 HOST_FLEET_ROWS_64 HOST_FLEET_ROWS_64 \
+                            HOST_FLEET_ROWS_64 HOST_FLEET_ROWS_64 HOST_FLEET_ROWS_64 HOST_FLEET_ROWS_64
+#define HOST_FLEET_CHANNELS 4096
+#define APP_CONTACT_EXTRA_CHANNELS HOST_FLEET_ROWS_512 HOST_FLEET_ROWS_512 HOST_FLEET_ROWS_512 HOST_FLEET_ROWS_512 \
+                                   HOST_FLEET_ROWS_512 HOST_FLEET_ROWS_512 HOST_FLEET_ROWS_512 HOST_FLEET_ROWS_512
+#else
+#define HOST_FLEET_CHANNELS 0
+#endif // HOST_FLEET
@@ -0,0 +1,57 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Host stand-ins for the application services the driver layer calls into: the telemetry
+ * stream, the contact event log and the deferred log task. Records are counted; deferred
+ * log records are formatted and printed when the host log level lets them through.
+ */
+
+#include <string.h>
+
+#include <esp_log.h>
+
+#include <app_priv.h>
+#include "dlog.h"
+#include "host_sim.h"
+
+static host_app_stats_t s_app_stats;
+
+void host_app_get_stats(host_app_stats_t *stats)
+{
+    *stats = s_app_stats;
+}
+
+void app_telemetry_contact_edge(uint8_t channel, bool closed, int64_t edge_us)
+{
+    s_app_stats.contact_edges++;
+}
+
+void app_telemetry_latency(uint8_t span, uint32_t value_us)
+{
+    s_app_stats.latencies++;
+}
+
+void app_evlog_record(uint16_t endpoint_id, bool closed, uint16_t transitions)
+{
+    s_app_stats.evlog_records++;
+}
+
+void dlog_commit(dlog_record_t *record)
+{
+    s_app_stats.log_records++;
+    if (host_log_level < record->desc->level) {
+        return;
+    }
+    static const dlog_abi_t abi = DLOG_ABI_NATIVE;
+    char text[CONFIG_APP_DLOG_LINE_LEN];
+    dlog_format(&abi, record->desc->fmt, record->words, record->nwords, NULL, NULL, text, sizeof(text));
+    esp_log_write((esp_log_level_t)record->desc->level, record->tag, "%s %s: %s%s\n",
+                  dlog_level_letter(record->desc->level), record->tag, text,
+                  record->truncated ? " [args truncated]" : "");
+}
@@ -0,0 +1,115 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "bsp/esp-bsp.h"
+
+#include "host_sim.h"
+
+typedef struct {
+    button_cb_t cb;
+    void *usr_data;
+} host_button_cb_t;
+
+/* One button, like BSP_BUTTON_NUM on the generic board */
+static host_button_cb_t s_button_cbs[BUTTON_EVENT_MAX];
+static int s_button;
+static host_led_state_t s_led;
+static uint32_t s_led_write_cost_ns = 0;
+
+/* Every led_indicator call is timed and counted, the state is kept for checks */
+#define HOST_LED_CALL(body)                                                                      \
+    do {                                                                                         \
+        uint64_t _start = host_wall_ns();                                                        \
+        s_led.calls++;                                                                           \
+        body;                                                                                    \
+        while (host_wall_ns() - _start < s_led_write_cost_ns) {                                  \
+        }                                                                                        \
+        host_samples_add(HOST_SAMPLE_LED, host_wall_ns() - _start);                              \
+    } while (0)
+
+void host_led_set_write_cost(uint32_t ns)
+{
+    s_led_write_cost_ns = ns;
+}
+
+esp_err_t bsp_iot_button_create(button_handle_t btn_array[], int *btn_cnt, int btn_array_size)
+{
+    if (btn_array_size < BSP_BUTTON_NUM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    btn_array[0] = &s_button;
+    if (btn_cnt) {
+        *btn_cnt = BSP_BUTTON_NUM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t iot_button_register_cb(button_handle_t btn_handle, button_event_t event, button_cb_t cb, void *usr_data)
+{
+    if (btn_handle != &s_button || event >= BUTTON_EVENT_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_button_cbs[event] = { cb, usr_data };
+    return ESP_OK;
+}
+
+void host_button_fire(button_event_t event)
+{
+    if (event < BUTTON_EVENT_MAX && s_button_cbs[event].cb) {
+        s_button_cbs[event].cb(&s_button, s_button_cbs[event].usr_data);
+    }
+}
+
+esp_err_t bsp_led_indicator_create(led_indicator_handle_t led_array[], int *led_cnt, int led_array_size)
+{
+    if (led_array_size < 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(&s_led, 0, sizeof(s_led));
+    led_array[0] = &s_led;
+    if (led_cnt) {
+        *led_cnt = 1;
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_indicator_start(led_indicator_handle_t handle, int blink_type)
+{
+    HOST_LED_CALL(s_led.on = blink_type == BSP_LED_ON);
+    return ESP_OK;
+}
+
+esp_err_t led_indicator_set_brightness(led_indicator_handle_t handle, uint32_t brightness)
+{
+    HOST_LED_CALL(s_led.brightness = brightness);
+    return ESP_OK;
+}
+
+esp_err_t led_indicator_set_hsv(led_indicator_handle_t handle, uint32_t ihsv_value)
+{
+    HOST_LED_CALL(s_led.hsv = ihsv_value);
+    return ESP_OK;
+}
+
+uint32_t led_indicator_get_hsv(led_indicator_handle_t handle)
+{
+    return s_led.hsv;
+}
+
+esp_err_t led_indicator_set_color_temperature(led_indicator_handle_t handle, uint32_t temperature)
+{
+    HOST_LED_CALL(s_led.temperature = temperature);
+    return ESP_OK;
+}
+
+void host_led_get_state(host_led_state_t *state)
+{
+    *state = s_led;
+}
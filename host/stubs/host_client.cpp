@@ -0,0 +1,307 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Host stand-in for the esp_matter client API and the Binding cluster: a binding table per
+ * endpoint, group memberships, and commands delivered to endpoints of the same node. The
+ * network is one fixed hop delay each way (host_matter_set_hop_delay()): a command is
+ * applied one hop after it was sent and a unicast command is answered one hop later, both
+ * on a later Matter turn. Commands and responses keep their order, so one FIFO and one
+ * esp_timer on its head cover them.
+ */
+
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_matter.h>
+#include <esp_timer.h>
+#include <platform/CHIPDeviceLayer.h>
+
+#include "host_sim.h"
+
+using namespace chip::app::Clusters;
+using namespace esp_matter;
+
+static const char *TAG = "host_client";
+
+#define HOST_BINDING_MAX 32
+#define HOST_GROUP_MEMBERS_MAX 32
+#define HOST_COMMANDS_IN_FLIGHT 32
+
+struct host_peer {
+    uint16_t endpoint_id;
+};
+
+typedef struct {
+    uint16_t local_endpoint_id;
+    uint16_t target_endpoint_id; /* kInvalidEndpointId for a group binding */
+    uint16_t group_id;
+} host_binding_t;
+
+typedef struct {
+    uint16_t group_id;
+    uint16_t endpoint_id;
+} host_group_member_t;
+
+typedef struct {
+    int64_t due_us;
+    bool applied;    /* unicast command on its way back as a response */
+    bool success;
+    bool group;
+    uint16_t target; /* endpoint or group ID */
+    chip::CommandId command_id;
+    void *ctx;
+    client::interaction::custom_command_callback::on_success_callback_t on_success;
+    client::interaction::custom_command_callback::on_error_callback_t on_error;
+} host_command_t;
+
+static host_binding_t s_bindings[HOST_BINDING_MAX];
+static size_t s_binding_count = 0;
+static host_group_member_t s_members[HOST_GROUP_MEMBERS_MAX];
+static size_t s_member_count = 0;
+static host_command_t s_commands[HOST_COMMANDS_IN_FLIGHT];
+static size_t s_command_head = 0;
+static size_t s_command_count = 0;
+static host_binding_stats_t s_binding_stats;
+static esp_timer_handle_t s_hop_timer = NULL;
+static uint32_t s_hop_us = 0;
+
+static client::request_callback_t s_request_cb = NULL;
+static client::group_request_callback_t s_group_request_cb = NULL;
+static void *s_request_priv_data = NULL;
+
+esp_err_t host_matter_bind(uint16_t local_endpoint_id, uint16_t target_endpoint_id)
+{
+    if (s_binding_count == HOST_BINDING_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_bindings[s_binding_count++] = { local_endpoint_id, target_endpoint_id, 0 };
+    return ESP_OK;
+}
+
+esp_err_t host_matter_bind_group(uint16_t local_endpoint_id, uint16_t group_id)
+{
+    if (s_binding_count == HOST_BINDING_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_bindings[s_binding_count++] = { local_endpoint_id, chip::kInvalidEndpointId, group_id };
+    return ESP_OK;
+}
+
+esp_err_t host_matter_group_add(uint16_t group_id, uint16_t endpoint_id)
+{
+    if (s_member_count == HOST_GROUP_MEMBERS_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_members[s_member_count++] = { group_id, endpoint_id };
+    return ESP_OK;
+}
+
+void host_matter_unbind_all()
+{
+    s_binding_count = 0;
+    s_member_count = 0;
+}
+
+void host_matter_get_binding_stats(host_binding_stats_t *stats)
+{
+    *stats = s_binding_stats;
+}
+
+void host_matter_set_hop_delay(uint32_t hop_us)
+{
+    s_hop_us = hop_us;
+}
+
+/* What the OnOff cluster server of the target does with the command */
+static bool host_client_apply(uint16_t endpoint_id, chip::CommandId command_id)
+{
+    attribute_t *attribute = attribute::get(cluster::get(endpoint::get(node::get(), endpoint_id), OnOff::Id),
+                                            OnOff::Attributes::OnOff::Id);
+    if (!attribute) {
+        s_binding_stats.rejected++;
+        return false;
+    }
+    esp_matter_attr_val_t val = esp_matter_invalid(NULL);
+    attribute::get_val(attribute, &val);
+    if (command_id == OnOff::Commands::Toggle::Id) {
+        val.val.b = !val.val.b;
+    } else {
+        val.val.b = command_id == OnOff::Commands::On::Id;
+    }
+    attribute::update(endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id, &val);
+    s_binding_stats.delivered++;
+    return true;
+}
+
+static void host_client_arm()
+{
+    esp_timer_stop(s_hop_timer);
+    if (s_command_count > 0) {
+        int64_t due = s_commands[s_command_head].due_us - esp_timer_get_time();
+        esp_timer_start_once(s_hop_timer, due > 0 ? due : 0);
+    }
+}
+
+static esp_err_t host_client_push(const host_command_t *command)
+{
+    if (s_command_count == HOST_COMMANDS_IN_FLIGHT) {
+        s_binding_stats.rejected++;
+        return ESP_ERR_NO_MEM;
+    }
+    s_commands[(s_command_head + s_command_count) % HOST_COMMANDS_IN_FLIGHT] = *command;
+    s_command_count++;
+    if (s_command_count == 1) {
+        host_client_arm();
+    }
+    return ESP_OK;
+}
+
+/* Matter thread: the target applies the commands that arrived, the responses that came
+ * back go to the sender */
+static void host_client_deliver(intptr_t arg)
+{
+    int64_t now = esp_timer_get_time();
+    while (s_command_count > 0 && s_commands[s_command_head].due_us <= now) {
+        host_command_t command = s_commands[s_command_head];
+        s_command_head = (s_command_head + 1) % HOST_COMMANDS_IN_FLIGHT;
+        s_command_count--;
+
+        if (command.group) {
+            for (size_t i = 0; i < s_member_count; i++) {
+                if (s_members[i].group_id == command.target) {
+                    host_client_apply(s_members[i].endpoint_id, command.command_id);
+                }
+            }
+        } else if (!command.applied) {
+            command.success = host_client_apply(command.target, command.command_id);
+            command.applied = true;
+            command.due_us = now + s_hop_us;
+            host_client_push(&command);
+        } else if (command.on_success) {
+            chip::app::StatusIB status;
+            /* UNSUPPORTED_CLUSTER */
+            status.mStatus = command.success ? 0 : 0xc3;
+            chip::app::ConcreteCommandPath path = { command.target, OnOff::Id, command.command_id };
+            command.on_success(command.ctx, path, status, NULL);
+        }
+    }
+    host_client_arm();
+}
+
+static void host_client_hop_timer_cb(void *arg)
+{
+    chip::DeviceLayer::PlatformMgr().ScheduleWork(host_client_deliver, 0);
+}
+
+static esp_err_t host_client_queue(host_command_t *command)
+{
+    if (!s_hop_timer) {
+        esp_timer_create_args_t timer_args = {
+            .callback = host_client_hop_timer_cb,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "host_hop",
+            .skip_unhandled_events = true,
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_hop_timer));
+    }
+    command->due_us = esp_timer_get_time() + s_hop_us;
+    return host_client_push(command);
+}
+
+namespace esp_matter {
+namespace client {
+
+esp_err_t set_request_callback(request_callback_t callback, group_request_callback_t g_callback, void *priv_data)
+{
+    s_request_cb = callback;
+    s_group_request_cb = g_callback;
+    s_request_priv_data = priv_data;
+    return ESP_OK;
+}
+
+esp_err_t cluster_update(uint16_t local_endpoint_id, request_handle_t *req_handle)
+{
+    for (size_t i = 0; i < s_binding_count; i++) {
+        const host_binding_t *binding = &s_bindings[i];
+        if (binding->local_endpoint_id != local_endpoint_id) {
+            continue;
+        }
+        if (binding->target_endpoint_id == chip::kInvalidEndpointId) {
+            if (s_group_request_cb) {
+                req_handle->command_path.mGroupId = binding->group_id;
+                s_group_request_cb(1, req_handle, s_request_priv_data);
+            }
+        } else if (s_request_cb) {
+            host_peer peer = { binding->target_endpoint_id };
+            req_handle->command_path.mEndpointId = binding->target_endpoint_id;
+            s_request_cb(&peer, req_handle, s_request_priv_data);
+        }
+    }
+    return ESP_OK;
+}
+
+namespace interaction {
+namespace invoke {
+
+esp_err_t send_request(void *ctx, peer_device_t *remote_device, const chip::app::CommandPathParams &command_path,
+                       const char *command_data_json_str,
+                       custom_command_callback::on_success_callback_t on_success,
+                       custom_command_callback::on_error_callback_t on_error,
+                       const chip::Optional<uint16_t> &timed_invoke_timeout_ms)
+{
+    if (!remote_device) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    host_command_t command = {
+        .due_us = 0,
+        .applied = false,
+        .success = false,
+        .group = false,
+        .target = remote_device->endpoint_id,
+        .command_id = command_path.mCommandId,
+        .ctx = ctx,
+        .on_success = on_success,
+        .on_error = on_error,
+    };
+    esp_err_t err = host_client_queue(&command);
+    if (err == ESP_OK) {
+        s_binding_stats.unicast++;
+    } else {
+        ESP_LOGW(TAG, "Command to endpoint %u dropped", remote_device->endpoint_id);
+    }
+    return err;
+}
+
+esp_err_t send_group_request(uint8_t fabric_index, const chip::app::CommandPathParams &command_path,
+                             const char *command_data_json_str)
+{
+    host_command_t command = {
+        .due_us = 0,
+        .applied = false,
+        .success = false,
+        .group = true,
+        .target = command_path.mGroupId,
+        .command_id = command_path.mCommandId,
+        .ctx = NULL,
+        .on_success = NULL,
+        .on_error = NULL,
+    };
+    esp_err_t err = host_client_queue(&command);
+    if (err == ESP_OK) {
+        s_binding_stats.group++;
+    }
+    return err;
+}
+
+} // namespace invoke
+} // namespace interaction
+
+} // namespace client
+} // namespace esp_matter
@@ -0,0 +1,192 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Host stand-in for app_contact.cpp: same debounce state machine, with the GPIO input
+ * driven by host_contact_set_input() and the settle timers kept in a min-heap on the
+ * simulation clock, so thousands of inputs cost O(log n) per timer.
+ */
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <app_priv.h>
+#include "contact_debounce.h"
+#include "host_sim.h"
+#include "latency_trace.h"
+
+static const char *TAG = "host_contact";
+
+#if CONFIG_APP_CONTACT_LEADING_EDGE
+#define APP_CONTACT_LEADING_EDGE true
+#else
+#define APP_CONTACT_LEADING_EDGE false
+#endif
+
+#define HOST_CONTACT_MAX_CHANNELS APP_CONTACT_CHANNEL_COUNT
+#define HOST_CONTACT_NOT_ARMED UINT32_MAX
+
+typedef struct {
+    bool input;
+    app_contact_cb_t cb;
+    void *cb_arg;
+    int64_t deadline_us;
+    uint32_t heap_pos; /* HOST_CONTACT_NOT_ARMED when the timer is idle */
+    contact_debounce_t db;
+} contact_channel_t;
+
+static contact_channel_t s_channels[HOST_CONTACT_MAX_CHANNELS];
+static uint16_t s_channel_count = 0;
+
+/* Pin levels, driven even before the channel is created (e.g. during a simulated boot) */
+static bool s_levels[HOST_CONTACT_MAX_CHANNELS];
+
+/* Armed timers, ordered by deadline */
+static uint16_t s_timer_heap[HOST_CONTACT_MAX_CHANNELS];
+static uint32_t s_timer_count = 0;
+
+static inline bool timer_before(uint32_t a, uint32_t b)
+{
+    return s_channels[s_timer_heap[a]].deadline_us < s_channels[s_timer_heap[b]].deadline_us;
+}
+
+static void timer_swap(uint32_t a, uint32_t b)
+{
+    uint16_t tmp = s_timer_heap[a];
+    s_timer_heap[a] = s_timer_heap[b];
+    s_timer_heap[b] = tmp;
+    s_channels[s_timer_heap[a]].heap_pos = a;
+    s_channels[s_timer_heap[b]].heap_pos = b;
+}
+
+static void timer_sift_up(uint32_t pos)
+{
+    while (pos > 0 && timer_before(pos, (pos - 1) / 2)) {
+        timer_swap(pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
+
+static void timer_sift_down(uint32_t pos)
+{
+    while (true) {
+        uint32_t smallest = pos;
+        uint32_t left = 2 * pos + 1;
+        uint32_t right = left + 1;
+        if (left < s_timer_count && timer_before(left, smallest)) {
+            smallest = left;
+        }
+        if (right < s_timer_count && timer_before(right, smallest)) {
+            smallest = right;
+        }
+        if (smallest == pos) {
+            return;
+        }
+        timer_swap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+/* esp_timer_start_once() equivalent, a running timer is restarted */
+static void timer_start(uint16_t channel, int64_t deadline_us)
+{
+    contact_channel_t *ch = &s_channels[channel];
+    ch->deadline_us = deadline_us;
+    if (ch->heap_pos == HOST_CONTACT_NOT_ARMED) {
+        ch->heap_pos = s_timer_count;
+        s_timer_heap[s_timer_count++] = channel;
+        timer_sift_up(ch->heap_pos);
+    } else {
+        timer_sift_up(ch->heap_pos);
+        timer_sift_down(ch->heap_pos);
+    }
+}
+
+static uint16_t timer_pop()
+{
+    uint16_t channel = s_timer_heap[0];
+    s_timer_count--;
+    if (s_timer_count > 0) {
+        timer_swap(0, s_timer_count);
+        timer_sift_down(0);
+    }
+    s_channels[channel].heap_pos = HOST_CONTACT_NOT_ARMED;
+    return channel;
+}
+
+/* Same flow as contact_isr_handler() */
+void host_contact_set_input(uint16_t channel, bool closed)
+{
+    if (channel >= HOST_CONTACT_MAX_CHANNELS) {
+        return;
+    }
+    s_levels[channel] = closed;
+    if (channel >= s_channel_count || s_channels[channel].input == closed) {
+        return;
+    }
+    contact_channel_t *ch = &s_channels[channel];
+    ch->input = closed;
+    int64_t now = esp_timer_get_time();
+    uint8_t flags = contact_debounce_on_edge(&ch->db, now, closed);
+    if (flags & CONTACT_DEBOUNCE_ARM) {
+        timer_start(channel, ch->db.deadline_us > now ? ch->db.deadline_us : now);
+    }
+}
+
+int64_t host_contact_next_deadline()
+{
+    return s_timer_count > 0 ? s_channels[s_timer_heap[0]].deadline_us : INT64_MAX;
+}
+
+/* Same flow as contact_timer_cb(), for every expired timer */
+void host_contact_run_timers()
+{
+    int64_t now = esp_timer_get_time();
+    while (s_timer_count > 0 && s_channels[s_timer_heap[0]].deadline_us <= now) {
+        uint64_t start = host_wall_ns();
+        uint16_t channel = timer_pop();
+        contact_channel_t *ch = &s_channels[channel];
+        latency_trace_record(TRACE_SPAN_TIMER_LATE, ch->deadline_us, now);
+        uint8_t flags = contact_debounce_on_timer(&ch->db, now, ch->input);
+        if (flags & CONTACT_DEBOUNCE_ARM) {
+            timer_start(channel, ch->db.deadline_us > now ? ch->db.deadline_us : now);
+        }
+        if (flags & CONTACT_DEBOUNCE_REPORT) {
+            ch->cb(ch->cb_arg, ch->db.stable_level, ch->db.first_edge_us);
+        }
+        host_samples_add(HOST_SAMPLE_CONTACT_CB, host_wall_ns() - start);
+    }
+}
+
+app_driver_handle_t app_contact_create(const app_contact_config_t *config, app_contact_cb_t cb, void *cb_arg)
+{
+    if (s_channel_count >= HOST_CONTACT_MAX_CHANNELS) {
+        ESP_LOGE(TAG, "No free contact channel for %s", config->name);
+        return NULL;
+    }
+    contact_channel_t *ch = &s_channels[s_channel_count];
+    ch->input = s_levels[s_channel_count];
+    ch->cb = cb;
+    ch->cb_arg = cb_arg;
+    ch->heap_pos = HOST_CONTACT_NOT_ARMED;
+
+    contact_debounce_config_t db_config = {
+        .settle_us = CONFIG_APP_CONTACT_SETTLE_MS * 1000,
+        .leading_edge = APP_CONTACT_LEADING_EDGE,
+    };
+    contact_debounce_init(&ch->db, &db_config, ch->input);
+
+    s_channel_count++;
+    return (app_driver_handle_t)ch;
+}
+
+bool app_contact_get_closed(app_driver_handle_t handle)
+{
+    contact_channel_t *ch = (contact_channel_t *)handle;
+    return ch->db.stable_level;
+}
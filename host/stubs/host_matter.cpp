@@ -0,0 +1,266 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_matter.h>
+
+#include "host_sim.h"
+
+using namespace chip::app::Clusters;
+
+static const char *TAG = "host_matter";
+
+/* Root node endpoint 0 is implicit, application endpoints start at 1 */
+#define HOST_MATTER_MAX_ENDPOINTS (HOST_FLEET_CHANNELS + 8)
+#define HOST_MATTER_MAX_CLUSTERS 3
+#define HOST_MATTER_MAX_ATTRIBUTES 8
+
+struct host_attribute {
+    uint32_t id;
+    esp_matter_attr_val_t val;
+};
+
+struct host_cluster {
+    uint32_t id;
+    host_attribute *attributes;
+    uint8_t attribute_count;
+};
+
+struct host_endpoint {
+    uint16_t id;
+    void *priv_data;
+    host_cluster clusters[HOST_MATTER_MAX_CLUSTERS];
+    uint8_t cluster_count;
+    host_attribute attributes[HOST_MATTER_MAX_ATTRIBUTES];
+    uint8_t attribute_count;
+};
+
+struct host_node {
+    esp_matter::attribute::callback_t attribute_cb;
+    uint16_t endpoint_count;
+    host_endpoint endpoints[HOST_MATTER_MAX_ENDPOINTS];
+};
+
+static host_node s_node;
+static host_matter_stats_t s_stats;
+
+esp_matter_attr_val_t esp_matter_invalid(void *val)
+{
+    esp_matter_attr_val_t attr_val = {};
+    attr_val.type = ESP_MATTER_VAL_TYPE_INVALID;
+    attr_val.val.p = val;
+    return attr_val;
+}
+
+esp_matter_attr_val_t esp_matter_bool(bool val)
+{
+    esp_matter_attr_val_t attr_val = {};
+    attr_val.type = ESP_MATTER_VAL_TYPE_BOOLEAN;
+    attr_val.val.b = val;
+    return attr_val;
+}
+
+esp_matter_attr_val_t esp_matter_uint8(uint8_t val)
+{
+    esp_matter_attr_val_t attr_val = {};
+    attr_val.type = ESP_MATTER_VAL_TYPE_UINT8;
+    attr_val.val.u8 = val;
+    return attr_val;
+}
+
+esp_matter_attr_val_t esp_matter_uint16(uint16_t val)
+{
+    esp_matter_attr_val_t attr_val = {};
+    attr_val.type = ESP_MATTER_VAL_TYPE_UINT16;
+    attr_val.val.u16 = val;
+    return attr_val;
+}
+
+esp_matter_attr_val_t esp_matter_enum8(uint8_t val)
+{
+    esp_matter_attr_val_t attr_val = {};
+    attr_val.type = ESP_MATTER_VAL_TYPE_ENUM8;
+    attr_val.val.u8 = val;
+    return attr_val;
+}
+
+static host_endpoint *host_matter_add_endpoint(void *priv_data)
+{
+    if (s_node.endpoint_count == HOST_MATTER_MAX_ENDPOINTS) {
+        ESP_LOGE(TAG, "No free endpoint");
+        return NULL;
+    }
+    host_endpoint *endpoint = &s_node.endpoints[s_node.endpoint_count];
+    memset(endpoint, 0, sizeof(*endpoint));
+    endpoint->id = ++s_node.endpoint_count;
+    endpoint->priv_data = priv_data;
+    return endpoint;
+}
+
+static void host_matter_add_cluster(host_endpoint *endpoint, uint32_t cluster_id)
+{
+    host_cluster *cluster = &endpoint->clusters[endpoint->cluster_count++];
+    cluster->id = cluster_id;
+    cluster->attributes = &endpoint->attributes[endpoint->attribute_count];
+    cluster->attribute_count = 0;
+}
+
+/* Adds to the last cluster added */
+static void host_matter_add_attribute(host_endpoint *endpoint, uint32_t attribute_id, esp_matter_attr_val_t val)
+{
+    host_attribute *attribute = &endpoint->attributes[endpoint->attribute_count++];
+    attribute->id = attribute_id;
+    attribute->val = val;
+    endpoint->clusters[endpoint->cluster_count - 1].attribute_count++;
+}
+
+void host_matter_init(esp_matter::attribute::callback_t attribute_cb)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_node.attribute_cb = attribute_cb;
+    s_node.endpoint_count = 0;
+}
+
+uint16_t host_matter_create_light(void *priv_data)
+{
+    host_endpoint *endpoint = host_matter_add_endpoint(priv_data);
+    if (!endpoint) {
+        return chip::kInvalidEndpointId;
+    }
+    host_matter_add_cluster(endpoint, OnOff::Id);
+    host_matter_add_attribute(endpoint, OnOff::Attributes::OnOff::Id, esp_matter_bool(true));
+    host_matter_add_cluster(endpoint, LevelControl::Id);
+    host_matter_add_attribute(endpoint, LevelControl::Attributes::CurrentLevel::Id, esp_matter_uint8(64));
+    host_matter_add_cluster(endpoint, ColorControl::Id);
+    host_matter_add_attribute(endpoint, ColorControl::Attributes::CurrentHue::Id, esp_matter_uint8(0));
+    host_matter_add_attribute(endpoint, ColorControl::Attributes::CurrentSaturation::Id, esp_matter_uint8(0));
+    host_matter_add_attribute(endpoint, ColorControl::Attributes::CurrentX::Id, esp_matter_uint16(0x616b));
+    host_matter_add_attribute(endpoint, ColorControl::Attributes::CurrentY::Id, esp_matter_uint16(0x607d));
+    host_matter_add_attribute(endpoint, ColorControl::Attributes::ColorTemperatureMireds::Id, esp_matter_uint16(250));
+    host_matter_add_attribute(endpoint, ColorControl::Attributes::ColorMode::Id,
+                              esp_matter_enum8((uint8_t)ColorControl::ColorMode::kColorTemperature));
+    return endpoint->id;
+}
+
+uint16_t host_matter_create_contact(bool state_value)
+{
+    host_endpoint *endpoint = host_matter_add_endpoint(NULL);
+    if (!endpoint) {
+        return chip::kInvalidEndpointId;
+    }
+    host_matter_add_cluster(endpoint, BooleanState::Id);
+    host_matter_add_attribute(endpoint, BooleanState::Attributes::StateValue::Id, esp_matter_bool(state_value));
+    return endpoint->id;
+}
+
+void host_matter_get_stats(host_matter_stats_t *stats)
+{
+    *stats = s_stats;
+}
+
+namespace esp_matter {
+
+namespace node {
+node_t *get()
+{
+    return &s_node;
+}
+} // namespace node
+
+namespace endpoint {
+endpoint_t *get(node_t *node, uint16_t endpoint_id)
+{
+    if (!node || endpoint_id == 0 || endpoint_id > node->endpoint_count) {
+        return NULL;
+    }
+    return &node->endpoints[endpoint_id - 1];
+}
+
+uint16_t get_id(endpoint_t *endpoint)
+{
+    return endpoint->id;
+}
+
+void *get_priv_data(uint16_t endpoint_id)
+{
+    endpoint_t *endpoint = get(&s_node, endpoint_id);
+    return endpoint ? endpoint->priv_data : NULL;
+}
+} // namespace endpoint
+
+namespace cluster {
+cluster_t *get(endpoint_t *endpoint, uint32_t cluster_id)
+{
+    if (!endpoint) {
+        return NULL;
+    }
+    for (uint8_t i = 0; i < endpoint->cluster_count; i++) {
+        if (endpoint->clusters[i].id == cluster_id) {
+            return &endpoint->clusters[i];
+        }
+    }
+    return NULL;
+}
+} // namespace cluster
+
+namespace attribute {
+attribute_t *get(cluster_t *cluster, uint32_t attribute_id)
+{
+    if (!cluster) {
+        return NULL;
+    }
+    for (uint8_t i = 0; i < cluster->attribute_count; i++) {
+        if (cluster->attributes[i].id == attribute_id) {
+            return &cluster->attributes[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t get_val(attribute_t *attribute, esp_matter_attr_val_t *val)
+{
+    if (!attribute) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *val = attribute->val;
+    return ESP_OK;
+}
+
+esp_err_t update(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id, esp_matter_attr_val_t *val)
+{
+    s_stats.updates++;
+    endpoint_t *endpoint = endpoint::get(&s_node, endpoint_id);
+    attribute_t *attribute = get(cluster::get(endpoint, cluster_id), attribute_id);
+    if (!attribute) {
+        s_stats.not_found++;
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (s_node.attribute_cb) {
+        uint64_t start = host_wall_ns();
+        esp_err_t err = s_node.attribute_cb(PRE_UPDATE, endpoint_id, cluster_id, attribute_id, val,
+                                            endpoint->priv_data);
+        host_samples_add(HOST_SAMPLE_ATTRIBUTE_CB, host_wall_ns() - start);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (attribute->val.type == val->type && attribute->val.val.u32 == val->val.u32) {
+        s_stats.unchanged++;
+    }
+    attribute->val = *val;
+    if (s_node.attribute_cb) {
+        s_node.attribute_cb(POST_UPDATE, endpoint_id, cluster_id, attribute_id, val, endpoint->priv_data);
+    }
+    return ESP_OK;
+}
+} // namespace attribute
+
+} // namespace esp_matter
@@ -0,0 +1,270 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Host stand-in for NVS, modelled on its page layout rather than its API alone, to count
+ * what settings writes cost the flash:
+ * - 4 KB pages of 126 entries of 32 bytes, written in order on the active page;
+ * - a blob takes an index entry, a data header entry and its data in whole entries; a
+ *   namespace takes one entry the first time it is opened for writing;
+ * - a new value is written in new entries and the old ones marked erased, a value equal to
+ *   the stored one is not written at all, as nvs_set_blob() does;
+ * - one page is kept free: when the active page is full and only that one is left, the full
+ *   page with the most erased entries has its live entries copied to it and is erased.
+ * Values are kept in memory, nothing survives the process.
+ */
+
+#include <string.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <nvs.h>
+
+#include "host_sim.h"
+#include "persist_cache.h"
+
+#define HOST_NVS_DEFAULT_BYTES 0xC000 /* nvs partition of partitions.csv */
+#define HOST_NVS_READONLY_FLAG 0x80000000u
+
+typedef enum {
+    HOST_NVS_PAGE_FREE,
+    HOST_NVS_PAGE_ACTIVE,
+    HOST_NVS_PAGE_FULL,
+} host_nvs_page_state_t;
+
+typedef struct {
+    host_nvs_page_state_t state;
+    uint16_t next;     /* first unwritten entry */
+    uint16_t erased;   /* entries written then erased */
+    uint32_t erases;
+} host_nvs_page_t;
+
+typedef struct {
+    std::vector<uint8_t> data;
+    uint16_t page;
+    uint16_t span;
+} host_nvs_item_t;
+
+/* Namespace index 0 holds the namespace entries, as in NVS */
+typedef std::pair<uint8_t, std::string> host_nvs_key_t;
+
+static std::vector<host_nvs_page_t> s_pages;
+static std::list<uint16_t> s_free_pages;
+static int s_active = -1;
+static std::map<host_nvs_key_t, host_nvs_item_t> s_items;
+static std::map<std::string, uint8_t> s_namespaces;
+static host_nvs_stats_t s_nvs_stats;
+
+void host_nvs_reset(uint32_t partition_bytes)
+{
+    uint32_t pages = partition_bytes / PERSIST_NVS_PAGE_BYTES;
+    s_pages.assign(pages, host_nvs_page_t{ HOST_NVS_PAGE_FREE, 0, 0, 0 });
+    s_free_pages.clear();
+    for (uint16_t i = 0; i < pages; i++) {
+        s_free_pages.push_back(i);
+    }
+    s_active = -1;
+    s_items.clear();
+    s_namespaces.clear();
+    memset(&s_nvs_stats, 0, sizeof(s_nvs_stats));
+    s_nvs_stats.pages = pages;
+}
+
+static void host_nvs_ensure()
+{
+    if (s_pages.empty()) {
+        host_nvs_reset(HOST_NVS_DEFAULT_BYTES);
+    }
+}
+
+/* Copy the live items of the full page with the most erased entries to the spare page,
+ * which becomes the active one, and erase it */
+static bool host_nvs_collect()
+{
+    int victim = -1;
+    for (uint16_t i = 0; i < s_pages.size(); i++) {
+        if (s_pages[i].state == HOST_NVS_PAGE_FULL && s_pages[i].erased > 0 &&
+            (victim < 0 || s_pages[i].erased > s_pages[victim].erased)) {
+            victim = i;
+        }
+    }
+    if (victim < 0 || s_free_pages.empty()) {
+        return false;
+    }
+    s_active = s_free_pages.front();
+    s_free_pages.pop_front();
+    host_nvs_page_t *active = &s_pages[s_active];
+    active->state = HOST_NVS_PAGE_ACTIVE;
+    for (auto &it : s_items) {
+        host_nvs_item_t *item = &it.second;
+        if (item->page != victim) {
+            continue;
+        }
+        item->page = s_active;
+        active->next += item->span;
+        s_nvs_stats.entry_writes += item->span;
+        s_nvs_stats.relocated_entries += item->span;
+    }
+    host_nvs_page_t *page = &s_pages[victim];
+    page->state = HOST_NVS_PAGE_FREE;
+    page->next = 0;
+    page->erased = 0;
+    page->erases++;
+    s_nvs_stats.page_erases++;
+    if (page->erases > s_nvs_stats.max_page_erases) {
+        s_nvs_stats.max_page_erases = page->erases;
+    }
+    s_free_pages.push_back(victim);
+    return true;
+}
+
+/* Page for `span` new entries, -1 when the partition is full of live entries */
+static int host_nvs_alloc(uint16_t span)
+{
+    for (size_t attempt = 0; attempt <= s_pages.size(); attempt++) {
+        if (s_active >= 0 && s_pages[s_active].next + span <= PERSIST_NVS_PAGE_ENTRIES) {
+            s_pages[s_active].next += span;
+            s_nvs_stats.entry_writes += span;
+            return s_active;
+        }
+        if (s_active >= 0) {
+            s_pages[s_active].state = HOST_NVS_PAGE_FULL;
+            s_active = -1;
+        }
+        if (s_free_pages.size() > 1) {
+            s_active = s_free_pages.front();
+            s_free_pages.pop_front();
+            s_pages[s_active].state = HOST_NVS_PAGE_ACTIVE;
+        } else if (!host_nvs_collect()) {
+            break;
+        }
+    }
+    s_nvs_stats.full++;
+    return -1;
+}
+
+static void host_nvs_erase(const host_nvs_item_t *item)
+{
+    s_pages[item->page].erased += item->span;
+}
+
+static bool host_nvs_name_ok(const char *name)
+{
+    return name && name[0] != '\0' && strlen(name) < PERSIST_NAME_MAX;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    host_nvs_ensure();
+    if (!host_nvs_name_ok(name)) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+    auto ns = s_namespaces.find(name);
+    if (ns == s_namespaces.end()) {
+        if (open_mode == NVS_READONLY) {
+            return ESP_ERR_NVS_NOT_FOUND;
+        }
+        int page = host_nvs_alloc(1);
+        if (page < 0) {
+            return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        }
+        uint8_t index = (uint8_t)(s_namespaces.size() + 1);
+        s_items[host_nvs_key_t(0, name)] = host_nvs_item_t{ std::vector<uint8_t>(1, index), (uint16_t)page, 1 };
+        ns = s_namespaces.emplace(name, index).first;
+    }
+    *out_handle = ns->second | (open_mode == NVS_READONLY ? HOST_NVS_READONLY_FLAG : 0);
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    if (handle & HOST_NVS_READONLY_FLAG) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    if (!host_nvs_name_ok(key)) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+    s_nvs_stats.sets++;
+    host_nvs_key_t id((uint8_t)handle, key);
+    const uint8_t *bytes = (const uint8_t *)value;
+    auto old = s_items.find(id);
+    if (old != s_items.end() && old->second.data.size() == length &&
+        memcmp(old->second.data.data(), bytes, length) == 0) {
+        s_nvs_stats.unchanged++;
+        return ESP_OK;
+    }
+    uint16_t span = (uint16_t)persist_nvs_blob_entries(length);
+    int page = host_nvs_alloc(span);
+    if (page < 0) {
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+    /* Looked up again: the collection may have moved the old value */
+    old = s_items.find(id);
+    if (old != s_items.end()) {
+        host_nvs_erase(&old->second);
+    }
+    s_items[id] = host_nvs_item_t{ std::vector<uint8_t>(bytes, bytes + length), (uint16_t)page, span };
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    auto item = s_items.find(host_nvs_key_t((uint8_t)handle, key));
+    if (item == s_items.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    size_t size = item->second.data.size();
+    if (out_value == NULL) {
+        *length = size;
+        return ESP_OK;
+    }
+    if (*length < size) {
+        *length = size;
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, item->second.data.data(), size);
+    *length = size;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    s_nvs_stats.commits++;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
+
+esp_err_t nvs_get_stats(const char *part_name, nvs_stats_t *nvs_stats)
+{
+    host_nvs_ensure();
+    size_t used = 0;
+    size_t free = 0;
+    for (const host_nvs_page_t &page : s_pages) {
+        used += page.next - page.erased;
+        free += PERSIST_NVS_PAGE_ENTRIES - page.next;
+    }
+    nvs_stats->used_entries = used;
+    nvs_stats->free_entries = free;
+    /* The spare page is not available */
+    nvs_stats->available_entries = free > PERSIST_NVS_PAGE_ENTRIES ? free - PERSIST_NVS_PAGE_ENTRIES : 0;
+    nvs_stats->total_entries = s_pages.size() * PERSIST_NVS_PAGE_ENTRIES;
+    nvs_stats->namespace_count = s_namespaces.size();
+    return ESP_OK;
+}
+
+void host_nvs_get_stats(host_nvs_stats_t *stats)
+{
+    host_nvs_ensure();
+    *stats = s_nvs_stats;
+}
@@ -0,0 +1,205 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Host stand-in for esp_partition and the app_update OTA API: two app slots backed by
+ * files, written with pwrite() and read back with pread(). Erased flash reads 0xFF, a
+ * sector is erased when the OTA write reaches it, as with OTA_WITH_SEQUENTIAL_WRITES.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <esp_log.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+
+#include "host_sim.h"
+
+static const char *TAG = "host_ota";
+
+#define HOST_OTA_SECTOR 4096
+#define HOST_OTA_IMAGE_MAGIC 0xE9
+
+static esp_partition_t s_slots[2] = {
+    { 0x20000, 0, "ota_0" },
+    { 0x200000, 0, "ota_1" },
+};
+static int s_slot_fds[2] = { -1, -1 };
+static const esp_partition_t *s_boot = NULL;
+static host_flash_stats_t s_flash_stats;
+
+/* One update in flight, like the single image processor of the requestor */
+static esp_ota_handle_t s_handle = 0;
+static esp_ota_handle_t s_next_handle = 1;
+static const esp_partition_t *s_update = NULL;
+static uint32_t s_wrote = 0;
+static uint32_t s_erased = 0; /* bytes erased from the start of the slot */
+
+static int host_ota_fd(const esp_partition_t *partition)
+{
+    return s_slot_fds[partition == &s_slots[0] ? 0 : 1];
+}
+
+static esp_err_t host_ota_erase(const esp_partition_t *partition, uint32_t offset, uint32_t len)
+{
+    static uint8_t erased[HOST_OTA_SECTOR];
+    memset(erased, 0xFF, sizeof(erased));
+    for (uint32_t at = offset; at < offset + len; at += HOST_OTA_SECTOR) {
+        if (pwrite(host_ota_fd(partition), erased, sizeof(erased), at) != (ssize_t)sizeof(erased)) {
+            return ESP_FAIL;
+        }
+        s_flash_stats.erases++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t host_ota_init(const char *dir, uint32_t slot_size)
+{
+    for (int i = 0; i < 2; i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.bin", dir, s_slots[i].label);
+        if (s_slot_fds[i] >= 0) {
+            close(s_slot_fds[i]);
+        }
+        s_slot_fds[i] = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (s_slot_fds[i] < 0) {
+            ESP_LOGE(TAG, "Cannot create %s", path);
+            return ESP_FAIL;
+        }
+        s_slots[i].size = slot_size;
+        if (host_ota_erase(&s_slots[i], 0, slot_size) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    s_boot = NULL;
+    s_handle = 0;
+    memset(&s_flash_stats, 0, sizeof(s_flash_stats));
+    return ESP_OK;
+}
+
+esp_err_t host_ota_flash_running(const uint8_t *image, size_t len)
+{
+    if (len > s_slots[0].size || pwrite(s_slot_fds[0], image, len, 0) != (ssize_t)len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+const esp_partition_t *host_ota_get_boot_partition()
+{
+    return s_boot;
+}
+
+void host_ota_get_flash_stats(host_flash_stats_t *stats)
+{
+    *stats = s_flash_stats;
+}
+
+void host_ota_reset_flash_stats()
+{
+    memset(&s_flash_stats, 0, sizeof(s_flash_stats));
+}
+
+extern "C" {
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    if (src_offset + size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (pread(host_ota_fd(partition), dst, size, src_offset) != (ssize_t)size) {
+        return ESP_FAIL;
+    }
+    s_flash_stats.reads++;
+    s_flash_stats.read_bytes += size;
+    return ESP_OK;
+}
+
+const esp_partition_t *esp_ota_get_running_partition(void)
+{
+    return &s_slots[0];
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+    return &s_slots[1];
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle)
+{
+    if (partition == esp_ota_get_running_partition()) {
+        return ESP_ERR_OTA_PARTITION_CONFLICT;
+    }
+    if (s_handle != 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_update = partition;
+    s_wrote = 0;
+    s_erased = 0;
+    s_handle = s_next_handle++;
+    *out_handle = s_handle;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
+{
+    if (handle != s_handle || handle == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint8_t *bytes = (const uint8_t *)data;
+    if (s_wrote == 0 && size > 0 && bytes[0] != HOST_OTA_IMAGE_MAGIC) {
+        ESP_LOGE(TAG, "OTA image has invalid magic byte (expected 0xE9, saw 0x%02x)", bytes[0]);
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    if (s_wrote + size > s_update->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (s_wrote + size > s_erased) {
+        uint32_t end = (s_wrote + size + HOST_OTA_SECTOR - 1) / HOST_OTA_SECTOR * HOST_OTA_SECTOR;
+        if (host_ota_erase(s_update, s_erased, end - s_erased) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        s_erased = end;
+    }
+    if (pwrite(host_ota_fd(s_update), data, size, s_wrote) != (ssize_t)size) {
+        return ESP_FAIL;
+    }
+    s_wrote += size;
+    s_flash_stats.writes++;
+    s_flash_stats.write_bytes += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle)
+{
+    if (handle != s_handle || handle == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_handle = 0;
+    return s_wrote > 0 ? ESP_OK : ESP_ERR_OTA_VALIDATE_FAILED;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle)
+{
+    if (handle != s_handle || handle == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_handle = 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition)
+{
+    s_boot = partition;
+    return ESP_OK;
+}
+
+} // extern "C"
@@ -0,0 +1,171 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <platform/CHIPDeviceLayer.h>
+
+#include "host_sim.h"
+
+esp_log_level_t host_log_level = ESP_LOG_WARN;
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+void host_error_check_failed(esp_err_t err, const char *file, int line, const char *expr)
+{
+    fprintf(stderr, "ESP_ERROR_CHECK failed: 0x%x at %s:%d\nexpression: %s\n", err, file, line, expr);
+    abort();
+}
+
+#define HOST_SHUTDOWN_HANDLERS 5 /* as on target */
+
+static shutdown_handler_t s_shutdown_handlers[HOST_SHUTDOWN_HANDLERS];
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler)
+{
+    for (size_t i = 0; i < HOST_SHUTDOWN_HANDLERS; i++) {
+        if (s_shutdown_handlers[i] == handler) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        if (s_shutdown_handlers[i] == NULL) {
+            s_shutdown_handlers[i] = handler;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+#define HOST_FREE_HEAP 200000
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return HOST_FREE_HEAP;
+}
+
+void host_system_restart()
+{
+    /* Last registered first */
+    for (size_t i = HOST_SHUTDOWN_HANDLERS; i-- > 0;) {
+        if (s_shutdown_handlers[i]) {
+            s_shutdown_handlers[i]();
+        }
+    }
+}
+
+uint64_t host_wall_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static host_samples_t s_samples[HOST_SAMPLE_MAX];
+
+void host_samples_reserve(size_t capacity)
+{
+    for (int kind = 0; kind < HOST_SAMPLE_MAX; kind++) {
+        free(s_samples[kind].ns);
+        s_samples[kind].ns = (uint32_t *)calloc(capacity, sizeof(uint32_t));
+        s_samples[kind].capacity = s_samples[kind].ns ? capacity : 0;
+    }
+    host_samples_reset();
+}
+
+void host_samples_reset()
+{
+    for (int kind = 0; kind < HOST_SAMPLE_MAX; kind++) {
+        s_samples[kind].count = 0;
+        s_samples[kind].overflow = 0;
+    }
+}
+
+host_samples_t *host_samples(host_sample_kind_t kind)
+{
+    return &s_samples[kind];
+}
+
+void host_samples_add(host_sample_kind_t kind, uint64_t ns)
+{
+    host_samples_t *samples = &s_samples[kind];
+    if (samples->count == samples->capacity) {
+        samples->overflow++;
+        return;
+    }
+    samples->ns[samples->count++] = ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+}
+
+typedef struct {
+    chip::DeviceLayer::AsyncWorkFunct fn;
+    intptr_t arg;
+} host_work_t;
+
+static host_work_t s_work[HOST_WORK_QUEUE_LEN];
+static size_t s_work_head = 0;
+static size_t s_work_count = 0;
+static host_work_stats_t s_work_stats;
+
+namespace chip {
+namespace DeviceLayer {
+
+CHIP_ERROR PlatformManager::ScheduleWork(AsyncWorkFunct workFunct, intptr_t arg)
+{
+    if (s_work_count == HOST_WORK_QUEUE_LEN) {
+        s_work_stats.rejected++;
+        return CHIP_ERROR_NO_MEMORY;
+    }
+    s_work[(s_work_head + s_work_count) % HOST_WORK_QUEUE_LEN] = { workFunct, arg };
+    s_work_count++;
+    s_work_stats.scheduled++;
+    if (s_work_count > s_work_stats.high_water) {
+        s_work_stats.high_water = s_work_count;
+    }
+    return CHIP_NO_ERROR;
+}
+
+PlatformManager &PlatformMgr()
+{
+    static PlatformManager s_manager;
+    return s_manager;
+}
+
+} // namespace DeviceLayer
+} // namespace chip
+
+size_t host_platform_run_work()
+{
+    size_t run = 0;
+    while (s_work_count > 0) {
+        host_work_t work = s_work[s_work_head];
+        s_work_head = (s_work_head + 1) % HOST_WORK_QUEUE_LEN;
+        s_work_count--;
+
+        uint64_t start = host_wall_ns();
+        work.fn(work.arg);
+        host_samples_add(HOST_SAMPLE_MATTER_WORK, host_wall_ns() - start);
+        s_work_stats.run++;
+        run++;
+    }
+    return run;
+}
+
+void host_platform_get_stats(host_work_stats_t *stats)
+{
+    *stats = s_work_stats;
+}
@@ -0,0 +1,156 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_timer.h>
+
+#include <atomic>
+
+#include "host_sim.h"
+
+/* The application creates a handful of timers, a linear scan is fine */
+#define HOST_TIMER_MAX 32
+
+struct host_timer {
+    bool used;
+    bool active;
+    esp_timer_cb_t callback;
+    void *arg;
+    bool skip_unhandled_events;
+    int64_t deadline_us;
+    uint64_t period_us; /* 0 for one-shot */
+};
+
+static host_timer s_timers[HOST_TIMER_MAX];
+static std::atomic<int64_t> s_fake_now{0};
+
+int64_t latency_fake_clock_now(void)
+{
+    return s_fake_now.load(std::memory_order_relaxed);
+}
+
+void latency_fake_clock_set(int64_t now_us)
+{
+    s_fake_now.store(now_us, std::memory_order_relaxed);
+}
+
+void latency_fake_clock_advance(int64_t delta_us)
+{
+    s_fake_now.fetch_add(delta_us, std::memory_order_relaxed);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return latency_fake_clock_now();
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (!create_args || !create_args->callback || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (host_timer &timer : s_timers) {
+        if (!timer.used) {
+            timer = {};
+            timer.used = true;
+            timer.callback = create_args->callback;
+            timer.arg = create_args->arg;
+            timer.skip_unhandled_events = create_args->skip_unhandled_events;
+            *out_handle = &timer;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+static esp_err_t host_timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+{
+    if (!timer || !timer->used) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = true;
+    timer->deadline_us = esp_timer_get_time() + (int64_t)timeout_us;
+    timer->period_us = period_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return host_timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    return host_timer_start(timer, period, period);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer || !timer->used) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (!timer || !timer->used) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->used = false;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer && timer->active;
+}
+
+int64_t host_timer_next_deadline(bool include_periodic)
+{
+    int64_t next = INT64_MAX;
+    for (const host_timer &timer : s_timers) {
+        if (timer.active && (include_periodic || timer.period_us == 0) && timer.deadline_us < next) {
+            next = timer.deadline_us;
+        }
+    }
+    return next;
+}
+
+void host_timer_run()
+{
+    int64_t now = esp_timer_get_time();
+    bool fired = true;
+    while (fired) {
+        fired = false;
+        for (host_timer &timer : s_timers) {
+            if (!timer.active || timer.deadline_us > now) {
+                continue;
+            }
+            if (timer.period_us == 0) {
+                timer.active = false;
+            } else if (timer.skip_unhandled_events) {
+                /* Missed periods are dropped, like esp_timer does when the task was busy */
+                timer.deadline_us += ((now - timer.deadline_us) / timer.period_us + 1) * timer.period_us;
+            } else {
+                timer.deadline_us += timer.period_us;
+            }
+            timer.callback(timer.arg);
+            fired = true;
+        }
+    }
+}
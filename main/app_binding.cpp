@@ -0,0 +1,227 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <esp_matter.h>
+
+#include <app_priv.h>
+#include "latency_trace.h"
+
+using namespace esp_matter;
+using namespace chip::app::Clusters;
+
+static const char *const k_binding_action_names[APP_BINDING_ACTION_MAX] = {
+    "none",
+    "on",
+    "off",
+    "toggle",
+};
+
+const char *app_binding_action_name(app_binding_action_t action)
+{
+    return action < APP_BINDING_ACTION_MAX ? k_binding_action_names[action] : "unknown";
+}
+
+#if CONFIG_APP_BINDING_ENABLE
+static const char *TAG = "app_binding";
+extern uint16_t contact_endpoint_ids[];
+
+/* Command of each action, APP_BINDING_ACTION_NONE sends nothing */
+static const chip::CommandId k_binding_commands[APP_BINDING_ACTION_MAX] = {
+    0,
+    OnOff::Commands::On::Id,
+    OnOff::Commands::Off::Id,
+    OnOff::Commands::Toggle::Id,
+};
+
+typedef struct {
+    uint8_t on_open;  /* app_binding_action_t */
+    uint8_t on_close;
+} app_binding_map_t;
+
+/* Saved actions, one app_binding_map_t per channel number */
+#define APP_BINDING_NS "binding"
+
+/* Edge of a transition whose commands may still be in flight. The request and the
+ * response callbacks carry the sequence number: a unicast peer may need a CASE session
+ * first, so they can run turns later. A slot is reused after APP_BINDING_MARKS newer
+ * transitions; a response that late is not measured. */
+#define APP_BINDING_MARKS 8
+
+typedef struct {
+    uint32_t seq;
+    int64_t edge_us;
+} app_binding_mark_t;
+
+/* Matter thread only */
+static app_binding_map_t s_binding_map[APP_CONTACT_MAX_CHANNEL_COUNT];
+static app_binding_mark_t s_binding_marks[APP_BINDING_MARKS];
+static uint32_t s_binding_seq = 0;
+static app_binding_stats_t s_binding_stats;
+
+static void app_binding_trace(trace_span_t span, uint32_t seq)
+{
+    const app_binding_mark_t *mark = &s_binding_marks[seq % APP_BINDING_MARKS];
+    if (mark->seq != seq || mark->edge_us == 0) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    latency_trace_record(span, mark->edge_us, now);
+    if (span == TRACE_SPAN_EDGE_TO_RESPONSE) {
+        app_telemetry_latency(span, (uint32_t)(now - mark->edge_us));
+    }
+}
+
+static void app_binding_response_cb(void *ctx, const chip::app::ConcreteCommandPath &command_path,
+                                    const chip::app::StatusIB &status, chip::TLV::TLVReader *response_data)
+{
+    if (!status.IsSuccess()) {
+        s_binding_stats.errors++;
+        return;
+    }
+    s_binding_stats.responses++;
+    app_binding_trace(TRACE_SPAN_EDGE_TO_RESPONSE, (uint32_t)(uintptr_t)ctx);
+}
+
+static void app_binding_error_cb(void *ctx, CHIP_ERROR error)
+{
+    s_binding_stats.errors++;
+    ESP_LOGW(TAG, "Bound device command failed, err:%" CHIP_ERROR_FORMAT, error.Format());
+}
+
+/* One call per unicast binding of the endpoint, once the CASE session with the peer is up */
+static void app_binding_unicast_cb(client::peer_device_t *peer_device, client::request_handle_t *req_handle,
+                                   void *priv_data)
+{
+    if (req_handle->type != client::INVOKE_CMD || req_handle->command_path.mClusterId != OnOff::Id) {
+        return;
+    }
+    uint32_t seq = (uint32_t)(uintptr_t)req_handle->request_data;
+    /* On, Off and Toggle have no fields */
+    esp_err_t err = client::interaction::invoke::send_request((void *)(uintptr_t)seq, peer_device,
+                                                              req_handle->command_path, "{}", app_binding_response_cb,
+                                                              app_binding_error_cb, chip::NullOptional);
+    if (err != ESP_OK) {
+        s_binding_stats.errors++;
+        ESP_LOGW(TAG, "Failed to send OnOff command 0x%" PRIx32 ", err:%d", req_handle->command_path.mCommandId, err);
+        return;
+    }
+    s_binding_stats.unicast++;
+    app_binding_trace(TRACE_SPAN_EDGE_TO_COMMAND, seq);
+}
+
+/* One call per group binding: a single multicast reaches every member, nothing answers */
+static void app_binding_group_cb(uint8_t fabric_index, client::request_handle_t *req_handle, void *priv_data)
+{
+    if (req_handle->type != client::INVOKE_CMD || req_handle->command_path.mClusterId != OnOff::Id) {
+        return;
+    }
+    esp_err_t err = client::interaction::invoke::send_group_request(fabric_index, req_handle->command_path, "{}");
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to send OnOff command 0x%" PRIx32 " to group %u, err:%d",
+                 req_handle->command_path.mCommandId, req_handle->command_path.mGroupId, err);
+        return;
+    }
+    s_binding_stats.group++;
+    app_binding_trace(TRACE_SPAN_EDGE_TO_COMMAND, (uint32_t)(uintptr_t)req_handle->request_data);
+}
+
+esp_err_t app_binding_init()
+{
+    for (uint16_t i = 0; i < APP_CONTACT_MAX_CHANNEL_COUNT; i++) {
+        s_binding_map[i].on_open = CONFIG_APP_BINDING_OPEN_ACTION;
+        s_binding_map[i].on_close = CONFIG_APP_BINDING_CLOSE_ACTION;
+    }
+    for (uint16_t i = 0; i < app_driver_contact_channel_count(); i++) {
+        char key[8];
+        snprintf(key, sizeof(key), "ch%u", i);
+        app_binding_map_t saved;
+        if (app_persist_get(APP_BINDING_NS, key, &saved, sizeof(saved)) == ESP_OK &&
+            saved.on_open < APP_BINDING_ACTION_MAX && saved.on_close < APP_BINDING_ACTION_MAX) {
+            s_binding_map[i] = saved;
+        }
+    }
+    return client::set_request_callback(app_binding_unicast_cb, app_binding_group_cb, NULL);
+}
+
+void app_binding_contact_changed(uint16_t channel, bool closed, int64_t edge_us)
+{
+    const app_binding_map_t *map = &s_binding_map[channel];
+    uint8_t action = closed ? map->on_close : map->on_open;
+    uint16_t endpoint_id = contact_endpoint_ids[channel];
+    if (action == APP_BINDING_ACTION_NONE || endpoint_id == chip::kInvalidEndpointId) {
+        return;
+    }
+    uint32_t seq = ++s_binding_seq;
+    s_binding_marks[seq % APP_BINDING_MARKS] = { seq, edge_us };
+    s_binding_stats.transitions++;
+
+    client::request_handle_t req_handle;
+    req_handle.type = client::INVOKE_CMD;
+    req_handle.command_path.mClusterId = OnOff::Id;
+    req_handle.command_path.mCommandId = k_binding_commands[action];
+    req_handle.request_data = (void *)(uintptr_t)seq;
+    /* Walks the binding table of the endpoint: the callbacks above run for the groups and
+     * the peers with a session right away, for the others once connected */
+    esp_err_t err = client::cluster_update(endpoint_id, &req_handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Contact %s: binding update failed, err:%d", app_driver_contact_name(channel), err);
+    }
+}
+
+void app_binding_get_actions(uint16_t channel, app_binding_action_t *on_open, app_binding_action_t *on_close)
+{
+    *on_open = (app_binding_action_t)s_binding_map[channel].on_open;
+    *on_close = (app_binding_action_t)s_binding_map[channel].on_close;
+}
+
+void app_binding_set_actions(uint16_t channel, app_binding_action_t on_open, app_binding_action_t on_close)
+{
+    s_binding_map[channel].on_open = on_open;
+    s_binding_map[channel].on_close = on_close;
+    char key[8];
+    snprintf(key, sizeof(key), "ch%u", channel);
+    esp_err_t err = app_persist_set(APP_BINDING_NS, key, &s_binding_map[channel], sizeof(s_binding_map[channel]));
+    if (err != ESP_OK) {
+        APP_LOGW(TAG, "Failed to save the binding actions, err:%d", err);
+    }
+}
+
+void app_binding_get_stats(app_binding_stats_t *stats)
+{
+    *stats = s_binding_stats;
+}
+#else
+esp_err_t app_binding_init()
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void app_binding_contact_changed(uint16_t channel, bool closed, int64_t edge_us)
+{
+}
+
+void app_binding_get_actions(uint16_t channel, app_binding_action_t *on_open, app_binding_action_t *on_close)
+{
+    *on_open = APP_BINDING_ACTION_NONE;
+    *on_close = APP_BINDING_ACTION_NONE;
+}
+
+void app_binding_set_actions(uint16_t channel, app_binding_action_t on_open, app_binding_action_t on_close)
+{
+}
+
+void app_binding_get_stats(app_binding_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+#endif // CONFIG_APP_BINDING_ENABLE
@@ -0,0 +1,700 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <esp_matter_console.h>
+#include <platform/CHIPDeviceLayer.h>
+
+#include <app_priv.h>
+#include "boot_trace.h"
+#include "hall_sense.h"
+#include "latency_trace.h"
+#include "storm_gen.h"
+#include "watermark.h"
+
+#if CONFIG_ENABLE_CHIP_SHELL
+using namespace esp_matter;
+
+static const char *TAG = "app_console";
+
+static console::engine sensor_console;
+
+static esp_err_t sensor_latency_handler(int argc, char **argv)
+{
+    if (argc == 1 && strncmp(argv[0], "reset", sizeof("reset")) == 0) {
+        latency_trace_reset();
+        return ESP_OK;
+    }
+    if (argc != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    printf("%-16s %8s %8s %8s %8s %8s %8s\n", "span (us)", "count", "min", "p50", "p90", "p99", "max");
+    for (int span = 0; span < TRACE_SPAN_MAX; span++) {
+        latency_hist_snapshot_t snapshot;
+        latency_trace_snapshot((trace_span_t)span, &snapshot);
+        printf("%-16s %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 "\n",
+               latency_trace_span_name((trace_span_t)span), snapshot.count, snapshot.min_us,
+               latency_trace_percentile(&snapshot, 50), latency_trace_percentile(&snapshot, 90),
+               latency_trace_percentile(&snapshot, 99), snapshot.max_us);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sensor_boot_handler(int argc, char **argv)
+{
+    printf("%-16s %10s %10s %10s\n", "phase (us)", "start", "duration", "end");
+    for (int phase = 0; phase < BOOT_PHASE_MAX; phase++) {
+        if (!boot_trace_reached((boot_phase_t)phase)) {
+            printf("%-16s %10s\n", boot_trace_phase_name((boot_phase_t)phase), "-");
+            continue;
+        }
+        printf("%-16s %10" PRId64 " %10" PRId64 " %10" PRId64 "\n", boot_trace_phase_name((boot_phase_t)phase),
+               boot_trace_start((boot_phase_t)phase), boot_trace_duration((boot_phase_t)phase),
+               boot_trace_end((boot_phase_t)phase));
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sensor_queue_handler(int argc, char **argv)
+{
+    app_contact_queue_stats_t stats;
+    app_driver_contact_get_queue_stats(&stats);
+    printf("pushed %" PRIu32 " dropped %" PRIu32 " depth %" PRIu32 " high-water %" PRIu32 " batches %" PRIu32
+           " coalesced %" PRIu32 " retries %" PRIu32 "\n",
+           stats.pushed, stats.dropped, stats.depth, stats.high_water, stats.batches, stats.coalesced, stats.retries);
+    return ESP_OK;
+}
+
+static esp_err_t sensor_power_handler(int argc, char **argv)
+{
+    app_power_stats_t stats;
+    app_power_get_stats(&stats);
+    printf("active %" PRId64 " ms light-sleep %" PRId64 " ms wakeups %" PRIu32 " sleep %" PRIu32 ".%" PRIu32 "%%\n",
+           stats.active_us / 1000, stats.light_sleep_us / 1000, stats.wakeups, stats.sleep_permille / 10,
+           stats.sleep_permille % 10);
+    return ESP_OK;
+}
+
+static esp_err_t sensor_evlog_handler(int argc, char **argv)
+{
+    app_evlog_stats_t stats;
+    app_evlog_get_stats(&stats);
+    printf("appends %" PRIu32 " unacked %" PRIu32 " overwritten %" PRIu32 " flash-writes %" PRIu32 " erases %" PRIu32
+           " crc-errors %" PRIu32 "\n",
+           stats.appends, stats.unacked, stats.overwritten, stats.flash_writes, stats.erases, stats.crc_errors);
+    return ESP_OK;
+}
+
+static esp_err_t sensor_telemetry_handler(int argc, char **argv)
+{
+    app_telemetry_stats_t stats;
+    app_telemetry_get_stats(&stats);
+    printf("frames %" PRIu32 " dropped %" PRIu32 " bytes %" PRIu32 "\n", stats.frames, stats.dropped, stats.bytes);
+    return ESP_OK;
+}
+
+/* Average cost of a log call seen by the caller, ESP_LOGI against APP_LOGI */
+static esp_err_t sensor_logbench_handler(int argc, char **argv)
+{
+    int count = argc > 0 ? atoi(argv[0]) : 16;
+    if (count <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < count; i++) {
+        ESP_LOGI(TAG, "logbench %d of %d: %s", i, count, "direct");
+    }
+    int64_t direct_us = esp_timer_get_time() - start;
+
+    app_dlog_stats_t before;
+    app_dlog_get_stats(&before);
+    start = esp_timer_get_time();
+    for (int i = 0; i < count; i++) {
+        APP_LOGI(TAG, "logbench %d of %d: %s", i, count, "deferred");
+    }
+    int64_t deferred_us = esp_timer_get_time() - start;
+    app_dlog_stats_t after;
+    app_dlog_get_stats(&after);
+
+    printf("ESP_LOGI %" PRId64 " ns/call, APP_LOGI %" PRId64 " ns/call, %" PRIu32 " deferred records dropped\n",
+           direct_us * 1000 / count, deferred_us * 1000 / count, after.dropped - before.dropped);
+    return ESP_OK;
+}
+
+static esp_err_t sensor_dlog_handler(int argc, char **argv)
+{
+    app_dlog_stats_t stats;
+    app_dlog_get_stats(&stats);
+    printf("records %" PRIu32 " dropped %" PRIu32 " high-water %" PRIu32 "\n", stats.records, stats.dropped,
+           stats.high_water);
+    return ESP_OK;
+}
+
+static esp_err_t sensor_imu_handler(int argc, char **argv)
+{
+    app_imu_stats_t stats;
+    app_imu_get_stats(&stats);
+    if (stats.odr_hz == 0) {
+        printf("no accelerometer\n");
+        return ESP_OK;
+    }
+    printf("odr %u Hz samples %" PRIu32 " drains %" PRIu32 " transfers %" PRIu32 " bytes %" PRIu32
+           " overruns %" PRIu32 "\n",
+           stats.odr_hz, stats.samples, stats.drains, stats.transfers, stats.bytes, stats.overruns);
+    printf("bus-errors %" PRIu32 " bus-resets %" PRIu32 " knocks %" PRIu32 " vibrating %d tilted %d\n",
+           stats.bus_errors, stats.bus_resets, stats.knocks, stats.vibrating, stats.tilted);
+    return ESP_OK;
+}
+
+static esp_err_t sensor_hall_handler(int argc, char **argv)
+{
+    if (argc == 1 && strncmp(argv[0], "calibrate", sizeof("calibrate")) == 0) {
+        esp_err_t err = app_hall_calibrate();
+        if (err == ESP_ERR_INVALID_STATE) {
+            printf("field too weak for a closed door\n");
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+    } else if (argc != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    app_hall_stats_t stats;
+    app_hall_get_stats(&stats);
+    if (stats.sample_hz == 0) {
+        printf("no hall sensor\n");
+        return ESP_OK;
+    }
+    printf("rate %" PRIu32 " Hz decimation %u frames %" PRIu32 " conversions %" PRIu32 " foreign %" PRIu32
+           " samples %" PRIu32 " overflows %" PRIu32 "\n",
+           stats.sample_hz, stats.decimation, stats.frames, stats.conversions, stats.foreign, stats.samples,
+           stats.overflows);
+    printf("state %s field %" PRId32 " uT closed %" PRId32 " uT gap ", hall_state_name((hall_state_t)stats.state),
+           stats.field_ut, stats.closed_ut);
+    if (stats.gap_mm == HALL_GAP_UNKNOWN) {
+        printf("out of range\n");
+    } else {
+        printf("%u mm\n", stats.gap_mm);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sensor_expander_handler(int argc, char **argv)
+{
+    app_expander_stats_t stats;
+    app_expander_get_stats(&stats);
+    if (stats.expanders == 0) {
+        printf("no expander\n");
+        return ESP_OK;
+    }
+    printf("expanders %u channels %u interrupts %" PRIu32 " scans %" PRIu32 " transfers %" PRIu32 "\n",
+           stats.expanders, stats.channels, stats.interrupts, stats.scans, stats.transfers);
+    printf("bus-errors %" PRIu32 " bus-resets %" PRIu32 " retries %" PRIu32 "%s changed-bits %" PRIu32
+           " reports %" PRIu32 "\n",
+           stats.bus_errors, stats.bus_resets, stats.retries, stats.stalled ? " (stalled)" : "", stats.changed_bits,
+           stats.reports);
+    return ESP_OK;
+}
+
+/* The policies belong to the Matter thread: hold the stack lock while touching them */
+static esp_err_t sensor_policy_handler(int argc, char **argv)
+{
+    if (argc != 0 && argc != 5) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    uint16_t count = app_driver_contact_channel_count();
+    if (argc == 5) {
+        bool all = strncmp(argv[0], "all", sizeof("all")) == 0;
+        int channel = atoi(argv[0]);
+        app_contact_policy_t policy = {};
+        policy.min_interval_ms = strtoul(argv[1], NULL, 0);
+        policy.holdoff_ms = strtoul(argv[2], NULL, 0);
+        policy.max_reports = (uint16_t)strtoul(argv[3], NULL, 0);
+        policy.window_sec = strtoul(argv[4], NULL, 0);
+        if ((!all && (channel < 0 || channel >= count)) || policy.window_sec == 0) {
+            chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+            return ESP_ERR_INVALID_ARG;
+        }
+        for (uint16_t i = all ? 0 : channel; i < (all ? count : channel + 1); i++) {
+            app_driver_contact_set_policy(i, &policy);
+        }
+    }
+    printf("%-8s %8s %8s %6s %6s %8s %8s %8s %6s %4s\n", "channel", "min-ms", "hold-ms", "max", "win-s", "trans",
+           "reports", "suppr", "summ", "held");
+    for (uint16_t i = 0; i < count; i++) {
+        app_contact_policy_t policy;
+        app_driver_contact_get_policy(i, &policy);
+        printf("%-8s %8" PRIu32 " %8" PRIu32 " %6u %6" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %6" PRIu32
+               " %4d\n",
+               app_driver_contact_name(i), policy.min_interval_ms, policy.holdoff_ms, policy.max_reports,
+               policy.window_sec, policy.transitions, policy.reports, policy.suppressed, policy.summaries,
+               policy.held);
+    }
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+    return ESP_OK;
+}
+
+static bool sensor_binding_action_parse(const char *name, app_binding_action_t *action)
+{
+    for (int i = 0; i < APP_BINDING_ACTION_MAX; i++) {
+        if (strcmp(name, app_binding_action_name((app_binding_action_t)i)) == 0) {
+            *action = (app_binding_action_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* The actions belong to the Matter thread, like the policies */
+static esp_err_t sensor_binding_handler(int argc, char **argv)
+{
+    if (argc != 0 && argc != 3) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    uint16_t count = app_driver_contact_channel_count();
+    if (argc == 3) {
+        bool all = strncmp(argv[0], "all", sizeof("all")) == 0;
+        int channel = atoi(argv[0]);
+        app_binding_action_t on_open, on_close;
+        if ((!all && (channel < 0 || channel >= count)) || !sensor_binding_action_parse(argv[1], &on_open) ||
+            !sensor_binding_action_parse(argv[2], &on_close)) {
+            chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+            return ESP_ERR_INVALID_ARG;
+        }
+        for (uint16_t i = all ? 0 : channel; i < (all ? count : channel + 1); i++) {
+            app_binding_set_actions(i, on_open, on_close);
+        }
+    }
+    printf("%-8s %-7s %-7s\n", "channel", "open", "close");
+    for (uint16_t i = 0; i < count; i++) {
+        app_binding_action_t on_open, on_close;
+        app_binding_get_actions(i, &on_open, &on_close);
+        printf("%-8s %-7s %-7s\n", app_driver_contact_name(i), app_binding_action_name(on_open),
+               app_binding_action_name(on_close));
+    }
+    app_binding_stats_t stats;
+    app_binding_get_stats(&stats);
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+    printf("transitions %" PRIu32 " unicast %" PRIu32 " group %" PRIu32 " responses %" PRIu32 " errors %" PRIu32
+           "\n",
+           stats.transitions, stats.unicast, stats.group, stats.responses, stats.errors);
+    return ESP_OK;
+}
+
+static void sensor_watermark_print(watermark_metric_t metric)
+{
+    app_watermark_metric_t m;
+    if (!app_watermark_get(metric, &m)) {
+        return;
+    }
+    printf("%-26s ", watermark_metric_name(metric));
+    if (m.present) {
+        printf("%10" PRIu32, m.last);
+    } else {
+        printf("%10s", "-");
+    }
+    if (m.window_seen) {
+        printf(" %10" PRIu32 " %10" PRIu32, m.window_min, m.window_max);
+    } else {
+        printf(" %10s %10s", "-", "-");
+    }
+    printf(" %10" PRIu32 " %10" PRIu32 "\n", m.total_min, m.total_max);
+}
+
+static esp_err_t sensor_watermark_handler(int argc, char **argv)
+{
+    if (argc > 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    watermark_metric_t metric = WATERMARK_METRIC_MAX;
+    if (argc == 1) {
+        metric = watermark_metric_find(argv[0]);
+        if (metric == WATERMARK_METRIC_MAX) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    app_watermark_stats_t stats;
+    app_watermark_get_stats(&stats);
+    if (stats.samples == 0) {
+        printf("no samples\n");
+        return ESP_OK;
+    }
+    printf("samples %" PRIu32 " window %u x %" PRIu32 " s exported %" PRIu32 "\n", stats.samples, stats.slots,
+           stats.slot_sec, stats.exported);
+    printf("%-26s %10s %10s %10s %10s %10s\n", "metric", "last", "win-min", "win-max", "boot-min", "boot-max");
+    for (int i = 0; i < WATERMARK_METRIC_MAX; i++) {
+        if (metric == WATERMARK_METRIC_MAX || metric == i) {
+            sensor_watermark_print((watermark_metric_t)i);
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sensor_cores_traffic(int argc, char **argv)
+{
+    if (argc == 1 && strncmp(argv[0], "stop", sizeof("stop")) == 0) {
+        app_cores_stop_traffic();
+        return ESP_OK;
+    }
+    if (argc != 4) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = app_cores_start_traffic((uint8_t)atoi(argv[0]), (uint8_t)atoi(argv[1]), strtoul(argv[2], NULL, 0),
+                                            strtoul(argv[3], NULL, 0));
+    if (err == ESP_ERR_INVALID_STATE) {
+        printf("already running, stop it first\n");
+    }
+    return err;
+}
+
+static esp_err_t sensor_cores_handler(int argc, char **argv)
+{
+    if (argc == 1 && strncmp(argv[0], "reset", sizeof("reset")) == 0) {
+        app_cores_reset_stats();
+        latency_trace_reset();
+        return ESP_OK;
+    }
+    if (argc >= 1 && strncmp(argv[0], "traffic", sizeof("traffic")) == 0) {
+        return sensor_cores_traffic(argc - 1, argv + 1);
+    }
+    if (argc != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    app_cores_stats_t stats;
+    app_cores_get_stats(&stats);
+#if CONFIG_APP_CORE_AFFINITY
+    printf("sensor core %d network core %d", APP_SENSOR_CORE, APP_NETWORK_CORE);
+#else
+    printf("no core affinity");
+#endif
+    printf(", gpio interrupts on core %d, esp_timer callbacks on core %d%s\n", stats.isr_core, stats.timer_core,
+           stats.timer_core >= 0 && stats.isr_core >= 0 && stats.timer_core != stats.isr_core ? " (split)" : "");
+#if CONFIG_APP_CORE_LOAD_MONITOR
+    printf("%-6s %6s %6s %6s  (%" PRIu32 " windows of %d ms)\n", "core", "last", "avg", "max", stats.windows,
+           CONFIG_APP_CORE_LOAD_SAMPLE_MS);
+    for (uint8_t core = 0; core < stats.cores; core++) {
+        printf("%-6u %5u%% %5u%% %5u%%\n", core, stats.load_pct[core], stats.load_avg_pct[core],
+               stats.load_max_pct[core]);
+    }
+#endif
+    latency_hist_snapshot_t late;
+    latency_trace_snapshot(TRACE_SPAN_TIMER_LATE, &late);
+    printf("debounce timer late (us): count %" PRIu32 " min %" PRIu32 " p50 %" PRIu32 " p99 %" PRIu32 " max %" PRIu32
+           "\n",
+           late.count, late.min_us, latency_trace_percentile(&late, 50), latency_trace_percentile(&late, 99),
+           late.max_us);
+    if (stats.traffic_running || stats.traffic_bursts > 0) {
+        printf("traffic %s on core %u: duty %u%% busy %u%% bursts %" PRIu32 " left %" PRIu32 " ms\n",
+               stats.traffic_running ? "running" : "done", stats.traffic_core, stats.traffic_duty_pct,
+               stats.traffic_busy_pct, stats.traffic_bursts, stats.traffic_left_ms);
+    }
+    return ESP_OK;
+}
+
+/* The OTA counters belong to the Matter thread, where the image processor runs */
+static esp_err_t sensor_ota_handler(int argc, char **argv)
+{
+    app_ota_stats_t stats;
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    app_ota_get_stats(&stats);
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+    printf("full %" PRIu32 " delta %" PRIu32 " failed %" PRIu32 " last-error %" PRId32 " ram %" PRIu32 "\n",
+           stats.full_images, stats.delta_images, stats.failures, stats.last_error, stats.ram_bytes);
+    if (stats.patch_bytes > 0) {
+        printf("%s patch %" PRIu32 " bytes -> image %" PRIu32 " bytes, %" PRIu32 " ms applying\n",
+               stats.in_progress ? "current" : "last", stats.patch_bytes, stats.image_bytes, stats.apply_us / 1000);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sensor_persist_handler(int argc, char **argv)
+{
+    if (argc == 1 && strncmp(argv[0], "flush", sizeof("flush")) == 0) {
+        esp_err_t err = app_persist_flush();
+        if (err != ESP_OK) {
+            return err;
+        }
+    } else if (argc == 2 && strncmp(argv[0], "delay", sizeof("delay")) == 0) {
+        app_persist_set_delay(strtoul(argv[1], NULL, 0));
+    } else if (argc != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    app_persist_stats_t stats;
+    app_persist_get_stats(&stats);
+    printf("delay %" PRIu32 " ms cached %u/%u dirty %u\n", stats.delay_ms, stats.cached, stats.capacity,
+           stats.dirty);
+    printf("sets %" PRIu32 " unchanged %" PRIu32 " coalesced %" PRIu32 " writes %" PRIu32 " commits %" PRIu32
+           " errors %" PRIu32 "\n",
+           stats.sets, stats.unchanged, stats.coalesced, stats.writes, stats.commits, stats.errors);
+    printf("flushes %" PRIu32 " early %" PRIu32 " max batch %" PRIu32 " flush time %" PRIu32 " ms\n", stats.flushes,
+           stats.early_flushes, stats.max_batch, stats.flush_ms);
+    printf("nvs entries %" PRIu64 " in %" PRIu32 " s, partition %" PRIu32 "/%" PRIu32 " used, ", stats.nvs_entries,
+           stats.uptime_s, stats.nvs_used_entries, stats.nvs_total_entries);
+    if (stats.projected_days == UINT32_MAX) {
+        printf("no wear\n");
+    } else {
+        printf("projected lifetime %" PRIu32 " days from settings\n", stats.projected_days);
+    }
+    return ESP_OK;
+}
+
+/* start <rate_hz> <seconds> [steady | burst <n> | random] [all | <ch>[,<ch>...]] */
+static esp_err_t sensor_storm_start(int argc, char **argv)
+{
+    if (argc < 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    app_storm_config_t config = {};
+    config.rate_hz = strtoul(argv[0], NULL, 0);
+    config.duration_ms = strtoul(argv[1], NULL, 0) * 1000;
+    config.pattern = STORM_STEADY;
+    config.seed = (uint32_t)esp_timer_get_time() | 1;
+    int i = 2;
+    if (i < argc && strncmp(argv[i], "steady", sizeof("steady")) == 0) {
+        i++;
+    } else if (i < argc && strncmp(argv[i], "random", sizeof("random")) == 0) {
+        config.pattern = STORM_RANDOM;
+        i++;
+    } else if (i + 1 < argc && strncmp(argv[i], "burst", sizeof("burst")) == 0) {
+        config.pattern = STORM_BURST;
+        config.burst_len = (uint16_t)strtoul(argv[i + 1], NULL, 0);
+        i += 2;
+    }
+    static uint16_t s_channels[APP_CONTACT_MAX_CHANNEL_COUNT];
+    if (i < argc && strncmp(argv[i], "all", sizeof("all")) != 0) {
+        for (char *p = argv[i]; *p != '\0' && config.channel_count < APP_CONTACT_MAX_CHANNEL_COUNT;) {
+            char *end;
+            s_channels[config.channel_count++] = (uint16_t)strtoul(p, &end, 0);
+            if (end == p || (*end != ',' && *end != '\0')) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            p = *end == ',' ? end + 1 : end;
+        }
+        config.channels = s_channels;
+        i++;
+    } else if (i < argc) {
+        i++;
+    }
+    if (i != argc) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    esp_err_t err = app_storm_start(&config);
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+    return err;
+}
+
+static esp_err_t sensor_storm_handler(int argc, char **argv)
+{
+    if (argc >= 1 && strncmp(argv[0], "start", sizeof("start")) == 0) {
+        return sensor_storm_start(argc - 1, argv + 1);
+    }
+    if (argc == 1 && strncmp(argv[0], "stop", sizeof("stop")) == 0) {
+        app_storm_stop();
+        return ESP_OK;
+    }
+    if (argc != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    app_storm_stats_t stats;
+    chip::DeviceLayer::PlatformMgr().LockChipStack();
+    app_storm_get_stats(&stats);
+    chip::DeviceLayer::PlatformMgr().UnlockChipStack();
+    if (stats.rate_hz == 0) {
+        printf("no storm run\n");
+        return ESP_OK;
+    }
+    printf("%s: %" PRIu32 "/s %s", stats.running ? "running" : "done", stats.rate_hz,
+           storm_pattern_name((storm_pattern_t)stats.pattern));
+    if (stats.pattern == STORM_BURST) {
+        printf(" of %u", stats.burst_len);
+    }
+    printf(" on %u channels, %" PRIu32 " ms\n", stats.channels, stats.elapsed_ms);
+    printf("injected %" PRIu32 " (%" PRIu32 "/s) max lag %" PRIu32 " us, %" PRIu32 " restored\n", stats.injected,
+           stats.achieved_hz, stats.max_lag_us, stats.restored);
+    printf("queued %" PRIu32 " dropped %" PRIu32 " coalesced %" PRIu32 " high-water %" PRIu32 " reports %" PRIu32
+           " suppressed %" PRIu32 "\n",
+           stats.queued, stats.dropped, stats.coalesced, stats.queue_high_water, stats.reports, stats.suppressed);
+    printf("edge->report (us): count %" PRIu32 " p50 %" PRIu32 " p99 %" PRIu32 " max %" PRIu32 "\n",
+           stats.report_count, stats.report_p50_us, stats.report_p99_us, stats.report_max_us);
+    printf("free heap %" PRIu32 " at start, min %" PRIu32 "\n", stats.heap_start, stats.heap_min);
+    return ESP_OK;
+}
+
+#if CONFIG_APP_HAS_LIGHT
+static void sensor_light_rate_work(intptr_t arg)
+{
+    app_driver_light_set_render_rate((uint32_t)arg);
+}
+
+static esp_err_t sensor_light_handler(int argc, char **argv)
+{
+    if (argc == 1) {
+        int hz = atoi(argv[0]);
+        if (hz < 0 || hz > 1000) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        chip::DeviceLayer::PlatformMgr().ScheduleWork(sensor_light_rate_work, hz);
+        return ESP_OK;
+    }
+    if (argc != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    app_light_render_stats_t stats;
+    app_driver_light_get_render_stats(&stats);
+    printf("rate %" PRIu32 " Hz writes %" PRIu32 " coalesced %" PRIu32 " renders %" PRIu32 " led-writes %" PRIu32
+           "\n",
+           stats.rate_hz, stats.writes, stats.coalesced, stats.renders, stats.led_writes);
+    return ESP_OK;
+}
+#endif
+
+static const console::command_t k_sensor_commands[] = {
+    {
+        .name = "latency",
+        .description = "Edge-to-report latency histograms. Usage: sensor latency [reset]",
+        .handler = sensor_latency_handler,
+    },
+    {
+        .name = "boot",
+        .description = "Boot phase timings, from esp_timer start. Usage: sensor boot",
+        .handler = sensor_boot_handler,
+    },
+    {
+        .name = "queue",
+        .description = "Contact event queue counters. Usage: sensor queue",
+        .handler = sensor_queue_handler,
+    },
+    {
+        .name = "power",
+        .description = "Time spent awake and in light sleep. Usage: sensor power",
+        .handler = sensor_power_handler,
+    },
+    {
+        .name = "evlog",
+        .description = "Contact event log counters. Usage: sensor evlog",
+        .handler = sensor_evlog_handler,
+    },
+    {
+        .name = "telemetry",
+        .description = "Binary telemetry stream counters. Usage: sensor telemetry",
+        .handler = sensor_telemetry_handler,
+    },
+    {
+        .name = "dlog",
+        .description = "Deferred log ring counters. Usage: sensor dlog",
+        .handler = sensor_dlog_handler,
+    },
+    {
+        .name = "logbench",
+        .description = "Time ESP_LOGI against deferred APP_LOGI calls. Usage: sensor logbench [count]",
+        .handler = sensor_logbench_handler,
+    },
+    {
+        .name = "imu",
+        .description = "Accelerometer FIFO and motion detector counters. Usage: sensor imu",
+        .handler = sensor_imu_handler,
+    },
+    {
+        .name = "hall",
+        .description = "Hall sensor counters and door position, or take the current field as the closed "
+                       "reference. Usage: sensor hall [calibrate]",
+        .handler = sensor_hall_handler,
+    },
+    {
+        .name = "policy",
+        .description = "Contact report policies and suppressed transitions, or set a policy (0 disables a limit). "
+                       "Usage: sensor policy [<channel|all> <min_ms> <holdoff_ms> <max_reports> <window_s>]",
+        .handler = sensor_policy_handler,
+    },
+    {
+        .name = "expander",
+        .description = "GPIO expander scan counters. Usage: sensor expander",
+        .handler = sensor_expander_handler,
+    },
+    {
+        .name = "binding",
+        .description = "Commands sent to bound devices per contact transition, or set them (none, on, off, toggle). "
+                       "Usage: sensor binding [<channel|all> <open> <close>]",
+        .handler = sensor_binding_handler,
+    },
+    {
+        .name = "watermark",
+        .description = "Heap, task stack and queue watermarks over the slot ring and since boot. "
+                       "Usage: sensor watermark [metric]",
+        .handler = sensor_watermark_handler,
+    },
+    {
+        .name = "cores",
+        .description = "Core placement, per-core load and debounce timer lateness, or run synthetic network load "
+                       "on a core (duty 1-90%). "
+                       "Usage: sensor cores [reset | traffic <core> <duty_pct> <burst_ms> <seconds> | traffic stop]",
+        .handler = sensor_cores_handler,
+    },
+    {
+        .name = "ota",
+        .description = "Full and delta OTA images received, last patch applied. Usage: sensor ota",
+        .handler = sensor_ota_handler,
+    },
+    {
+        .name = "persist",
+        .description = "Settings cache counters and projected flash lifetime, write the pending settings now, or "
+                       "set the write-behind delay (0 writes through). Usage: sensor persist [flush | delay <ms>]",
+        .handler = sensor_persist_handler,
+    },
+    {
+        .name = "storm",
+        .description = "Feed synthetic contact transitions at a rate and pattern to the channels in turn, bound "
+                       "devices included, and print throughput, drops, report latency and heap. "
+                       "Usage: sensor storm [start <rate_hz> <seconds> [steady | burst <n> | random] "
+                       "[all | <ch>,<ch>...] | stop]",
+        .handler = sensor_storm_handler,
+    },
+#if CONFIG_APP_HAS_LIGHT
+    {
+        .name = "light",
+        .description = "Light render counters, or set the render rate. Usage: sensor light [hz]",
+        .handler = sensor_light_handler,
+    },
+#endif
+};
+
+static esp_err_t sensor_dispatch(int argc, char **argv)
+{
+    if (argc <= 0) {
+        for (size_t i = 0; i < sizeof(k_sensor_commands) / sizeof(k_sensor_commands[0]); i++) {
+            printf("  %-10s %s\n", k_sensor_commands[i].name, k_sensor_commands[i].description);
+        }
+        return ESP_OK;
+    }
+    return sensor_console.exec_command(argc, argv);
+}
+
+esp_err_t app_console_register_commands()
+{
+    static const console::command_t command = {
+        .name = "sensor",
+        .description = "Contact sensor instrumentation. Usage: matter esp sensor <subcommand>",
+        .handler = sensor_dispatch,
+    };
+    sensor_console.register_commands(k_sensor_commands, sizeof(k_sensor_commands) / sizeof(k_sensor_commands[0]));
+    return console::add_commands(&command, 1);
+}
+#endif // CONFIG_ENABLE_CHIP_SHELL
@@ -0,0 +1,181 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+
+#include <app_priv.h>
+#include "contact_debounce.h"
+#include "latency_trace.h"
+
+static const char *TAG = "app_contact";
+
+#if CONFIG_APP_CONTACT_LEADING_EDGE
+#define APP_CONTACT_LEADING_EDGE true
+#else
+#define APP_CONTACT_LEADING_EDGE false
+#endif
+
+typedef struct {
+    gpio_num_t gpio_num;
+    uint8_t active_level;
+    app_contact_cb_t cb;
+    void *cb_arg;
+    esp_timer_handle_t timer;
+    portMUX_TYPE lock;
+    contact_debounce_t db;
+} contact_channel_t;
+
+static contact_channel_t s_channels[CONFIG_APP_CONTACT_MAX_CHANNELS];
+static uint8_t s_channel_count = 0;
+
+static inline bool contact_read_closed(const contact_channel_t *ch)
+{
+    return gpio_get_level(ch->gpio_num) == ch->active_level;
+}
+
+#if CONFIG_APP_SLEEPY_END_DEVICE
+/* Edge interrupts cannot wake the chip from light sleep, so wait for the level the input is
+ * not at: the interrupt then fires on the next change and doubles as the wakeup source. */
+static inline void contact_arm_level(const contact_channel_t *ch, int level)
+{
+    gpio_wakeup_enable(ch->gpio_num, level ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+}
+#endif
+
+/* Runs on every edge: only feeds the state machine, reports happen in the timer callback */
+static void contact_isr_handler(void *arg)
+{
+    contact_channel_t *ch = (contact_channel_t *)arg;
+    int64_t now = esp_timer_get_time();
+#if CONFIG_APP_SLEEPY_END_DEVICE
+    int level = gpio_get_level(ch->gpio_num);
+    contact_arm_level(ch, level);
+    bool closed = level == ch->active_level;
+#else
+    bool closed = contact_read_closed(ch);
+#endif
+
+    portENTER_CRITICAL_ISR(&ch->lock);
+    uint8_t flags = contact_debounce_on_edge(&ch->db, now, closed);
+    int64_t deadline = ch->db.deadline_us;
+    portEXIT_CRITICAL_ISR(&ch->lock);
+
+    if (flags & CONTACT_DEBOUNCE_ARM) {
+        esp_timer_start_once(ch->timer, deadline > now ? deadline - now : 0);
+    }
+}
+
+static void contact_timer_cb(void *arg)
+{
+    contact_channel_t *ch = (contact_channel_t *)arg;
+    int64_t now = esp_timer_get_time();
+    bool closed = contact_read_closed(ch);
+
+    portENTER_CRITICAL(&ch->lock);
+    int64_t due = ch->db.deadline_us;
+    uint8_t flags = contact_debounce_on_timer(&ch->db, now, closed);
+    int64_t deadline = ch->db.deadline_us;
+    int64_t edge = ch->db.first_edge_us;
+    bool stable = ch->db.stable_level;
+    portEXIT_CRITICAL(&ch->lock);
+    latency_trace_record(TRACE_SPAN_TIMER_LATE, due, now);
+
+    if (flags & CONTACT_DEBOUNCE_ARM) {
+        esp_timer_start_once(ch->timer, deadline > now ? deadline - now : 0);
+    }
+    if (flags & CONTACT_DEBOUNCE_REPORT) {
+        ch->cb(ch->cb_arg, stable, edge);
+    }
+}
+
+app_driver_handle_t app_contact_create(const app_contact_config_t *config, app_contact_cb_t cb, void *cb_arg)
+{
+    if (s_channel_count >= CONFIG_APP_CONTACT_MAX_CHANNELS) {
+        ESP_LOGE(TAG, "No free contact channel for GPIO %d", config->gpio_num);
+        return NULL;
+    }
+    contact_channel_t *ch = &s_channels[s_channel_count];
+    ch->gpio_num = config->gpio_num;
+    ch->active_level = config->active_level;
+    ch->cb = cb;
+    ch->cb_arg = cb_arg;
+    portMUX_INITIALIZE(&ch->lock);
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << config->gpio_num,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = config->active_level == 0 ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
+        .pull_down_en = config->active_level == 0 ? GPIO_PULLDOWN_DISABLE : GPIO_PULLDOWN_ENABLE,
+#if CONFIG_APP_SLEEPY_END_DEVICE
+        .intr_type = GPIO_INTR_DISABLE,
+#else
+        .intr_type = GPIO_INTR_ANYEDGE,
+#endif
+    };
+    esp_err_t err = gpio_config(&io_conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure GPIO %d, err:%d", config->gpio_num, err);
+        return NULL;
+    }
+
+    esp_timer_create_args_t timer_args = {
+        .callback = contact_timer_cb,
+        .arg = ch,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "contact",
+        .skip_unhandled_events = false,
+    };
+    err = esp_timer_create(&timer_args, &ch->timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create debounce timer, err:%d", err);
+        return NULL;
+    }
+
+    contact_debounce_config_t db_config = {
+        .settle_us = CONFIG_APP_CONTACT_SETTLE_MS * 1000,
+        .leading_edge = APP_CONTACT_LEADING_EDGE,
+    };
+    contact_debounce_init(&ch->db, &db_config, contact_read_closed(ch));
+
+    err = app_cores_install_gpio_isr_service();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to install GPIO ISR service, err:%d", err);
+        esp_timer_delete(ch->timer);
+        return NULL;
+    }
+    err = gpio_isr_handler_add(config->gpio_num, contact_isr_handler, ch);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add ISR handler for GPIO %d, err:%d", config->gpio_num, err);
+        esp_timer_delete(ch->timer);
+        return NULL;
+    }
+
+#if CONFIG_APP_SLEEPY_END_DEVICE
+    /* Keep the pull configuration while sleeping and start waiting for the first change.
+     * gpio_config() left the interrupt disabled and gpio_wakeup_enable() only sets the level
+     * type: enable it, or the handler never runs, awake or on a wakeup. */
+    gpio_sleep_sel_dis(config->gpio_num);
+    contact_arm_level(ch, gpio_get_level(config->gpio_num));
+    gpio_intr_enable(config->gpio_num);
+#endif
+
+    s_channel_count++;
+    return (app_driver_handle_t)ch;
+}
+
+bool app_contact_get_closed(app_driver_handle_t handle)
+{
+    contact_channel_t *ch = (contact_channel_t *)handle;
+    portENTER_CRITICAL(&ch->lock);
+    bool closed = ch->db.stable_level;
+    portEXIT_CRITICAL(&ch->lock);
+    return closed;
+}
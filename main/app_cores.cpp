@@ -0,0 +1,342 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#if CONFIG_APP_CORE_AFFINITY
+#include <esp_ipc.h>
+#endif
+
+#include <atomic>
+
+#include <app_priv.h>
+
+static_assert(portNUM_PROCESSORS <= APP_CORES_MAX, "app_cores_stats_t holds APP_CORES_MAX cores");
+
+/* The debounce timers and the GPIO interrupts belong on the same core: sdkconfig.defaults
+ * pins the esp_timer task and ISR to core 1, so a sensor core of 0 needs them moved too */
+#if CONFIG_APP_CORE_AFFINITY
+#if (CONFIG_APP_SENSOR_CORE == 0 && (CONFIG_ESP_TIMER_TASK_AFFINITY_CPU1 || CONFIG_ESP_TIMER_ISR_AFFINITY_CPU1)) || \
+    (CONFIG_APP_SENSOR_CORE == 1 && (CONFIG_ESP_TIMER_TASK_AFFINITY_CPU0 || CONFIG_ESP_TIMER_ISR_AFFINITY_CPU0))
+#error "ESP_TIMER_TASK_AFFINITY and ESP_TIMER_ISR_AFFINITY must pin esp_timer to CONFIG_APP_SENSOR_CORE"
+#endif
+#endif
+
+static const char *TAG = "app_cores";
+
+static std::atomic<int8_t> s_isr_core{-1};
+
+static void app_cores_install_isr(void *arg)
+{
+    esp_err_t *err = (esp_err_t *)arg;
+    *err = gpio_install_isr_service(0);
+    if (*err == ESP_OK) {
+        s_isr_core.store((int8_t)xPortGetCoreID());
+    }
+}
+
+esp_err_t app_cores_install_gpio_isr_service()
+{
+    esp_err_t err;
+#if CONFIG_APP_CORE_AFFINITY
+    if (xPortGetCoreID() != APP_SENSOR_CORE) {
+        /* Runs in the IPC task of the sensor core, the interrupt is allocated there */
+        esp_err_t ipc_err = esp_ipc_call_blocking(APP_SENSOR_CORE, app_cores_install_isr, &err);
+        if (ipc_err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to reach core %d, err:%d", APP_SENSOR_CORE, ipc_err);
+            return ipc_err;
+        }
+    } else {
+        app_cores_install_isr(&err);
+    }
+#else
+    app_cores_install_isr(&err);
+#endif
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "GPIO interrupts on core %d", s_isr_core.load());
+    } else if (err == ESP_ERR_INVALID_STATE) {
+        /* Installed by an earlier driver */
+        err = ESP_OK;
+    } else {
+        ESP_LOGE(TAG, "Failed to install GPIO ISR service, err:%d", err);
+    }
+    return err;
+}
+
+#if CONFIG_APP_CORE_LOAD_MONITOR
+#define APP_CORES_STACK_SIZE 2560
+#define APP_CORES_TRAFFIC_STACK_SIZE 2048
+#define APP_CORES_PACKET_SIZE 1280 /* IPv6 minimum MTU */
+
+/* uxTaskGetSystemState() counters: uint32_t before FreeRTOS 10.5 */
+#ifndef configRUN_TIME_COUNTER_TYPE
+#define configRUN_TIME_COUNTER_TYPE uint32_t
+#endif
+
+static portMUX_TYPE s_cores_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t s_cores_task = NULL;
+static esp_timer_handle_t s_timer_probe = NULL;
+static std::atomic<int8_t> s_timer_core{-1};
+
+/* Idle run time per core at the last sample, owned by the monitor task */
+static TaskStatus_t *s_task_status = NULL;
+static UBaseType_t s_task_status_len = 0;
+static uint32_t s_last_idle[portNUM_PROCESSORS];
+static uint32_t s_last_total;
+
+/* Under s_cores_lock */
+static uint8_t s_load[portNUM_PROCESSORS];
+static uint8_t s_load_max[portNUM_PROCESSORS];
+static uint64_t s_busy_sum[portNUM_PROCESSORS];
+static uint64_t s_time_sum;
+static uint32_t s_windows;
+
+/* Synthetic load */
+static std::atomic<bool> s_traffic_running{false};
+static std::atomic<bool> s_traffic_stop{false};
+static uint8_t s_traffic_core;
+static uint8_t s_traffic_duty;
+static uint32_t s_traffic_burst_us;
+static int64_t s_traffic_start_us;
+static int64_t s_traffic_end_us;
+static uint64_t s_traffic_busy_us;
+static uint32_t s_traffic_bursts;
+static uint8_t s_packets[2][APP_CORES_PACKET_SIZE];
+
+static void app_cores_timer_probe_cb(void *arg)
+{
+    s_timer_core.store((int8_t)xPortGetCoreID());
+}
+
+/* Run time of each idle task and the total, false if the task list could not be read */
+static bool app_cores_sample(uint32_t *idle, uint32_t *total)
+{
+    UBaseType_t count = uxTaskGetNumberOfTasks();
+    if (count > s_task_status_len) {
+        free(s_task_status);
+        /* Room for a few tasks created before the next call */
+        s_task_status_len = count + 4;
+        s_task_status = (TaskStatus_t *)malloc(s_task_status_len * sizeof(TaskStatus_t));
+        if (!s_task_status) {
+            s_task_status_len = 0;
+            return false;
+        }
+    }
+    configRUN_TIME_COUNTER_TYPE run_time;
+    count = uxTaskGetSystemState(s_task_status, s_task_status_len, &run_time);
+    if (count == 0) {
+        return false;
+    }
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        TaskHandle_t idle_task = xTaskGetIdleTaskHandleForCore(core);
+        idle[core] = 0;
+        for (UBaseType_t i = 0; i < count; i++) {
+            if (s_task_status[i].xHandle == idle_task) {
+                idle[core] = (uint32_t)s_task_status[i].ulRunTimeCounter;
+                break;
+            }
+        }
+    }
+    *total = (uint32_t)run_time;
+    return true;
+}
+
+/* Differences are taken on 32 bits, so counter wraps are harmless */
+static void app_cores_task(void *arg)
+{
+    uint32_t idle[portNUM_PROCESSORS];
+    uint32_t total;
+    app_cores_sample(s_last_idle, &s_last_total);
+    TickType_t wake = xTaskGetTickCount();
+    while (true) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(CONFIG_APP_CORE_LOAD_SAMPLE_MS));
+        if (!app_cores_sample(idle, &total)) {
+            continue;
+        }
+        uint32_t elapsed = total - s_last_total;
+        portENTER_CRITICAL(&s_cores_lock);
+        for (int core = 0; core < portNUM_PROCESSORS && elapsed > 0; core++) {
+            uint32_t idle_time = idle[core] - s_last_idle[core];
+            uint32_t busy = idle_time < elapsed ? elapsed - idle_time : 0;
+            s_load[core] = (uint8_t)((uint64_t)busy * 100 / elapsed);
+            if (s_load[core] > s_load_max[core]) {
+                s_load_max[core] = s_load[core];
+            }
+            s_busy_sum[core] += busy;
+        }
+        s_time_sum += elapsed;
+        s_windows++;
+        portEXIT_CRITICAL(&s_cores_lock);
+        memcpy(s_last_idle, idle, sizeof(s_last_idle));
+        s_last_total = total;
+    }
+}
+
+esp_err_t app_cores_init()
+{
+    esp_timer_create_args_t timer_args = {
+        .callback = app_cores_timer_probe_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "cores_probe",
+        .skip_unhandled_events = false,
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &s_timer_probe);
+    if (err != ESP_OK) {
+        return err;
+    }
+    esp_timer_start_once(s_timer_probe, 0);
+
+    if (xTaskCreatePinnedToCore(app_cores_task, "cores", APP_CORES_STACK_SIZE, NULL,
+                                CONFIG_APP_BACKGROUND_TASK_PRIORITY, &s_cores_task, APP_NETWORK_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Sampling core load every %d ms", CONFIG_APP_CORE_LOAD_SAMPLE_MS);
+    return ESP_OK;
+}
+
+void app_cores_get_stats(app_cores_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->isr_core = s_isr_core.load();
+    stats->timer_core = s_timer_core.load();
+    stats->cores = portNUM_PROCESSORS;
+    portENTER_CRITICAL(&s_cores_lock);
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        stats->load_pct[core] = s_load[core];
+        stats->load_max_pct[core] = s_load_max[core];
+        stats->load_avg_pct[core] = s_time_sum ? (uint8_t)(s_busy_sum[core] * 100 / s_time_sum) : 0;
+    }
+    stats->windows = s_windows;
+    bool running = s_traffic_running.load();
+    stats->traffic_running = running;
+    if (running || s_traffic_bursts > 0) {
+        int64_t now = esp_timer_get_time();
+        int64_t elapsed = (running ? now : s_traffic_end_us) - s_traffic_start_us;
+        stats->traffic_core = s_traffic_core;
+        stats->traffic_duty_pct = s_traffic_duty;
+        stats->traffic_busy_pct = elapsed > 0 ? (uint8_t)(s_traffic_busy_us * 100 / elapsed) : 0;
+        stats->traffic_bursts = s_traffic_bursts;
+        stats->traffic_left_ms = running && s_traffic_end_us > now ? (uint32_t)((s_traffic_end_us - now) / 1000) : 0;
+    }
+    portEXIT_CRITICAL(&s_cores_lock);
+}
+
+void app_cores_reset_stats()
+{
+    portENTER_CRITICAL(&s_cores_lock);
+    memset(s_load_max, 0, sizeof(s_load_max));
+    memset(s_busy_sum, 0, sizeof(s_busy_sum));
+    s_time_sum = 0;
+    s_windows = 0;
+    portEXIT_CRITICAL(&s_cores_lock);
+    /* The esp_timer task affinity is set at build time, probe it again anyway */
+    if (s_timer_probe) {
+        esp_timer_start_once(s_timer_probe, 0);
+    }
+}
+
+/* Packet copies in bursts of s_traffic_burst_us, then sleep for the rest of the period */
+static void app_cores_traffic_task(void *arg)
+{
+    /* In us and rounded to the nearest tick, a truncated rest is too short for short bursts */
+    uint64_t rest_us = (uint64_t)s_traffic_burst_us * (100 - s_traffic_duty) / s_traffic_duty;
+    TickType_t rest = (TickType_t)((rest_us * configTICK_RATE_HZ + 500000) / 1000000);
+    if (rest == 0) {
+        /* Give the idle task of this core a turn, or the task watchdog fires */
+        rest = 1;
+    }
+    while (!s_traffic_stop.load() && esp_timer_get_time() < s_traffic_end_us) {
+        int64_t start = esp_timer_get_time();
+        int64_t now = start;
+        while (now - start < s_traffic_burst_us) {
+            memcpy(s_packets[1], s_packets[0], APP_CORES_PACKET_SIZE);
+            s_packets[0][now % APP_CORES_PACKET_SIZE]++;
+            now = esp_timer_get_time();
+        }
+        portENTER_CRITICAL(&s_cores_lock);
+        s_traffic_busy_us += now - start;
+        s_traffic_bursts++;
+        portEXIT_CRITICAL(&s_cores_lock);
+        vTaskDelay(rest);
+    }
+    portENTER_CRITICAL(&s_cores_lock);
+    s_traffic_end_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&s_cores_lock);
+    APP_LOGI(TAG, "Synthetic load done, %" PRIu32 " bursts", s_traffic_bursts);
+    s_traffic_running.store(false);
+    vTaskDelete(NULL);
+}
+
+esp_err_t app_cores_start_traffic(uint8_t core, uint8_t duty_pct, uint32_t burst_ms, uint32_t duration_s)
+{
+    if (core >= portNUM_PROCESSORS || duty_pct == 0 || duty_pct > 90 || burst_ms == 0 || burst_ms > 1000 ||
+        duration_s == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_traffic_running.exchange(true)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_cores_lock);
+    s_traffic_core = core;
+    s_traffic_duty = duty_pct;
+    s_traffic_burst_us = burst_ms * 1000;
+    s_traffic_start_us = now;
+    s_traffic_end_us = now + (int64_t)duration_s * 1000000;
+    s_traffic_busy_us = 0;
+    s_traffic_bursts = 0;
+    portEXIT_CRITICAL(&s_cores_lock);
+    s_traffic_stop.store(false);
+    if (xTaskCreatePinnedToCore(app_cores_traffic_task, "traffic", APP_CORES_TRAFFIC_STACK_SIZE, NULL,
+                                CONFIG_APP_CORE_TRAFFIC_PRIORITY, NULL, core) != pdPASS) {
+        s_traffic_running.store(false);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void app_cores_stop_traffic()
+{
+    s_traffic_stop.store(true);
+}
+#else
+esp_err_t app_cores_init()
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void app_cores_get_stats(app_cores_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->isr_core = s_isr_core.load();
+    stats->timer_core = -1;
+    stats->cores = portNUM_PROCESSORS;
+}
+
+void app_cores_reset_stats()
+{
+}
+
+esp_err_t app_cores_start_traffic(uint8_t core, uint8_t duty_pct, uint32_t burst_ms, uint32_t duration_s)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void app_cores_stop_traffic()
+{
+}
+#endif // CONFIG_APP_CORE_LOAD_MONITOR
@@ -0,0 +1,116 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <app_priv.h>
+
+#if CONFIG_APP_DEFERRED_LOG
+#include "dlog.h"
+#include "spsc_ring.h"
+
+/* One ring per core: producers on a core only contend with each other, the log task is
+ * the single consumer of every ring. */
+static spsc_ring<dlog_record_t, CONFIG_APP_DLOG_RING_LEN> s_dlog_rings[portNUM_PROCESSORS];
+static portMUX_TYPE s_dlog_locks[portNUM_PROCESSORS] = {
+    portMUX_INITIALIZER_UNLOCKED,
+#if portNUM_PROCESSORS > 1
+    portMUX_INITIALIZER_UNLOCKED,
+#endif
+};
+static TaskHandle_t s_dlog_task = NULL;
+
+void dlog_commit(dlog_record_t *record)
+{
+    record->timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000);
+
+    /* A task moved to the other core between the two lines still takes a valid lock */
+    int core = xPortGetCoreID();
+    portENTER_CRITICAL_SAFE(&s_dlog_locks[core]);
+    bool queued = s_dlog_rings[core].push(*record);
+    portEXIT_CRITICAL_SAFE(&s_dlog_locks[core]);
+
+    if (!queued || !s_dlog_task) {
+        return;
+    }
+    if (xPortInIsrContext()) {
+        vTaskNotifyGiveFromISR(s_dlog_task, NULL);
+    } else {
+        xTaskNotifyGive(s_dlog_task);
+    }
+}
+
+static void app_dlog_emit(const dlog_record_t *record)
+{
+#if CONFIG_APP_DLOG_TELEMETRY
+    /* The host formats the record from the ELF string table */
+    if (app_telemetry_log((uint32_t)(uintptr_t)record->desc, (uint32_t)(uintptr_t)record->tag, record->words,
+                          record->nwords)) {
+        return;
+    }
+#endif
+    static const dlog_abi_t abi = DLOG_ABI_NATIVE;
+    char text[CONFIG_APP_DLOG_LINE_LEN];
+    dlog_format(&abi, record->desc->fmt, record->words, record->nwords, NULL, NULL, text, sizeof(text));
+    esp_log_write((esp_log_level_t)record->desc->level, record->tag, "%s (%" PRIu32 ") %s: %s%s\n",
+                  dlog_level_letter(record->desc->level), record->timestamp_ms, record->tag, text,
+                  record->truncated ? " [args truncated]" : "");
+}
+
+static void app_dlog_task(void *arg)
+{
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            dlog_record_t record;
+            while (s_dlog_rings[core].pop(&record)) {
+                app_dlog_emit(&record);
+            }
+        }
+    }
+}
+
+esp_err_t app_dlog_init()
+{
+    if (xTaskCreatePinnedToCore(app_dlog_task, "dlog", 3072, NULL, CONFIG_APP_BACKGROUND_TASK_PRIORITY, &s_dlog_task,
+                                APP_NETWORK_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    /* Flush whatever was logged before the task existed */
+    xTaskNotifyGive(s_dlog_task);
+    return ESP_OK;
+}
+
+void app_dlog_get_stats(app_dlog_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        stats->records += s_dlog_rings[core].pushed();
+        stats->dropped += s_dlog_rings[core].dropped();
+        if (s_dlog_rings[core].high_water() > stats->high_water) {
+            stats->high_water = s_dlog_rings[core].high_water();
+        }
+    }
+}
+#else
+esp_err_t app_dlog_init()
+{
+    return ESP_OK;
+}
+
+void app_dlog_get_stats(app_dlog_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+#endif // CONFIG_APP_DEFERRED_LOG
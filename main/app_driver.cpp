@@ -7,130 +7,322 @@
 */
 
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <esp_matter.h>
+#include <platform/CHIPDeviceLayer.h>
 #include "bsp/esp-bsp.h"
 
+#include <atomic>
+
 #include <app_priv.h>
+#include "boot_trace.h"
+#include "contact_events.h"
+#include "flat_dispatch.h"
+#include "latency_trace.h"
+#include "report_policy.h"
 
 using namespace chip::app::Clusters;
 using namespace esp_matter;
 
 static const char *TAG = "app_driver";
 extern uint16_t light_endpoint_id;
-extern uint16_t door_endpoint_id;
+extern uint16_t contact_endpoint_ids[];
 
-/* Do any conversions/remapping for the actual value here */
-static esp_err_t app_driver_light_set_power(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+#if CONFIG_APP_HAS_LIGHT
+/* Light render stage
+ *
+ * Attribute writes only update a shadow of the LED state; a render applies the fields that
+ * changed in one LED transaction, at most once per render tick. Controller transitions
+ * arrive as a stream of CurrentLevel/CurrentHue/... writes, so this coalesces them into one
+ * driver write per tick instead of one (or a read-modify-write) per attribute. Setters and
+ * renders run on the Matter thread.
+ */
+#define APP_LIGHT_DIRTY_POWER       0x01
+#define APP_LIGHT_DIRTY_BRIGHTNESS  0x02
+#define APP_LIGHT_DIRTY_HUE         0x04
+#define APP_LIGHT_DIRTY_SATURATION  0x08
+#define APP_LIGHT_DIRTY_TEMPERATURE 0x10
+
+typedef enum {
+    APP_LIGHT_COLOR_HS = 0,
+    APP_LIGHT_COLOR_TEMPERATURE,
+} app_light_color_t;
+
+typedef struct {
+    led_indicator_handle_t handle;
+    bool on;
+    uint8_t brightness;   /* 0-255 */
+    uint16_t hue;         /* 0-360 */
+    uint8_t saturation;   /* 0-255 */
+    uint32_t temperature; /* kelvin */
+    app_light_color_t color;
+    uint8_t dirty;        /* APP_LIGHT_DIRTY_* not rendered yet */
+} app_light_shadow_t;
+
+static app_light_shadow_t s_light_shadow = {
+    .handle = NULL,
+    .on = DEFAULT_POWER,
+    .brightness = DEFAULT_BRIGHTNESS,
+    .hue = DEFAULT_HUE,
+    .saturation = DEFAULT_SATURATION,
+    .temperature = 0,
+    .color = APP_LIGHT_COLOR_HS,
+    .dirty = 0,
+};
+static app_light_render_stats_t s_light_render_stats;
+static uint32_t s_light_render_hz = CONFIG_APP_LIGHT_RENDER_HZ;
+static esp_timer_handle_t s_light_render_timer = NULL;
+static bool s_light_render_armed = false;
+
+static esp_err_t app_driver_light_render()
 {
-#if CONFIG_BSP_LEDS_NUM > 0
+    app_light_shadow_t *shadow = &s_light_shadow;
+    uint8_t dirty = shadow->dirty;
+    if (!dirty) {
+        return ESP_OK;
+    }
+    shadow->dirty = 0;
+    s_light_render_stats.renders++;
+
     esp_err_t err = ESP_OK;
-    if (val->val.b) {
-        err = led_indicator_start(handle, BSP_LED_ON);
+#if CONFIG_BSP_LEDS_NUM > 0
+    led_indicator_handle_t handle = shadow->handle;
+    if (dirty & APP_LIGHT_DIRTY_POWER) {
+        err |= led_indicator_start(handle, shadow->on ? BSP_LED_ON : BSP_LED_OFF);
+        s_light_render_stats.led_writes++;
+    }
+#if CONFIG_APP_HAS_COLOR_LIGHT
+    if (shadow->color == APP_LIGHT_COLOR_HS) {
+        /* Hue, saturation and brightness all fit in one HSV write */
+        if (dirty & (APP_LIGHT_DIRTY_HUE | APP_LIGHT_DIRTY_SATURATION | APP_LIGHT_DIRTY_BRIGHTNESS)) {
+            err |= led_indicator_set_hsv(handle, SET_HSV(shadow->hue, shadow->saturation, shadow->brightness));
+            s_light_render_stats.led_writes++;
+        }
     } else {
-        err = led_indicator_start(handle, BSP_LED_OFF);
+        if (dirty & APP_LIGHT_DIRTY_TEMPERATURE) {
+            err |= led_indicator_set_color_temperature(handle, shadow->temperature);
+            s_light_render_stats.led_writes++;
+        }
+        if (dirty & APP_LIGHT_DIRTY_BRIGHTNESS) {
+            err |= led_indicator_set_brightness(handle, shadow->brightness);
+            s_light_render_stats.led_writes++;
+        }
     }
-    return err;
+#endif
 #else
-    ESP_LOGI(TAG, "LED set power: %d", val->val.b);
-    return ESP_OK;
+    APP_LOGI(TAG, "LED render: power %d, brightness %d, hue %d, saturation %d, temperature %" PRIu32, shadow->on,
+             shadow->brightness, shadow->hue, shadow->saturation, shadow->temperature);
 #endif
+    return err;
 }
 
-static esp_err_t app_driver_light_set_brightness(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+static void app_driver_light_render_work(intptr_t arg)
 {
-    int value = REMAP_TO_RANGE(val->val.u8, MATTER_BRIGHTNESS, STANDARD_BRIGHTNESS);
-#if CONFIG_BSP_LEDS_NUM > 0
-    return led_indicator_set_brightness(handle, value);
-#else
-    ESP_LOGI(TAG, "LED set brightness: %d", value);
+    s_light_render_armed = false;
+    app_driver_light_render();
+}
+
+static void app_driver_light_render_timer_cb(void *arg)
+{
+    if (chip::DeviceLayer::PlatformMgr().ScheduleWork(app_driver_light_render_work, 0) != CHIP_NO_ERROR) {
+        /* Full Matter queue: s_light_render_armed stays set, so nothing else would render */
+        uint32_t hz = s_light_render_hz ? s_light_render_hz : 1000;
+        esp_timer_start_once(s_light_render_timer, 1000000 / hz);
+    }
+}
+
+/* Mark fields dirty and make sure a render follows within one tick */
+static esp_err_t app_driver_light_invalidate(led_indicator_handle_t handle, uint8_t dirty)
+{
+    app_light_shadow_t *shadow = &s_light_shadow;
+    shadow->handle = handle;
+    s_light_render_stats.writes++;
+    if (shadow->dirty) {
+        s_light_render_stats.coalesced++;
+    }
+    shadow->dirty |= dirty;
+
+    if (s_light_render_hz == 0 || !s_light_render_timer) {
+        return app_driver_light_render();
+    }
+    if (!s_light_render_armed) {
+        if (esp_timer_start_once(s_light_render_timer, 1000000 / s_light_render_hz) != ESP_OK) {
+            return app_driver_light_render();
+        }
+        s_light_render_armed = true;
+    }
     return ESP_OK;
-#endif
+}
+
+static esp_err_t app_driver_light_set_power(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+{
+    s_light_shadow.on = val->val.b;
+    return app_driver_light_invalidate(handle, APP_LIGHT_DIRTY_POWER);
+}
+
+#if CONFIG_APP_HAS_COLOR_LIGHT
+static esp_err_t app_driver_light_set_brightness(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
+{
+    s_light_shadow.brightness = REMAP_TO_RANGE(val->val.u8, MATTER_BRIGHTNESS, STANDARD_BRIGHTNESS);
+    return app_driver_light_invalidate(handle, APP_LIGHT_DIRTY_BRIGHTNESS);
 }
 
 static esp_err_t app_driver_light_set_hue(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
 {
-    int value = REMAP_TO_RANGE(val->val.u8, MATTER_HUE, STANDARD_HUE);
-#if CONFIG_BSP_LEDS_NUM > 0
-    led_indicator_ihsv_t hsv;
-    hsv.value = led_indicator_get_hsv(handle);
-    hsv.h = value;
-    return led_indicator_set_hsv(handle, hsv.value);
-#else
-    ESP_LOGI(TAG, "LED set hue: %d", value);
-    return ESP_OK;
-#endif
+    s_light_shadow.hue = REMAP_TO_RANGE(val->val.u8, MATTER_HUE, STANDARD_HUE);
+    s_light_shadow.color = APP_LIGHT_COLOR_HS;
+    return app_driver_light_invalidate(handle, APP_LIGHT_DIRTY_HUE);
 }
 
 static esp_err_t app_driver_light_set_saturation(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
 {
-    int value = REMAP_TO_RANGE(val->val.u8, MATTER_SATURATION, STANDARD_SATURATION);
-#if CONFIG_BSP_LEDS_NUM > 0
-    led_indicator_ihsv_t hsv;
-    hsv.value = led_indicator_get_hsv(handle);
-    hsv.s = value;
-    return led_indicator_set_hsv(handle, hsv.value);
-#else
-    ESP_LOGI(TAG, "LED set saturation: %d", value);
-    return ESP_OK;
-#endif
+    s_light_shadow.saturation = REMAP_TO_RANGE(val->val.u8, MATTER_SATURATION, STANDARD_SATURATION);
+    s_light_shadow.color = APP_LIGHT_COLOR_HS;
+    return app_driver_light_invalidate(handle, APP_LIGHT_DIRTY_SATURATION);
 }
 
 static esp_err_t app_driver_light_set_temperature(led_indicator_handle_t handle, esp_matter_attr_val_t *val)
 {
-    uint32_t value = REMAP_TO_RANGE_INVERSE(val->val.u16, STANDARD_TEMPERATURE_FACTOR);
-#if CONFIG_BSP_LEDS_NUM > 0
-    return led_indicator_set_color_temperature(handle, value);
-#else
-    ESP_LOGI(TAG, "LED set temperature: %ld", value);
+    s_light_shadow.temperature = REMAP_TO_RANGE_INVERSE(val->val.u16, STANDARD_TEMPERATURE_FACTOR);
+    s_light_shadow.color = APP_LIGHT_COLOR_TEMPERATURE;
+    return app_driver_light_invalidate(handle, APP_LIGHT_DIRTY_TEMPERATURE);
+}
+#endif // CONFIG_APP_HAS_COLOR_LIGHT
+
+esp_err_t app_driver_light_set_render_rate(uint32_t hz)
+{
+    if (hz > 1000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_light_render_hz = hz;
+    if (hz == 0) {
+        /* Whatever the pending tick was going to render goes out now */
+        return app_driver_light_render();
+    }
     return ESP_OK;
-#endif
 }
 
-static void app_driver_button_toggle_cb(void *arg, void *data)
+void app_driver_light_get_render_stats(app_light_render_stats_t *stats)
 {
-    ESP_LOGI(TAG, "Toggle button pressed");
-    uint16_t endpoint_id = light_endpoint_id;
-    uint32_t cluster_id = OnOff::Id;
-    uint32_t attribute_id = OnOff::Attributes::OnOff::Id;
+    *stats = s_light_render_stats;
+    stats->rate_hz = s_light_render_hz;
+}
 
-    node_t *node = node::get();
-    endpoint_t *endpoint = endpoint::get(node, endpoint_id);
+/* Attributes resolved once by app_driver_attribute_cache_init(), after esp_matter::start() */
+typedef struct {
+    attribute_t *on_off;
+#if CONFIG_APP_HAS_COLOR_LIGHT
+    attribute_t *current_level;
+    attribute_t *color_mode;
+    attribute_t *current_hue;
+    attribute_t *current_saturation;
+    attribute_t *color_temperature;
+#endif
+} app_light_attributes_t;
+
+static app_light_attributes_t s_light_attributes;
+
+/* Role of each endpoint, indexed by endpoint ID */
+enum {
+    APP_ENDPOINT_ROLE_NONE = 0,
+    APP_ENDPOINT_ROLE_LIGHT,
+};
+static uint8_t s_endpoint_roles[CONFIG_ESP_MATTER_MAX_DYNAMIC_ENDPOINT_COUNT];
+
+typedef esp_err_t (*app_driver_setter_t)(led_indicator_handle_t handle, esp_matter_attr_val_t *val);
+
+/* Keep sorted by (role, cluster, attribute) */
+static constexpr dispatch_entry_t<app_driver_setter_t> k_attribute_dispatch[] = {
+    { { APP_ENDPOINT_ROLE_LIGHT, OnOff::Id, OnOff::Attributes::OnOff::Id }, app_driver_light_set_power },
+#if CONFIG_APP_HAS_COLOR_LIGHT
+    { { APP_ENDPOINT_ROLE_LIGHT, LevelControl::Id, LevelControl::Attributes::CurrentLevel::Id },
+      app_driver_light_set_brightness },
+    { { APP_ENDPOINT_ROLE_LIGHT, ColorControl::Id, ColorControl::Attributes::CurrentHue::Id }, app_driver_light_set_hue },
+    { { APP_ENDPOINT_ROLE_LIGHT, ColorControl::Id, ColorControl::Attributes::CurrentSaturation::Id },
+      app_driver_light_set_saturation },
+    { { APP_ENDPOINT_ROLE_LIGHT, ColorControl::Id, ColorControl::Attributes::ColorTemperatureMireds::Id },
+      app_driver_light_set_temperature },
+#endif
+};
+static_assert(dispatch_table_sorted(k_attribute_dispatch), "k_attribute_dispatch must be sorted");
+
+static attribute_t *app_driver_attribute_resolve(endpoint_t *endpoint, uint32_t cluster_id, uint32_t attribute_id)
+{
     cluster_t *cluster = cluster::get(endpoint, cluster_id);
-    attribute_t *attribute = attribute::get(cluster, attribute_id);
+    attribute_t *attribute = cluster ? attribute::get(cluster, attribute_id) : NULL;
+    if (!attribute) {
+        ESP_LOGE(TAG, "Attribute 0x%08" PRIx32 " of cluster 0x%08" PRIx32 " not found", attribute_id, cluster_id);
+    }
+    return attribute;
+}
+
+esp_err_t app_driver_attribute_cache_init()
+{
+    node_t *node = node::get();
+    endpoint_t *endpoint = endpoint::get(node, light_endpoint_id);
+    if (!endpoint || light_endpoint_id >= CONFIG_ESP_MATTER_MAX_DYNAMIC_ENDPOINT_COUNT) {
+        ESP_LOGE(TAG, "Light endpoint %d not found", light_endpoint_id);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    app_light_attributes_t *attrs = &s_light_attributes;
+    attrs->on_off = app_driver_attribute_resolve(endpoint, OnOff::Id, OnOff::Attributes::OnOff::Id);
+    if (!attrs->on_off) {
+        return ESP_ERR_NOT_FOUND;
+    }
+#if CONFIG_APP_HAS_COLOR_LIGHT
+    attrs->current_level = app_driver_attribute_resolve(endpoint, LevelControl::Id,
+                                                        LevelControl::Attributes::CurrentLevel::Id);
+    attrs->color_mode = app_driver_attribute_resolve(endpoint, ColorControl::Id, ColorControl::Attributes::ColorMode::Id);
+    attrs->current_hue = app_driver_attribute_resolve(endpoint, ColorControl::Id,
+                                                      ColorControl::Attributes::CurrentHue::Id);
+    attrs->current_saturation = app_driver_attribute_resolve(endpoint, ColorControl::Id,
+                                                             ColorControl::Attributes::CurrentSaturation::Id);
+    attrs->color_temperature = app_driver_attribute_resolve(endpoint, ColorControl::Id,
+                                                            ColorControl::Attributes::ColorTemperatureMireds::Id);
+    if (!attrs->current_level || !attrs->color_mode || !attrs->current_hue || !attrs->current_saturation ||
+        !attrs->color_temperature) {
+        return ESP_ERR_NOT_FOUND;
+    }
+#endif
+
+    s_endpoint_roles[light_endpoint_id] = APP_ENDPOINT_ROLE_LIGHT;
+    return ESP_OK;
+}
+
+static void app_driver_button_toggle_cb(void *arg, void *data)
+{
+    APP_LOGI(TAG, "Toggle button pressed");
+    attribute_t *attribute = s_light_attributes.on_off;
+    if (!attribute) {
+        return;
+    }
 
     esp_matter_attr_val_t val = esp_matter_invalid(NULL);
     attribute::get_val(attribute, &val);
     val.val.b = !val.val.b;
-    attribute::update(endpoint_id, cluster_id, attribute_id, &val);
+    attribute::update(light_endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id, &val);
 }
 
 esp_err_t app_driver_attribute_update(app_driver_handle_t driver_handle, uint16_t endpoint_id, uint32_t cluster_id,
                                       uint32_t attribute_id, esp_matter_attr_val_t *val)
 {
-    esp_err_t err = ESP_OK;
-    if (endpoint_id == light_endpoint_id) {
-        led_indicator_handle_t handle = (led_indicator_handle_t)driver_handle;
-        if (cluster_id == OnOff::Id) {
-            if (attribute_id == OnOff::Attributes::OnOff::Id) {
-                err = app_driver_light_set_power(handle, val);
-            }
-        } else if (cluster_id == LevelControl::Id) {
-            if (attribute_id == LevelControl::Attributes::CurrentLevel::Id) {
-                err = app_driver_light_set_brightness(handle, val);
-            }
-        } else if (cluster_id == ColorControl::Id) {
-            if (attribute_id == ColorControl::Attributes::CurrentHue::Id) {
-                err = app_driver_light_set_hue(handle, val);
-            } else if (attribute_id == ColorControl::Attributes::CurrentSaturation::Id) {
-                err = app_driver_light_set_saturation(handle, val);
-            } else if (attribute_id == ColorControl::Attributes::ColorTemperatureMireds::Id) {
-                err = app_driver_light_set_temperature(handle, val);
-            }
-        }
+    if (endpoint_id >= CONFIG_ESP_MATTER_MAX_DYNAMIC_ENDPOINT_COUNT) {
+        return ESP_OK;
     }
-    return err;
+    uint8_t role = s_endpoint_roles[endpoint_id];
+    if (role == APP_ENDPOINT_ROLE_NONE) {
+        return ESP_OK;
+    }
+    app_driver_setter_t setter = dispatch_table_find(k_attribute_dispatch, { role, cluster_id, attribute_id });
+    if (!setter) {
+        return ESP_OK;
+    }
+    return setter((led_indicator_handle_t)driver_handle, val);
 }
 
 esp_err_t app_driver_light_set_defaults(uint16_t endpoint_id)
@@ -138,51 +330,61 @@ esp_err_t app_driver_light_set_defaults(uint16_t endpoint_id)
     esp_err_t err = ESP_OK;
     void *priv_data = endpoint::get_priv_data(endpoint_id);
     led_indicator_handle_t handle = (led_indicator_handle_t)priv_data;
-    node_t *node = node::get();
-    endpoint_t *endpoint = endpoint::get(node, endpoint_id);
-    cluster_t *cluster = NULL;
-    attribute_t *attribute = NULL;
+    const app_light_attributes_t *attrs = &s_light_attributes;
     esp_matter_attr_val_t val = esp_matter_invalid(NULL);
 
+    if (!attrs->on_off) {
+        ESP_LOGE(TAG, "Attribute cache not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+#if CONFIG_APP_HAS_COLOR_LIGHT
     /* Setting brightness */
-    cluster = cluster::get(endpoint, LevelControl::Id);
-    attribute = attribute::get(cluster, LevelControl::Attributes::CurrentLevel::Id);
-    attribute::get_val(attribute, &val);
+    attribute::get_val(attrs->current_level, &val);
     err |= app_driver_light_set_brightness(handle, &val);
 
     /* Setting color */
-    cluster = cluster::get(endpoint, ColorControl::Id);
-    attribute = attribute::get(cluster, ColorControl::Attributes::ColorMode::Id);
-    attribute::get_val(attribute, &val);
+    attribute::get_val(attrs->color_mode, &val);
     if (val.val.u8 == (uint8_t)ColorControl::ColorMode::kCurrentHueAndCurrentSaturation) {
         /* Setting hue */
-        attribute = attribute::get(cluster, ColorControl::Attributes::CurrentHue::Id);
-        attribute::get_val(attribute, &val);
+        attribute::get_val(attrs->current_hue, &val);
         err |= app_driver_light_set_hue(handle, &val);
         /* Setting saturation */
-        attribute = attribute::get(cluster, ColorControl::Attributes::CurrentSaturation::Id);
-        attribute::get_val(attribute, &val);
+        attribute::get_val(attrs->current_saturation, &val);
         err |= app_driver_light_set_saturation(handle, &val);
     } else if (val.val.u8 == (uint8_t)ColorControl::ColorMode::kColorTemperature) {
         /* Setting temperature */
-        attribute = attribute::get(cluster, ColorControl::Attributes::ColorTemperatureMireds::Id);
-        attribute::get_val(attribute, &val);
+        attribute::get_val(attrs->color_temperature, &val);
         err |= app_driver_light_set_temperature(handle, &val);
     } else {
         ESP_LOGE(TAG, "Color mode not supported");
     }
+#endif
 
     /* Setting power */
-    cluster = cluster::get(endpoint, OnOff::Id);
-    attribute = attribute::get(cluster, OnOff::Attributes::OnOff::Id);
-    attribute::get_val(attribute, &val);
+    attribute::get_val(attrs->on_off, &val);
     err |= app_driver_light_set_power(handle, &val);
 
+    /* Apply everything in one render instead of waiting for the tick */
+    err |= app_driver_light_render();
     return err;
 }
 
 app_driver_handle_t app_driver_light_init()
 {
+    esp_timer_create_args_t timer_args = {
+        .callback = app_driver_light_render_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "light_render",
+        .skip_unhandled_events = true,
+    };
+    if (esp_timer_create(&timer_args, &s_light_render_timer) != ESP_OK) {
+        /* Without the timer every attribute write renders right away */
+        ESP_LOGW(TAG, "Failed to create light render timer");
+        s_light_render_timer = NULL;
+    }
+
 #if CONFIG_BSP_LEDS_NUM > 0
     /* Initialize led */
     led_indicator_handle_t leds[CONFIG_BSP_LEDS_NUM];
@@ -194,69 +396,439 @@ app_driver_handle_t app_driver_light_init()
     return NULL;
 #endif
 }
+#else
+/* Contact-only profile: no endpoint is driven by attribute writes */
+esp_err_t app_driver_attribute_update(app_driver_handle_t driver_handle, uint16_t endpoint_id, uint32_t cluster_id,
+                                      uint32_t attribute_id, esp_matter_attr_val_t *val)
+{
+    return ESP_OK;
+}
+#endif // CONFIG_APP_HAS_LIGHT
 
 app_driver_handle_t app_driver_button_init()
 {
     /* Initialize button */
     button_handle_t btns[BSP_BUTTON_NUM];
     ESP_ERROR_CHECK(bsp_iot_button_create(btns, NULL, BSP_BUTTON_NUM));
+#if CONFIG_APP_HAS_LIGHT
     ESP_ERROR_CHECK(iot_button_register_cb(btns[0], BUTTON_PRESS_DOWN, app_driver_button_toggle_cb, NULL));
+#endif
     
     return (app_driver_handle_t)btns[0];
 }
 
 
-static void app_driver_door_opened_cb(void *arg, void *data)
-{   
-    ESP_LOGI(TAG, "Door opened");
-    uint16_t endpoint_id = door_endpoint_id;
-    uint32_t cluster_id = BooleanState::Id;
-    uint32_t attribute_id = BooleanState::Attributes::StateValue::Id;
-    
-    // node_t *node = node::get();
-    // endpoint_t *endpoint = endpoint::get(node, door_endpoint_id);
-    // cluster_t *cluster = cluster::get(endpoint, cluster_id);
-    // attribute_t *attribute = attribute::get(cluster, attribute_id);
+static app_driver_handle_t s_contact_handles[APP_CONTACT_CHANNEL_COUNT];
+/* Table rows, then the expander pins found at init */
+static uint16_t s_contact_channel_count = APP_CONTACT_CHANNEL_COUNT;
+
+/* Debounced transitions, produced in the esp_timer task and drained on the Matter thread */
+static spsc_ring<contact_event_t, CONFIG_APP_CONTACT_QUEUE_LEN> s_contact_events;
+static contact_pending_t s_contact_pending[APP_CONTACT_MAX_CHANNEL_COUNT];
+static contact_drain_stats_t s_contact_drain_stats;
+static std::atomic<bool> s_contact_drain_scheduled{false};
+static std::atomic<bool> s_contact_reporting{false};
+static std::atomic<uint32_t> s_contact_drain_retries{0};
+static esp_timer_handle_t s_contact_drain_timer = NULL;
+
+/* Retry delay when the drain work was lost to a full Matter work queue */
+#define APP_CONTACT_DRAIN_RETRY_MS 10
+
+/* Timestamps of the last report per channel, closed by the next Matter event loop turn */
+typedef struct {
+    int64_t edge_us;
+    int64_t update_us;
+    bool open; /* reported, span not closed yet */
+} app_contact_report_mark_t;
+
+static app_contact_report_mark_t s_contact_report_marks[APP_CONTACT_MAX_CHANNEL_COUNT];
+static bool s_contact_report_marks_open = false;
 
-    esp_matter_attr_val_t new_state = esp_matter_bool(false);
-    attribute::update(endpoint_id, cluster_id, attribute_id, &new_state);
+static void app_driver_contact_schedule_drain();
+
+/* Close the spans of every channel reported since the last call, Matter thread only */
+static void app_driver_contact_report_done(intptr_t arg)
+{
+    int64_t now = esp_timer_get_time();
+    for (uint16_t i = 0; i < s_contact_channel_count; i++) {
+        app_contact_report_mark_t *mark = &s_contact_report_marks[i];
+        if (!mark->open) {
+            continue;
+        }
+        latency_trace_record(TRACE_SPAN_UPDATE_TO_REPORT, mark->update_us, now);
+        latency_trace_record(TRACE_SPAN_EDGE_TO_REPORT, mark->edge_us, now);
+        app_telemetry_latency(TRACE_SPAN_EDGE_TO_REPORT, (uint32_t)(now - mark->edge_us));
+        mark->open = false;
+    }
+    s_contact_report_marks_open = false;
 }
 
-static void app_driver_door_closed_cb(void *arg, void *data)
-{   
-    ESP_LOGI(TAG, "Door closed");
-    uint16_t endpoint_id = door_endpoint_id;
-    uint32_t cluster_id = BooleanState::Id;
-    uint32_t attribute_id = BooleanState::Attributes::StateValue::Id;
-    
-    // node_t *node = node::get();
-    // endpoint_t *endpoint = endpoint::get(node, door_endpoint_id);
-    // cluster_t *cluster = cluster::get(endpoint, cluster_id);
-    // attribute_t *attribute = attribute::get(cluster, attribute_id);
+/* One work item per drain, scheduled after its attribute::update() calls: the reporting
+ * engine runs they queued are ahead of it, so it marks the end of report encode/transmit.
+ * On a full queue the spans end now rather than take a slot from the drain. */
+static void app_driver_contact_close_reports()
+{
+    if (!s_contact_report_marks_open) {
+        return;
+    }
+    if (chip::DeviceLayer::PlatformMgr().ScheduleWork(app_driver_contact_report_done, 0) != CHIP_NO_ERROR) {
+        app_driver_contact_report_done(0);
+    }
+}
+
+/* Report policy per channel, Matter thread only. One timer covers the earliest deadline. */
+#define APP_CONTACT_POLICY_NS "policy"
+static report_policy_t s_contact_policy[APP_CONTACT_MAX_CHANNEL_COUNT];
+static esp_timer_handle_t s_contact_policy_timer = NULL;
+
+static const report_policy_config_t k_contact_policy_default = {
+    .min_interval_ms = CONFIG_APP_REPORT_MIN_INTERVAL_MS,
+    .holdoff_ms = CONFIG_APP_REPORT_HOLDOFF_MS,
+    .max_reports = CONFIG_APP_REPORT_MAX_PER_WINDOW,
+    .window_ms = CONFIG_APP_REPORT_WINDOW_SEC * 1000,
+};
+
+/* Apply what the policy decided. `confirm_us` is the debounce confirmation time of a change
+ * reported right away, 0 for one the policy held back: the latency spans measure the
+ * pipeline, not the throttling. */
+static void app_driver_contact_apply_policy(uint16_t channel, uint8_t flags, int64_t confirm_us)
+{
+    report_policy_t *rp = &s_contact_policy[channel];
+    if (flags & REPORT_POLICY_SUMMARY) {
+        APP_LOGI(TAG, "Contact %s: %" PRIu32 " transitions held back by the report cap", app_driver_contact_name(channel),
+                 rp->summary_held);
+        if (!(flags & REPORT_POLICY_REPORT)) {
+            /* Same level as reported: only the event log tells what happened */
+            app_evlog_record(contact_endpoint_ids[channel], rp->reported,
+                             rp->summary_held > UINT16_MAX ? UINT16_MAX : rp->summary_held);
+        }
+    }
+    if (!(flags & REPORT_POLICY_REPORT)) {
+        return;
+    }
+    uint32_t transitions = rp->report_transitions + ((flags & REPORT_POLICY_SUMMARY) ? rp->summary_held : 0);
+    if (rp->report_transitions > 1) {
+        APP_LOGI(TAG, "Contact %s: %" PRIu32 " transitions coalesced", app_driver_contact_name(channel),
+                 rp->report_transitions);
+    }
+    /* Bound devices first, a light switching on is what someone at the door waits for */
+    app_binding_contact_changed(channel, rp->reported, confirm_us ? s_contact_report_marks[channel].edge_us : 0);
+    int64_t update_start = esp_timer_get_time();
+    if (confirm_us) {
+        latency_trace_record(TRACE_SPAN_CONFIRM_TO_UPDATE, confirm_us, update_start);
+    }
+    app_driver_contact_set_state(channel, rp->reported);
+    int64_t update_end = esp_timer_get_time();
+    latency_trace_record(TRACE_SPAN_UPDATE, update_start, update_end);
+    app_evlog_record(contact_endpoint_ids[channel], rp->reported, transitions > UINT16_MAX ? UINT16_MAX : transitions);
+
+    if (confirm_us) {
+        s_contact_report_marks[channel].update_us = update_end;
+        s_contact_report_marks[channel].open = true;
+        s_contact_report_marks_open = true;
+    }
+}
+
+static void app_driver_contact_policy_rearm()
+{
+    if (!s_contact_policy_timer) {
+        return;
+    }
+    int64_t deadline = INT64_MAX;
+    for (uint16_t i = 0; i < s_contact_channel_count; i++) {
+        if (s_contact_policy[i].armed && s_contact_policy[i].deadline_us < deadline) {
+            deadline = s_contact_policy[i].deadline_us;
+        }
+    }
+    esp_timer_stop(s_contact_policy_timer);
+    if (deadline != INT64_MAX) {
+        int64_t now = esp_timer_get_time();
+        esp_timer_start_once(s_contact_policy_timer, deadline > now ? deadline - now : 0);
+    }
+}
+
+static void app_driver_contact_policy_work(intptr_t arg)
+{
+    int64_t now = esp_timer_get_time();
+    for (uint16_t i = 0; i < s_contact_channel_count; i++) {
+        uint8_t flags = report_policy_on_timer(&s_contact_policy[i], now);
+        app_driver_contact_apply_policy(i, flags, 0);
+    }
+    app_driver_contact_policy_rearm();
+}
+
+static void app_driver_contact_policy_timer_cb(void *arg)
+{
+    chip::DeviceLayer::PlatformMgr().ScheduleWork(app_driver_contact_policy_work, 0);
+}
+
+static void app_driver_contact_drain(intptr_t arg)
+{
+    s_contact_drain_scheduled.store(false);
+    size_t count = contact_events_drain(&s_contact_events, s_contact_pending, s_contact_channel_count,
+                                        CONFIG_APP_CONTACT_DRAIN_BATCH, &s_contact_drain_stats);
+
+    bool armed = false;
+    for (uint16_t i = 0; i < s_contact_channel_count; i++) {
+        contact_pending_t *slot = &s_contact_pending[i];
+        if (!slot->pending) {
+            continue;
+        }
+        uint8_t flags = report_policy_on_change(&s_contact_policy[i], slot->last_us, slot->closed, slot->transitions);
+        s_contact_report_marks[i].edge_us = slot->last_edge_us;
+        app_driver_contact_apply_policy(i, flags, slot->last_us);
+        armed |= (flags & REPORT_POLICY_ARM) != 0;
+        slot->pending = false;
+    }
+    if (armed) {
+        app_driver_contact_policy_rearm();
+    }
+    app_driver_contact_close_reports();
+
+    /* Give other Matter work a turn before draining the rest */
+    if (count == CONFIG_APP_CONTACT_DRAIN_BATCH && s_contact_events.size() > 0) {
+        app_driver_contact_schedule_drain();
+    }
+}
+
+static void app_driver_contact_schedule_drain()
+{
+    if (!s_contact_reporting.load()) {
+        return;
+    }
+    if (s_contact_drain_scheduled.exchange(true)) {
+        return;
+    }
+    if (chip::DeviceLayer::PlatformMgr().ScheduleWork(app_driver_contact_drain, 0) != CHIP_NO_ERROR) {
+        /* Full Matter queue: the flag would hold back every later drain, try again shortly */
+        s_contact_drain_scheduled.store(false);
+        s_contact_drain_retries.fetch_add(1);
+        if (s_contact_drain_timer && !esp_timer_is_active(s_contact_drain_timer)) {
+            esp_timer_start_once(s_contact_drain_timer, APP_CONTACT_DRAIN_RETRY_MS * 1000);
+        }
+    }
+}
+
+static void app_driver_contact_drain_retry_cb(void *arg)
+{
+    app_driver_contact_schedule_drain();
+}
+
+/* Shared by every contact channel, `arg` carries the channel index */
+static void app_driver_contact_cb(void *arg, bool closed, int64_t edge_us)
+{
+    contact_event_t event = {
+        .channel = (uint16_t)(uintptr_t)arg,
+        .closed = closed,
+        .edge_us = edge_us,
+        .timestamp_us = esp_timer_get_time(),
+    };
+    latency_trace_record(TRACE_SPAN_EDGE_TO_CONFIRM, edge_us, event.timestamp_us);
+    s_contact_events.push(event);
+    app_driver_contact_schedule_drain();
+    app_telemetry_contact_edge((uint8_t)event.channel, closed, edge_us);
+}
+
+/* First report after boot, on the Matter thread. Nothing drains the queue before this, so
+ * it holds every transition since app_driver_contact_init(): they are merged per channel
+ * into one event log entry, and the data model gets the current debounced level, which
+ * stays right even if the queue overflowed during boot. */
+static void app_driver_contact_publish_boot_state(intptr_t arg)
+{
+    contact_events_drain(&s_contact_events, s_contact_pending, s_contact_channel_count, CONFIG_APP_CONTACT_QUEUE_LEN,
+                         &s_contact_drain_stats);
+    for (uint16_t i = 0; i < s_contact_channel_count; i++) {
+        contact_pending_t *slot = &s_contact_pending[i];
+        bool closed = app_driver_contact_get_closed(i);
+        app_driver_contact_set_state(i, closed);
+        /* The policy starts from what the data model now holds */
+        report_policy_config_t config = s_contact_policy[i].config;
+        report_policy_init(&s_contact_policy[i], &config, closed);
+        if (slot->pending) {
+            APP_LOGI(TAG, "Contact %s: %u transitions during boot", app_driver_contact_name(i), slot->transitions);
+            app_evlog_record(contact_endpoint_ids[i], closed, slot->transitions);
+            slot->pending = false;
+        }
+    }
+    boot_trace_mark(BOOT_PHASE_FIRST_REPORT, esp_timer_get_time());
+
+    /* Transitions queued from now on go through the regular drain */
+    s_contact_reporting.store(true);
+    app_driver_contact_schedule_drain();
+}
+
+void app_driver_contact_start_reporting()
+{
+    chip::DeviceLayer::PlatformMgr().ScheduleWork(app_driver_contact_publish_boot_state, 0);
+}
+
+void app_driver_contact_get_policy(uint16_t channel, app_contact_policy_t *policy)
+{
+    const report_policy_t *rp = &s_contact_policy[channel];
+    policy->min_interval_ms = rp->config.min_interval_ms;
+    policy->holdoff_ms = rp->config.holdoff_ms;
+    policy->max_reports = rp->config.max_reports;
+    policy->window_sec = rp->config.window_ms / 1000;
+    policy->transitions = rp->transitions;
+    policy->reports = rp->reports;
+    policy->suppressed = rp->suppressed;
+    policy->summaries = rp->summaries;
+    policy->held = rp->level != rp->reported || rp->window_held;
+}
+
+/* Saved per channel number: expander pins keep their numbers as long as the wiring does */
+static void app_driver_contact_save_policy(uint16_t channel, const report_policy_config_t *config)
+{
+    /* Field by field on zeroes: the padding is compared too */
+    report_policy_config_t saved;
+    memset(&saved, 0, sizeof(saved));
+    saved.min_interval_ms = config->min_interval_ms;
+    saved.holdoff_ms = config->holdoff_ms;
+    saved.max_reports = config->max_reports;
+    saved.window_ms = config->window_ms;
+    char key[8];
+    snprintf(key, sizeof(key), "ch%u", channel);
+    esp_err_t err = app_persist_set(APP_CONTACT_POLICY_NS, key, &saved, sizeof(saved));
+    if (err != ESP_OK) {
+        APP_LOGW(TAG, "Failed to save the report policy, err:%d", err);
+    }
+}
+
+void app_driver_contact_set_policy(uint16_t channel, const app_contact_policy_t *policy)
+{
+    report_policy_config_t config = {
+        .min_interval_ms = policy->min_interval_ms,
+        .holdoff_ms = policy->holdoff_ms,
+        .max_reports = policy->max_reports,
+        .window_ms = policy->window_sec * 1000,
+    };
+    app_driver_contact_save_policy(channel, &config);
+    if (!s_contact_reporting.load()) {
+        /* Before the first report the data model has nothing to catch up with */
+        s_contact_policy[channel].config = config;
+        return;
+    }
+    uint8_t flags = report_policy_configure(&s_contact_policy[channel], &config, esp_timer_get_time());
+    app_driver_contact_apply_policy(channel, flags, 0);
+    app_driver_contact_policy_rearm();
+}
+
+void app_driver_contact_restore_policies()
+{
+    for (uint16_t i = 0; i < s_contact_channel_count; i++) {
+        char key[8];
+        snprintf(key, sizeof(key), "ch%u", i);
+        report_policy_config_t config;
+        if (app_persist_get(APP_CONTACT_POLICY_NS, key, &config, sizeof(config)) == ESP_OK) {
+            s_contact_policy[i].config = config;
+        }
+    }
+}
+
+void app_driver_contact_get_queue_stats(app_contact_queue_stats_t *stats)
+{
+    stats->pushed = s_contact_events.pushed();
+    stats->dropped = s_contact_events.dropped();
+    stats->high_water = s_contact_events.high_water();
+    stats->depth = s_contact_events.size();
+    stats->batches = s_contact_drain_stats.batches;
+    stats->coalesced = s_contact_drain_stats.coalesced;
+    stats->retries = s_contact_drain_retries.load();
+}
+
+void app_driver_contact_set_state(uint16_t channel, bool closed)
+{
+    uint16_t endpoint_id = contact_endpoint_ids[channel];
+    if (endpoint_id == chip::kInvalidEndpointId) {
+        return;
+    }
+    APP_LOGI(TAG, "Contact %s %s", app_driver_contact_name(channel), closed ? "closed" : "opened");
 
-    esp_matter_attr_val_t new_state = esp_matter_bool(true);
-    attribute::update(endpoint_id, cluster_id, attribute_id, &new_state);
+    esp_matter_attr_val_t new_state = esp_matter_bool(closed);
+    attribute::update(endpoint_id, BooleanState::Id, BooleanState::Attributes::StateValue::Id, &new_state);
 }
 
-bool app_driver_get_button_state(app_driver_handle_t handle){
-    return iot_button_get_key_level((button_handle_t) handle);
+bool app_driver_contact_get_closed(uint16_t channel)
+{
+#if CONFIG_APP_EXPANDER_ENABLE
+    if (channel >= APP_CONTACT_CHANNEL_COUNT) {
+        return app_expander_get_closed(channel - APP_CONTACT_CHANNEL_COUNT);
+    }
+#endif
+    return app_contact_get_closed(s_contact_handles[channel]);
 }
-void app_driver_set_door_opened(){
-    app_driver_door_opened_cb(NULL, NULL);
+
+uint16_t app_driver_contact_channel_count()
+{
+    return s_contact_channel_count;
 }
-void app_driver_set_door_closed(){
-    app_driver_door_closed_cb(NULL, NULL);
+
+const char *app_driver_contact_name(uint16_t channel)
+{
+#if CONFIG_APP_EXPANDER_ENABLE
+    if (channel >= APP_CONTACT_CHANNEL_COUNT) {
+        return app_expander_name(channel - APP_CONTACT_CHANNEL_COUNT);
+    }
+#endif
+    return k_contact_channels[channel].name;
 }
 
-app_driver_handle_t app_driver_door_init(){
-    button_handle_t handle = iot_button_create(&door_btn_cfg);
-    iot_button_register_cb(handle, BUTTON_PRESS_UP, app_driver_door_opened_cb, NULL);
-    iot_button_register_cb(handle, BUTTON_PRESS_DOWN, app_driver_door_closed_cb, NULL);
-    return (app_driver_handle_t) handle;
+void app_driver_contact_inject(uint16_t channel, bool closed, int64_t edge_us)
+{
+    app_driver_contact_cb((void *)(uintptr_t)channel, closed, edge_us);
 }
 
+void app_driver_set_door_opened()
+{
+    app_driver_contact_inject(APP_CONTACT_DOOR, false, esp_timer_get_time());
+}
 
-// bool app_driver_is_door_open(){
-//     return (bool) gpio_get_level((door_sensor_gpio));
-// }
+void app_driver_set_door_closed()
+{
+    app_driver_contact_inject(APP_CONTACT_DOOR, true, esp_timer_get_time());
+}
 
+esp_err_t app_driver_contact_init()
+{
+    /* Nothing is reported before app_driver_contact_start_reporting() */
+    for (uint16_t i = 0; i < APP_CONTACT_MAX_CHANNEL_COUNT; i++) {
+        contact_endpoint_ids[i] = chip::kInvalidEndpointId;
+        report_policy_init(&s_contact_policy[i], &k_contact_policy_default, false);
+    }
+    esp_timer_create_args_t timer_args = {
+        .callback = app_driver_contact_policy_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "report_policy",
+        .skip_unhandled_events = true,
+    };
+    if (esp_timer_create(&timer_args, &s_contact_policy_timer) != ESP_OK) {
+        /* Without the timer held back reports wait for the next change of the channel */
+        ESP_LOGW(TAG, "Failed to create report policy timer");
+        s_contact_policy_timer = NULL;
+    }
+    timer_args.callback = app_driver_contact_drain_retry_cb;
+    timer_args.name = "contact_drain";
+    if (esp_timer_create(&timer_args, &s_contact_drain_timer) != ESP_OK) {
+        /* Without the timer a lost drain waits for the next transition */
+        ESP_LOGW(TAG, "Failed to create contact drain retry timer");
+        s_contact_drain_timer = NULL;
+    }
+    for (uint16_t i = 0; i < APP_CONTACT_CHANNEL_COUNT; i++) {
+        s_contact_handles[i] = app_contact_create(&k_contact_channels[i], app_driver_contact_cb, (void *)(uintptr_t)i);
+        if (!s_contact_handles[i]) {
+            ESP_LOGE(TAG, "Failed to create contact %s", k_contact_channels[i].name);
+            return ESP_FAIL;
+        }
+    }
+#if CONFIG_APP_EXPANDER_ENABLE
+    /* The GPIO contacts work without the expanders */
+    uint16_t expander_channels = 0;
+    esp_err_t err = app_expander_init(app_driver_contact_cb, APP_CONTACT_CHANNEL_COUNT, &expander_channels);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "GPIO expanders unavailable, err:%d", err);
+    }
+    s_contact_channel_count = APP_CONTACT_CHANNEL_COUNT + expander_channels;
+#endif
+    return ESP_OK;
+}
@@ -0,0 +1,206 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <esp_matter.h>
+#include <app/EventLogging.h>
+#include <platform/CHIPDeviceLayer.h>
+
+#include <app_priv.h>
+#include "event_log.h"
+
+using namespace chip::app::Clusters;
+
+#if CONFIG_APP_EVLOG_ENABLE
+static const char *TAG = "app_evlog";
+
+#define APP_EVLOG_PARTITION_SUBTYPE ((esp_partition_subtype_t)0x40)
+
+/* Record value: bit 0 is the contact state, bits 1-7 the number of coalesced transitions */
+#define APP_EVLOG_VALUE_CLOSED 0x01
+#define APP_EVLOG_VALUE_COUNT_MAX 0x7F
+
+static event_log_t s_evlog;
+static uint8_t s_evlog_buf[(CONFIG_APP_EVLOG_BATCH_RECORDS + 1) * EVENT_LOG_RECORD_SIZE];
+static bool s_evlog_mounted = false;
+static bool s_online = false;
+static uint32_t s_evlog_overwritten_seen = 0;
+
+static int app_evlog_flash_read(void *ctx, uint32_t offset, void *dst, size_t len)
+{
+    return esp_partition_read((const esp_partition_t *)ctx, offset, dst, len) == ESP_OK ? 0 : -1;
+}
+
+static int app_evlog_flash_write(void *ctx, uint32_t offset, const void *src, size_t len)
+{
+    return esp_partition_write((const esp_partition_t *)ctx, offset, src, len) == ESP_OK ? 0 : -1;
+}
+
+static int app_evlog_flash_erase(void *ctx, uint32_t offset)
+{
+    const esp_partition_t *partition = (const esp_partition_t *)ctx;
+    return esp_partition_erase_range(partition, offset, partition->erase_size) == ESP_OK ? 0 : -1;
+}
+
+static bool app_evlog_emit_state_change(uint16_t endpoint_id, bool closed)
+{
+    BooleanState::Events::StateChange::Type event{ closed };
+    chip::EventNumber event_number;
+    CHIP_ERROR err = chip::app::LogEvent(event, endpoint_id, event_number);
+    if (err != CHIP_NO_ERROR) {
+        ESP_LOGE(TAG, "Failed to log StateChange event, err:%" CHIP_ERROR_FORMAT, err.Format());
+        return false;
+    }
+    return true;
+}
+
+static bool app_evlog_replay_cb(const event_log_entry_t *entry, void *arg)
+{
+    if (!app_evlog_emit_state_change(entry->endpoint, entry->value & APP_EVLOG_VALUE_CLOSED)) {
+        return false;
+    }
+    *(uint32_t *)arg = entry->seq;
+    return true;
+}
+
+/* Called after anything that can flush, i.e. wrap the ring */
+static void app_evlog_check_overwritten()
+{
+    uint32_t lost = s_evlog.stats.overwritten - s_evlog_overwritten_seen;
+    if (lost) {
+        s_evlog_overwritten_seen = s_evlog.stats.overwritten;
+        ESP_LOGW(TAG, "Event log full, %" PRIu32 " events not replayed yet were overwritten", lost);
+    }
+}
+
+static void app_evlog_flush_work(intptr_t arg)
+{
+    if (event_log_flush(&s_evlog) != EVENT_LOG_OK) {
+        ESP_LOGE(TAG, "Failed to flush event log");
+    }
+    app_evlog_check_overwritten();
+}
+
+static void app_evlog_flush_timer_cb(void *arg)
+{
+    chip::DeviceLayer::PlatformMgr().ScheduleWork(app_evlog_flush_work, 0);
+}
+
+esp_err_t app_evlog_init()
+{
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, APP_EVLOG_PARTITION_SUBTYPE,
+                                                                "evlog");
+    if (!partition) {
+        ESP_LOGE(TAG, "Event log partition not found");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    event_log_flash_t flash = {
+        .read = app_evlog_flash_read,
+        .write = app_evlog_flash_write,
+        .erase_sector = app_evlog_flash_erase,
+        .ctx = (void *)partition,
+        .size = (uint32_t)(partition->size - partition->size % partition->erase_size),
+        .sector_size = partition->erase_size,
+    };
+    int err = event_log_mount(&s_evlog, &flash, s_evlog_buf, sizeof(s_evlog_buf));
+    if (err != EVENT_LOG_OK) {
+        ESP_LOGE(TAG, "Failed to mount event log, err:%d", err);
+        return ESP_FAIL;
+    }
+    s_evlog_mounted = true;
+    ESP_LOGI(TAG, "Event log mounted, next seq %" PRIu32 ", %" PRIu32 " events to replay", s_evlog.next_seq,
+             event_log_unacked(&s_evlog));
+
+    esp_timer_create_args_t timer_args = {
+        .callback = app_evlog_flush_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "evlog_flush",
+        .skip_unhandled_events = true,
+    };
+    esp_timer_handle_t timer;
+    esp_err_t esp_err = esp_timer_create(&timer_args, &timer);
+    if (esp_err == ESP_OK) {
+        esp_err = esp_timer_start_periodic(timer, (uint64_t)CONFIG_APP_EVLOG_FLUSH_INTERVAL_SEC * 1000000);
+    }
+    return esp_err;
+}
+
+void app_evlog_record(uint16_t endpoint_id, bool closed, uint16_t transitions)
+{
+    if (!s_evlog_mounted) {
+        return;
+    }
+    uint8_t value = (closed ? APP_EVLOG_VALUE_CLOSED : 0) |
+                    (uint8_t)((transitions > APP_EVLOG_VALUE_COUNT_MAX ? APP_EVLOG_VALUE_COUNT_MAX : transitions) << 1);
+    uint32_t seq = event_log_append(&s_evlog, (uint32_t)(esp_timer_get_time() / 1000), endpoint_id, value);
+    app_evlog_check_overwritten();
+    if (seq == 0) {
+        ESP_LOGE(TAG, "Failed to append to event log");
+        return;
+    }
+    /* While online the event goes out right away, otherwise it waits for the replay */
+    if (s_online && app_evlog_emit_state_change(endpoint_id, closed)) {
+        event_log_ack(&s_evlog, seq);
+    }
+}
+
+void app_evlog_set_online(bool online)
+{
+    if (!s_evlog_mounted || online == s_online) {
+        return;
+    }
+    s_online = online;
+    if (!online || event_log_unacked(&s_evlog) == 0) {
+        return;
+    }
+
+    uint32_t pending = event_log_unacked(&s_evlog);
+    uint32_t last_seq = s_evlog.acked_seq;
+    event_log_for_each(&s_evlog, s_evlog.acked_seq, app_evlog_replay_cb, &last_seq);
+    event_log_ack(&s_evlog, last_seq);
+    ESP_LOGI(TAG, "Replayed %" PRIu32 " of %" PRIu32 " buffered events", pending - event_log_unacked(&s_evlog),
+             pending);
+    event_log_flush(&s_evlog);
+    app_evlog_check_overwritten();
+}
+
+void app_evlog_get_stats(app_evlog_stats_t *stats)
+{
+    stats->appends = s_evlog.stats.appends;
+    stats->unacked = s_evlog_mounted ? event_log_unacked(&s_evlog) : 0;
+    stats->flash_writes = s_evlog.stats.flash_writes;
+    stats->erases = s_evlog.stats.erases;
+    stats->crc_errors = s_evlog.stats.crc_errors;
+    stats->overwritten = s_evlog.stats.overwritten;
+}
+#else
+esp_err_t app_evlog_init()
+{
+    return ESP_OK;
+}
+
+void app_evlog_record(uint16_t endpoint_id, bool closed, uint16_t transitions)
+{
+}
+
+void app_evlog_set_online(bool online)
+{
+}
+
+void app_evlog_get_stats(app_evlog_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+#endif // CONFIG_APP_EVLOG_ENABLE
@@ -0,0 +1,369 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+
+#include <app_priv.h>
+
+#if CONFIG_APP_EXPANDER_ENABLE
+#include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "gpio_expander.h"
+#include "spsc_ring.h"
+
+static const char *TAG = "app_expander";
+
+#if CONFIG_APP_CONTACT_LEADING_EDGE
+#define APP_EXPANDER_LEADING_EDGE true
+#else
+#define APP_EXPANDER_LEADING_EDGE false
+#endif
+
+#if CONFIG_APP_EXPANDER_MCP23017
+#define APP_EXPANDER_REGMAP expander_regmap_mcp23017
+#else
+#define APP_EXPANDER_REGMAP expander_regmap_pca9555
+#endif
+
+#define APP_EXPANDER_I2C_TIMEOUT_MS 20
+#define APP_EXPANDER_I2C_HZ 400000
+/* Interrupt scans that failed are retried after 10, 20, 40... ms, then the line stays masked */
+#define APP_EXPANDER_RETRY_MS 10
+#define APP_EXPANDER_RETRY_MAX 6
+/* "x<expander>.<pin>" */
+#define APP_EXPANDER_NAME_LEN 8
+/* A scan reports each pin at most once: room for every pin of 8 expanders */
+#define APP_EXPANDER_REPORT_RING_LEN 128
+
+static i2c_master_bus_handle_t s_bus = NULL;
+static i2c_master_dev_handle_t s_devs[CONFIG_APP_EXPANDER_COUNT];
+static expander_t s_expanders[CONFIG_APP_EXPANDER_COUNT];
+static uint8_t s_expander_count = 0;
+static char s_names[APP_EXPANDER_MAX_CHANNELS][APP_EXPANDER_NAME_LEN];
+static app_contact_cb_t s_cb = NULL;
+static uint16_t s_first_channel = 0;
+static TaskHandle_t s_scan_task = NULL;
+static esp_timer_handle_t s_scan_timer = NULL;   /* wakes the scan task at a deadline */
+static esp_timer_handle_t s_report_timer = NULL; /* delivers the reports in the esp_timer task */
+static uint32_t s_bus_resets = 0;
+/* Scan retry state, owned by the scan task */
+static uint32_t s_scan_failures = 0; /* consecutive interrupt scans with a bus error */
+static int64_t s_retry_us = INT64_MAX;
+static uint32_t s_retries = 0;
+static bool s_stalled = false;
+
+typedef struct {
+    uint16_t index; /* channel minus s_first_channel */
+    bool closed;
+    int64_t edge_us;
+} app_expander_report_t;
+
+/* Produced by the scan task, consumed in the esp_timer task */
+static spsc_ring<app_expander_report_t, APP_EXPANDER_REPORT_RING_LEN> s_reports;
+
+/* Set by the interrupt, consumed by the scan */
+static std::atomic<bool> s_interrupt_pending{false};
+static std::atomic<int64_t> s_interrupt_us{0};
+static std::atomic<uint32_t> s_interrupts{0};
+
+static int app_expander_bus_read(void *ctx, uint8_t address, uint8_t reg, uint8_t *buf, size_t len)
+{
+    i2c_master_dev_handle_t dev = s_devs[address - CONFIG_APP_EXPANDER_BASE_ADDRESS];
+    esp_err_t err = i2c_master_transmit_receive(dev, &reg, 1, buf, len, APP_EXPANDER_I2C_TIMEOUT_MS);
+    return err == ESP_OK ? 0 : -1;
+}
+
+static int app_expander_bus_write(void *ctx, uint8_t address, uint8_t reg, const uint8_t *buf, size_t len)
+{
+    uint8_t data[1 + 2];
+    if (len > sizeof(data) - 1) {
+        return -1;
+    }
+    data[0] = reg;
+    memcpy(&data[1], buf, len);
+    i2c_master_dev_handle_t dev = s_devs[address - CONFIG_APP_EXPANDER_BASE_ADDRESS];
+    esp_err_t err = i2c_master_transmit(dev, data, 1 + len, APP_EXPANDER_I2C_TIMEOUT_MS);
+    return err == ESP_OK ? 0 : -1;
+}
+
+/* esp_timer task, like the debounce timers of the GPIO contacts: the contact queue keeps a
+ * single producer */
+static void app_expander_report_cb(void *arg)
+{
+    app_expander_report_t report;
+    while (s_reports.pop(&report)) {
+        s_cb((void *)(uintptr_t)(s_first_channel + report.index), report.closed, report.edge_us);
+    }
+}
+
+/* Scan task */
+static void app_expander_report(void *arg, uint8_t pin, bool closed, int64_t edge_us)
+{
+    app_expander_report_t report = {
+        .index = (uint16_t)((uintptr_t)arg * EXPANDER_PINS + pin),
+        .closed = closed,
+        .edge_us = edge_us,
+    };
+    while (s_reports.size() >= s_reports.capacity()) {
+        vTaskDelay(1);
+    }
+    s_reports.push(report);
+    /* Fails while a delivery is already pending, which then takes this report too */
+    esp_timer_start_once(s_report_timer, 0);
+}
+
+/* Runs in the scan task on the sensor core: the I2C transfers (up to 20 ms each on a
+ * failing bus) and bus resets stay out of the esp_timer task, which runs every debounce
+ * timer. Woken by the interrupt (all expanders are read: the line is shared), at the
+ * earliest settle deadline (only the expanders that are due) and to retry an interrupt scan
+ * that failed. */
+static void app_expander_scan()
+{
+    int64_t now = esp_timer_get_time();
+    bool retry = s_retry_us <= now;
+    if (retry) {
+        s_retry_us = INT64_MAX;
+    }
+    /* The line stays masked until a retry succeeds, so the edge is still the one of the interrupt */
+    bool interrupt = s_interrupt_pending.exchange(false) || retry;
+    int64_t edge = interrupt ? s_interrupt_us.load() : now;
+    int64_t next = INT64_MAX;
+    bool failed = false;
+    for (uint8_t i = 0; i < s_expander_count; i++) {
+        expander_t *exp = &s_expanders[i];
+        bool due = exp->settling && exp->deadline_us <= now;
+        if (interrupt || due) {
+            uint32_t bus_errors = exp->stats.bus_errors;
+            expander_scan(exp, interrupt ? edge : now, app_expander_report, (void *)(uintptr_t)i);
+            if (exp->stats.bus_errors != bus_errors) {
+                /* A slave holding SDA low after a glitch, clock it free */
+                i2c_master_bus_reset(s_bus);
+                s_bus_resets++;
+                failed = true;
+            }
+        }
+        if (exp->settling && exp->deadline_us < next) {
+            next = exp->deadline_us;
+        }
+    }
+    if (interrupt && failed) {
+        /* The expander that failed still holds the line low: unmasking it now would fire
+         * again at once and keep the task scanning a broken bus */
+        if (s_scan_failures++ < APP_EXPANDER_RETRY_MAX) {
+            s_retry_us = now + ((int64_t)APP_EXPANDER_RETRY_MS * 1000 << (s_scan_failures - 1));
+            s_retries++;
+        } else if (!s_stalled) {
+            s_stalled = true;
+            ESP_LOGE(TAG, "I2C bus still failing after %d retries, expander inputs stopped", APP_EXPANDER_RETRY_MAX);
+        }
+    } else if (interrupt) {
+        s_scan_failures = 0;
+    }
+    if (s_retry_us < next) {
+        next = s_retry_us;
+    }
+    /* Deadline first: an interrupt from now on wakes the task right away */
+    esp_timer_stop(s_scan_timer);
+    if (next != INT64_MAX) {
+        esp_timer_start_once(s_scan_timer, next > now ? next - now : 0);
+    }
+    if (interrupt && !failed) {
+        gpio_intr_enable((gpio_num_t)CONFIG_APP_EXPANDER_INT_GPIO);
+    }
+}
+
+static void app_expander_task(void *arg)
+{
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        app_expander_scan();
+    }
+}
+
+static void app_expander_scan_timer_cb(void *arg)
+{
+    xTaskNotifyGive(s_scan_task);
+}
+
+/* The interrupt stays low until the ports are read: masked here, unmasked by the scan */
+static void app_expander_isr_handler(void *arg)
+{
+    gpio_intr_disable((gpio_num_t)CONFIG_APP_EXPANDER_INT_GPIO);
+    s_interrupt_us.store(esp_timer_get_time());
+    s_interrupt_pending.store(true);
+    s_interrupts.fetch_add(1);
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_scan_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+esp_err_t app_expander_init(app_contact_cb_t cb, uint16_t first_channel, uint16_t *count)
+{
+    *count = 0;
+    s_cb = cb;
+    s_first_channel = first_channel;
+    esp_err_t err = app_i2c_bus_get(&s_bus);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    expander_bus_t bus = { NULL, app_expander_bus_read, app_expander_bus_write };
+    contact_debounce_config_t db_config = {
+        .settle_us = CONFIG_APP_CONTACT_SETTLE_MS * 1000,
+        .leading_edge = APP_EXPANDER_LEADING_EDGE,
+    };
+    /* Expanders are found in address order and stop at the first gap, so channel numbers
+     * (and endpoints) stay the same from one boot to the next */
+    for (uint8_t i = 0; i < CONFIG_APP_EXPANDER_COUNT; i++) {
+        uint8_t address = CONFIG_APP_EXPANDER_BASE_ADDRESS + i;
+        if (i2c_master_probe(s_bus, address, APP_EXPANDER_I2C_TIMEOUT_MS) != ESP_OK) {
+            break;
+        }
+        i2c_device_config_t dev_config;
+        memset(&dev_config, 0, sizeof(dev_config));
+        dev_config.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+        dev_config.device_address = address;
+        dev_config.scl_speed_hz = APP_EXPANDER_I2C_HZ;
+        err = i2c_master_bus_add_device(s_bus, &dev_config, &s_devs[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to add the expander at 0x%02x, err:%d", address, err);
+            return err;
+        }
+        /* Contacts to ground on the pulled up pins, like the GPIO inputs */
+        expander_err_t exp_err = expander_init(&s_expanders[i], &bus, &APP_EXPANDER_REGMAP, address, 0, &db_config,
+                                               esp_timer_get_time());
+        if (exp_err != EXPANDER_OK) {
+            ESP_LOGE(TAG, "Failed to configure the %s at 0x%02x: %s", APP_EXPANDER_REGMAP.name, address,
+                     expander_err_name(exp_err));
+            i2c_master_bus_rm_device(s_devs[i]);
+            break;
+        }
+        for (uint8_t pin = 0; pin < EXPANDER_PINS; pin++) {
+            snprintf(s_names[i * EXPANDER_PINS + pin], APP_EXPANDER_NAME_LEN, "x%u.%u", i, pin);
+        }
+        s_expander_count++;
+    }
+    if (s_expander_count == 0) {
+        ESP_LOGW(TAG, "No %s found at 0x%02x", APP_EXPANDER_REGMAP.name, CONFIG_APP_EXPANDER_BASE_ADDRESS);
+        return ESP_OK;
+    }
+
+    esp_timer_create_args_t timer_args = {
+        .callback = app_expander_scan_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "expander",
+        .skip_unhandled_events = false,
+    };
+    err = esp_timer_create(&timer_args, &s_scan_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    timer_args.callback = app_expander_report_cb;
+    timer_args.name = "expander_report";
+    err = esp_timer_create(&timer_args, &s_report_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (xTaskCreatePinnedToCore(app_expander_task, "expander", 3072, NULL, CONFIG_APP_SENSOR_TASK_PRIORITY,
+                                &s_scan_task, APP_SENSOR_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create the expander task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* Open drain, active low, shared by every expander */
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << CONFIG_APP_EXPANDER_INT_GPIO,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_LOW_LEVEL,
+    };
+    err = gpio_config(&io_conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure GPIO %d, err:%d", CONFIG_APP_EXPANDER_INT_GPIO, err);
+        return err;
+    }
+#if CONFIG_APP_SLEEPY_END_DEVICE
+    gpio_sleep_sel_dis((gpio_num_t)CONFIG_APP_EXPANDER_INT_GPIO);
+    gpio_wakeup_enable((gpio_num_t)CONFIG_APP_EXPANDER_INT_GPIO, GPIO_INTR_LOW_LEVEL);
+#endif
+    /* Usually installed by the contact inputs already */
+    err = app_cores_install_gpio_isr_service();
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = gpio_isr_handler_add((gpio_num_t)CONFIG_APP_EXPANDER_INT_GPIO, app_expander_isr_handler, NULL);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add the expander interrupt handler, err:%d", err);
+        return err;
+    }
+
+    *count = s_expander_count * EXPANDER_PINS;
+    ESP_LOGI(TAG, "%u x %s, %u contact inputs from channel %u", s_expander_count, APP_EXPANDER_REGMAP.name, *count,
+             first_channel);
+    return ESP_OK;
+}
+
+bool app_expander_get_closed(uint16_t index)
+{
+    return expander_get_closed(&s_expanders[index / EXPANDER_PINS], index % EXPANDER_PINS);
+}
+
+const char *app_expander_name(uint16_t index)
+{
+    return s_names[index];
+}
+
+void app_expander_get_stats(app_expander_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->expanders = s_expander_count;
+    stats->channels = s_expander_count * EXPANDER_PINS;
+    stats->interrupts = s_interrupts.load();
+    stats->bus_resets = s_bus_resets;
+    stats->retries = s_retries;
+    stats->stalled = s_stalled;
+    for (uint8_t i = 0; i < s_expander_count; i++) {
+        const expander_stats_t *exp = &s_expanders[i].stats;
+        stats->scans += exp->scans;
+        stats->transfers += exp->transfers;
+        stats->bus_errors += exp->bus_errors;
+        stats->changed_bits += exp->changed_bits;
+        stats->reports += exp->reports;
+    }
+}
+#else
+esp_err_t app_expander_init(app_contact_cb_t cb, uint16_t first_channel, uint16_t *count)
+{
+    *count = 0;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+bool app_expander_get_closed(uint16_t index)
+{
+    return false;
+}
+
+const char *app_expander_name(uint16_t index)
+{
+    return "";
+}
+
+void app_expander_get_stats(app_expander_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+#endif // CONFIG_APP_EXPANDER_ENABLE
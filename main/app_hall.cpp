@@ -0,0 +1,421 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <atomic>
+
+#include <app_priv.h>
+
+using namespace esp_matter;
+
+#if CONFIG_APP_HALL_ENABLE
+#include <esp_adc/adc_cali.h>
+#include <esp_adc/adc_cali_scheme.h>
+#include <esp_adc/adc_continuous.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "hall_sense.h"
+
+static const char *TAG = "app_hall";
+
+/* Door position cluster, manufacturer specific (test vendor 0xFFF1), on the door contact
+ * endpoint next to BooleanState */
+#define APP_HALL_CLUSTER_ID 0xFFF1FC20
+#define APP_HALL_ATTR_STATE 0x0000    /* enum8, hall_state_t */
+#define APP_HALL_ATTR_GAP_MM 0x0001   /* uint16, HALL_GAP_UNKNOWN while open */
+#define APP_HALL_ATTR_FIELD_UT 0x0002 /* int32, at the last report */
+#define APP_HALL_CLUSTER_REVISION 1
+
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define APP_HALL_TYPE1 1
+#define APP_HALL_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#else
+#define APP_HALL_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#endif
+
+/* Closed reference taken at runtime */
+#define APP_HALL_NS "hall"
+#define APP_HALL_KEY_CLOSED_UT "closed_ut"
+
+/* Without eFuse calibration: nominal full scale at 12 dB */
+#define APP_HALL_NOMINAL_FULL_SCALE_MV 3100
+/* Sensitivity measured over this span around the zero field output */
+#define APP_HALL_CALI_SPAN_MV 500
+/* Frames are read on the conversion done callback, this only covers a lost one */
+#define APP_HALL_FALLBACK_MS 100
+
+typedef enum {
+    APP_HALL_CALIBRATION_IDLE = 0,
+    APP_HALL_CALIBRATION_REQUESTED,
+    APP_HALL_CALIBRATION_DONE,
+    APP_HALL_CALIBRATION_FAILED,
+} app_hall_calibration_t;
+
+static adc_continuous_handle_t s_adc = NULL;
+static adc_cali_handle_t s_cali = NULL;
+static hall_sense_t s_hall;
+static TaskHandle_t s_hall_task = NULL;
+static uint16_t s_endpoint_id = chip::kInvalidEndpointId;
+static uint32_t s_frames = 0;
+static std::atomic<uint32_t> s_overflows{0};
+static std::atomic<uint8_t> s_calibration{APP_HALL_CALIBRATION_IDLE};
+
+/* Detector results, published by the Hall task and reported on the Matter thread */
+static std::atomic<uint8_t> s_state{HALL_STATE_MAX};
+static std::atomic<uint16_t> s_gap_mm{HALL_GAP_UNKNOWN};
+static std::atomic<int32_t> s_field_ut{0};
+static std::atomic<bool> s_report_scheduled{false};
+static std::atomic<bool> s_reporting{false};
+
+/* What the data model holds, Matter thread only */
+static uint8_t s_reported_state = HALL_STATE_MAX;
+static uint16_t s_reported_gap_mm = HALL_GAP_UNKNOWN;
+
+static void app_hall_report(intptr_t arg)
+{
+    s_report_scheduled.store(false);
+    if (s_endpoint_id == chip::kInvalidEndpointId) {
+        return;
+    }
+    uint8_t state = s_state.load();
+    uint16_t gap_mm = s_gap_mm.load();
+    if (state == s_reported_state && gap_mm == s_reported_gap_mm) {
+        return;
+    }
+    esp_matter_attr_val_t val = esp_matter_int32(s_field_ut.load());
+    attribute::update(s_endpoint_id, APP_HALL_CLUSTER_ID, APP_HALL_ATTR_FIELD_UT, &val);
+    if (gap_mm != s_reported_gap_mm) {
+        s_reported_gap_mm = gap_mm;
+        val = esp_matter_uint16(gap_mm);
+        attribute::update(s_endpoint_id, APP_HALL_CLUSTER_ID, APP_HALL_ATTR_GAP_MM, &val);
+    }
+    if (state != s_reported_state) {
+        APP_LOGI(TAG, "Door %s", hall_state_name((hall_state_t)state));
+        s_reported_state = state;
+        val = esp_matter_enum8(state);
+        attribute::update(s_endpoint_id, APP_HALL_CLUSTER_ID, APP_HALL_ATTR_STATE, &val);
+    }
+}
+
+static void app_hall_schedule_report()
+{
+    if (!s_reporting.load()) {
+        return;
+    }
+    if (!s_report_scheduled.exchange(true)) {
+        chip::DeviceLayer::PlatformMgr().ScheduleWork(app_hall_report, 0);
+    }
+}
+
+static IRAM_ATTR bool app_hall_conv_done_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata,
+                                             void *user_data)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_hall_task, &woken);
+    return woken == pdTRUE;
+}
+
+static IRAM_ATTR bool app_hall_pool_ovf_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata,
+                                            void *user_data)
+{
+    s_overflows.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+static void app_hall_task(void *arg)
+{
+    static uint8_t frame[CONFIG_APP_HALL_FRAME_BYTES];
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(APP_HALL_FALLBACK_MS));
+        /* Everything the driver has, a frame at a time: the detector sees each conversion once
+         * and the CPU never touches a single sample outside this loop */
+        uint32_t len = 0;
+        uint8_t events = 0;
+        while (adc_continuous_read(s_adc, frame, sizeof(frame), &len, 0) == ESP_OK && len > 0) {
+            events |= hall_sense_feed(&s_hall, frame, len);
+            s_frames++;
+        }
+        if (s_calibration.load() == APP_HALL_CALIBRATION_REQUESTED) {
+            bool ok = hall_sense_calibrate(&s_hall);
+            s_calibration.store(ok ? APP_HALL_CALIBRATION_DONE : APP_HALL_CALIBRATION_FAILED);
+        }
+        if (events == 0) {
+            continue;
+        }
+        s_field_ut.store(s_hall.field_ut);
+        s_gap_mm.store(s_hall.reported_gap_mm);
+        s_state.store(s_hall.state);
+        APP_LOGD(TAG, "Hall events 0x%02x, field %" PRId32 " uT", events, s_hall.field_ut);
+        app_hall_schedule_report();
+    }
+}
+
+/* Word layout from the driver's own bitfields, so every target reads them the same way */
+static hall_frame_format_t app_hall_frame_format()
+{
+    hall_frame_format_t format;
+    adc_digi_output_data_t probe;
+    uint32_t ones = UINT32_MAX;
+    memset(&probe, 0, sizeof(probe));
+#if APP_HALL_TYPE1
+    probe.type1.channel = ones;
+    uint32_t channel_bits = probe.val & 0xFFFF;
+    memset(&probe, 0, sizeof(probe));
+    probe.type1.data = ones;
+    uint32_t data_bits = probe.val & 0xFFFF;
+#else
+    probe.type2.channel = ones;
+    uint32_t channel_bits = probe.val;
+    memset(&probe, 0, sizeof(probe));
+    probe.type2.data = ones;
+    uint32_t data_bits = probe.val;
+#endif
+    format.word_bytes = SOC_ADC_DIGI_RESULT_BYTES;
+    format.channel_shift = (uint8_t)__builtin_ctz(channel_bits);
+    format.channel_mask = (uint8_t)(channel_bits >> format.channel_shift);
+    format.data_mask = (uint16_t)data_bits;
+    return format;
+}
+
+/* Conversion result for an input voltage: the calibration only maps the other way */
+static int32_t app_hall_counts_at(int mv, uint16_t data_mask)
+{
+    if (!s_cali) {
+        return (int32_t)((int64_t)mv * (data_mask + 1) / APP_HALL_NOMINAL_FULL_SCALE_MV);
+    }
+    int32_t low = 0;
+    int32_t high = data_mask;
+    while (low < high) {
+        int32_t mid = (low + high) / 2;
+        int voltage = 0;
+        adc_cali_raw_to_voltage(s_cali, mid, &voltage);
+        if (voltage < mv) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static esp_err_t app_hall_cali_init()
+{
+    esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t cali_config = {
+        .unit_id = ADC_UNIT_1,
+        .chan = (adc_channel_t)CONFIG_APP_HALL_ADC_CHANNEL,
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    err = adc_cali_create_scheme_curve_fitting(&cali_config, &s_cali);
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cali_config = {
+        .unit_id = ADC_UNIT_1,
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    err = adc_cali_create_scheme_line_fitting(&cali_config, &s_cali);
+#endif
+    return err;
+}
+
+esp_err_t app_hall_init()
+{
+    hall_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.format = app_hall_frame_format();
+    config.channel = CONFIG_APP_HALL_ADC_CHANNEL;
+    config.sample_hz = CONFIG_APP_HALL_SAMPLE_HZ;
+    config.decimation = CONFIG_APP_HALL_DECIMATION;
+
+    /* Sensor zero and gain in conversion counts */
+    if (app_hall_cali_init() != ESP_OK) {
+        ESP_LOGW(TAG, "No ADC calibration, assuming %d mV full scale", APP_HALL_NOMINAL_FULL_SCALE_MV);
+    }
+    int32_t low = app_hall_counts_at(CONFIG_APP_HALL_ZERO_MV - APP_HALL_CALI_SPAN_MV / 2, config.format.data_mask);
+    int32_t high = app_hall_counts_at(CONFIG_APP_HALL_ZERO_MV + APP_HALL_CALI_SPAN_MV / 2, config.format.data_mask);
+    if (high <= low) {
+        ESP_LOGE(TAG, "Zero field output %d mV out of the ADC range", CONFIG_APP_HALL_ZERO_MV);
+        return ESP_ERR_INVALID_ARG;
+    }
+    config.zero_counts = app_hall_counts_at(CONFIG_APP_HALL_ZERO_MV, config.format.data_mask);
+    /* uT per count = span uV / (uV per mT) * 1000 / counts */
+    config.ut_per_count_q8 = (int32_t)((int64_t)APP_HALL_CALI_SPAN_MV * 1000 * 1000 * 256 /
+                                       ((int64_t)CONFIG_APP_HALL_SENSITIVITY_UV_PER_MT * (high - low)));
+
+    /* A reference taken with app_hall_calibrate() wins over the configured one */
+    config.closed_ut = CONFIG_APP_HALL_CLOSED_UT;
+    int32_t saved_ut;
+    if (app_persist_get(APP_HALL_NS, APP_HALL_KEY_CLOSED_UT, &saved_ut, sizeof(saved_ut)) == ESP_OK) {
+        config.closed_ut = saved_ut;
+    }
+    config.magnet_mm = CONFIG_APP_HALL_MAGNET_MM;
+    config.closed_mm = CONFIG_APP_HALL_CLOSED_MM;
+    config.open_mm = CONFIG_APP_HALL_OPEN_MM;
+    config.hysteresis_mm = CONFIG_APP_HALL_HYSTERESIS_MM;
+    config.tamper_pct = CONFIG_APP_HALL_TAMPER_PCT;
+    config.dwell_ms = CONFIG_APP_HALL_DWELL_MS;
+    config.report_step_mm = CONFIG_APP_HALL_REPORT_STEP_MM;
+    if (!hall_sense_init(&s_hall, &config)) {
+        ESP_LOGE(TAG, "Invalid Hall sensor thresholds, see the Hall sensor menu");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    adc_continuous_handle_cfg_t handle_config = {
+        .max_store_buf_size = CONFIG_APP_HALL_FRAME_BYTES * 4,
+        .conv_frame_size = CONFIG_APP_HALL_FRAME_BYTES,
+    };
+    esp_err_t err = adc_continuous_new_handle(&handle_config, &s_adc);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create the ADC continuous driver, err:%d", err);
+        return err;
+    }
+    adc_digi_pattern_config_t pattern = {
+        .atten = ADC_ATTEN_DB_12,
+        .channel = CONFIG_APP_HALL_ADC_CHANNEL,
+        .unit = ADC_UNIT_1,
+        .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+    };
+    adc_continuous_config_t adc_config = {
+        .pattern_num = 1,
+        .adc_pattern = &pattern,
+        .sample_freq_hz = CONFIG_APP_HALL_SAMPLE_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = APP_HALL_OUTPUT_FORMAT,
+    };
+    err = adc_continuous_config(s_adc, &adc_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure ADC1 channel %d at %d Hz, err:%d", CONFIG_APP_HALL_ADC_CHANNEL,
+                 CONFIG_APP_HALL_SAMPLE_HZ, err);
+        return err;
+    }
+
+    if (xTaskCreatePinnedToCore(app_hall_task, "hall", 3072, NULL, CONFIG_APP_SENSOR_TASK_PRIORITY, &s_hall_task,
+                                APP_SENSOR_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    adc_continuous_evt_cbs_t cbs = {
+        .on_conv_done = app_hall_conv_done_cb,
+        .on_pool_ovf = app_hall_pool_ovf_cb,
+    };
+    err = adc_continuous_register_event_callbacks(s_adc, &cbs, NULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = adc_continuous_start(s_adc);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start the ADC, err:%d", err);
+        return err;
+    }
+
+    ESP_LOGI(TAG, "ADC1 channel %d at %d Hz, %d per field sample, zero %" PRId32 " counts, %" PRId32
+             "/256 uT per count",
+             CONFIG_APP_HALL_ADC_CHANNEL, CONFIG_APP_HALL_SAMPLE_HZ, CONFIG_APP_HALL_DECIMATION, config.zero_counts,
+             config.ut_per_count_q8);
+    return ESP_OK;
+}
+
+esp_err_t app_hall_add_cluster(uint16_t endpoint_id)
+{
+    if (!s_hall_task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    endpoint_t *endpoint = endpoint::get(node::get(), endpoint_id);
+    cluster_t *cluster = endpoint ? cluster::create(endpoint, APP_HALL_CLUSTER_ID, CLUSTER_FLAG_SERVER) : NULL;
+    if (!cluster) {
+        ESP_LOGE(TAG, "Failed to add the door position cluster to endpoint %d", endpoint_id);
+        return ESP_FAIL;
+    }
+    cluster::global::attribute::create_cluster_revision(cluster, APP_HALL_CLUSTER_REVISION);
+    cluster::global::attribute::create_feature_map(cluster, 0);
+    attribute::create(cluster, APP_HALL_ATTR_STATE, ATTRIBUTE_FLAG_NONE, esp_matter_enum8(HALL_STATE_OPEN));
+    attribute::create(cluster, APP_HALL_ATTR_GAP_MM, ATTRIBUTE_FLAG_NONE, esp_matter_uint16(HALL_GAP_UNKNOWN));
+    attribute::create(cluster, APP_HALL_ATTR_FIELD_UT, ATTRIBUTE_FLAG_NONE, esp_matter_int32(0));
+    s_endpoint_id = endpoint_id;
+    return ESP_OK;
+}
+
+void app_hall_start_reporting()
+{
+    if (!s_hall_task) {
+        return;
+    }
+    s_reporting.store(true);
+    app_hall_schedule_report();
+}
+
+esp_err_t app_hall_calibrate()
+{
+    if (!s_hall_task) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    s_calibration.store(APP_HALL_CALIBRATION_REQUESTED);
+    for (int i = 0; i < 10 && s_calibration.load() == APP_HALL_CALIBRATION_REQUESTED; i++) {
+        vTaskDelay(pdMS_TO_TICKS(APP_HALL_FALLBACK_MS));
+    }
+    uint8_t result = s_calibration.exchange(APP_HALL_CALIBRATION_IDLE);
+    if (result == APP_HALL_CALIBRATION_REQUESTED) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (result != APP_HALL_CALIBRATION_DONE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    /* Read back after the task answered, it no longer writes the config */
+    int32_t closed_ut = s_hall.config.closed_ut;
+    return app_persist_set(APP_HALL_NS, APP_HALL_KEY_CLOSED_UT, &closed_ut, sizeof(closed_ut));
+}
+
+void app_hall_get_stats(app_hall_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (!s_hall_task) {
+        return;
+    }
+    stats->sample_hz = s_hall.config.sample_hz;
+    stats->decimation = s_hall.config.decimation;
+    stats->frames = s_frames;
+    stats->conversions = s_hall.words;
+    stats->foreign = s_hall.foreign;
+    stats->samples = s_hall.samples;
+    stats->overflows = s_overflows.load();
+    stats->state = s_state.load();
+    stats->gap_mm = s_gap_mm.load();
+    stats->field_ut = s_hall.field_ut;
+    stats->closed_ut = s_hall.config.closed_ut;
+}
+#else
+esp_err_t app_hall_init()
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t app_hall_add_cluster(uint16_t endpoint_id)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void app_hall_start_reporting()
+{
+}
+
+esp_err_t app_hall_calibrate()
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void app_hall_get_stats(app_hall_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+#endif // CONFIG_APP_HALL_ENABLE
@@ -0,0 +1,42 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <string.h>
+
+#include <app_priv.h>
+
+#if CONFIG_APP_I2C_BUS
+static const char *TAG = "app_i2c";
+
+static i2c_master_bus_handle_t s_i2c_bus = NULL;
+
+/* Created by the first driver that needs it, the accelerometer and the expanders share it.
+ * Drivers initialize from app_main, one after the other: no lock needed here. */
+esp_err_t app_i2c_bus_get(i2c_master_bus_handle_t *bus)
+{
+    if (!s_i2c_bus) {
+        i2c_master_bus_config_t bus_config;
+        memset(&bus_config, 0, sizeof(bus_config));
+        bus_config.i2c_port = -1;
+        bus_config.sda_io_num = (gpio_num_t)CONFIG_APP_I2C_SDA_GPIO;
+        bus_config.scl_io_num = (gpio_num_t)CONFIG_APP_I2C_SCL_GPIO;
+        bus_config.clk_source = I2C_CLK_SRC_DEFAULT;
+        bus_config.glitch_ignore_cnt = 7;
+        bus_config.flags.enable_internal_pullup = true;
+        esp_err_t err = i2c_new_master_bus(&bus_config, &s_i2c_bus);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create I2C bus, err:%d", err);
+            s_i2c_bus = NULL;
+            return err;
+        }
+    }
+    *bus = s_i2c_bus;
+    return ESP_OK;
+}
+#endif // CONFIG_APP_I2C_BUS
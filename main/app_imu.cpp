@@ -0,0 +1,290 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <atomic>
+
+#include <app_priv.h>
+
+using namespace esp_matter;
+using namespace chip::app::Clusters;
+
+#if CONFIG_APP_IMU_ENABLE
+#include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "imu.h"
+#include "motion_detect.h"
+
+static const char *TAG = "app_imu";
+
+extern uint16_t imu_knock_endpoint_id;
+extern uint16_t imu_tamper_endpoint_id;
+
+#define APP_IMU_I2C_TIMEOUT_MS 20
+#define APP_IMU_I2C_HZ 400000
+
+static i2c_master_bus_handle_t s_imu_bus = NULL;
+static i2c_master_dev_handle_t s_imu_dev = NULL;
+static imu_t s_imu;
+static motion_detect_t s_motion;
+static TaskHandle_t s_imu_task = NULL;
+static esp_timer_handle_t s_knock_timer = NULL;
+static uint32_t s_bus_resets = 0;
+
+/* Detector results, published by the IMU task and reported on the Matter thread */
+static std::atomic<uint32_t> s_knocks{0};
+static std::atomic<bool> s_tamper{false};
+static std::atomic<bool> s_report_scheduled{false};
+static std::atomic<bool> s_reporting{false};
+
+/* What the data model holds, Matter thread only */
+static uint32_t s_reported_knocks = 0;
+static bool s_reported_tamper = false;
+
+static int app_imu_bus_read(void *ctx, uint8_t reg, uint8_t *buf, size_t len)
+{
+    esp_err_t err = i2c_master_transmit_receive(s_imu_dev, &reg, 1, buf, len, APP_IMU_I2C_TIMEOUT_MS);
+    return err == ESP_OK ? 0 : -1;
+}
+
+static int app_imu_bus_write(void *ctx, uint8_t reg, uint8_t value)
+{
+    uint8_t data[2] = { reg, value };
+    esp_err_t err = i2c_master_transmit(s_imu_dev, data, sizeof(data), APP_IMU_I2C_TIMEOUT_MS);
+    return err == ESP_OK ? 0 : -1;
+}
+
+static void app_imu_set_state(uint16_t endpoint_id, bool state)
+{
+    esp_matter_attr_val_t val = esp_matter_bool(state);
+    attribute::update(endpoint_id, BooleanState::Id, BooleanState::Attributes::StateValue::Id, &val);
+    app_evlog_record(endpoint_id, state, 1);
+}
+
+static void app_imu_knock_clear(intptr_t arg)
+{
+    app_imu_set_state(imu_knock_endpoint_id, false);
+}
+
+static void app_imu_knock_timer_cb(void *arg)
+{
+    chip::DeviceLayer::PlatformMgr().ScheduleWork(app_imu_knock_clear, 0);
+}
+
+static void app_imu_report(intptr_t arg)
+{
+    s_report_scheduled.store(false);
+    uint32_t knocks = s_knocks.load();
+    if (knocks != s_reported_knocks) {
+        APP_LOGI(TAG, "Knock x%" PRIu32, knocks - s_reported_knocks);
+        s_reported_knocks = knocks;
+        /* Knocks in a row keep the state up, it drops once they stop */
+        if (!esp_timer_is_active(s_knock_timer)) {
+            app_imu_set_state(imu_knock_endpoint_id, true);
+        } else {
+            esp_timer_stop(s_knock_timer);
+        }
+        esp_timer_start_once(s_knock_timer, CONFIG_APP_IMU_KNOCK_HOLD_MS * 1000);
+    }
+    bool tamper = s_tamper.load();
+    if (tamper != s_reported_tamper) {
+        APP_LOGI(TAG, "Tamper %s", tamper ? "detected" : "cleared");
+        s_reported_tamper = tamper;
+        app_imu_set_state(imu_tamper_endpoint_id, tamper);
+    }
+}
+
+static void app_imu_schedule_report()
+{
+    if (!s_reporting.load()) {
+        return;
+    }
+    if (!s_report_scheduled.exchange(true)) {
+        chip::DeviceLayer::PlatformMgr().ScheduleWork(app_imu_report, 0);
+    }
+}
+
+/* The watermark interrupt is level triggered: masked here, unmasked by the task once the
+ * FIFO is drained below the watermark */
+static void app_imu_isr_handler(void *arg)
+{
+    gpio_intr_disable((gpio_num_t)CONFIG_APP_IMU_INT_GPIO);
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_imu_task, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void app_imu_task(void *arg)
+{
+    static imu_sample_t samples[32];
+    /* Twice the watermark fill time: a lost interrupt costs latency, not samples */
+    TickType_t fallback = pdMS_TO_TICKS(2000u * CONFIG_APP_IMU_WATERMARK / s_imu.config.odr_hz + 1);
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, fallback);
+        uint32_t bus_errors = s_imu.stats.bus_errors;
+        size_t count = imu_drain(&s_imu, samples, sizeof(samples) / sizeof(samples[0]));
+        if (s_imu.stats.bus_errors != bus_errors) {
+            /* A slave holding SDA low after a glitch, clock it free */
+            i2c_master_bus_reset(s_imu_bus);
+            s_bus_resets++;
+        }
+        gpio_intr_enable((gpio_num_t)CONFIG_APP_IMU_INT_GPIO);
+        if (count == 0) {
+            continue;
+        }
+        uint8_t events = motion_detect_feed(&s_motion, samples, count);
+        if (events == 0) {
+            continue;
+        }
+        if (events & MOTION_EVENT_KNOCK) {
+            s_knocks.store(s_motion.knocks);
+        }
+        s_tamper.store(s_motion.vibrating || s_motion.tilted);
+        APP_LOGD(TAG, "Motion events 0x%02x, peak %u mg", events, s_motion.peak_mg);
+        app_imu_schedule_report();
+    }
+}
+
+esp_err_t app_imu_init()
+{
+    esp_err_t err = app_i2c_bus_get(&s_imu_bus);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    i2c_device_config_t dev_config;
+    memset(&dev_config, 0, sizeof(dev_config));
+    dev_config.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+    dev_config.device_address = CONFIG_APP_IMU_I2C_ADDRESS;
+    dev_config.scl_speed_hz = APP_IMU_I2C_HZ;
+    err = i2c_master_bus_add_device(s_imu_bus, &dev_config, &s_imu_dev);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add the IMU to the I2C bus, err:%d", err);
+        return err;
+    }
+
+    imu_bus_t bus = { NULL, app_imu_bus_read, app_imu_bus_write };
+    imu_config_t config = {
+        .odr_hz = CONFIG_APP_IMU_ODR_HZ,
+        .range_g = CONFIG_APP_IMU_RANGE_G,
+        .watermark = CONFIG_APP_IMU_WATERMARK,
+    };
+    imu_err_t imu_err = imu_init(&s_imu, &bus, &imu_regmap_lis3dh, &config);
+    if (imu_err != IMU_OK) {
+        ESP_LOGE(TAG, "Failed to configure the %s: %s", imu_regmap_lis3dh.name, imu_err_name(imu_err));
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    motion_config_t motion_config = {
+        .odr_hz = s_imu.config.odr_hz,
+        .knock_mg = CONFIG_APP_IMU_KNOCK_MG,
+        .knock_max_ms = CONFIG_APP_IMU_KNOCK_MAX_MS,
+        .vibration_mg = CONFIG_APP_IMU_VIBRATION_MG,
+        .vibration_ms = CONFIG_APP_IMU_VIBRATION_MS,
+        .tilt_deg = CONFIG_APP_IMU_TILT_DEG,
+    };
+    motion_detect_init(&s_motion, &motion_config);
+
+    esp_timer_create_args_t timer_args = {
+        .callback = app_imu_knock_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "imu_knock",
+        .skip_unhandled_events = false,
+    };
+    err = esp_timer_create(&timer_args, &s_knock_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (xTaskCreatePinnedToCore(app_imu_task, "imu", 3072, NULL, CONFIG_APP_SENSOR_TASK_PRIORITY, &s_imu_task,
+                                APP_SENSOR_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << CONFIG_APP_IMU_INT_GPIO,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_HIGH_LEVEL,
+    };
+    err = gpio_config(&io_conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure GPIO %d, err:%d", CONFIG_APP_IMU_INT_GPIO, err);
+        return err;
+    }
+#if CONFIG_APP_SLEEPY_END_DEVICE
+    /* A level interrupt is also a light sleep wakeup source: the chip sleeps through a
+     * whole watermark worth of samples */
+    gpio_wakeup_enable((gpio_num_t)CONFIG_APP_IMU_INT_GPIO, GPIO_INTR_HIGH_LEVEL);
+#endif
+    /* Usually installed by the contact inputs already */
+    err = app_cores_install_gpio_isr_service();
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = gpio_isr_handler_add((gpio_num_t)CONFIG_APP_IMU_INT_GPIO, app_imu_isr_handler, NULL);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add the IMU interrupt handler, err:%d", err);
+        return err;
+    }
+
+    ESP_LOGI(TAG, "%s at %u Hz, +-%u g, watermark %u", imu_regmap_lis3dh.name, s_imu.config.odr_hz,
+             s_imu.config.range_g, s_imu.config.watermark);
+    return ESP_OK;
+}
+
+void app_imu_start_reporting()
+{
+    if (!s_imu_task) {
+        return;
+    }
+    s_reporting.store(true);
+    app_imu_schedule_report();
+}
+
+void app_imu_get_stats(app_imu_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (!s_imu_task) {
+        return;
+    }
+    stats->samples = s_imu.stats.samples;
+    stats->drains = s_imu.stats.drains;
+    stats->transfers = s_imu.stats.transfers;
+    stats->bytes = s_imu.stats.bytes;
+    stats->overruns = s_imu.stats.overruns;
+    stats->bus_errors = s_imu.stats.bus_errors;
+    stats->bus_resets = s_bus_resets;
+    stats->knocks = s_knocks.load();
+    stats->vibrating = s_motion.vibrating;
+    stats->tilted = s_motion.tilted;
+    stats->odr_hz = s_imu.config.odr_hz;
+}
+#else
+esp_err_t app_imu_init()
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void app_imu_start_reporting()
+{
+}
+
+void app_imu_get_stats(app_imu_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+#endif // CONFIG_APP_IMU_ENABLE
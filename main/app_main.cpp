@@ -8,6 +8,9 @@
 
 #include <esp_err.h>
 #include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <inttypes.h>
 #include <nvs_flash.h>
 
 #include <esp_matter.h>
@@ -17,6 +20,7 @@
 #include <common_macros.h>
 #include <app_priv.h>
 #include <app_reset.h>
+#include "boot_trace.h"
 
 #include <platform/ESP32/OpenthreadLauncher.h>
 
@@ -26,8 +30,9 @@
 
 static const char *TAG = "app_main";
 uint16_t light_endpoint_id = 0;
-uint16_t door_endpoint_id = 1;
-uint16_t window_endpoint_id = 2;
+uint16_t contact_endpoint_ids[APP_CONTACT_MAX_CHANNEL_COUNT];
+uint16_t imu_knock_endpoint_id = chip::kInvalidEndpointId;
+uint16_t imu_tamper_endpoint_id = chip::kInvalidEndpointId;
 
 using namespace esp_matter;
 using namespace esp_matter::attribute;
@@ -44,40 +49,52 @@ static const char *s_decryption_key = decryption_key_start;
 static const uint16_t s_decryption_key_len = decryption_key_end - decryption_key_start;
 #endif // CONFIG_ENABLE_ENCRYPTED_OTA
 
+/* Last boot phase: log the whole boot timeline once, on the first attach */
+static void app_boot_network_attached()
+{
+    if (boot_trace_reached(BOOT_PHASE_NETWORK_ATTACH)) {
+        return;
+    }
+    boot_trace_mark(BOOT_PHASE_NETWORK_ATTACH, esp_timer_get_time());
+    char summary[256];
+    boot_trace_summary(summary, sizeof(summary));
+    ESP_LOGI(TAG, "Boot phases: %s", summary);
+}
+
 static void app_event_cb(const ChipDeviceEvent *event, intptr_t arg)
 {
     switch (event->Type) {
     case chip::DeviceLayer::DeviceEventType::kInterfaceIpAddressChanged:
-        ESP_LOGI(TAG, "Interface IP Address changed");
+        APP_LOGI(TAG, "Interface IP Address changed");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kCommissioningComplete:
-        ESP_LOGI(TAG, "Commissioning complete");
+        APP_LOGI(TAG, "Commissioning complete");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kFailSafeTimerExpired:
-        ESP_LOGI(TAG, "Commissioning failed, fail safe timer expired");
+        APP_LOGI(TAG, "Commissioning failed, fail safe timer expired");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kCommissioningSessionStarted:
-        ESP_LOGI(TAG, "Commissioning session started");
+        APP_LOGI(TAG, "Commissioning session started");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kCommissioningSessionStopped:
-        ESP_LOGI(TAG, "Commissioning session stopped");
+        APP_LOGI(TAG, "Commissioning session stopped");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kCommissioningWindowOpened:
-        ESP_LOGI(TAG, "Commissioning window opened");
+        APP_LOGI(TAG, "Commissioning window opened");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kCommissioningWindowClosed:
-        ESP_LOGI(TAG, "Commissioning window closed");
+        APP_LOGI(TAG, "Commissioning window closed");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kFabricRemoved:
         {
-            ESP_LOGI(TAG, "Fabric removed successfully");
+            APP_LOGI(TAG, "Fabric removed successfully");
             if (chip::Server::GetInstance().GetFabricTable().FabricCount() == 0)
             {
                 chip::CommissioningWindowManager & commissionMgr = chip::Server::GetInstance().GetCommissioningWindowManager();
@@ -99,19 +116,43 @@ static void app_event_cb(const ChipDeviceEvent *event, intptr_t arg)
         }
 
     case chip::DeviceLayer::DeviceEventType::kFabricWillBeRemoved:
-        ESP_LOGI(TAG, "Fabric will be removed");
+        APP_LOGI(TAG, "Fabric will be removed");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kFabricUpdated:
-        ESP_LOGI(TAG, "Fabric is updated");
+        APP_LOGI(TAG, "Fabric is updated");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kFabricCommitted:
-        ESP_LOGI(TAG, "Fabric is committed");
+        APP_LOGI(TAG, "Fabric is committed");
         break;
 
     case chip::DeviceLayer::DeviceEventType::kBLEDeinitialized:
-        ESP_LOGI(TAG, "BLE deinitialized and memory reclaimed");
+        APP_LOGI(TAG, "BLE deinitialized and memory reclaimed");
+        break;
+
+    case chip::DeviceLayer::DeviceEventType::kThreadStateChange:
+        if (event->ThreadStateChange.RoleChanged) {
+            app_telemetry_thread_role_changed();
+        }
+        break;
+
+    case chip::DeviceLayer::DeviceEventType::kThreadConnectivityChange:
+        if (event->ThreadConnectivityChange.Result == chip::DeviceLayer::kConnectivity_Established) {
+            app_boot_network_attached();
+            app_evlog_set_online(true);
+        } else if (event->ThreadConnectivityChange.Result == chip::DeviceLayer::kConnectivity_Lost) {
+            app_evlog_set_online(false);
+        }
+        break;
+
+    case chip::DeviceLayer::DeviceEventType::kWiFiConnectivityChange:
+        if (event->WiFiConnectivityChange.Result == chip::DeviceLayer::kConnectivity_Established) {
+            app_boot_network_attached();
+            app_evlog_set_online(true);
+        } else if (event->WiFiConnectivityChange.Result == chip::DeviceLayer::kConnectivity_Lost) {
+            app_evlog_set_online(false);
+        }
         break;
 
     default:
@@ -119,12 +160,34 @@ static void app_event_cb(const ChipDeviceEvent *event, intptr_t arg)
     }
 }
 
+/* Controllers drive level, color and on/off in bursts: every non-volatile attribute of the
+ * application endpoints is written to NVS once the burst settles rather than on each step.
+ * Endpoint 0 keeps its writes immediate, fabric and network state must survive a reset. */
+static void app_defer_persistence(node_t *node)
+{
+    uint32_t count = 0;
+    for (endpoint_t *ep = endpoint::get_first(node); ep; ep = endpoint::get_next(ep)) {
+        if (endpoint::get_id(ep) == 0) {
+            continue;
+        }
+        for (cluster_t *cl = cluster::get_first(ep); cl; cl = cluster::get_next(cl)) {
+            for (attribute_t *attr = attribute::get_first(cl); attr; attr = attribute::get_next(attr)) {
+                if ((attribute::get_flags(attr) & ATTRIBUTE_FLAG_NONVOLATILE) &&
+                    attribute::set_deferred_persistence(attr) == ESP_OK) {
+                    count++;
+                }
+            }
+        }
+    }
+    ESP_LOGI(TAG, "Deferred persistence on %" PRIu32 " attributes", count);
+}
+
 // This callback is invoked when clients interact with the Identify Cluster.
 // In the callback implementation, an endpoint can identify itself. (e.g., by flashing an LED or light).
 static esp_err_t app_identification_cb(identification::callback_type_t type, uint16_t endpoint_id, uint8_t effect_id,
                                        uint8_t effect_variant, void *priv_data)
 {
-    ESP_LOGI(TAG, "Identification callback: type: %u, effect: %u, variant: %u", type, effect_id, effect_variant);
+    APP_LOGI(TAG, "Identification callback: type: %u, effect: %u, variant: %u", type, effect_id, effect_variant);
     return ESP_OK;
 }
 
@@ -148,21 +211,69 @@ static esp_err_t app_attribute_update_cb(attribute::callback_type_t type, uint16
 extern "C" void app_main()
 {
     esp_err_t err = ESP_OK;
+    boot_trace_mark(BOOT_PHASE_STARTUP, esp_timer_get_time());
+
+    /* Latch the contact inputs before anything else: a door moving while the rest boots is
+     * queued from here and reported once Matter is up, and the endpoints start from the
+     * latched level */
+    err = app_driver_contact_init();
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to initialize contact sensors, err:%d", err));
+    boot_trace_mark(BOOT_PHASE_CONTACT_LATCH, esp_timer_get_time());
 
     /* Initialize the ESP NVS layer */
     nvs_flash_init();
+    boot_trace_mark(BOOT_PHASE_NVS, esp_timer_get_time());
+
+    /* Saved settings: without the cache they are written through to NVS */
+    err = app_persist_init();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Settings cache unavailable, err:%d", err);
+    }
+    app_driver_contact_restore_policies();
+
+    err = app_dlog_init();
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to start deferred logging, err:%d", err));
+
+    err = app_power_init();
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to initialize power management, err:%d", err));
+
+    err = app_telemetry_init();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Telemetry stream unavailable, err:%d", err);
+    }
+
+    /* The event log is best effort, the sensor keeps reporting without it */
+    err = app_evlog_init();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Contact event log unavailable, err:%d", err);
+    }
 
     /* Initialize driver */
+#if CONFIG_APP_HAS_LIGHT
     app_driver_handle_t light_handle = app_driver_light_init();
+#endif
     app_driver_handle_t button_handle = app_driver_button_init();
     app_reset_button_register(button_handle);
-    app_driver_handle_t door_button_handle = app_driver_door_init();
+#if CONFIG_APP_IMU_ENABLE
+    /* The contact sensors work without the accelerometer */
+    esp_err_t imu_err = app_imu_init();
+    if (imu_err != ESP_OK) {
+        ESP_LOGW(TAG, "Accelerometer unavailable, err:%d", imu_err);
+    }
+#endif
+    /* The reed switch keeps reporting open/closed without the Hall sensor */
+    err = app_hall_init();
+    if (err != ESP_OK && err != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGW(TAG, "Hall sensor unavailable, err:%d", err);
+    }
+    boot_trace_mark(BOOT_PHASE_DRIVERS, esp_timer_get_time());
 
     /* Create a Matter node and add the mandatory Root Node device type on endpoint 0 */
     node::config_t node_config;
     node_t *node = node::create(&node_config, app_attribute_update_cb, app_identification_cb);
     ABORT_APP_ON_FAILURE(node != nullptr, ESP_LOGE(TAG, "Failed to create Matter node"));
 
+#if CONFIG_APP_HAS_COLOR_LIGHT
     extended_color_light::config_t light_config;
     light_config.on_off.on_off = DEFAULT_POWER;
     light_config.on_off.lighting.start_up_on_off = nullptr;
@@ -175,31 +286,72 @@ extern "C" void app_main()
     ABORT_APP_ON_FAILURE(endpoint != nullptr, ESP_LOGE(TAG, "Failed to create extended color light endpoint"));
     light_endpoint_id = endpoint::get_id(endpoint);
     ESP_LOGI(TAG, "Light created with endpoint_id %d", light_endpoint_id);
-    cluster_t *level_control_cluster = cluster::get(endpoint, LevelControl::Id);
-    attribute_t *current_level_attribute = attribute::get(level_control_cluster, LevelControl::Attributes::CurrentLevel::Id);
-    attribute::set_deferred_persistence(current_level_attribute);
-    cluster_t *color_control_cluster = cluster::get(endpoint, ColorControl::Id);
-    attribute_t *current_x_attribute = attribute::get(color_control_cluster, ColorControl::Attributes::CurrentX::Id);
-    attribute::set_deferred_persistence(current_x_attribute);
-    attribute_t *current_y_attribute = attribute::get(color_control_cluster, ColorControl::Attributes::CurrentY::Id);
-    attribute::set_deferred_persistence(current_y_attribute);
-    attribute_t *color_temp_attribute = attribute::get(color_control_cluster, ColorControl::Attributes::ColorTemperatureMireds::Id);
-    attribute::set_deferred_persistence(color_temp_attribute);
-
-    // Start my clusters
-    contact_sensor::config_t door_config;
-    endpoint_t *door_endpoint = contact_sensor::create(node, &door_config, ENDPOINT_FLAG_NONE, NULL);
-    ABORT_APP_ON_FAILURE(endpoint != nullptr, ESP_LOGE(TAG, "Failed to create door sensor endpoint"));
-    door_endpoint_id = endpoint::get_id(door_endpoint);
-    ESP_LOGI(TAG, "Door sensor created with endpoint_id %d", door_endpoint_id);
-
-    contact_sensor::config_t window_config;
-    endpoint_t *window_endpoint = contact_sensor::create(node, &window_config, ENDPOINT_FLAG_NONE, NULL);
-    ABORT_APP_ON_FAILURE(endpoint != nullptr, ESP_LOGE(TAG, "Failed to create window sensor endpoint"));
-    window_endpoint_id = endpoint::get_id(window_endpoint);
-    ESP_LOGI(TAG, "Window sensor created with endpoint_id %d", window_endpoint_id);
+#elif CONFIG_APP_HAS_LIGHT
+    /* Indicator: OnOff only, nothing to persist beyond the on/off state */
+    on_off_light::config_t light_config;
+    light_config.on_off.on_off = DEFAULT_POWER;
+    light_config.on_off.lighting.start_up_on_off = nullptr;
+    endpoint_t *endpoint = on_off_light::create(node, &light_config, ENDPOINT_FLAG_NONE, light_handle);
+    ABORT_APP_ON_FAILURE(endpoint != nullptr, ESP_LOGE(TAG, "Failed to create on/off light endpoint"));
+    light_endpoint_id = endpoint::get_id(endpoint);
+    ESP_LOGI(TAG, "Indicator created with endpoint_id %d", light_endpoint_id);
+#endif
+
+    /* One contact sensor endpoint per contact channel, expander pins included */
+    for (uint16_t i = 0; i < app_driver_contact_channel_count(); i++) {
+        contact_sensor::config_t contact_config;
+        /* Start from the latched level, not the cluster default */
+        contact_config.boolean_state.state_value = app_driver_contact_get_closed(i);
+        endpoint_t *contact_endpoint = contact_sensor::create(node, &contact_config, ENDPOINT_FLAG_NONE, NULL);
+        ABORT_APP_ON_FAILURE(contact_endpoint != nullptr,
+                             ESP_LOGE(TAG, "Failed to create %s sensor endpoint", app_driver_contact_name(i)));
+        contact_endpoint_ids[i] = endpoint::get_id(contact_endpoint);
+        cluster::boolean_state::event::create_state_change(cluster::get(contact_endpoint, BooleanState::Id));
+#if CONFIG_APP_BINDING_ENABLE
+        /* Transitions go straight to the devices and groups in the Binding table */
+        cluster::binding::config_t binding_config;
+        cluster::binding::create(contact_endpoint, &binding_config, CLUSTER_FLAG_SERVER);
+        cluster::on_off::config_t on_off_config;
+        cluster::on_off::create(contact_endpoint, &on_off_config, CLUSTER_FLAG_CLIENT, ESP_MATTER_NONE_FEATURE_ID);
+#endif
+        ESP_LOGI(TAG, "Contact sensor %s created with endpoint_id %d", app_driver_contact_name(i),
+                 contact_endpoint_ids[i]);
+    }
+
+    /* Door position (closed, ajar, open, tamper) next to the door BooleanState */
+    err = app_hall_add_cluster(contact_endpoint_ids[APP_CONTACT_DOOR]);
+    if (err != ESP_OK && err != ESP_ERR_NOT_SUPPORTED && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "Door position cluster unavailable, err:%d", err);
+    }
+
+#if CONFIG_APP_IMU_ENABLE
+    /* Knock and tamper (vibration or tilt) on the door, as two more BooleanState endpoints */
+    if (imu_err == ESP_OK) {
+        uint16_t *imu_endpoint_ids[] = { &imu_knock_endpoint_id, &imu_tamper_endpoint_id };
+        static const char *const k_imu_endpoint_names[] = { "knock", "tamper" };
+        for (size_t i = 0; i < sizeof(imu_endpoint_ids) / sizeof(imu_endpoint_ids[0]); i++) {
+            contact_sensor::config_t imu_config;
+            imu_config.boolean_state.state_value = false;
+            endpoint_t *imu_endpoint = contact_sensor::create(node, &imu_config, ENDPOINT_FLAG_NONE, NULL);
+            ABORT_APP_ON_FAILURE(imu_endpoint != nullptr,
+                                 ESP_LOGE(TAG, "Failed to create %s sensor endpoint", k_imu_endpoint_names[i]));
+            *imu_endpoint_ids[i] = endpoint::get_id(imu_endpoint);
+            cluster::boolean_state::event::create_state_change(cluster::get(imu_endpoint, BooleanState::Id));
+            ESP_LOGI(TAG, "%s sensor created with endpoint_id %d", k_imu_endpoint_names[i], *imu_endpoint_ids[i]);
+        }
+    }
+#endif
+
+#if CONFIG_APP_BINDING_ENABLE
+    err = app_binding_init();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Direct binding unavailable, err:%d", err);
+    }
+#endif
 
+    app_defer_persistence(node);
 
+    boot_trace_mark(BOOT_PHASE_NODE_CREATE, esp_timer_get_time());
 
     /* Set OpenThread platform config */
     esp_openthread_platform_config_t config = {
@@ -213,16 +365,30 @@ extern "C" void app_main()
     /* Matter start */
     err = esp_matter::start(app_event_cb);
     ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to start Matter, err:%d", err));
+    boot_trace_mark(BOOT_PHASE_MATTER_START, esp_timer_get_time());
+    app_driver_contact_start_reporting();
+    app_imu_start_reporting();
+    app_hall_start_reporting();
+
+    err = app_watermark_init();
+    if (err != ESP_OK && err != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGW(TAG, "Watermark sampling unavailable, err:%d", err);
+    }
+
+    err = app_cores_init();
+    if (err != ESP_OK && err != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGW(TAG, "Core load monitor unavailable, err:%d", err);
+    }
+
+#if CONFIG_APP_HAS_LIGHT
+    err = app_driver_attribute_cache_init();
+    ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to initialize attribute cache, err:%d", err));
 
     /* Starting driver with default values */
     app_driver_light_set_defaults(light_endpoint_id);
-    if (app_driver_get_button_state(door_button_handle)){
-        app_driver_set_door_closed();
-        ESP_LOGI(TAG, "Set door initially closed");
-    } else {
-        app_driver_set_door_opened();
-        ESP_LOGI(TAG, "Set door initially open");
-    }
+#endif
+    ESP_LOGI(TAG, "Free heap after start: %" PRIu32 " bytes, minimum %" PRIu32, esp_get_free_heap_size(),
+             esp_get_minimum_free_heap_size());
 
 #if CONFIG_ENABLE_ENCRYPTED_OTA
     err = esp_matter_ota_requestor_encrypted_init(s_decryption_key, s_decryption_key_len);
@@ -231,6 +397,7 @@ extern "C" void app_main()
 
 #if CONFIG_ENABLE_CHIP_SHELL
     esp_matter::console::diagnostics_register_commands();
+    app_console_register_commands();
     esp_matter::console::wifi_register_commands();
 #if CONFIG_OPENTHREAD_CLI
     esp_matter::console::otcli_register_commands();
@@ -0,0 +1,280 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <app_priv.h>
+
+#if CONFIG_APP_DELTA_OTA
+#include "crc32.h"
+#include "delta_patch.h"
+
+/*
+ * Delta images through the unmodified OTA requestor: the linker wraps the esp_ota_* calls
+ * of the Matter OTA image processor (main/CMakeLists.txt). What it writes to the update
+ * partition is the downloaded image, already decrypted with CONFIG_ENABLE_ENCRYPTED_OTA.
+ * A full image starts with the 0xE9 app image magic and goes through untouched; a delta
+ * patch is rebuilt on the fly from the running partition, and the update partition only
+ * ever sees the rebuilt image, which esp_ota_end() verifies as usual.
+ *
+ * All calls come from the Matter thread.
+ */
+
+static const char *TAG = "app_ota";
+
+#define APP_DELTA_OTA_WINDOW_SIZE (1u << CONFIG_APP_DELTA_OTA_WINDOW_BITS)
+#define APP_DELTA_OTA_CACHE_SIZE 256
+#define APP_DELTA_OTA_OUT_SIZE 1024
+
+extern "C" {
+esp_err_t __real_esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle);
+esp_err_t __real_esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size);
+esp_err_t __real_esp_ota_end(esp_ota_handle_t handle);
+esp_err_t __real_esp_ota_abort(esp_ota_handle_t handle);
+
+esp_err_t __wrap_esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle);
+esp_err_t __wrap_esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size);
+esp_err_t __wrap_esp_ota_end(esp_ota_handle_t handle);
+esp_err_t __wrap_esp_ota_abort(esp_ota_handle_t handle);
+}
+
+typedef enum {
+    APP_OTA_IDLE,
+    APP_OTA_SNIFF, /* waiting for the first bytes of the image */
+    APP_OTA_FULL,
+    APP_OTA_DELTA,
+    APP_OTA_FAILED,
+} app_ota_mode_t;
+
+static app_ota_mode_t s_ota_mode = APP_OTA_IDLE;
+static esp_ota_handle_t s_ota_handle = 0;
+static uint8_t s_ota_header[DELTA_PATCH_HEADER_SIZE];
+static size_t s_ota_header_len = 0;
+static const esp_partition_t *s_ota_source = NULL;
+/* Window, source cache and output buffer, only allocated while a patch is applied */
+static uint8_t *s_ota_buffers = NULL;
+static delta_patch_t s_ota_patch;
+static app_ota_stats_t s_ota_stats;
+
+static int app_ota_read_source(void *ctx, uint32_t offset, uint8_t *dst, size_t len)
+{
+    return esp_partition_read(s_ota_source, offset, dst, len) == ESP_OK ? 0 : -1;
+}
+
+static int app_ota_write_target(void *ctx, const uint8_t *src, size_t len)
+{
+    return __real_esp_ota_write(s_ota_handle, src, len) == ESP_OK ? 0 : -1;
+}
+
+static void app_ota_release()
+{
+    free(s_ota_buffers);
+    s_ota_buffers = NULL;
+    s_ota_mode = APP_OTA_IDLE;
+}
+
+static esp_err_t app_ota_fail(int err)
+{
+    s_ota_mode = APP_OTA_FAILED;
+    s_ota_stats.failures++;
+    s_ota_stats.last_error = err;
+    return ESP_ERR_OTA_VALIDATE_FAILED;
+}
+
+/* The header is in: check the patch applies to the running image and set the applier up */
+static esp_err_t app_ota_delta_start()
+{
+    delta_patch_header_t header;
+    if (delta_patch_header_parse(s_ota_header, &header) != DELTA_PATCH_OK) {
+        ESP_LOGE(TAG, "Invalid delta image header");
+        return app_ota_fail(DELTA_PATCH_ERR_FORMAT);
+    }
+    if (header.window_bits > CONFIG_APP_DELTA_OTA_WINDOW_BITS) {
+        ESP_LOGE(TAG, "Delta image needs a %u byte window, %u available", 1u << header.window_bits,
+                 APP_DELTA_OTA_WINDOW_SIZE);
+        return app_ota_fail(DELTA_PATCH_ERR_WINDOW);
+    }
+    s_ota_source = esp_ota_get_running_partition();
+    if (!s_ota_source || header.source_size > s_ota_source->size) {
+        return app_ota_fail(DELTA_PATCH_ERR_FORMAT);
+    }
+    s_ota_buffers = (uint8_t *)malloc(APP_DELTA_OTA_WINDOW_SIZE + APP_DELTA_OTA_CACHE_SIZE + APP_DELTA_OTA_OUT_SIZE);
+    if (!s_ota_buffers) {
+        return app_ota_fail(DELTA_PATCH_ERR_IO);
+    }
+
+    /* One pass over the running image, the window doubles as the read buffer */
+    uint32_t crc = 0;
+    for (uint32_t offset = 0; offset < header.source_size; offset += APP_DELTA_OTA_WINDOW_SIZE) {
+        uint32_t len = header.source_size - offset;
+        if (len > APP_DELTA_OTA_WINDOW_SIZE) {
+            len = APP_DELTA_OTA_WINDOW_SIZE;
+        }
+        if (esp_partition_read(s_ota_source, offset, s_ota_buffers, len) != ESP_OK) {
+            return app_ota_fail(DELTA_PATCH_ERR_IO);
+        }
+        crc = crc32_update(crc, s_ota_buffers, len);
+    }
+    if (crc != header.source_crc) {
+        ESP_LOGE(TAG, "Delta image made for another firmware (source CRC %08" PRIx32 ", running %08" PRIx32 ")",
+                 header.source_crc, crc);
+        return app_ota_fail(DELTA_PATCH_ERR_FORMAT);
+    }
+
+    delta_patch_io_t io = {
+        .read_source = app_ota_read_source,
+        .write_target = app_ota_write_target,
+        .ctx = NULL,
+    };
+    delta_patch_buffers_t buffers = {
+        .window = s_ota_buffers,
+        .window_bits = CONFIG_APP_DELTA_OTA_WINDOW_BITS,
+        .source_cache = s_ota_buffers + APP_DELTA_OTA_WINDOW_SIZE,
+        .source_cache_size = APP_DELTA_OTA_CACHE_SIZE,
+        .out = s_ota_buffers + APP_DELTA_OTA_WINDOW_SIZE + APP_DELTA_OTA_CACHE_SIZE,
+        .out_size = APP_DELTA_OTA_OUT_SIZE,
+    };
+    int err = delta_patch_init(&s_ota_patch, &header, &io, &buffers);
+    if (err != DELTA_PATCH_OK) {
+        return app_ota_fail(err);
+    }
+    s_ota_mode = APP_OTA_DELTA;
+    s_ota_stats.patch_bytes = DELTA_PATCH_HEADER_SIZE;
+    s_ota_stats.image_bytes = 0;
+    s_ota_stats.apply_us = 0;
+    ESP_LOGI(TAG, "Delta image: %" PRIu32 " byte patch body rebuilds %" PRIu32 " bytes from %s", header.body_size,
+             header.target_size, s_ota_source->label);
+    return ESP_OK;
+}
+
+static esp_err_t app_ota_delta_feed(const uint8_t *data, size_t size)
+{
+    int64_t start = esp_timer_get_time();
+    int err = delta_patch_feed(&s_ota_patch, data, size);
+    s_ota_stats.apply_us += (uint32_t)(esp_timer_get_time() - start);
+    s_ota_stats.patch_bytes += size;
+    s_ota_stats.image_bytes = s_ota_patch.written;
+    if (err != DELTA_PATCH_OK) {
+        ESP_LOGE(TAG, "Delta image failed at patch byte %" PRIu32 ", err:%d", s_ota_stats.patch_bytes, err);
+        return app_ota_fail(err);
+    }
+    return ESP_OK;
+}
+
+esp_err_t __wrap_esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle)
+{
+    esp_err_t err = __real_esp_ota_begin(partition, image_size, out_handle);
+    if (err == ESP_OK) {
+        app_ota_release();
+        s_ota_handle = *out_handle;
+        s_ota_mode = APP_OTA_SNIFF;
+        s_ota_header_len = 0;
+    }
+    return err;
+}
+
+esp_err_t __wrap_esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
+{
+    if (handle != s_ota_handle || s_ota_mode == APP_OTA_IDLE || s_ota_mode == APP_OTA_FULL) {
+        return __real_esp_ota_write(handle, data, size);
+    }
+    const uint8_t *bytes = (const uint8_t *)data;
+    switch (s_ota_mode) {
+    case APP_OTA_SNIFF: {
+        size_t take = sizeof(s_ota_header) - s_ota_header_len;
+        if (take > size) {
+            take = size;
+        }
+        memcpy(s_ota_header + s_ota_header_len, bytes, take);
+        s_ota_header_len += take;
+        if (s_ota_header_len < 4) {
+            return ESP_OK;
+        }
+        if (!delta_patch_is_patch(s_ota_header, s_ota_header_len)) {
+            s_ota_mode = APP_OTA_FULL;
+            s_ota_stats.full_images++;
+            /* Hand over what was held back, then the rest of this block */
+            size_t held = s_ota_header_len - take;
+            esp_err_t err = held ? __real_esp_ota_write(handle, s_ota_header, held) : ESP_OK;
+            return err == ESP_OK ? __real_esp_ota_write(handle, data, size) : err;
+        }
+        if (s_ota_header_len < sizeof(s_ota_header)) {
+            return ESP_OK;
+        }
+        esp_err_t err = app_ota_delta_start();
+        if (err != ESP_OK || take == size) {
+            return err;
+        }
+        return app_ota_delta_feed(bytes + take, size - take);
+    }
+    case APP_OTA_DELTA:
+        return app_ota_delta_feed(bytes, size);
+    default:
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+}
+
+esp_err_t __wrap_esp_ota_end(esp_ota_handle_t handle)
+{
+    if (handle != s_ota_handle) {
+        return __real_esp_ota_end(handle);
+    }
+    app_ota_mode_t mode = s_ota_mode;
+    if (mode == APP_OTA_SNIFF && s_ota_header_len > 0) {
+        /* Shorter than a patch header: not a patch, let the image checks reject it */
+        __real_esp_ota_write(handle, s_ota_header, s_ota_header_len);
+    } else if (mode == APP_OTA_DELTA) {
+        int err = delta_patch_finish(&s_ota_patch);
+        s_ota_stats.image_bytes = s_ota_patch.written;
+        if (err != DELTA_PATCH_OK) {
+            ESP_LOGE(TAG, "Delta image did not rebuild the target image, err:%d", err);
+            app_ota_fail(err);
+            mode = APP_OTA_FAILED;
+        } else {
+            s_ota_stats.delta_images++;
+            s_ota_stats.last_error = DELTA_PATCH_OK;
+            ESP_LOGI(TAG, "Delta image rebuilt: %" PRIu32 " bytes from %" PRIu32 " patch bytes, %" PRIu32
+                     " ms applying", s_ota_stats.image_bytes, s_ota_stats.patch_bytes, s_ota_stats.apply_us / 1000);
+        }
+    }
+    app_ota_release();
+    s_ota_handle = 0;
+    if (mode == APP_OTA_FAILED) {
+        __real_esp_ota_abort(handle);
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    return __real_esp_ota_end(handle);
+}
+
+esp_err_t __wrap_esp_ota_abort(esp_ota_handle_t handle)
+{
+    if (handle == s_ota_handle) {
+        app_ota_release();
+        s_ota_handle = 0;
+    }
+    return __real_esp_ota_abort(handle);
+}
+
+void app_ota_get_stats(app_ota_stats_t *stats)
+{
+    *stats = s_ota_stats;
+    stats->in_progress = s_ota_mode == APP_OTA_DELTA;
+    stats->ram_bytes = APP_DELTA_OTA_WINDOW_SIZE + APP_DELTA_OTA_CACHE_SIZE + APP_DELTA_OTA_OUT_SIZE;
+}
+#else
+void app_ota_get_stats(app_ota_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+#endif // CONFIG_APP_DELTA_OTA
@@ -0,0 +1,255 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <nvs.h>
+#include <string.h>
+
+#include <mutex>
+
+#include <app_priv.h>
+#include <platform/CHIPDeviceLayer.h>
+
+#include "persist_cache.h"
+
+static const char *TAG = "app_persist";
+
+/* Retry delay when the flush work was lost to a full Matter work queue */
+#define APP_PERSIST_RETRY_MS 100
+
+/* The cache and the NVS handle of the namespace being flushed */
+static std::mutex s_persist_lock;
+static persist_entry_t s_persist_entries[CONFIG_APP_PERSIST_CACHE_ENTRIES];
+static persist_cache_t s_persist;
+static bool s_persist_ready = false;
+static nvs_handle_t s_nvs = 0;
+static char s_nvs_ns[PERSIST_NAME_MAX];
+static int64_t s_start_us = 0;
+static int64_t s_flush_us = 0; /* time spent in flushes */
+
+static esp_timer_handle_t s_persist_timer = NULL;
+
+static int app_persist_nvs_write(void *ctx, const char *ns, const char *key, const void *data, size_t len)
+{
+    if (s_nvs_ns[0] == '\0' || strcmp(s_nvs_ns, ns) != 0) {
+        if (s_nvs_ns[0] != '\0') {
+            nvs_close(s_nvs);
+            s_nvs_ns[0] = '\0';
+        }
+        esp_err_t err = nvs_open(ns, NVS_READWRITE, &s_nvs);
+        if (err != ESP_OK) {
+            APP_LOGW(TAG, "Failed to open NVS namespace, err:%d", err);
+            return -1;
+        }
+        strcpy(s_nvs_ns, ns);
+    }
+    esp_err_t err = nvs_set_blob(s_nvs, key, data, len);
+    if (err != ESP_OK) {
+        APP_LOGW(TAG, "Failed to write NVS, err:%d", err);
+        return -1;
+    }
+    return 0;
+}
+
+static int app_persist_nvs_commit(void *ctx, const char *ns)
+{
+    if (s_nvs_ns[0] == '\0') {
+        return -1;
+    }
+    esp_err_t err = nvs_commit(s_nvs);
+    nvs_close(s_nvs);
+    s_nvs_ns[0] = '\0';
+    return err == ESP_OK ? 0 : -1;
+}
+
+/* Lock held */
+static void app_persist_arm()
+{
+    int64_t deadline = persist_cache_deadline(&s_persist);
+    if (!s_persist_timer || deadline == INT64_MAX || esp_timer_is_active(s_persist_timer)) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    esp_timer_start_once(s_persist_timer, deadline > now ? deadline - now : 0);
+}
+
+/* Lock held */
+static int app_persist_flush_locked()
+{
+    int64_t start = esp_timer_get_time();
+    int errors = persist_cache_flush(&s_persist, start);
+    s_flush_us += esp_timer_get_time() - start;
+    return errors;
+}
+
+/* NVS writes go on the Matter thread, like the ones of esp_matter, not on the esp_timer task
+ * where they would delay the debounce timers */
+static void app_persist_flush_work(intptr_t arg)
+{
+    std::lock_guard<std::mutex> lock(s_persist_lock);
+    esp_timer_stop(s_persist_timer);
+    if (persist_cache_deadline(&s_persist) <= esp_timer_get_time()) {
+        app_persist_flush_locked();
+    }
+    app_persist_arm();
+}
+
+static void app_persist_timer_cb(void *arg)
+{
+    /* Fires again if the work is lost to a full queue, the flush stops it */
+    esp_timer_start_once(s_persist_timer, APP_PERSIST_RETRY_MS * 1000);
+    chip::DeviceLayer::PlatformMgr().ScheduleWork(app_persist_flush_work, 0);
+}
+
+/* esp_restart(): OTA reboot, console reboot */
+static void app_persist_shutdown()
+{
+    std::lock_guard<std::mutex> lock(s_persist_lock);
+    app_persist_flush_locked();
+}
+
+esp_err_t app_persist_init()
+{
+    std::lock_guard<std::mutex> lock(s_persist_lock);
+    if (s_persist_ready) {
+        return ESP_OK;
+    }
+    persist_backend_t backend = { NULL, app_persist_nvs_write, app_persist_nvs_commit };
+    persist_cache_init(&s_persist, &backend, s_persist_entries, CONFIG_APP_PERSIST_CACHE_ENTRIES,
+                       CONFIG_APP_PERSIST_DELAY_MS);
+    esp_timer_create_args_t timer_args = {
+        .callback = app_persist_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "persist",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &s_persist_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = esp_register_shutdown_handler(app_persist_shutdown);
+    if (err != ESP_OK) {
+        /* Values set in the last delay before a restart are lost */
+        ESP_LOGW(TAG, "Failed to register the shutdown flush, err:%d", err);
+    }
+    s_start_us = esp_timer_get_time();
+    s_persist_ready = true;
+    ESP_LOGI(TAG, "%d cache entries, flush after %d ms", CONFIG_APP_PERSIST_CACHE_ENTRIES,
+             CONFIG_APP_PERSIST_DELAY_MS);
+    return ESP_OK;
+}
+
+esp_err_t app_persist_set(const char *ns, const char *key, const void *data, size_t len)
+{
+    std::lock_guard<std::mutex> lock(s_persist_lock);
+    if (!s_persist_ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int result = persist_cache_set(&s_persist, ns, key, data, len, esp_timer_get_time());
+    if (result == -1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    app_persist_arm();
+    return result == 0 ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t app_persist_get(const char *ns, const char *key, void *data, size_t len)
+{
+    std::lock_guard<std::mutex> lock(s_persist_lock);
+    if (!s_persist_ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    size_t cached = len;
+    if (persist_cache_get(&s_persist, ns, key, data, &cached)) {
+        return cached == len ? ESP_OK : ESP_ERR_INVALID_SIZE;
+    }
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(ns, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        /* No namespace yet: nothing was ever saved in it */
+        return ESP_ERR_NOT_FOUND;
+    }
+    size_t stored = len;
+    err = nvs_get_blob(handle, key, data, &stored);
+    nvs_close(handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (err != ESP_OK || stored != len) {
+        /* Saved by another firmware with another layout */
+        return err == ESP_OK || err == ESP_ERR_NVS_INVALID_LENGTH ? ESP_ERR_INVALID_SIZE : err;
+    }
+    persist_cache_preload(&s_persist, ns, key, data, len);
+    return ESP_OK;
+}
+
+esp_err_t app_persist_flush()
+{
+    std::lock_guard<std::mutex> lock(s_persist_lock);
+    if (!s_persist_ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_persist_timer) {
+        esp_timer_stop(s_persist_timer);
+    }
+    return app_persist_flush_locked() == 0 ? ESP_OK : ESP_FAIL;
+}
+
+void app_persist_set_delay(uint32_t delay_ms)
+{
+    std::lock_guard<std::mutex> lock(s_persist_lock);
+    if (!s_persist_ready) {
+        return;
+    }
+    persist_cache_set_delay(&s_persist, delay_ms);
+    if (delay_ms == 0) {
+        app_persist_flush_locked();
+    }
+    if (s_persist_timer) {
+        esp_timer_stop(s_persist_timer);
+    }
+    app_persist_arm();
+}
+
+void app_persist_get_stats(app_persist_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    std::lock_guard<std::mutex> lock(s_persist_lock);
+    if (!s_persist_ready) {
+        return;
+    }
+    const persist_stats_t *ps = &s_persist.stats;
+    stats->delay_ms = s_persist.max_delay_ms;
+    stats->cached = s_persist.count;
+    stats->capacity = s_persist.capacity;
+    stats->dirty = s_persist.dirty;
+    stats->sets = ps->sets;
+    stats->unchanged = ps->unchanged;
+    stats->coalesced = ps->coalesced;
+    stats->flushes = ps->flushes;
+    stats->early_flushes = ps->early;
+    stats->writes = ps->writes;
+    stats->commits = ps->commits;
+    stats->errors = ps->errors;
+    stats->max_batch = ps->max_batch;
+    stats->nvs_entries = ps->nvs_entries;
+    stats->flush_ms = (uint32_t)(s_flush_us / 1000);
+    stats->uptime_s = (uint32_t)((esp_timer_get_time() - s_start_us) / 1000000);
+
+    nvs_stats_t nvs_stats;
+    if (nvs_get_stats(NULL, &nvs_stats) == ESP_OK) {
+        stats->nvs_used_entries = nvs_stats.used_entries;
+        stats->nvs_total_entries = nvs_stats.total_entries;
+        /* The entry count of the default partition gives its page count */
+        uint32_t partition_bytes = nvs_stats.total_entries / PERSIST_NVS_PAGE_ENTRIES * PERSIST_NVS_PAGE_BYTES;
+        stats->projected_days = persist_projected_days(ps->nvs_entries, stats->uptime_s, partition_bytes);
+    }
+}
@@ -0,0 +1,130 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+#include <freertos/FreeRTOS.h>
+
+#include <app_priv.h>
+#include "power_account.h"
+
+static const char *TAG = "app_power";
+
+static power_account_t s_power_account;
+static portMUX_TYPE s_power_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+/* Both run from the idle task right around light sleep, keep them in IRAM */
+static IRAM_ATTR esp_err_t app_power_sleep_enter_cb(int64_t sleep_time_us, void *arg)
+{
+    return ESP_OK;
+}
+
+static IRAM_ATTR esp_err_t app_power_sleep_exit_cb(int64_t sleep_time_us, void *arg)
+{
+    portENTER_CRITICAL_SAFE(&s_power_lock);
+    power_account_add(&s_power_account, esp_timer_get_time(), POWER_STATE_LIGHT_SLEEP, sleep_time_us);
+    portEXIT_CRITICAL_SAFE(&s_power_lock);
+    return ESP_OK;
+}
+#endif
+
+#if CONFIG_APP_POWER_REPORT_INTERVAL_SEC > 0
+static void app_power_report_cb(void *arg)
+{
+    app_power_stats_t stats;
+    app_power_get_stats(&stats);
+    ESP_LOGI(TAG, "Active %lld ms, light sleep %lld ms (%" PRIu32 " wakeups), sleep duty %" PRIu32 ".%" PRIu32 "%%",
+             stats.active_us / 1000, stats.light_sleep_us / 1000, stats.wakeups,
+             stats.sleep_permille / 10, stats.sleep_permille % 10);
+}
+#endif
+
+esp_err_t app_power_init()
+{
+    power_account_init(&s_power_account, esp_timer_get_time(), POWER_STATE_ACTIVE);
+
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_XTAL_FREQ,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#endif
+    };
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure power management, err:%d", err);
+        return err;
+    }
+#endif
+
+#if CONFIG_APP_SLEEPY_END_DEVICE
+    /* Contact inputs arm level wakeups, see app_contact.cpp */
+    esp_err_t wake_err = esp_sleep_enable_gpio_wakeup();
+    if (wake_err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to enable GPIO wakeup, err:%d", wake_err);
+        return wake_err;
+    }
+#endif
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    esp_pm_sleep_cbs_register_config_t cbs_config = {
+        .enter_cb = app_power_sleep_enter_cb,
+        .exit_cb = app_power_sleep_exit_cb,
+        .enter_cb_user_arg = NULL,
+        .exit_cb_user_arg = NULL,
+        .enter_cb_prior = 0,
+        .exit_cb_prior = 0,
+    };
+    esp_err_t cb_err = esp_pm_light_sleep_register_cbs(&cbs_config);
+    if (cb_err != ESP_OK) {
+        ESP_LOGW(TAG, "Light sleep accounting unavailable, err:%d", cb_err);
+    }
+#endif
+
+#if CONFIG_APP_POWER_REPORT_INTERVAL_SEC > 0
+    esp_timer_create_args_t timer_args = {
+        .callback = app_power_report_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "power_report",
+        .skip_unhandled_events = true,
+    };
+    esp_timer_handle_t timer;
+    if (esp_timer_create(&timer_args, &timer) == ESP_OK) {
+        esp_timer_start_periodic(timer, (uint64_t)CONFIG_APP_POWER_REPORT_INTERVAL_SEC * 1000000);
+    }
+#endif
+
+#if CONFIG_PM_ENABLE && CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    ESP_LOGI(TAG, "Automatic light sleep enabled");
+#else
+    ESP_LOGI(TAG, "Automatic light sleep disabled");
+#endif
+    return ESP_OK;
+}
+
+void app_power_get_stats(app_power_stats_t *stats)
+{
+    int64_t time_us[POWER_STATE_MAX];
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_power_lock);
+    power_account_snapshot(&s_power_account, now, time_us);
+    stats->wakeups = s_power_account.entries[POWER_STATE_LIGHT_SLEEP];
+    stats->sleep_permille = power_account_permille(&s_power_account, now, POWER_STATE_LIGHT_SLEEP);
+    portEXIT_CRITICAL(&s_power_lock);
+
+    stats->active_us = time_us[POWER_STATE_ACTIVE];
+    stats->light_sleep_us = time_us[POWER_STATE_LIGHT_SLEEP];
+}
@@ -17,6 +17,26 @@
 #include "esp_openthread_types.h"
 #endif
 
+/** Application log macros, same shape as ESP_LOGx
+ *
+ * With CONFIG_APP_DEFERRED_LOG they only queue the format ID and the raw arguments, see
+ * dlog.h: `%s` arguments must point to literals or static strings.
+ */
+#if CONFIG_APP_DEFERRED_LOG
+#define DLOG_MAX_LEVEL CONFIG_LOG_MAXIMUM_LEVEL
+#include "dlog.h"
+#define APP_LOGE(tag, format, ...) DLOGE(tag, format, ##__VA_ARGS__)
+#define APP_LOGW(tag, format, ...) DLOGW(tag, format, ##__VA_ARGS__)
+#define APP_LOGI(tag, format, ...) DLOGI(tag, format, ##__VA_ARGS__)
+#define APP_LOGD(tag, format, ...) DLOGD(tag, format, ##__VA_ARGS__)
+#else
+#include <esp_log.h>
+#define APP_LOGE(tag, format, ...) ESP_LOGE(tag, format, ##__VA_ARGS__)
+#define APP_LOGW(tag, format, ...) ESP_LOGW(tag, format, ##__VA_ARGS__)
+#define APP_LOGI(tag, format, ...) ESP_LOGI(tag, format, ##__VA_ARGS__)
+#define APP_LOGD(tag, format, ...) ESP_LOGD(tag, format, ##__VA_ARGS__)
+#endif
+
 /** Standard max values (used for remapping attributes) */
 #define STANDARD_BRIGHTNESS 255
 #define STANDARD_HUE 360
@@ -39,18 +59,46 @@
 #define DOOR_GPIO_PIN 2
 #define WINDOW_GPIO_PIN 3
 
-const button_config_t door_btn_cfg = {
-    .type = BUTTON_TYPE_GPIO,
-    .long_press_time = 1000,
-    .short_press_time = 100,
-    .gpio_button_config = {
-        .gpio_num = DOOR_GPIO_PIN,
-        .active_level = 0,
-    },
+typedef void *app_driver_handle_t;
+
+/** Contact input configuration */
+typedef struct {
+    const char *name;
+    gpio_num_t gpio_num;
+    uint8_t active_level; /* level read while the contact is closed */
+} app_contact_config_t;
+
+/** Contact sensor channels
+ *
+ * One row per contact input. Each row gets its own contact_sensor endpoint, created in
+ * table order, and the row index is the channel number used by the `app_driver_contact_*` APIs.
+ */
+static constexpr app_contact_config_t k_contact_channels[] = {
+    { .name = "door", .gpio_num = (gpio_num_t)DOOR_GPIO_PIN, .active_level = 0 },
+    { .name = "window", .gpio_num = (gpio_num_t)WINDOW_GPIO_PIN, .active_level = 0 },
+#ifdef APP_CONTACT_EXTRA_CHANNELS
+    /* Extra rows from the build, e.g. the synthetic sensor fleet of the host benchmark */
+    APP_CONTACT_EXTRA_CHANNELS
+#endif
 };
+#define APP_CONTACT_CHANNEL_COUNT (sizeof(k_contact_channels) / sizeof(k_contact_channels[0]))
+#define APP_CONTACT_DOOR 0
 
-typedef void *app_driver_handle_t;
+/* Expander pins found at boot follow the table rows, up to 16 channels per expander */
+#if CONFIG_APP_EXPANDER_ENABLE
+#define APP_EXPANDER_MAX_CHANNELS (CONFIG_APP_EXPANDER_COUNT * 16)
+#else
+#define APP_EXPANDER_MAX_CHANNELS 0
+#endif
+#define APP_CONTACT_MAX_CHANNEL_COUNT (APP_CONTACT_CHANNEL_COUNT + APP_EXPANDER_MAX_CHANNELS)
 
+/** Contact report callback, called from the esp_timer task when a new stable level is confirmed
+ *
+ * `edge_us` is the esp_timer timestamp of the interrupt that started the change.
+ */
+typedef void (*app_contact_cb_t)(void *arg, bool closed, int64_t edge_us);
+
+#if CONFIG_APP_HAS_LIGHT
 /** Initialize the light driver
  *
  * This initializes the light driver associated with the selected board.
@@ -59,6 +107,7 @@ typedef void *app_driver_handle_t;
  * @return NULL in case of failure.
  */
 app_driver_handle_t app_driver_light_init();
+#endif
 
 /** Initialize the button driver
  *
@@ -69,11 +118,864 @@ app_driver_handle_t app_driver_light_init();
  */
 app_driver_handle_t app_driver_button_init();
 
-app_driver_handle_t app_driver_door_init();
-bool app_driver_get_button_state(app_driver_handle_t handle);
+/** Create a contact input
+ *
+ * Configures the GPIO for edge interrupts and debounces it with an esp_timer, so the
+ * input costs nothing while the contact is quiet.
+ *
+ * @param[in] config Contact input configuration.
+ * @param[in] cb Callback invoked with every debounced change.
+ * @param[in] cb_arg Argument passed to the callback.
+ *
+ * @return Handle on success.
+ * @return NULL in case of failure.
+ */
+app_driver_handle_t app_contact_create(const app_contact_config_t *config, app_contact_cb_t cb, void *cb_arg);
+
+/** Get the last debounced state of a contact input
+ *
+ * @param[in] handle Handle returned by `app_contact_create()`.
+ *
+ * @return true if the contact is closed.
+ */
+bool app_contact_get_closed(app_driver_handle_t handle);
+
+/** Initialize the contact sensor channels
+ *
+ * Creates a contact input for every row of `k_contact_channels`, then one per pin of the
+ * GPIO expanders that answer on the I2C bus, all reporting through one shared handler.
+ * The input levels are latched and edges queued from this call on, so it comes first in
+ * app_main; nothing is reported before `app_driver_contact_start_reporting()`.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_driver_contact_init();
+
+/** Get the number of contact channels
+ *
+ * The rows of `k_contact_channels`, then the pins of the expanders found by
+ * `app_driver_contact_init()`.
+ *
+ * @return Channel count, at most APP_CONTACT_MAX_CHANNEL_COUNT.
+ */
+uint16_t app_driver_contact_channel_count();
+
+/** Get the name of a contact channel
+ *
+ * @param[in] channel Channel number.
+ *
+ * @return Static string.
+ */
+const char *app_driver_contact_name(uint16_t channel);
+
+/** Get the debounced state of a contact channel
+ *
+ * @param[in] channel Channel number.
+ *
+ * @return true if the contact is closed.
+ */
+bool app_driver_contact_get_closed(uint16_t channel);
+
+/** Report a contact channel state
+ *
+ * Updates the BooleanState StateValue attribute of the channel endpoint.
+ *
+ * @param[in] channel Channel number.
+ * @param[in] closed true if the contact is closed.
+ */
+void app_driver_contact_set_state(uint16_t channel, bool closed);
+
+/** Start reporting contact changes
+ *
+ * Schedules the first report on the Matter thread: the current state of every channel, plus
+ * one event log entry per channel that changed since `app_driver_contact_init()`. Future
+ * transitions go through to the Matter thread from then on. Must be called after
+ * `esp_matter::start()`.
+ */
+void app_driver_contact_start_reporting();
+
+/** Contact event queue counters */
+typedef struct {
+    uint32_t pushed;     /* transitions queued */
+    uint32_t dropped;    /* transitions lost because the queue was full */
+    uint32_t high_water; /* deepest the queue has been */
+    uint32_t depth;      /* current depth */
+    uint32_t batches;    /* drains on the Matter thread */
+    uint32_t coalesced;  /* transitions merged into another report of the same channel */
+    uint32_t retries;    /* drains lost to a full Matter work queue and scheduled again */
+} app_contact_queue_stats_t;
+
+/** Get the contact event queue counters
+ *
+ * @param[out] stats Counters.
+ */
+void app_driver_contact_get_queue_stats(app_contact_queue_stats_t *stats);
+
+/** Report policy of a contact channel and its counters
+ *
+ * Transitions reach the data model at most every `min_interval_ms`, once the level held for
+ * `holdoff_ms`, and at most `max_reports` times per `window_sec`; the latest level is
+ * reported with a summary when a capped window ends. 0 disables a limit.
+ */
+typedef struct {
+    uint32_t min_interval_ms;
+    uint32_t holdoff_ms;
+    uint16_t max_reports;
+    uint32_t window_sec;
+    /* Counters, ignored by app_driver_contact_set_policy() */
+    uint32_t transitions; /* debounced transitions seen */
+    uint32_t reports;     /* level changes written to the data model */
+    uint32_t suppressed;  /* transitions not reported on their own */
+    uint32_t summaries;   /* capped windows closed with a summary */
+    bool held;            /* a level or a summary is waiting for the policy */
+} app_contact_policy_t;
+
+/** Get the report policy of a contact channel
+ *
+ * Matter thread (or chip stack lock held).
+ *
+ * @param[in] channel Channel number.
+ * @param[out] policy Policy and counters.
+ */
+void app_driver_contact_get_policy(uint16_t channel, app_contact_policy_t *policy);
+
+/** Set the report policy of a contact channel
+ *
+ * A level held back by the old policy is reported if the new one lets it through. The
+ * policy is saved, see `app_driver_contact_restore_policies()`.
+ * Matter thread (or chip stack lock held).
+ *
+ * @param[in] channel Channel number.
+ * @param[in] policy Policy, the counters are ignored.
+ */
+void app_driver_contact_set_policy(uint16_t channel, const app_contact_policy_t *policy);
+
+/** Apply the report policies saved by `app_driver_contact_set_policy()`
+ *
+ * Channels without a saved policy keep the Kconfig defaults. Call after
+ * `app_persist_init()` and before `app_driver_contact_start_reporting()`.
+ */
+void app_driver_contact_restore_policies();
+
+/** OnOff command sent to the bound devices on a contact transition */
+typedef enum {
+    APP_BINDING_ACTION_NONE = 0,
+    APP_BINDING_ACTION_ON,
+    APP_BINDING_ACTION_OFF,
+    APP_BINDING_ACTION_TOGGLE,
+    APP_BINDING_ACTION_MAX,
+} app_binding_action_t;
+
+/** Binding counters */
+typedef struct {
+    uint32_t transitions; /* reported transitions mapped to a command */
+    uint32_t unicast;     /* commands sent to bound devices */
+    uint32_t group;       /* commands multicast to bound groups */
+    uint32_t responses;   /* unicast commands the device accepted */
+    uint32_t errors;      /* unicast commands failed, rejected or not answered */
+} app_binding_stats_t;
+
+/** Initialize direct binding
+ *
+ * Registers the OnOff client request handlers with esp_matter: the Binding cluster of a
+ * contact endpoint lists the devices (unicast) and groups (multicast) its transitions are
+ * sent to. Restores the saved actions. Must be called after `app_persist_init()` and before
+ * `esp_matter::start()`.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_SUPPORTED if CONFIG_APP_BINDING_ENABLE is off.
+ */
+esp_err_t app_binding_init();
+
+/** Send the OnOff command mapped to a reported contact transition to the bound devices
+ *
+ * Matter thread (or chip stack lock held).
+ *
+ * @param[in] channel Channel number.
+ * @param[in] closed Reported state.
+ * @param[in] edge_us Timestamp of the edge behind the transition, 0 to leave it out of the
+ *            latency spans.
+ */
+void app_binding_contact_changed(uint16_t channel, bool closed, int64_t edge_us);
+
+/** Get the actions of a contact channel
+ *
+ * @param[in] channel Channel number.
+ * @param[out] on_open Command sent when the contact opens.
+ * @param[out] on_close Command sent when the contact closes.
+ */
+void app_binding_get_actions(uint16_t channel, app_binding_action_t *on_open, app_binding_action_t *on_close);
+
+/** Set the actions of a contact channel
+ *
+ * Saved, `app_binding_init()` restores them. Matter thread (or chip stack lock held).
+ *
+ * @param[in] channel Channel number.
+ * @param[in] on_open Command sent when the contact opens.
+ * @param[in] on_close Command sent when the contact closes.
+ */
+void app_binding_set_actions(uint16_t channel, app_binding_action_t on_open, app_binding_action_t on_close);
+
+/** Name of an action: "none", "on", "off" or "toggle" */
+const char *app_binding_action_name(app_binding_action_t action);
+
+/** Get the binding counters
+ *
+ * @param[out] stats Counters.
+ */
+void app_binding_get_stats(app_binding_stats_t *stats);
+
+/** Feed a transition to the contact path as if a debounce timer had confirmed it
+ *
+ * The transition is queued, drained, goes through the report policy and the bindings and
+ * reaches the data model like a real one. The contact queue has a single producer: call
+ * from the esp_timer task only, where the debounce and expander report callbacks run.
+ *
+ * @param[in] channel Channel number.
+ * @param[in] closed New level.
+ * @param[in] edge_us Time of the edge, for the latency spans.
+ */
+void app_driver_contact_inject(uint16_t channel, bool closed, int64_t edge_us);
+
+/** Door transition through `app_driver_contact_inject()`, timestamped now. esp_timer task only. */
 void app_driver_set_door_opened();
 void app_driver_set_door_closed();
 
+/** Power state counters */
+typedef struct {
+    int64_t active_us;       /* time awake since boot */
+    int64_t light_sleep_us;  /* time in light sleep since boot */
+    uint32_t wakeups;        /* light sleep entries */
+    uint32_t sleep_permille; /* light sleep share of the time since boot */
+} app_power_stats_t;
+
+/** Initialize power management
+ *
+ * Configures dynamic frequency scaling and automatic light sleep when enabled in
+ * sdkconfig, enables GPIO wakeup for the sleepy end device profile and starts the power
+ * state accounting.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_power_init();
+
+/** Get the power state counters
+ *
+ * @param[out] stats Counters.
+ */
+void app_power_get_stats(app_power_stats_t *stats);
+
+/** Deferred log counters */
+typedef struct {
+    uint32_t records;    /* records queued since boot */
+    uint32_t dropped;    /* records dropped on a full ring */
+    uint32_t high_water; /* deepest ring occupancy */
+} app_dlog_stats_t;
+
+/** Start the deferred log task
+ *
+ * Records queued before this call wait in the rings and are emitted once the task runs.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_dlog_init();
+
+/** Get the deferred log counters, summed over all cores
+ *
+ * @param[out] stats Counters.
+ */
+void app_dlog_get_stats(app_dlog_stats_t *stats);
+
+/** Contact event log counters */
+typedef struct {
+    uint32_t appends;      /* events appended since boot */
+    uint32_t unacked;      /* events waiting to be replayed */
+    uint32_t flash_writes; /* flash write operations since boot */
+    uint32_t erases;       /* sector erases since boot */
+    uint32_t crc_errors;   /* corrupted records skipped at mount */
+    uint32_t overwritten;  /* events lost to the ring wrapping before they were replayed */
+} app_evlog_stats_t;
+
+/** Mount the contact event log
+ *
+ * The log lives in the `evlog` data partition and survives reboots. Events are batched in
+ * RAM and flushed every CONFIG_APP_EVLOG_FLUSH_INTERVAL_SEC seconds or when the batch is full.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_evlog_init();
+
+/** Append a contact report to the event log
+ *
+ * While online a BooleanState StateChange event is emitted right away, otherwise the entry
+ * is kept for replay. Must be called on the Matter thread.
+ *
+ * @param[in] endpoint_id Contact sensor endpoint.
+ * @param[in] closed Reported state.
+ * @param[in] transitions Number of transitions coalesced into the report.
+ */
+void app_evlog_record(uint16_t endpoint_id, bool closed, uint16_t transitions);
+
+/** Update the link state of the event log
+ *
+ * Going online replays every entry logged while offline as StateChange events.
+ * Must be called on the Matter thread.
+ *
+ * @param[in] online true once the node has network connectivity.
+ */
+void app_evlog_set_online(bool online);
+
+/** Get the event log counters
+ *
+ * @param[out] stats Counters.
+ */
+void app_evlog_get_stats(app_evlog_stats_t *stats);
+
+/** Telemetry stream counters */
+typedef struct {
+    uint32_t frames;  /* records queued since boot */
+    uint32_t dropped; /* records dropped on a full ring */
+    uint32_t bytes;   /* encoded bytes handed to the UART */
+} app_telemetry_stats_t;
+
+/** Start the binary telemetry stream
+ *
+ * Sets up the telemetry UART and the task that drains the record ring into it.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_telemetry_init();
+
+/** Queue a debounced contact transition record
+ *
+ * @param[in] channel Contact channel index.
+ * @param[in] closed New state.
+ * @param[in] edge_us Timestamp of the edge that started the transition.
+ */
+void app_telemetry_contact_edge(uint8_t channel, bool closed, int64_t edge_us);
+
+/** Queue a latency sample record
+ *
+ * @param[in] span Span, see trace_span_t.
+ * @param[in] value_us Sample.
+ */
+void app_telemetry_latency(uint8_t span, uint32_t value_us);
+
+/** Queue a raw deferred log record
+ *
+ * @param[in] format_id Address of the log call site descriptor.
+ * @param[in] tag Address of the tag string.
+ * @param[in] words Argument words.
+ * @param[in] nwords Number of words.
+ *
+ * @return true if the record was queued.
+ */
+bool app_telemetry_log(uint32_t format_id, uint32_t tag, const uint32_t *words, uint8_t nwords);
+
+/** Queue a record with the current Thread device role */
+void app_telemetry_thread_role_changed();
+
+/** Queue a resource watermark record
+ *
+ * @param[in] metric Metric, see watermark_metric_t.
+ * @param[in] min Lowest value over the slot.
+ * @param[in] max Highest value over the slot.
+ */
+void app_telemetry_watermark(uint8_t metric, uint32_t min, uint32_t max);
+
+/** Get the telemetry counters
+ *
+ * @param[out] stats Counters.
+ */
+void app_telemetry_get_stats(app_telemetry_stats_t *stats);
+
+/** One resource metric, in metric units (bytes, us or queue entries) */
+typedef struct {
+    bool present;        /* available in the last sample */
+    uint32_t last;
+    bool window_seen;    /* sampled in the slots still in the ring */
+    uint32_t window_min; /* over the slots still in the ring */
+    uint32_t window_max;
+    uint32_t total_min;  /* since boot */
+    uint32_t total_max;
+} app_watermark_metric_t;
+
+/** Resource sampler counters */
+typedef struct {
+    uint32_t samples;  /* samples since boot */
+    uint16_t slots;    /* slots in the ring, the one being filled included */
+    uint32_t slot_sec; /* slot length */
+    uint32_t exported; /* slots sent on the telemetry stream */
+} app_watermark_stats_t;
+
+/** Start sampling heap, task stack and queue watermarks
+ *
+ * A low priority task samples every metric of watermark.h periodically and keeps their
+ * min and max per time slot. Each closed slot goes out on the telemetry stream. Must be
+ * called after `esp_matter::start()`.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_SUPPORTED if CONFIG_APP_WATERMARK_ENABLE is off.
+ * @return error in case of failure.
+ */
+esp_err_t app_watermark_init();
+
+/** Get one resource metric
+ *
+ * @param[in] metric Metric, see watermark_metric_t.
+ * @param[out] out Last value, min and max.
+ *
+ * @return false if the metric was never sampled.
+ */
+bool app_watermark_get(uint8_t metric, app_watermark_metric_t *out);
+
+/** Get the resource sampler counters
+ *
+ * @param[out] stats Counters.
+ */
+void app_watermark_get_stats(app_watermark_stats_t *stats);
+
+/** Delta OTA counters */
+typedef struct {
+    uint32_t full_images;  /* images that went through untouched */
+    uint32_t delta_images; /* patches applied and verified */
+    uint32_t failures;     /* patches rejected or that failed to apply */
+    int32_t last_error;    /* DELTA_PATCH_ERR_* of the last failure, see delta_patch.h */
+    bool in_progress;
+    uint32_t patch_bytes;  /* of the last patch, so far */
+    uint32_t image_bytes;  /* rebuilt by the last patch, so far */
+    uint32_t apply_us;     /* spent in the applier for the last patch */
+    uint32_t ram_bytes;    /* applier buffers, allocated while a patch is applied */
+} app_ota_stats_t;
+
+/** Get the delta OTA counters
+ *
+ * Delta images need no setup: with CONFIG_APP_DELTA_OTA, app_ota.cpp sits between the OTA
+ * requestor and the update partition and rebuilds the image from any patch it receives.
+ *
+ * @param[out] stats Counters.
+ */
+void app_ota_get_stats(app_ota_stats_t *stats);
+
+/** Task placement, see the "Task placement" menu
+ *
+ * Cores for xTaskCreatePinnedToCore(): the sensor path (GPIO interrupts, accelerometer
+ * task) on one core, the background tasks next to the network stacks on the other.
+ */
+#if CONFIG_APP_CORE_AFFINITY
+#define APP_SENSOR_CORE CONFIG_APP_SENSOR_CORE
+#define APP_NETWORK_CORE (1 - CONFIG_APP_SENSOR_CORE)
+#else
+#define APP_SENSOR_CORE tskNO_AFFINITY
+#define APP_NETWORK_CORE tskNO_AFFINITY
+#endif
+
+#define APP_CORES_MAX 2
+
+/** Per-core load and placement of the sensor path */
+typedef struct {
+    int8_t isr_core;                  /* core the GPIO interrupts are allocated on, -1 before */
+    int8_t timer_core;                /* core the esp_timer callbacks ran on, -1 not seen yet */
+    uint8_t cores;
+    uint8_t load_pct[APP_CORES_MAX];  /* over the last sample window */
+    uint8_t load_max_pct[APP_CORES_MAX];
+    uint8_t load_avg_pct[APP_CORES_MAX];
+    uint32_t windows;                 /* sample windows since the last reset */
+    bool traffic_running;
+    uint8_t traffic_core;
+    uint8_t traffic_duty_pct;         /* busy share requested */
+    uint8_t traffic_busy_pct;         /* busy share achieved so far */
+    uint32_t traffic_bursts;
+    uint32_t traffic_left_ms;
+} app_cores_stats_t;
+
+/** Install the GPIO ISR service on the sensor core
+ *
+ * Interrupts are allocated on the core that asks for them: the service is installed from
+ * the sensor core, so every contact, expander and accelerometer interrupt runs there. Does
+ * nothing if already installed.
+ *
+ * @return ESP_OK on success, or the gpio_install_isr_service() error.
+ */
+esp_err_t app_cores_install_gpio_isr_service();
+
+/** Start the per-core load monitor
+ *
+ * A low priority task on the network core samples the idle time of each core.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_SUPPORTED if CONFIG_APP_CORE_LOAD_MONITOR is off.
+ * @return error in case of failure.
+ */
+esp_err_t app_cores_init();
+
+/** Get the per-core load and placement
+ *
+ * @param[out] stats Load and placement.
+ */
+void app_cores_get_stats(app_cores_stats_t *stats);
+
+/** Restart the load averages and maxima */
+void app_cores_reset_stats();
+
+/** Run synthetic network stack load on a core
+ *
+ * A task at CONFIG_APP_CORE_TRAFFIC_PRIORITY copies packet sized buffers in bursts, busy
+ * for `duty_pct` of the time, to see how the sensor path holds up (debounce timer
+ * lateness, `sensor latency`) with a loaded network core, or with the load on its own core.
+ *
+ * @param[in] core Core to load.
+ * @param[in] duty_pct Busy share, 1-90.
+ * @param[in] burst_ms Length of one busy burst.
+ * @param[in] duration_s Run time.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_STATE if a run is in progress.
+ * @return ESP_ERR_INVALID_ARG on a bad core or duty.
+ * @return ESP_ERR_NOT_SUPPORTED if CONFIG_APP_CORE_LOAD_MONITOR is off.
+ */
+esp_err_t app_cores_start_traffic(uint8_t core, uint8_t duty_pct, uint32_t burst_ms, uint32_t duration_s);
+
+/** Stop the synthetic load, if running */
+void app_cores_stop_traffic();
+
+/** Contact event storm, see storm_gen.h */
+typedef struct {
+    uint32_t rate_hz;         /* transitions per second, all channels together */
+    uint32_t duration_ms;
+    uint8_t pattern;          /* storm_pattern_t: steady, burst, random */
+    uint16_t burst_len;       /* transitions per burst */
+    uint32_t seed;            /* random pattern */
+    const uint16_t *channels; /* channels taking turns, NULL for all of them */
+    uint16_t channel_count;
+} app_storm_config_t;
+
+typedef struct {
+    bool running;
+    uint32_t rate_hz;
+    uint8_t pattern;
+    uint16_t burst_len;
+    uint16_t channels;
+    uint32_t elapsed_ms;
+    uint32_t injected;         /* transitions fed to the contact path */
+    uint32_t achieved_hz;
+    uint32_t max_lag_us;       /* latest a transition was injected after its scheduled time */
+    uint32_t restored;         /* transitions back to the debounced levels at the end */
+    uint32_t queued;           /* contact queue, all channels, since the start */
+    uint32_t dropped;
+    uint32_t coalesced;
+    uint32_t queue_high_water; /* since boot */
+    uint32_t reports;          /* storm channels, report policy */
+    uint32_t suppressed;
+    uint32_t report_count;     /* edge->report span since the start */
+    uint32_t report_p50_us;
+    uint32_t report_p99_us;
+    uint32_t report_max_us;
+    uint32_t heap_start;       /* free heap at the start */
+    uint32_t heap_min;         /* lowest free heap seen by the generator */
+} app_storm_stats_t;
+
+/** Feed synthetic transitions to the contact path until the run ends
+ *
+ * An esp_timer toggles the channels in turn through `app_driver_contact_inject()`, at most
+ * CONFIG_APP_STORM_BATCH transitions per callback, to find the rate the node ingests and
+ * reports before the queue drops or the reports fall behind. The transitions go through
+ * the report policy and the bindings: bound devices get the commands. At the end the
+ * channels are set back to their debounced level. Restarts the latency spans. Matter
+ * thread (or chip stack lock held).
+ *
+ * @param[in] config Run, the channel list is copied.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_STATE if a run is in progress.
+ * @return ESP_ERR_INVALID_ARG on a bad rate, duration, pattern or channel.
+ * @return ESP_ERR_NOT_SUPPORTED if CONFIG_APP_STORM_ENABLE is off.
+ */
+esp_err_t app_storm_start(const app_storm_config_t *config);
+
+/** End the run early */
+void app_storm_stop();
+
+/** Get the counters of the current or last run
+ *
+ * Matter thread (or chip stack lock held).
+ *
+ * @param[out] stats Counters, all 0 before the first run.
+ */
+void app_storm_get_stats(app_storm_stats_t *stats);
+
+/** Settings persistence counters, see persist_cache.h */
+typedef struct {
+    uint32_t delay_ms;          /* longest a value stays in RAM only, 0: written through */
+    uint16_t cached;            /* values in the cache */
+    uint16_t capacity;
+    uint16_t dirty;             /* values waiting for the flush */
+    uint32_t sets;
+    uint32_t unchanged;         /* sets of the value already on flash */
+    uint32_t coalesced;         /* sets replacing a value not flushed yet */
+    uint32_t flushes;
+    uint32_t early_flushes;     /* flushes before the deadline, cache full */
+    uint32_t writes;            /* values written to NVS */
+    uint32_t commits;
+    uint32_t errors;
+    uint32_t max_batch;
+    uint64_t nvs_entries;       /* NVS entries the writes took */
+    uint32_t flush_ms;          /* time spent flushing */
+    uint32_t uptime_s;          /* since app_persist_init() */
+    uint32_t nvs_used_entries;  /* whole partition, esp_matter and CHIP included */
+    uint32_t nvs_total_entries;
+    uint32_t projected_days;    /* flash lifetime at the rate of these writes, UINT32_MAX if none */
+} app_persist_stats_t;
+
+/** Initialize the settings persistence
+ *
+ * Application settings (report policies, binding actions, calibration) go through a
+ * write-behind cache in front of NVS: repeated sets of a key are coalesced in RAM and the
+ * dirty values written in one batch on the Matter thread CONFIG_APP_PERSIST_DELAY_MS after
+ * the first of them, or on esp_restart(). Call after `nvs_flash_init()`.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_persist_init();
+
+/** Save a setting
+ *
+ * Any task. The value reaches flash within the flush delay.
+ *
+ * @param[in] ns NVS namespace, 15 characters at most.
+ * @param[in] key NVS key, 15 characters at most.
+ * @param[in] data Value.
+ * @param[in] len Value length, 32 bytes at most.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if a name or the value is too long.
+ * @return ESP_ERR_INVALID_STATE before `app_persist_init()`.
+ * @return ESP_FAIL if a write forced by a full cache failed.
+ */
+esp_err_t app_persist_set(const char *ns, const char *key, const void *data, size_t len);
+
+/** Read a setting, the cached value if it is not flushed yet
+ *
+ * @param[out] data Value.
+ * @param[in] len Expected length.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_FOUND if it was never saved.
+ * @return ESP_ERR_INVALID_SIZE if it was saved with another length.
+ * @return ESP_ERR_INVALID_STATE before `app_persist_init()`.
+ */
+esp_err_t app_persist_get(const char *ns, const char *key, void *data, size_t len);
+
+/** Write the pending values now
+ *
+ * @return ESP_OK on success.
+ * @return ESP_FAIL if a write failed, the value stays pending.
+ */
+esp_err_t app_persist_flush();
+
+/** Change the flush delay at runtime, 0 writes every value through (not saved)
+ *
+ * @param[in] delay_ms New delay.
+ */
+void app_persist_set_delay(uint32_t delay_ms);
+
+/** Get the persistence counters
+ *
+ * @param[out] stats Counters.
+ */
+void app_persist_get_stats(app_persist_stats_t *stats);
+
+/** Accelerometer counters */
+typedef struct {
+    uint32_t samples;    /* samples drained from the FIFO */
+    uint32_t drains;     /* FIFO drains that read samples */
+    uint32_t transfers;  /* I2C transactions */
+    uint32_t bytes;      /* bytes read */
+    uint32_t overruns;   /* drains that found the FIFO overrun */
+    uint32_t bus_errors; /* failed I2C transactions */
+    uint32_t bus_resets; /* bus recoveries after an error */
+    uint32_t knocks;     /* knocks detected since boot */
+    bool vibrating;
+    bool tilted;
+    uint16_t odr_hz;     /* output data rate applied, 0 without an IMU */
+} app_imu_stats_t;
+
+/** Initialize the accelerometer
+ *
+ * Probes and configures the IMU on the I2C bus: samples are buffered in its FIFO and
+ * drained in one burst read on every watermark interrupt, then run through the knock,
+ * vibration and tilt detector. Nothing is reported before `app_imu_start_reporting()`.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_SUPPORTED if CONFIG_APP_IMU_ENABLE is off.
+ * @return error in case of failure.
+ */
+esp_err_t app_imu_init();
+
+/** Start reporting knock and tamper changes to the data model
+ *
+ * Must be called after `esp_matter::start()`.
+ */
+void app_imu_start_reporting();
+
+/** Get the accelerometer counters
+ *
+ * @param[out] stats Counters.
+ */
+void app_imu_get_stats(app_imu_stats_t *stats);
+
+/** Hall sensor counters and detector state */
+typedef struct {
+    uint32_t sample_hz;   /* ADC conversion rate, 0 without a Hall sensor */
+    uint16_t decimation;  /* conversions per field sample */
+    uint32_t frames;      /* DMA frames read */
+    uint32_t conversions; /* conversion words parsed */
+    uint32_t foreign;     /* words of another channel */
+    uint32_t samples;     /* field samples classified */
+    uint32_t overflows;   /* frames dropped by the driver, the task fell behind */
+    uint8_t state;        /* hall_state_t, HALL_STATE_MAX before the first sample */
+    uint16_t gap_mm;      /* last reported gap, HALL_GAP_UNKNOWN while open */
+    int32_t field_ut;     /* last field sample */
+    int32_t closed_ut;    /* closed reference in use */
+} app_hall_stats_t;
+
+/** Initialize the Hall sensor
+ *
+ * Starts ADC1 in continuous mode on the sensor channel: conversions land in DMA frames with
+ * no CPU involvement, and a task on the sensor core wakes once per frame to decimate and
+ * classify the whole frame (see hall_sense.h). Nothing is reported before
+ * `app_hall_start_reporting()`.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_SUPPORTED if CONFIG_APP_HALL_ENABLE is off.
+ * @return error in case of failure.
+ */
+esp_err_t app_hall_init();
+
+/** Add the door position cluster to an endpoint
+ *
+ * Manufacturer specific cluster with the door state (closed, ajar, open, tamper), the gap in
+ * millimeters and the field. Must be called before `esp_matter::start()`.
+ *
+ * @param[in] endpoint_id Endpoint of the door contact sensor.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_STATE if the Hall sensor is not running.
+ * @return ESP_ERR_NOT_SUPPORTED if CONFIG_APP_HALL_ENABLE is off.
+ */
+esp_err_t app_hall_add_cluster(uint16_t endpoint_id);
+
+/** Start reporting door position changes to the data model
+ *
+ * Must be called after `esp_matter::start()`.
+ */
+void app_hall_start_reporting();
+
+/** Use the field being measured as the closed reference
+ *
+ * To be called with the door shut. Saved with `app_persist_set()`, it replaces
+ * CONFIG_APP_HALL_CLOSED_UT from the next boot on.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_STATE if the field is too weak to be the door magnet.
+ * @return ESP_ERR_TIMEOUT if the Hall task did not answer.
+ * @return ESP_ERR_NOT_SUPPORTED if the Hall sensor is not running.
+ */
+esp_err_t app_hall_calibrate();
+
+/** Get the Hall sensor counters
+ *
+ * @param[out] stats Counters.
+ */
+void app_hall_get_stats(app_hall_stats_t *stats);
+
+#if CONFIG_APP_I2C_BUS
+#include <driver/i2c_master.h>
+
+/** Get the I2C bus shared by the accelerometer and the GPIO expanders
+ *
+ * Created on the first call.
+ *
+ * @param[out] bus Bus handle.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_i2c_bus_get(i2c_master_bus_handle_t *bus);
+#endif
+
+/** GPIO expander counters, summed over the expanders */
+typedef struct {
+    uint8_t expanders;     /* expanders found at boot */
+    uint16_t channels;     /* contact channels they provide */
+    uint32_t interrupts;   /* interrupt line wakeups */
+    uint32_t scans;        /* bulk port reads */
+    uint32_t transfers;    /* I2C transactions, configuration included */
+    uint32_t bus_errors;   /* failed I2C transactions */
+    uint32_t bus_resets;   /* bus recoveries after an error */
+    uint32_t retries;      /* interrupt scans retried after a bus error */
+    bool stalled;          /* gave up retrying, the interrupt stays masked */
+    uint32_t changed_bits; /* pin changes seen between two reads */
+    uint32_t reports;      /* debounced changes reported */
+} app_expander_stats_t;
+
+/** Initialize the GPIO expanders
+ *
+ * Probes CONFIG_APP_EXPANDER_COUNT expanders from CONFIG_APP_EXPANDER_BASE_ADDRESS on and
+ * makes every pin of the ones that answer a contact input. The expanders share one
+ * interrupt line: each interrupt reads all 16 pins of an expander in one I2C transaction
+ * and debounces only the pins that changed. The reads run in a task on the sensor core,
+ * `cb` in the esp_timer task.
+ *
+ * @param[in] cb Callback invoked with every debounced change, `cb_arg` is the channel number.
+ * @param[in] first_channel Channel number of pin 0 of the first expander.
+ * @param[out] count Number of channels created.
+ *
+ * @return ESP_OK on success, also when no expander answered.
+ * @return error in case of failure.
+ */
+esp_err_t app_expander_init(app_contact_cb_t cb, uint16_t first_channel, uint16_t *count);
+
+/** Get the debounced state of an expander channel
+ *
+ * @param[in] index Channel number minus the `first_channel` given to `app_expander_init()`.
+ *
+ * @return true if the contact is closed.
+ */
+bool app_expander_get_closed(uint16_t index);
+
+/** Get the name of an expander channel, "x<expander>.<pin>"
+ *
+ * @param[in] index Channel number minus the `first_channel` given to `app_expander_init()`.
+ *
+ * @return Static string.
+ */
+const char *app_expander_name(uint16_t index);
+
+/** Get the GPIO expander counters
+ *
+ * @param[out] stats Counters.
+ */
+void app_expander_get_stats(app_expander_stats_t *stats);
+
+#if CONFIG_ENABLE_CHIP_SHELL
+/** Register the application console commands
+ *
+ * Adds the `sensor` command group (latency histograms, queue and power counters) to the
+ * Matter shell. Must be called before `esp_matter::console::init()`.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_console_register_commands();
+#endif
+
 /** Driver Update
  *
  * This API should be called to update the driver for the attribute being updated.
@@ -90,6 +992,18 @@ void app_driver_set_door_closed();
 esp_err_t app_driver_attribute_update(app_driver_handle_t driver_handle, uint16_t endpoint_id, uint32_t cluster_id,
                                       uint32_t attribute_id, esp_matter_attr_val_t *val);
 
+#if CONFIG_APP_HAS_LIGHT
+/** Initialize the attribute handle cache
+ *
+ * Resolves every attribute the driver reads or dispatches on, so the callbacks never walk
+ * the data model. Must be called after `esp_matter::start()` and before any other driver API
+ * that touches the light endpoint.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_driver_attribute_cache_init();
+
 /** Set defaults for light driver
  *
  * Set the attribute drivers to their default values from the created data model.
@@ -101,6 +1015,33 @@ esp_err_t app_driver_attribute_update(app_driver_handle_t driver_handle, uint16_
  */
 esp_err_t app_driver_light_set_defaults(uint16_t endpoint_id);
 
+/** Light render counters */
+typedef struct {
+    uint32_t writes;     /* attribute writes applied to the shadow state */
+    uint32_t coalesced;  /* writes merged into an already pending render */
+    uint32_t renders;    /* renders that had something to apply */
+    uint32_t led_writes; /* LED driver calls */
+    uint32_t rate_hz;    /* current render rate, 0 renders on every write */
+} app_light_render_stats_t;
+
+/** Set the light render rate
+ *
+ * Must be called on the Matter thread.
+ *
+ * @param[in] hz Renders per second, 0 to apply every attribute write right away.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if the rate is above 1000 Hz.
+ */
+esp_err_t app_driver_light_set_render_rate(uint32_t hz);
+
+/** Get the light render counters
+ *
+ * @param[out] stats Counters.
+ */
+void app_driver_light_get_render_stats(app_light_render_stats_t *stats);
+#endif
+
 #if CHIP_DEVICE_CONFIG_ENABLE_THREAD
 #define ESP_OPENTHREAD_DEFAULT_RADIO_CONFIG()                                           \
     {                                                                                   \
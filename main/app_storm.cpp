@@ -0,0 +1,268 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <mutex>
+
+#include <app_priv.h>
+
+#include "latency_trace.h"
+#include "storm_gen.h"
+
+#if CONFIG_APP_STORM_ENABLE
+
+static const char *TAG = "app_storm";
+
+/* Shortest wait between two timer callbacks: a storm faster than this is injected in
+ * batches, and the debounce timers still get the esp_timer task in between */
+#define APP_STORM_MIN_WAIT_US 100
+
+/* Run state, shared by the esp_timer task and the console */
+static std::mutex s_storm_lock;
+static esp_timer_handle_t s_storm_timer = NULL;
+static storm_gen_t s_storm_gen;
+static bool s_storm_running = false;
+static bool s_storm_ran = false;
+static bool s_storm_stop = false;
+static uint16_t s_storm_channels[APP_CONTACT_MAX_CHANNEL_COUNT];
+static bool s_storm_levels[APP_CONTACT_MAX_CHANNEL_COUNT]; /* last injected, per entry of s_storm_channels */
+static uint16_t s_storm_channel_count = 0;
+static uint16_t s_storm_restore_next = 0; /* next entry of s_storm_channels to restore */
+static uint32_t s_storm_restored = 0;
+static int64_t s_storm_end_us = 0;        /* end of the schedule, 0 while it runs */
+static uint32_t s_storm_max_lag_us = 0;
+static uint32_t s_storm_heap_start = 0;
+static uint32_t s_storm_heap_min = 0;
+
+/* Counters when the run started */
+static app_contact_queue_stats_t s_storm_queue_base;
+static uint32_t s_storm_reports_base = 0;
+static uint32_t s_storm_suppressed_base = 0;
+
+static void app_storm_policy_totals(uint32_t *reports, uint32_t *suppressed)
+{
+    *reports = 0;
+    *suppressed = 0;
+    for (uint16_t i = 0; i < s_storm_channel_count; i++) {
+        app_contact_policy_t policy;
+        app_driver_contact_get_policy(s_storm_channels[i], &policy);
+        *reports += policy.reports;
+        *suppressed += policy.suppressed;
+    }
+}
+
+/* esp_timer task, lock held. Leaves every channel on its debounced level, the data model
+ * follows; a batch per call so the restore does not overflow the queue either. */
+static void app_storm_finish(int64_t now)
+{
+    int n = 0;
+    for (; s_storm_restore_next < s_storm_channel_count && n < CONFIG_APP_STORM_BATCH; s_storm_restore_next++) {
+        uint16_t i = s_storm_restore_next;
+        bool closed = app_driver_contact_get_closed(s_storm_channels[i]);
+        if (s_storm_levels[i] != closed) {
+            s_storm_levels[i] = closed;
+            app_driver_contact_inject(s_storm_channels[i], closed, now);
+            s_storm_restored++;
+            n++;
+        }
+    }
+    if (s_storm_end_us == 0) {
+        s_storm_end_us = now;
+    }
+    if (s_storm_restore_next < s_storm_channel_count) {
+        esp_timer_start_once(s_storm_timer, APP_STORM_MIN_WAIT_US);
+        return;
+    }
+    s_storm_running = false;
+    APP_LOGI(TAG, "Storm done, %" PRIu32 " transitions", (uint32_t)s_storm_gen.emitted);
+}
+
+/* Runs in the esp_timer task, the producer side of the contact queue */
+static void app_storm_timer_cb(void *arg)
+{
+    std::lock_guard<std::mutex> lock(s_storm_lock);
+    if (!s_storm_running) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    uint32_t heap = esp_get_free_heap_size();
+    if (heap < s_storm_heap_min) {
+        s_storm_heap_min = heap;
+    }
+    if (s_storm_stop || s_storm_end_us != 0) {
+        app_storm_finish(now);
+        return;
+    }
+    int64_t at_us;
+    for (int n = 0; n < CONFIG_APP_STORM_BATCH && storm_gen_pop(&s_storm_gen, now, &at_us); n++) {
+        uint16_t slot = (uint16_t)((s_storm_gen.emitted - 1) % s_storm_channel_count);
+        s_storm_levels[slot] = !s_storm_levels[slot];
+        app_driver_contact_inject(s_storm_channels[slot], s_storm_levels[slot], at_us);
+        if (now - at_us > s_storm_max_lag_us) {
+            s_storm_max_lag_us = (uint32_t)(now - at_us);
+        }
+    }
+    int64_t next = storm_gen_next(&s_storm_gen);
+    if (next == INT64_MAX) {
+        app_storm_finish(now);
+        return;
+    }
+    int64_t wait = next - now;
+    esp_timer_start_once(s_storm_timer, wait > APP_STORM_MIN_WAIT_US ? wait : APP_STORM_MIN_WAIT_US);
+}
+
+esp_err_t app_storm_start(const app_storm_config_t *config)
+{
+    std::lock_guard<std::mutex> lock(s_storm_lock);
+    if (s_storm_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint16_t channel_count = app_driver_contact_channel_count();
+    if (config->channels && config->channel_count > 0) {
+        if (config->channel_count > APP_CONTACT_MAX_CHANNEL_COUNT) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        for (uint16_t i = 0; i < config->channel_count; i++) {
+            if (config->channels[i] >= channel_count) {
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+    } else if (channel_count == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    storm_config_t gen_config = {
+        .rate_hz = config->rate_hz,
+        .duration_ms = config->duration_ms,
+        .pattern = (storm_pattern_t)config->pattern,
+        .burst_len = config->burst_len,
+        .seed = config->seed,
+    };
+    int64_t now = esp_timer_get_time();
+    if (!storm_gen_init(&s_storm_gen, &gen_config, now)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_storm_timer) {
+        esp_timer_create_args_t timer_args = {
+            .callback = app_storm_timer_cb,
+            .arg = NULL,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "storm",
+            .skip_unhandled_events = true,
+        };
+        esp_err_t err = esp_timer_create(&timer_args, &s_storm_timer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    if (config->channels && config->channel_count > 0) {
+        s_storm_channel_count = config->channel_count;
+        memcpy(s_storm_channels, config->channels, config->channel_count * sizeof(s_storm_channels[0]));
+    } else {
+        s_storm_channel_count = channel_count;
+        for (uint16_t i = 0; i < channel_count; i++) {
+            s_storm_channels[i] = i;
+        }
+    }
+    for (uint16_t i = 0; i < s_storm_channel_count; i++) {
+        s_storm_levels[i] = app_driver_contact_get_closed(s_storm_channels[i]);
+    }
+    app_driver_contact_get_queue_stats(&s_storm_queue_base);
+    app_storm_policy_totals(&s_storm_reports_base, &s_storm_suppressed_base);
+    latency_trace_reset();
+    s_storm_heap_start = esp_get_free_heap_size();
+    s_storm_heap_min = s_storm_heap_start;
+    s_storm_max_lag_us = 0;
+    s_storm_end_us = 0;
+    s_storm_restore_next = 0;
+    s_storm_restored = 0;
+    s_storm_stop = false;
+    s_storm_running = true;
+    s_storm_ran = true;
+    ESP_LOGI(TAG, "Storm of %" PRIu32 " transitions/s %s on %u channels for %" PRIu32 " ms", config->rate_hz,
+             storm_pattern_name(gen_config.pattern), s_storm_channel_count, config->duration_ms);
+    int64_t next = storm_gen_next(&s_storm_gen);
+    return esp_timer_start_once(s_storm_timer, next > now ? next - now : 0);
+}
+
+void app_storm_stop()
+{
+    std::lock_guard<std::mutex> lock(s_storm_lock);
+    if (!s_storm_running) {
+        return;
+    }
+    /* The callback restores the levels: only the esp_timer task may feed the queue */
+    s_storm_stop = true;
+    esp_timer_stop(s_storm_timer);
+    esp_timer_start_once(s_storm_timer, 0);
+}
+
+void app_storm_get_stats(app_storm_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    std::lock_guard<std::mutex> lock(s_storm_lock);
+    if (!s_storm_ran) {
+        return;
+    }
+    const storm_config_t *config = &s_storm_gen.config;
+    stats->running = s_storm_running;
+    stats->rate_hz = config->rate_hz;
+    stats->pattern = (uint8_t)config->pattern;
+    stats->burst_len = config->burst_len;
+    stats->channels = s_storm_channel_count;
+    int64_t end = s_storm_end_us != 0 ? s_storm_end_us : esp_timer_get_time();
+    int64_t elapsed_us = end - s_storm_gen.start_us;
+    stats->elapsed_ms = (uint32_t)(elapsed_us / 1000);
+    stats->injected = (uint32_t)s_storm_gen.emitted;
+    stats->achieved_hz = elapsed_us > 0 ? (uint32_t)(s_storm_gen.emitted * 1000000 / elapsed_us) : 0;
+    stats->max_lag_us = s_storm_max_lag_us;
+    stats->restored = s_storm_restored;
+
+    app_contact_queue_stats_t queue;
+    app_driver_contact_get_queue_stats(&queue);
+    stats->queued = queue.pushed - s_storm_queue_base.pushed;
+    stats->dropped = queue.dropped - s_storm_queue_base.dropped;
+    stats->coalesced = queue.coalesced - s_storm_queue_base.coalesced;
+    stats->queue_high_water = queue.high_water;
+    uint32_t reports, suppressed;
+    app_storm_policy_totals(&reports, &suppressed);
+    stats->reports = reports - s_storm_reports_base;
+    stats->suppressed = suppressed - s_storm_suppressed_base;
+
+    latency_hist_snapshot_t report;
+    latency_trace_snapshot(TRACE_SPAN_EDGE_TO_REPORT, &report);
+    stats->report_count = report.count;
+    stats->report_p50_us = latency_trace_percentile(&report, 50);
+    stats->report_p99_us = latency_trace_percentile(&report, 99);
+    stats->report_max_us = report.max_us;
+    stats->heap_start = s_storm_heap_start;
+    stats->heap_min = s_storm_heap_min;
+}
+
+#else
+
+esp_err_t app_storm_start(const app_storm_config_t *config)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void app_storm_stop()
+{
+}
+
+void app_storm_get_stats(app_storm_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+#endif // CONFIG_APP_STORM_ENABLE
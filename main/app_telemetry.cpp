@@ -0,0 +1,216 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <string.h>
+
+#include <driver/uart.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#if CONFIG_OPENTHREAD_ENABLED
+#include <esp_openthread.h>
+#include <esp_openthread_lock.h>
+#include <openthread/thread.h>
+#endif
+
+#include <app_priv.h>
+#include "telemetry.h"
+
+#if CONFIG_APP_TELEMETRY_ENABLE
+static const char *TAG = "app_telemetry";
+
+#define APP_TELEMETRY_UART ((uart_port_t)CONFIG_APP_TELEMETRY_UART_NUM)
+#define APP_TELEMETRY_UART_TX_BUF 1024
+#define APP_TELEMETRY_UART_RX_BUF (SOC_UART_FIFO_LEN * 2)
+
+static uint8_t s_telemetry_buf[CONFIG_APP_TELEMETRY_RING_SIZE];
+static telemetry_t s_telemetry;
+static portMUX_TYPE s_telemetry_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t s_telemetry_task = NULL;
+static uint32_t s_telemetry_bytes = 0;
+
+/* Records come from several tasks, the ring only takes one writer at a time. Encoding a
+ * record is a few dozen byte stores, the UART pump never holds the lock. `call` can use
+ * `now`, the record timestamp. */
+#define APP_TELEMETRY_WRITE(call)                      \
+    do {                                               \
+        if (!s_telemetry_task) {                       \
+            break;                                     \
+        }                                              \
+        uint32_t now = (uint32_t)esp_timer_get_time(); \
+        portENTER_CRITICAL(&s_telemetry_lock);         \
+        bool queued = call;                            \
+        portEXIT_CRITICAL(&s_telemetry_lock);          \
+        if (queued) {                                  \
+            xTaskNotifyGive(s_telemetry_task);         \
+        }                                              \
+    } while (0)
+
+static void app_telemetry_task(void *arg)
+{
+    while (true) {
+        const uint8_t *data;
+        size_t len = telemetry_peek(&s_telemetry, &data);
+        if (len == 0) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        /* Copies the span into the driver TX ring, the UART interrupt feeds the FIFO from there */
+        int written = uart_write_bytes(APP_TELEMETRY_UART, data, len);
+        if (written > 0) {
+            telemetry_consume(&s_telemetry, written);
+            s_telemetry_bytes += written;
+        }
+    }
+}
+
+#if CONFIG_APP_TELEMETRY_STATS_INTERVAL_SEC > 0
+static void app_telemetry_stats_cb(void *arg)
+{
+    uint32_t free_bytes = esp_get_free_heap_size();
+    uint32_t min_free_bytes = esp_get_minimum_free_heap_size();
+    uint32_t largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    app_contact_queue_stats_t queue;
+    app_driver_contact_get_queue_stats(&queue);
+
+    APP_TELEMETRY_WRITE(telemetry_heap(&s_telemetry, now, free_bytes, min_free_bytes, largest_block));
+    APP_TELEMETRY_WRITE(telemetry_queue(&s_telemetry, now, (uint16_t)queue.depth, (uint16_t)queue.high_water,
+                                        queue.pushed, queue.dropped));
+}
+#endif
+
+esp_err_t app_telemetry_init()
+{
+    if (telemetry_init(&s_telemetry, s_telemetry_buf, sizeof(s_telemetry_buf)) != TELEMETRY_OK) {
+        ESP_LOGE(TAG, "Invalid telemetry ring size %d", CONFIG_APP_TELEMETRY_RING_SIZE);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uart_config_t uart_config = {
+        .baud_rate = CONFIG_APP_TELEMETRY_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .rx_flow_ctrl_thresh = 0,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    esp_err_t err = uart_driver_install(APP_TELEMETRY_UART, APP_TELEMETRY_UART_RX_BUF, APP_TELEMETRY_UART_TX_BUF, 0,
+                                        NULL, 0);
+    if (err == ESP_OK) {
+        err = uart_param_config(APP_TELEMETRY_UART, &uart_config);
+    }
+    if (err == ESP_OK) {
+        err = uart_set_pin(APP_TELEMETRY_UART, CONFIG_APP_TELEMETRY_TX_GPIO, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE,
+                           UART_PIN_NO_CHANGE);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set up telemetry UART, err:%d", err);
+        return err;
+    }
+
+    if (xTaskCreatePinnedToCore(app_telemetry_task, "telemetry", 2048, NULL, CONFIG_APP_BACKGROUND_TASK_PRIORITY,
+                                &s_telemetry_task, APP_NETWORK_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+#if CONFIG_APP_TELEMETRY_STATS_INTERVAL_SEC > 0
+    esp_timer_create_args_t timer_args = {
+        .callback = app_telemetry_stats_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "telemetry_stats",
+        .skip_unhandled_events = true,
+    };
+    esp_timer_handle_t timer;
+    err = esp_timer_create(&timer_args, &timer);
+    if (err == ESP_OK) {
+        err = esp_timer_start_periodic(timer, (uint64_t)CONFIG_APP_TELEMETRY_STATS_INTERVAL_SEC * 1000000);
+    }
+#endif
+    ESP_LOGI(TAG, "Telemetry on UART%d TX GPIO%d at %d baud", CONFIG_APP_TELEMETRY_UART_NUM,
+             CONFIG_APP_TELEMETRY_TX_GPIO, CONFIG_APP_TELEMETRY_BAUD);
+    return err;
+}
+
+void app_telemetry_contact_edge(uint8_t channel, bool closed, int64_t edge_us)
+{
+    APP_TELEMETRY_WRITE(telemetry_contact_edge(&s_telemetry, now, channel, closed, (uint32_t)edge_us));
+}
+
+void app_telemetry_latency(uint8_t span, uint32_t value_us)
+{
+    APP_TELEMETRY_WRITE(telemetry_latency(&s_telemetry, now, span, value_us));
+}
+
+bool app_telemetry_log(uint32_t format_id, uint32_t tag, const uint32_t *words, uint8_t nwords)
+{
+    bool logged = false;
+    APP_TELEMETRY_WRITE(logged = telemetry_log(&s_telemetry, now, format_id, tag, words, nwords));
+    return logged;
+}
+
+void app_telemetry_thread_role_changed()
+{
+#if CONFIG_OPENTHREAD_ENABLED
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    uint8_t role = (uint8_t)otThreadGetDeviceRole(esp_openthread_get_instance());
+    esp_openthread_lock_release();
+    APP_TELEMETRY_WRITE(telemetry_thread_role(&s_telemetry, now, role));
+#endif
+}
+
+void app_telemetry_watermark(uint8_t metric, uint32_t min, uint32_t max)
+{
+    APP_TELEMETRY_WRITE(telemetry_watermark(&s_telemetry, now, metric, min, max));
+}
+
+void app_telemetry_get_stats(app_telemetry_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_telemetry_lock);
+    stats->frames = s_telemetry.frames;
+    stats->dropped = s_telemetry.dropped;
+    portEXIT_CRITICAL(&s_telemetry_lock);
+    stats->bytes = s_telemetry_bytes;
+}
+#else
+esp_err_t app_telemetry_init()
+{
+    return ESP_OK;
+}
+
+void app_telemetry_contact_edge(uint8_t channel, bool closed, int64_t edge_us)
+{
+}
+
+void app_telemetry_latency(uint8_t span, uint32_t value_us)
+{
+}
+
+bool app_telemetry_log(uint32_t format_id, uint32_t tag, const uint32_t *words, uint8_t nwords)
+{
+    return false;
+}
+
+void app_telemetry_thread_role_changed()
+{
+}
+
+void app_telemetry_watermark(uint8_t metric, uint32_t min, uint32_t max)
+{
+}
+
+void app_telemetry_get_stats(app_telemetry_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+#endif // CONFIG_APP_TELEMETRY_ENABLE
@@ -0,0 +1,231 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <platform/CHIPDeviceLayer.h>
+
+#if CONFIG_OPENTHREAD_ENABLED
+#include <esp_openthread_lock.h>
+#endif
+
+#include <app_priv.h>
+#include "watermark.h"
+
+#if CONFIG_APP_WATERMARK_ENABLE
+static const char *TAG = "app_watermark";
+
+#define APP_WATERMARK_STACK_SIZE 2560
+
+/* Task whose stack high-water mark each STACK_* metric samples */
+static const struct {
+    watermark_metric_t metric;
+    const char *task_name;
+} k_watermark_tasks[] = {
+    { WATERMARK_STACK_CHIP, "CHIP" },
+    { WATERMARK_STACK_OPENTHREAD, "ot_task" },
+    { WATERMARK_STACK_NIMBLE, "nimble_host" },
+    { WATERMARK_STACK_ESP_TIMER, "esp_timer" },
+    { WATERMARK_STACK_TELEMETRY, "telemetry" },
+    { WATERMARK_STACK_DLOG, "dlog" },
+    { WATERMARK_STACK_IMU, "imu" },
+    { WATERMARK_STACK_WATERMARK, "watermark" },
+};
+
+static watermark_slot_t s_watermark_slots[CONFIG_APP_WATERMARK_SLOTS];
+static watermark_t s_watermark;
+static portMUX_TYPE s_watermark_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t s_watermark_task = NULL;
+static uint32_t s_watermark_samples = 0;
+static uint32_t s_watermark_exported = 0;
+
+/* Matter work queue probe: the esp-matter queue has no depth accessor, the time a work item
+ * waits before it runs stands in for it. 0 when no probe is pending. */
+static volatile int64_t s_probe_sent_us = 0;
+static volatile uint32_t s_probe_delay_us = 0;
+
+static void app_watermark_probe_work(intptr_t arg)
+{
+    s_probe_delay_us = (uint32_t)(esp_timer_get_time() - s_probe_sent_us);
+    s_probe_sent_us = 0;
+}
+
+static uint32_t app_watermark_matter_delay(int64_t now)
+{
+    int64_t sent = s_probe_sent_us;
+    if (sent != 0) {
+        /* Still queued since the last sample: the wait so far is a lower bound */
+        return (uint32_t)(now - sent);
+    }
+    uint32_t delay = s_probe_delay_us;
+    s_probe_sent_us = now;
+    chip::DeviceLayer::PlatformMgr().ScheduleWork(app_watermark_probe_work, 0);
+    return delay;
+}
+
+#if CONFIG_OPENTHREAD_ENABLED
+/* The OpenThread port queues have no depth accessor either. The OpenThread task holds the
+ * stack lock while it processes them, so the wait for that lock tracks their backlog. */
+static uint32_t app_watermark_openthread_wait()
+{
+    int64_t start = esp_timer_get_time();
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(CONFIG_APP_WATERMARK_SAMPLE_MS))) {
+        return CONFIG_APP_WATERMARK_SAMPLE_MS * 1000;
+    }
+    uint32_t wait = (uint32_t)(esp_timer_get_time() - start);
+    esp_openthread_lock_release();
+    return wait;
+}
+#endif
+
+static void app_watermark_heap(uint32_t caps, uint32_t *free_bytes, uint32_t *largest)
+{
+    if (heap_caps_get_total_size(caps) == 0) {
+        return;
+    }
+    *free_bytes = heap_caps_get_free_size(caps);
+    *largest = heap_caps_get_largest_free_block(caps);
+}
+
+static void app_watermark_collect(uint32_t *values, int64_t now)
+{
+    for (int i = 0; i < WATERMARK_METRIC_MAX; i++) {
+        values[i] = WATERMARK_ABSENT;
+    }
+    app_watermark_heap(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, &values[WATERMARK_HEAP_INTERNAL_FREE],
+                       &values[WATERMARK_HEAP_INTERNAL_LARGEST]);
+    values[WATERMARK_HEAP_INTERNAL_MIN_FREE] = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    app_watermark_heap(MALLOC_CAP_DMA, &values[WATERMARK_HEAP_DMA_FREE], &values[WATERMARK_HEAP_DMA_LARGEST]);
+    app_watermark_heap(MALLOC_CAP_SPIRAM, &values[WATERMARK_HEAP_SPIRAM_FREE], &values[WATERMARK_HEAP_SPIRAM_LARGEST]);
+
+    /* Looked up on every sample: BLE and the IMU tasks come and go */
+    for (size_t i = 0; i < sizeof(k_watermark_tasks) / sizeof(k_watermark_tasks[0]); i++) {
+        TaskHandle_t task = xTaskGetHandle(k_watermark_tasks[i].task_name);
+        if (task) {
+            values[k_watermark_tasks[i].metric] = uxTaskGetStackHighWaterMark(task);
+        }
+    }
+
+    app_contact_queue_stats_t queue;
+    app_driver_contact_get_queue_stats(&queue);
+    values[WATERMARK_QUEUE_CONTACT] = queue.depth;
+    values[WATERMARK_QUEUE_MATTER_DELAY_US] = app_watermark_matter_delay(now);
+#if CONFIG_OPENTHREAD_ENABLED
+    values[WATERMARK_QUEUE_OPENTHREAD_WAIT_US] = app_watermark_openthread_wait();
+#endif
+}
+
+/* One record per metric seen in the slot, in metric units */
+static void app_watermark_export(const watermark_slot_t *slot)
+{
+    for (int i = 0; i < WATERMARK_METRIC_MAX; i++) {
+        if (slot->seen & (1u << i)) {
+            app_telemetry_watermark(i, watermark_value((watermark_metric_t)i, slot->min[i]),
+                                    watermark_value((watermark_metric_t)i, slot->max[i]));
+        }
+    }
+    s_watermark_exported++;
+}
+
+static void app_watermark_task(void *arg)
+{
+    TickType_t wake = xTaskGetTickCount();
+    while (true) {
+        int64_t now = esp_timer_get_time();
+        uint32_t values[WATERMARK_METRIC_MAX];
+        app_watermark_collect(values, now);
+
+        watermark_slot_t closed;
+        portENTER_CRITICAL(&s_watermark_lock);
+        bool rolled = watermark_sample(&s_watermark, (uint32_t)(now / 1000), values, &closed);
+        s_watermark_samples++;
+        portEXIT_CRITICAL(&s_watermark_lock);
+        if (rolled) {
+            app_watermark_export(&closed);
+            uint32_t min_free = watermark_value(WATERMARK_HEAP_INTERNAL_FREE, closed.min[WATERMARK_HEAP_INTERNAL_FREE]);
+            if (min_free < CONFIG_APP_WATERMARK_HEAP_WARN_BYTES) {
+                APP_LOGW(TAG, "Internal heap down to %" PRIu32 " bytes free", min_free);
+            }
+        }
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(CONFIG_APP_WATERMARK_SAMPLE_MS));
+    }
+}
+
+esp_err_t app_watermark_init()
+{
+    watermark_init(&s_watermark, s_watermark_slots, CONFIG_APP_WATERMARK_SLOTS,
+                   CONFIG_APP_WATERMARK_SLOT_SEC * 1000, (uint32_t)(esp_timer_get_time() / 1000));
+    if (xTaskCreatePinnedToCore(app_watermark_task, "watermark", APP_WATERMARK_STACK_SIZE, NULL,
+                                CONFIG_APP_BACKGROUND_TASK_PRIORITY, &s_watermark_task, APP_NETWORK_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Sampling %d metrics every %d ms, %d slots of %d s", WATERMARK_METRIC_MAX,
+             CONFIG_APP_WATERMARK_SAMPLE_MS, CONFIG_APP_WATERMARK_SLOTS, CONFIG_APP_WATERMARK_SLOT_SEC);
+    return ESP_OK;
+}
+
+bool app_watermark_get(uint8_t metric, app_watermark_metric_t *out)
+{
+    if (!s_watermark_task || metric >= WATERMARK_METRIC_MAX) {
+        return false;
+    }
+    watermark_slot_t window;
+    portENTER_CRITICAL(&s_watermark_lock);
+    watermark_window(&s_watermark, &window);
+    uint16_t last = s_watermark.last[metric];
+    bool present = s_watermark.last_seen & (1u << metric);
+    uint16_t total_min = s_watermark.total.min[metric];
+    uint16_t total_max = s_watermark.total.max[metric];
+    bool seen = s_watermark.total.seen & (1u << metric);
+    portEXIT_CRITICAL(&s_watermark_lock);
+    if (!seen) {
+        return false;
+    }
+
+    watermark_metric_t m = (watermark_metric_t)metric;
+    out->present = present;
+    out->last = watermark_value(m, last);
+    out->window_seen = window.seen & (1u << metric);
+    out->window_min = watermark_value(m, window.min[metric]);
+    out->window_max = watermark_value(m, window.max[metric]);
+    out->total_min = watermark_value(m, total_min);
+    out->total_max = watermark_value(m, total_max);
+    return true;
+}
+
+void app_watermark_get_stats(app_watermark_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_watermark_lock);
+    stats->samples = s_watermark_samples;
+    stats->slots = s_watermark.closed + 1;
+    portEXIT_CRITICAL(&s_watermark_lock);
+    stats->slot_sec = CONFIG_APP_WATERMARK_SLOT_SEC;
+    stats->exported = s_watermark_exported;
+}
+#else
+esp_err_t app_watermark_init()
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+bool app_watermark_get(uint8_t metric, app_watermark_metric_t *out)
+{
+    return false;
+}
+
+void app_watermark_get_stats(app_watermark_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+#endif // CONFIG_APP_WATERMARK_ENABLE
@@ -0,0 +1,109 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <atomic>
+
+#include "boot_trace.h"
+
+/* Stored inverted so that a zeroed slot means "not reached"; 32 bits of microseconds
+ * cover the first 71 minutes after boot */
+static std::atomic<uint32_t> s_marks[BOOT_PHASE_MAX];
+
+static const char *const k_phase_names[BOOT_PHASE_MAX] = {
+    "startup",
+    "contact-latch",
+    "nvs",
+    "drivers",
+    "node-create",
+    "matter-start",
+    "first-report",
+    "network-attach",
+};
+
+/* Phase each one starts after, BOOT_PHASE_MAX for the first one */
+static const boot_phase_t k_phase_after[BOOT_PHASE_MAX] = {
+    BOOT_PHASE_MAX,
+    BOOT_PHASE_STARTUP,
+    BOOT_PHASE_CONTACT_LATCH,
+    BOOT_PHASE_NVS,
+    BOOT_PHASE_DRIVERS,
+    BOOT_PHASE_NODE_CREATE,
+    BOOT_PHASE_MATTER_START,
+    BOOT_PHASE_MATTER_START,
+};
+
+void boot_trace_mark(boot_phase_t phase, int64_t now_us)
+{
+    if (phase >= BOOT_PHASE_MAX || now_us < 0) {
+        return;
+    }
+    uint32_t us = now_us >= UINT32_MAX ? UINT32_MAX - 1 : (uint32_t)now_us;
+    uint32_t unset = 0;
+    s_marks[phase].compare_exchange_strong(unset, ~us, std::memory_order_relaxed);
+}
+
+bool boot_trace_reached(boot_phase_t phase)
+{
+    return phase < BOOT_PHASE_MAX && s_marks[phase].load(std::memory_order_relaxed) != 0;
+}
+
+int64_t boot_trace_end(boot_phase_t phase)
+{
+    if (!boot_trace_reached(phase)) {
+        return -1;
+    }
+    return ~s_marks[phase].load(std::memory_order_relaxed);
+}
+
+int64_t boot_trace_start(boot_phase_t phase)
+{
+    if (phase >= BOOT_PHASE_MAX) {
+        return -1;
+    }
+    boot_phase_t after = k_phase_after[phase];
+    return after == BOOT_PHASE_MAX ? 0 : boot_trace_end(after);
+}
+
+int64_t boot_trace_duration(boot_phase_t phase)
+{
+    int64_t start = boot_trace_start(phase);
+    int64_t end = boot_trace_end(phase);
+    if (start < 0 || end < 0) {
+        return -1;
+    }
+    /* A phase marked out of order (e.g. a failed step retried later) shows as 0 */
+    return end > start ? end - start : 0;
+}
+
+size_t boot_trace_summary(char *buf, size_t len)
+{
+    size_t used = 0;
+    if (len > 0) {
+        buf[0] = '\0';
+    }
+    for (int phase = 0; phase < BOOT_PHASE_MAX; phase++) {
+        int64_t duration = boot_trace_duration((boot_phase_t)phase);
+        if (duration < 0) {
+            continue;
+        }
+        int n = snprintf(used < len ? buf + used : NULL, used < len ? len - used : 0, "%s%s %" PRId64 " us",
+                         used ? ", " : "", k_phase_names[phase], duration);
+        if (n > 0) {
+            used += n;
+        }
+    }
+    return used;
+}
+
+const char *boot_trace_phase_name(boot_phase_t phase)
+{
+    return phase < BOOT_PHASE_MAX ? k_phase_names[phase] : "unknown";
+}
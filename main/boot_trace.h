@@ -0,0 +1,67 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Boot phase timings.
+ *
+ * The startup sequence marks the end of each phase with an esp_timer timestamp (time since
+ * the timer started, early in the second stage of startup; ROM and bootloader time is not
+ * included). Each phase is marked once, later marks are ignored. Marks come from app_main
+ * and the Matter thread and are single relaxed stores, reads can happen from any task.
+ */
+
+typedef enum {
+    BOOT_PHASE_STARTUP = 0,     /* esp_timer start -> app_main() entry */
+    BOOT_PHASE_CONTACT_LATCH,   /* contact levels latched, edge interrupts enabled */
+    BOOT_PHASE_NVS,             /* nvs_flash_init() */
+    BOOT_PHASE_DRIVERS,         /* logging, power, telemetry, event log, light and button drivers */
+    BOOT_PHASE_NODE_CREATE,     /* Matter node and endpoints created */
+    BOOT_PHASE_MATTER_START,    /* esp_matter::start() returned */
+    BOOT_PHASE_FIRST_REPORT,    /* contact states published on the Matter thread, reporting enabled */
+    BOOT_PHASE_NETWORK_ATTACH,  /* Thread (or Wi-Fi) connectivity established */
+    BOOT_PHASE_MAX,
+} boot_phase_t;
+
+/** Mark the end of a phase
+ *
+ * @param[in] phase Phase that just completed.
+ * @param[in] now_us Timestamp, in microseconds.
+ */
+void boot_trace_mark(boot_phase_t phase, int64_t now_us);
+
+/** Whether a phase has been marked */
+bool boot_trace_reached(boot_phase_t phase);
+
+/** End timestamp of a phase, -1 if not reached */
+int64_t boot_trace_end(boot_phase_t phase);
+
+/** Duration of a phase, from the end of the phase it follows; -1 if either is not reached
+ *
+ * Phases run one after the other, except the network attach which runs in the background
+ * from the end of esp_matter::start().
+ */
+int64_t boot_trace_duration(boot_phase_t phase);
+
+/** Start of a phase: end of the phase it follows, 0 for the first one; -1 if not reached */
+int64_t boot_trace_start(boot_phase_t phase);
+
+/** One line summary of the phases reached so far
+ *
+ * @param[out] buf Output buffer, always NUL terminated.
+ * @param[in] len Size of the buffer.
+ *
+ * @return length of the summary, without the truncation.
+ */
+size_t boot_trace_summary(char *buf, size_t len);
+
+const char *boot_trace_phase_name(boot_phase_t phase);
@@ -0,0 +1,72 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "contact_debounce.h"
+
+void contact_debounce_init(contact_debounce_t *db, const contact_debounce_config_t *config, bool level)
+{
+    memset(db, 0, sizeof(*db));
+    db->config = *config;
+    db->state = CONTACT_DEBOUNCE_STABLE;
+    db->stable_level = level;
+    db->edge_level = level;
+}
+
+uint8_t contact_debounce_on_edge(contact_debounce_t *db, int64_t now_us, bool level)
+{
+    db->edges++;
+    db->last_edge_us = now_us;
+    if (db->state != CONTACT_DEBOUNCE_STABLE) {
+        /* The timer is already armed, it re-arms itself until the input goes quiet */
+        return CONTACT_DEBOUNCE_NONE;
+    }
+
+    db->first_edge_us = now_us;
+    if (db->config.leading_edge && level != db->stable_level) {
+        /* Hand the report to the timer context right away */
+        db->edge_level = level;
+        db->state = CONTACT_DEBOUNCE_LEADING;
+        db->deadline_us = now_us;
+    } else {
+        db->state = CONTACT_DEBOUNCE_SETTLING;
+        db->deadline_us = now_us + db->config.settle_us;
+    }
+    return CONTACT_DEBOUNCE_ARM;
+}
+
+uint8_t contact_debounce_on_timer(contact_debounce_t *db, int64_t now_us, bool level)
+{
+    switch (db->state) {
+    case CONTACT_DEBOUNCE_LEADING:
+        db->stable_level = db->edge_level;
+        db->reports++;
+        db->state = CONTACT_DEBOUNCE_SETTLING;
+        db->deadline_us = db->last_edge_us + db->config.settle_us;
+        return CONTACT_DEBOUNCE_REPORT | CONTACT_DEBOUNCE_ARM;
+
+    case CONTACT_DEBOUNCE_SETTLING:
+        if (now_us - db->last_edge_us < (int64_t)db->config.settle_us) {
+            db->deadline_us = db->last_edge_us + db->config.settle_us;
+            return CONTACT_DEBOUNCE_ARM;
+        }
+        db->state = CONTACT_DEBOUNCE_STABLE;
+        if (level != db->stable_level) {
+            db->stable_level = level;
+            db->reports++;
+            return CONTACT_DEBOUNCE_REPORT;
+        }
+        return CONTACT_DEBOUNCE_NONE;
+
+    case CONTACT_DEBOUNCE_STABLE:
+    default:
+        /* Stale expiry, e.g. the timer was re-armed right before it fired */
+        return CONTACT_DEBOUNCE_NONE;
+    }
+}
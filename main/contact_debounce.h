@@ -0,0 +1,82 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Debounce state machine for a single contact input.
+ *
+ * This module has no dependency on ESP-IDF: the caller feeds it edge timestamps and
+ * sampled levels and it answers with what to do next (arm the settle timer and/or
+ * report a new stable level). On target the edges come from a GPIO interrupt and the
+ * timer is an esp_timer; on the host they can come from a recorded edge trace.
+ */
+
+/** Returned by the event functions, OR-ed together */
+#define CONTACT_DEBOUNCE_NONE   0x00
+#define CONTACT_DEBOUNCE_REPORT 0x01 /* `stable_level` changed and should be reported */
+#define CONTACT_DEBOUNCE_ARM    0x02 /* (re)arm the settle timer to fire at `deadline_us` */
+
+typedef enum {
+    CONTACT_DEBOUNCE_STABLE = 0, /* no edge pending, timer idle */
+    CONTACT_DEBOUNCE_LEADING,    /* first edge seen in leading-edge mode, report pending */
+    CONTACT_DEBOUNCE_SETTLING,   /* waiting for `settle_us` of quiet time */
+} contact_debounce_state_t;
+
+typedef struct {
+    /** Quiet time the input has to hold before its level is trusted */
+    uint32_t settle_us;
+    /** Report the first edge out of a stable state immediately and only use the settle
+     * window to filter the bounce that follows (and correct it if the input went back). */
+    bool leading_edge;
+} contact_debounce_config_t;
+
+typedef struct {
+    contact_debounce_config_t config;
+    contact_debounce_state_t state;
+    bool stable_level;     /* last reported level */
+    bool edge_level;       /* level sampled on the first edge (leading-edge mode) */
+    int64_t first_edge_us; /* edge that took the input out of its stable state */
+    int64_t last_edge_us;
+    int64_t deadline_us;   /* valid when CONTACT_DEBOUNCE_ARM is returned */
+    uint32_t edges;        /* edges seen since init, bounce included */
+    uint32_t reports;      /* stable level changes reported since init */
+} contact_debounce_t;
+
+/** Initialize the state machine
+ *
+ * @param[out] db State machine to initialize.
+ * @param[in] config Debounce configuration.
+ * @param[in] level Current input level, taken as the initial stable level.
+ */
+void contact_debounce_init(contact_debounce_t *db, const contact_debounce_config_t *config, bool level);
+
+/** Feed an input edge
+ *
+ * Must be serialized with `contact_debounce_on_timer()` for the same input.
+ *
+ * @param[in] db State machine.
+ * @param[in] now_us Timestamp of the edge.
+ * @param[in] level Input level sampled right after the edge.
+ *
+ * @return CONTACT_DEBOUNCE_* flags.
+ */
+uint8_t contact_debounce_on_edge(contact_debounce_t *db, int64_t now_us, bool level);
+
+/** Feed a settle timer expiry
+ *
+ * @param[in] db State machine.
+ * @param[in] now_us Timestamp of the expiry.
+ * @param[in] level Input level sampled at the expiry.
+ *
+ * @return CONTACT_DEBOUNCE_* flags.
+ */
+uint8_t contact_debounce_on_timer(contact_debounce_t *db, int64_t now_us, bool level);
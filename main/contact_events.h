@@ -0,0 +1,96 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "spsc_ring.h"
+
+/*
+ * Contact events travel from the sensor edge context to the Matter thread through an
+ * spsc_ring. The consumer drains the ring in batches and merges the events of each
+ * channel, so a burst of transitions costs one report: the final state plus a count.
+ */
+
+/** One debounced contact transition */
+typedef struct {
+    uint16_t channel;
+    bool closed;
+    int64_t edge_us;      /* interrupt that started the transition */
+    int64_t timestamp_us; /* debounced level confirmed */
+} contact_event_t;
+
+/** Per-channel result of a drain */
+typedef struct {
+    bool pending;         /* at least one event was merged */
+    bool closed;          /* state of the last merged event */
+    uint16_t transitions; /* events merged into this report */
+    int64_t first_us;     /* timestamp of the first merged event */
+    int64_t last_us;      /* timestamp of the last merged event */
+    int64_t last_edge_us; /* edge timestamp of the last merged event */
+} contact_pending_t;
+
+/** Consumer side counters */
+typedef struct {
+    uint32_t batches;   /* drains that found at least one event */
+    uint32_t events;    /* events popped */
+    uint32_t coalesced; /* events merged into a report of the same channel */
+} contact_drain_stats_t;
+
+static inline void contact_event_merge(contact_pending_t *slot, const contact_event_t *event)
+{
+    if (!slot->pending) {
+        slot->pending = true;
+        slot->transitions = 0;
+        slot->first_us = event->timestamp_us;
+    }
+    slot->closed = event->closed;
+    slot->last_us = event->timestamp_us;
+    slot->last_edge_us = event->edge_us;
+    if (slot->transitions < UINT16_MAX) {
+        slot->transitions++;
+    }
+}
+
+/** Drain up to `max_batch` events and merge them per channel
+ *
+ * Events for channels outside `[0, channel_count)` are discarded.
+ *
+ * @param[in] ring Ring to drain (consumer side).
+ * @param[in,out] pending Per-channel slots, `pending` must be cleared by the caller once reported.
+ * @param[in] channel_count Number of slots.
+ * @param[in] max_batch Maximum number of events to pop.
+ * @param[in,out] stats Consumer counters.
+ *
+ * @return Number of events popped.
+ */
+template <size_t N>
+size_t contact_events_drain(spsc_ring<contact_event_t, N> *ring, contact_pending_t *pending, size_t channel_count,
+                            size_t max_batch, contact_drain_stats_t *stats)
+{
+    size_t count = 0;
+    contact_event_t event;
+    while (count < max_batch && ring->pop(&event)) {
+        count++;
+        if (event.channel >= channel_count) {
+            continue;
+        }
+        contact_pending_t *slot = &pending[event.channel];
+        if (slot->pending) {
+            stats->coalesced++;
+        }
+        contact_event_merge(slot, &event);
+    }
+    if (count > 0) {
+        stats->batches++;
+        stats->events += count;
+    }
+    return count;
+}
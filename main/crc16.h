@@ -0,0 +1,29 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Feed `len` bytes into a running CRC-16/CCITT-FALSE (poly 0x1021), bitwise to stay out of .rodata */
+static inline uint16_t crc16_ccitt_update(uint16_t crc, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static inline uint16_t crc16_ccitt(const uint8_t *data, size_t len)
+{
+    return crc16_ccitt_update(0xFFFF, data, len);
+}
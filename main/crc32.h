@@ -0,0 +1,32 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Feed `len` bytes into a running CRC-32 (IEEE 802.3, reflected poly 0xEDB88320), start from 0
+ *
+ * A nibble at a time from a 16 entry table: whole firmware images go through it, the bitwise
+ * loop of crc16.h would take seconds there.
+ */
+static inline uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    static const uint32_t k_nibble[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ k_nibble[crc & 0x0F];
+        crc = (crc >> 4) ^ k_nibble[crc & 0x0F];
+    }
+    return ~crc;
+}
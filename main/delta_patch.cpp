@@ -0,0 +1,308 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "crc32.h"
+#include "delta_patch.h"
+
+enum {
+    LZ_FLAGS,
+    LZ_ITEM,
+    LZ_TOKEN_HI,
+    LZ_LENGTH,
+};
+
+enum {
+    OP_CODE,
+    OP_LEN,
+    OP_SEEK,
+    OP_DATA,
+};
+
+static inline void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool delta_patch_is_patch(const uint8_t *data, size_t len)
+{
+    return len >= 4 && get_le32(data) == DELTA_PATCH_MAGIC;
+}
+
+void delta_patch_header_write(const delta_patch_header_t *header, uint8_t *data)
+{
+    put_le32(data, DELTA_PATCH_MAGIC);
+    data[4] = DELTA_PATCH_VERSION;
+    data[5] = header->window_bits;
+    data[6] = 0;
+    data[7] = 0;
+    put_le32(data + 8, header->source_size);
+    put_le32(data + 12, header->source_crc);
+    put_le32(data + 16, header->target_size);
+    put_le32(data + 20, header->target_crc);
+    put_le32(data + 24, header->body_size);
+    put_le32(data + 28, crc32_update(0, data, 28));
+}
+
+int delta_patch_header_parse(const uint8_t *data, delta_patch_header_t *header)
+{
+    if (!delta_patch_is_patch(data, DELTA_PATCH_HEADER_SIZE) || data[4] != DELTA_PATCH_VERSION ||
+        get_le32(data + 28) != crc32_update(0, data, 28)) {
+        return DELTA_PATCH_ERR_FORMAT;
+    }
+    header->window_bits = data[5];
+    header->source_size = get_le32(data + 8);
+    header->source_crc = get_le32(data + 12);
+    header->target_size = get_le32(data + 16);
+    header->target_crc = get_le32(data + 20);
+    header->body_size = get_le32(data + 24);
+    if (header->window_bits < DELTA_PATCH_MIN_WINDOW_BITS || header->window_bits > DELTA_PATCH_MAX_WINDOW_BITS) {
+        return DELTA_PATCH_ERR_FORMAT;
+    }
+    return DELTA_PATCH_OK;
+}
+
+int delta_patch_init(delta_patch_t *dp, const delta_patch_header_t *header, const delta_patch_io_t *io,
+                     const delta_patch_buffers_t *buffers)
+{
+    memset(dp, 0, sizeof(*dp));
+    if (header->window_bits > buffers->window_bits || buffers->source_cache_size == 0 || buffers->out_size == 0) {
+        dp->error = DELTA_PATCH_ERR_WINDOW;
+        return dp->error;
+    }
+    dp->header = *header;
+    dp->io = *io;
+    dp->buffers = *buffers;
+    dp->window_mask = (1u << header->window_bits) - 1;
+    dp->len_bits = 16 - header->window_bits;
+    dp->lz_state = LZ_FLAGS;
+    dp->op_state = OP_CODE;
+    return DELTA_PATCH_OK;
+}
+
+static bool delta_patch_flush(delta_patch_t *dp)
+{
+    if (dp->out_len == 0) {
+        return true;
+    }
+    dp->crc = crc32_update(dp->crc, dp->buffers.out, dp->out_len);
+    if (dp->io.write_target(dp->io.ctx, dp->buffers.out, dp->out_len) != 0) {
+        dp->error = DELTA_PATCH_ERR_IO;
+        return false;
+    }
+    dp->written += dp->out_len;
+    dp->out_len = 0;
+    return true;
+}
+
+static inline void delta_patch_out(delta_patch_t *dp, uint8_t byte)
+{
+    if (dp->written + dp->out_len >= dp->header.target_size) {
+        dp->error = DELTA_PATCH_ERR_TARGET;
+        return;
+    }
+    dp->buffers.out[dp->out_len++] = byte;
+    if (dp->out_len == dp->buffers.out_size) {
+        delta_patch_flush(dp);
+    }
+}
+
+static inline bool delta_patch_source(delta_patch_t *dp, uint8_t *byte)
+{
+    uint32_t pos = dp->source_pos;
+    if (pos >= dp->header.source_size) {
+        dp->error = DELTA_PATCH_ERR_FORMAT;
+        return false;
+    }
+    if (pos - dp->cache_offset >= dp->cache_len) {
+        size_t len = dp->header.source_size - pos;
+        if (len > dp->buffers.source_cache_size) {
+            len = dp->buffers.source_cache_size;
+        }
+        if (dp->io.read_source(dp->io.ctx, pos, dp->buffers.source_cache, len) != 0) {
+            dp->error = DELTA_PATCH_ERR_IO;
+            return false;
+        }
+        dp->cache_offset = pos;
+        dp->cache_len = len;
+        dp->source_reads++;
+    }
+    *byte = dp->buffers.source_cache[pos - dp->cache_offset];
+    dp->source_pos = pos + 1;
+    return true;
+}
+
+/* LEB128, true once the last byte is in */
+static inline bool delta_patch_varint(delta_patch_t *dp, uint8_t byte)
+{
+    if (dp->varint_shift > 28) {
+        dp->error = DELTA_PATCH_ERR_FORMAT;
+        return false;
+    }
+    dp->varint |= (uint32_t)(byte & 0x7F) << dp->varint_shift;
+    dp->varint_shift += 7;
+    return !(byte & 0x80);
+}
+
+/* One decompressed byte through the operation stage */
+static inline void delta_patch_op_byte(delta_patch_t *dp, uint8_t byte)
+{
+    switch (dp->op_state) {
+    case OP_CODE:
+        if (dp->ended || byte > DELTA_OP_INSERT) {
+            dp->error = DELTA_PATCH_ERR_FORMAT;
+            return;
+        }
+        if (byte == DELTA_OP_END) {
+            dp->ended = true;
+            return;
+        }
+        dp->op = byte;
+        dp->varint = 0;
+        dp->varint_shift = 0;
+        dp->op_state = OP_LEN;
+        break;
+    case OP_LEN:
+        if (!delta_patch_varint(dp, byte)) {
+            break;
+        }
+        dp->op_len = dp->varint;
+        dp->varint = 0;
+        dp->varint_shift = 0;
+        if (dp->op == DELTA_OP_DIFF) {
+            dp->op_state = OP_SEEK;
+        } else {
+            dp->op_state = dp->op_len ? OP_DATA : OP_CODE;
+        }
+        break;
+    case OP_SEEK:
+        if (!delta_patch_varint(dp, byte)) {
+            break;
+        }
+        /* zigzag */
+        dp->source_pos += (dp->varint >> 1) ^ (0u - (dp->varint & 1));
+        dp->op_state = dp->op_len ? OP_DATA : OP_CODE;
+        break;
+    case OP_DATA:
+        if (dp->op == DELTA_OP_DIFF) {
+            uint8_t source;
+            if (!delta_patch_source(dp, &source)) {
+                return;
+            }
+            byte += source;
+        }
+        delta_patch_out(dp, byte);
+        if (--dp->op_len == 0) {
+            dp->op_state = OP_CODE;
+        }
+        break;
+    }
+}
+
+static inline void delta_patch_emit(delta_patch_t *dp, uint8_t byte)
+{
+    dp->buffers.window[dp->window_pos & dp->window_mask] = byte;
+    dp->window_pos++;
+    delta_patch_op_byte(dp, byte);
+}
+
+static void delta_patch_copy(delta_patch_t *dp, uint32_t length)
+{
+    uint32_t distance = (dp->token >> dp->len_bits) + 1;
+    if (distance > dp->window_pos) {
+        dp->error = DELTA_PATCH_ERR_FORMAT;
+        return;
+    }
+    for (uint32_t i = 0; i < length && dp->error == DELTA_PATCH_OK; i++) {
+        delta_patch_emit(dp, dp->buffers.window[(dp->window_pos - distance) & dp->window_mask]);
+    }
+}
+
+int delta_patch_feed(delta_patch_t *dp, const uint8_t *data, size_t len)
+{
+    if (dp->error != DELTA_PATCH_OK) {
+        return dp->error;
+    }
+    if (len > dp->header.body_size - dp->body_read) {
+        dp->error = DELTA_PATCH_ERR_FORMAT;
+        return dp->error;
+    }
+    dp->body_read += len;
+
+    uint16_t len_max = (uint16_t)((1u << dp->len_bits) - 1);
+    for (size_t i = 0; i < len && dp->error == DELTA_PATCH_OK; i++) {
+        uint8_t byte = data[i];
+        switch (dp->lz_state) {
+        case LZ_FLAGS:
+            dp->flags = byte;
+            dp->flag_count = 8;
+            dp->lz_state = LZ_ITEM;
+            break;
+        case LZ_ITEM:
+            if (dp->flags & 1) {
+                delta_patch_emit(dp, byte);
+            } else {
+                dp->token = byte;
+                dp->lz_state = LZ_TOKEN_HI;
+                break;
+            }
+            dp->flags >>= 1;
+            if (--dp->flag_count == 0) {
+                dp->lz_state = LZ_FLAGS;
+            }
+            break;
+        case LZ_TOKEN_HI:
+        case LZ_LENGTH: {
+            uint32_t length;
+            if (dp->lz_state == LZ_TOKEN_HI) {
+                dp->token |= (uint16_t)byte << 8;
+                uint16_t code = dp->token & len_max;
+                if (code == len_max) {
+                    dp->lz_state = LZ_LENGTH;
+                    break;
+                }
+                length = code + DELTA_PATCH_MIN_MATCH;
+            } else {
+                length = len_max + DELTA_PATCH_MIN_MATCH + byte;
+            }
+            delta_patch_copy(dp, length);
+            dp->flags >>= 1;
+            dp->lz_state = --dp->flag_count == 0 ? LZ_FLAGS : LZ_ITEM;
+            break;
+        }
+        }
+    }
+    return dp->error;
+}
+
+int delta_patch_finish(delta_patch_t *dp)
+{
+    if (dp->error != DELTA_PATCH_OK) {
+        return dp->error;
+    }
+    if (!dp->ended || dp->body_read != dp->header.body_size) {
+        dp->error = DELTA_PATCH_ERR_FORMAT;
+        return dp->error;
+    }
+    if (!delta_patch_flush(dp)) {
+        return dp->error;
+    }
+    if (dp->written != dp->header.target_size || dp->crc != dp->header.target_crc) {
+        dp->error = DELTA_PATCH_ERR_TARGET;
+    }
+    return dp->error;
+}
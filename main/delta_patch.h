@@ -0,0 +1,165 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Delta firmware images: a patch rebuilds the new image from the one running, so an update
+ * only carries what changed. Generated on the host by tools/delta_ota.
+ *
+ * A patch is a fixed header followed by a compressed body:
+ *
+ *     magic(4) version(1) window_bits(1) reserved(2) source_size(4) source_crc(4)
+ *     target_size(4) target_crc(4) body_size(4) header_crc(4)
+ *
+ * The body is an LZSS stream (one flag byte per 8 items; literal byte, or a 16-bit match
+ * token with the distance in its top `window_bits` bits and the length in the others, an
+ * all-ones length taking one more byte). Decompressed, it is a list of operations:
+ *
+ *     DIFF    len seek byte[len]  target = source[pos + seek...] + byte, pos moves past it
+ *     INSERT  len byte[len]       target = byte
+ *     END
+ *
+ * with LEB128 lengths and a zigzag LEB128 seek. As in bsdiff, code that moved keeps its
+ * alignment in DIFF runs, and the addresses that changed inside it leave mostly zero bytes
+ * that the LZSS stage compresses away.
+ *
+ * The applier is a byte-at-a-time state machine fed the body in arbitrary chunks (BDX
+ * blocks), with fixed RAM: the LZSS window, a source read cache and an output buffer, all
+ * owned by the caller. Source reads and target writes go through `delta_patch_io_t`, flash
+ * partitions on target, files or memory on the host.
+ */
+
+#define DELTA_PATCH_MAGIC 0x31544C44 /* "DLT1", a firmware image starts with 0xE9 */
+#define DELTA_PATCH_VERSION 1
+#define DELTA_PATCH_HEADER_SIZE 32
+#define DELTA_PATCH_MIN_WINDOW_BITS 8
+#define DELTA_PATCH_MAX_WINDOW_BITS 14
+#define DELTA_PATCH_MIN_MATCH 3
+
+/* Decompressed operation codes */
+#define DELTA_OP_END 0
+#define DELTA_OP_DIFF 1
+#define DELTA_OP_INSERT 2
+
+#define DELTA_PATCH_OK 0
+#define DELTA_PATCH_ERR_FORMAT -1 /* bad header, corrupt body or a read past the source */
+#define DELTA_PATCH_ERR_WINDOW -2 /* the patch needs a larger LZSS window */
+#define DELTA_PATCH_ERR_IO -3
+#define DELTA_PATCH_ERR_TARGET -4 /* rebuilt image size or CRC differs from the header */
+
+typedef struct {
+    uint8_t window_bits;
+    uint32_t source_size;
+    uint32_t source_crc; /* crc32.h */
+    uint32_t target_size;
+    uint32_t target_crc;
+    uint32_t body_size;
+} delta_patch_header_t;
+
+/** Source and target access, both return 0 on success */
+typedef struct {
+    int (*read_source)(void *ctx, uint32_t offset, uint8_t *dst, size_t len);
+    int (*write_target)(void *ctx, const uint8_t *src, size_t len);
+    void *ctx;
+} delta_patch_io_t;
+
+/** Buffers owned by the caller */
+typedef struct {
+    uint8_t *window;       /* 1 << window_bits bytes, at least that of the patch */
+    uint8_t window_bits;
+    uint8_t *source_cache;
+    size_t source_cache_size;
+    uint8_t *out;          /* target bytes are written in chunks of this size */
+    size_t out_size;
+} delta_patch_buffers_t;
+
+typedef struct {
+    delta_patch_header_t header;
+    delta_patch_io_t io;
+    delta_patch_buffers_t buffers;
+    int error;
+
+    /* LZSS stage */
+    uint32_t window_mask;
+    uint32_t window_pos;
+    uint8_t len_bits;
+    uint8_t flags;
+    uint8_t flag_count;    /* items left under `flags` */
+    uint8_t lz_state;
+    uint16_t token;
+
+    /* Operation stage */
+    uint8_t op_state;
+    uint8_t op;
+    uint32_t varint;
+    uint8_t varint_shift;
+    uint32_t op_len;
+    uint32_t source_pos;
+    uint32_t cache_offset;
+    size_t cache_len;
+    size_t out_len;
+
+    /* Progress */
+    uint32_t body_read;
+    uint32_t written;
+    uint32_t crc;
+    bool ended;
+    uint32_t source_reads;
+} delta_patch_t;
+
+/** Check the first bytes of an image for the patch magic */
+bool delta_patch_is_patch(const uint8_t *data, size_t len);
+
+/** Parse a patch header
+ *
+ * @param[in] data First DELTA_PATCH_HEADER_SIZE bytes of the patch.
+ * @param[out] header Parsed header.
+ *
+ * @return DELTA_PATCH_OK, or DELTA_PATCH_ERR_FORMAT on a bad magic, version or CRC.
+ */
+int delta_patch_header_parse(const uint8_t *data, delta_patch_header_t *header);
+
+/** Serialize a patch header, header CRC included
+ *
+ * @param[in] header Header.
+ * @param[out] data DELTA_PATCH_HEADER_SIZE bytes.
+ */
+void delta_patch_header_write(const delta_patch_header_t *header, uint8_t *data);
+
+/** Start applying a patch
+ *
+ * @param[out] dp Applier state.
+ * @param[in] header Parsed header of the patch.
+ * @param[in] io Source and target access.
+ * @param[in] buffers Window, source cache and output buffer.
+ *
+ * @return DELTA_PATCH_OK, DELTA_PATCH_ERR_WINDOW if `buffers` has a smaller window than the patch.
+ */
+int delta_patch_init(delta_patch_t *dp, const delta_patch_header_t *header, const delta_patch_io_t *io,
+                     const delta_patch_buffers_t *buffers);
+
+/** Feed body bytes, header excluded
+ *
+ * @param[in] dp Applier state.
+ * @param[in] data Next body bytes, any length.
+ * @param[in] len Length of `data`.
+ *
+ * @return DELTA_PATCH_OK, or the first error met; the applier stays in error from then on.
+ */
+int delta_patch_feed(delta_patch_t *dp, const uint8_t *data, size_t len);
+
+/** Flush the output and check the rebuilt image against the header
+ *
+ * @return DELTA_PATCH_OK if the whole body went through and the target matches.
+ */
+int delta_patch_finish(delta_patch_t *dp);
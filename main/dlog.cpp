@@ -0,0 +1,208 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "dlog.h"
+
+/* Cursor over the captured argument words */
+typedef struct {
+    const uint32_t *words;
+    size_t nwords;
+    size_t next;
+} dlog_args_t;
+
+static bool dlog_take(dlog_args_t *args, size_t count, uint64_t *value)
+{
+    if (args->next + count > args->nwords) {
+        args->next = args->nwords;
+        return false;
+    }
+    *value = args->words[args->next];
+    if (count == 2) {
+        *value |= (uint64_t)args->words[args->next + 1] << 32;
+    }
+    args->next += count;
+    return true;
+}
+
+static void dlog_append(char *out, size_t size, size_t *len, const char *src, size_t src_len)
+{
+    if (*len + 1 < size) {
+        size_t room = size - 1 - *len;
+        size_t n = src_len < room ? src_len : room;
+        memcpy(out + *len, src, n);
+        out[*len + n] = '\0';
+    }
+    *len += src_len;
+}
+
+size_t dlog_format(const dlog_abi_t *abi, const char *fmt, const uint32_t *words, size_t nwords,
+                   dlog_resolve_t resolve, void *ctx, char *out, size_t size)
+{
+    dlog_args_t args = { words, nwords, 0 };
+    size_t len = 0;
+    if (size > 0) {
+        out[0] = '\0';
+    }
+
+    const char *p = fmt;
+    while (*p) {
+        const char *start = p;
+        while (*p && *p != '%') {
+            p++;
+        }
+        dlog_append(out, size, &len, start, p - start);
+        if (!*p) {
+            break;
+        }
+
+        /* %[flags][width][.precision][length]conversion, `*` fields resolved to numbers */
+        char spec[48];
+        size_t spec_len = 0;
+        spec[spec_len++] = '%';
+        p++;
+        while (*p && strchr("-+ #0", *p) && spec_len < 8) {
+            spec[spec_len++] = *p++;
+        }
+        bool missing = false;
+        for (int field = 0; field < 2; field++) {
+            if (field == 1) {
+                if (*p != '.') {
+                    break;
+                }
+                spec[spec_len++] = *p++;
+            }
+            if (*p == '*') {
+                uint64_t value = 0;
+                missing |= !dlog_take(&args, 1, &value);
+                spec_len += snprintf(spec + spec_len, sizeof(spec) - spec_len, "%d", (int)(int32_t)value);
+                p++;
+            } else {
+                while (*p >= '0' && *p <= '9' && spec_len < 24) {
+                    spec[spec_len++] = *p++;
+                }
+            }
+        }
+
+        size_t arg_words = 1;
+        while (*p && strchr("hljztL", *p)) {
+            if (*p == 'l') {
+                arg_words = (p[1] == 'l') ? 2 : abi->long_words;
+                p += (p[1] == 'l') ? 2 : 1;
+            } else {
+                arg_words = (*p == 'j') ? 2 : (*p == 'z' || *p == 't') ? abi->ptr_words : arg_words;
+                p++;
+            }
+        }
+        char conv = *p;
+        if (!conv) {
+            break;
+        }
+        p++;
+
+        char text[64];
+        int n = 0;
+        uint64_t value = 0;
+        switch (conv) {
+        case '%':
+            n = snprintf(text, sizeof(text), "%%");
+            break;
+        case 'd':
+        case 'i':
+            if (missing || !dlog_take(&args, arg_words, &value)) {
+                n = snprintf(text, sizeof(text), "?");
+                break;
+            }
+            memcpy(spec + spec_len, "lld", 4);
+            n = snprintf(text, sizeof(text), spec,
+                         arg_words == 2 ? (long long)(int64_t)value : (long long)(int32_t)value);
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+        case 'c':
+            if (missing || !dlog_take(&args, arg_words, &value)) {
+                n = snprintf(text, sizeof(text), "?");
+                break;
+            }
+            if (conv == 'c') {
+                spec[spec_len] = 'c';
+                spec[spec_len + 1] = '\0';
+                n = snprintf(text, sizeof(text), spec, (int)(char)value);
+                break;
+            }
+            spec[spec_len] = 'l';
+            spec[spec_len + 1] = 'l';
+            spec[spec_len + 2] = conv;
+            spec[spec_len + 3] = '\0';
+            n = snprintf(text, sizeof(text), spec,
+                         arg_words == 2 ? (unsigned long long)value : (unsigned long long)(uint32_t)value);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A': {
+            if (missing || !dlog_take(&args, 2, &value)) {
+                n = snprintf(text, sizeof(text), "?");
+                break;
+            }
+            double d;
+            memcpy(&d, &value, sizeof(d));
+            spec[spec_len] = conv;
+            spec[spec_len + 1] = '\0';
+            n = snprintf(text, sizeof(text), spec, d);
+            break;
+        }
+        case 'p':
+            if (missing || !dlog_take(&args, abi->ptr_words, &value)) {
+                n = snprintf(text, sizeof(text), "?");
+                break;
+            }
+            n = snprintf(text, sizeof(text), "0x%" PRIx64, value);
+            break;
+        case 's': {
+            if (missing || !dlog_take(&args, abi->ptr_words, &value)) {
+                n = snprintf(text, sizeof(text), "?");
+                break;
+            }
+            const char *str = resolve ? resolve(value, ctx) : (const char *)(uintptr_t)value;
+            if (!str) {
+                n = snprintf(text, sizeof(text), value ? "<0x%" PRIx64 ">" : "(null)", value);
+                break;
+            }
+            /* Strings can be longer than `text`, format straight into the output */
+            spec[spec_len] = 's';
+            spec[spec_len + 1] = '\0';
+            size_t room = len + 1 < size ? size - len : 0;
+            int written = snprintf(room ? out + len : NULL, room, spec, str);
+            len += written > 0 ? written : 0;
+            continue;
+        }
+        default:
+            /* %n and unknown conversions print nothing */
+            continue;
+        }
+        if (n > 0) {
+            dlog_append(out, size, &len, text, (size_t)n < sizeof(text) ? n : sizeof(text) - 1);
+        }
+    }
+    return size == 0 ? 0 : (len < size ? len : size - 1);
+}
+
+const char *dlog_level_letter(uint8_t level)
+{
+    static const char *const k_letters[] = { "N", "E", "W", "I", "D", "V" };
+    return level < sizeof(k_letters) / sizeof(k_letters[0]) ? k_letters[level] : "?";
+}
@@ -0,0 +1,158 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <type_traits>
+
+/*
+ * Deferred logging.
+ *
+ * A log call site owns a static descriptor holding its level and format string. Logging
+ * copies the descriptor address (the format ID), the tag pointer and the raw argument
+ * words into a record and hands it to `dlog_commit()`; nothing is formatted at the call
+ * site. Records are formatted later by `dlog_format()`, on the device by a low priority
+ * task or on the host from a string table extracted from the ELF: descriptors are local
+ * statics named `_dlog_desc`, which tools/dlog/dlog_strings.py looks up in the symbol table.
+ *
+ * Arguments are captured by type: 64-bit integers and floating point values take two
+ * words, pointers take one word per 32 bits, everything else one word. `%s` arguments are
+ * captured as pointers, so they must point to strings that outlive the record (literals,
+ * static tables).
+ */
+
+#define DLOG_MAX_ARG_WORDS 6
+
+/* Same values as esp_log_level_t */
+#define DLOG_LEVEL_ERROR 1
+#define DLOG_LEVEL_WARN 2
+#define DLOG_LEVEL_INFO 3
+#define DLOG_LEVEL_DEBUG 4
+#define DLOG_LEVEL_VERBOSE 5
+
+#ifndef DLOG_MAX_LEVEL
+#define DLOG_MAX_LEVEL DLOG_LEVEL_VERBOSE
+#endif
+
+typedef struct {
+    const char *fmt;
+    uint8_t level;
+} dlog_desc_t;
+
+typedef struct {
+    const dlog_desc_t *desc;
+    const char *tag;
+    uint32_t timestamp_ms;
+    uint8_t nwords;
+    bool truncated; /* arguments did not fit in `words` */
+    uint32_t words[DLOG_MAX_ARG_WORDS];
+} dlog_record_t;
+
+/** Word sizes of the platform that captured a record */
+typedef struct {
+    uint8_t long_words;
+    uint8_t ptr_words;
+} dlog_abi_t;
+
+#define DLOG_ABI_NATIVE { (uint8_t)(sizeof(long) / 4), (uint8_t)(sizeof(void *) / 4) }
+
+/** Resolve a captured `%s` pointer, return NULL if it cannot be resolved */
+typedef const char *(*dlog_resolve_t)(uint64_t addr, void *ctx);
+
+/** Queue a record, implemented by the platform glue */
+void dlog_commit(dlog_record_t *record);
+
+/** Format the arguments of a record
+ *
+ * Supports the printf conversions with flags, width, precision (including `*`) and the
+ * hh/h/l/ll/j/z/t length modifiers. Missing arguments print as `?`.
+ *
+ * @param[in] abi Word sizes of the capturing platform.
+ * @param[in] fmt Format string of the record descriptor.
+ * @param[in] words Captured argument words.
+ * @param[in] nwords Number of words.
+ * @param[in] resolve `%s` resolver, NULL to dereference pointers directly.
+ * @param[in] ctx Resolver context.
+ * @param[out] out Output buffer.
+ * @param[in] size Size of `out`, the output is always terminated.
+ *
+ * @return length of the output, truncated to `size - 1`.
+ */
+size_t dlog_format(const dlog_abi_t *abi, const char *fmt, const uint32_t *words, size_t nwords,
+                   dlog_resolve_t resolve, void *ctx, char *out, size_t size);
+
+const char *dlog_level_letter(uint8_t level);
+
+template <typename T>
+static inline void dlog_put(dlog_record_t *record, T value)
+{
+    uint32_t words[2];
+    size_t count = 1;
+    if constexpr (std::is_floating_point<T>::value) {
+        double promoted = value;
+        memcpy(words, &promoted, sizeof(words));
+        count = 2;
+    } else if constexpr (std::is_pointer<T>::value || std::is_null_pointer<T>::value) {
+        uint64_t addr = (uint64_t)(uintptr_t)value;
+        words[0] = (uint32_t)addr;
+        words[1] = (uint32_t)(addr >> 32);
+        count = sizeof(void *) / 4;
+    } else {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "unsupported log argument type");
+        uint64_t bits = (uint64_t)value;
+        words[0] = (uint32_t)bits;
+        words[1] = (uint32_t)(bits >> 32);
+        count = sizeof(T) > 4 ? 2 : 1;
+    }
+    if (record->nwords + count > DLOG_MAX_ARG_WORDS) {
+        record->truncated = true;
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        record->words[record->nwords++] = words[i];
+    }
+}
+
+template <typename... Args>
+static inline void dlog_write(const dlog_desc_t *desc, const char *tag, Args... args)
+{
+    dlog_record_t record;
+    record.desc = desc;
+    record.tag = tag;
+    record.nwords = 0;
+    record.truncated = false;
+    (dlog_put(&record, args), ...);
+    dlog_commit(&record);
+}
+
+/* Never called, lets the compiler check the format against the arguments */
+static inline void dlog_check_format(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static inline void dlog_check_format(const char *fmt, ...)
+{
+}
+
+#define DLOG(level, tag, format, ...)                                      \
+    do {                                                                   \
+        if ((level) <= DLOG_MAX_LEVEL) {                                   \
+            static const dlog_desc_t _dlog_desc = { format, (level) };     \
+            if (false) {                                                   \
+                dlog_check_format(format, ##__VA_ARGS__);                  \
+            }                                                              \
+            dlog_write(&_dlog_desc, tag, ##__VA_ARGS__);                   \
+        }                                                                  \
+    } while (0)
+
+#define DLOGE(tag, format, ...) DLOG(DLOG_LEVEL_ERROR, tag, format, ##__VA_ARGS__)
+#define DLOGW(tag, format, ...) DLOG(DLOG_LEVEL_WARN, tag, format, ##__VA_ARGS__)
+#define DLOGI(tag, format, ...) DLOG(DLOG_LEVEL_INFO, tag, format, ##__VA_ARGS__)
+#define DLOGD(tag, format, ...) DLOG(DLOG_LEVEL_DEBUG, tag, format, ##__VA_ARGS__)
+#define DLOGV(tag, format, ...) DLOG(DLOG_LEVEL_VERBOSE, tag, format, ##__VA_ARGS__)
@@ -0,0 +1,465 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Streaming fixed-point signal processing kernels.
+ *
+ * Every kernel is a template over the sample type (int16_t or int32_t) and the channel count
+ * `C`, keeps its state per channel in arrays (structure of arrays), and processes a block
+ * of samples per call: `in[c][i]` is sample `i` of channel `c`. The channel loop is outside
+ * the sample loop, so the state of a channel stays in registers for the whole block. Nothing
+ * allocates and nothing uses floating point on the sample path; the design helpers (double)
+ * run once at init.
+ *
+ * - dsp_biquad: second order IIR section, direct form I
+ * - dsp_moving_rms: RMS over the last N samples
+ * - dsp_crossings: zero crossings with hysteresis, peak and length of every half cycle
+ * - dsp_complementary: tilt angle from an accelerometer axis pair, optionally blended with
+ *   a gyro rate
+ */
+
+/** Accumulator widths and coefficient format per sample type */
+template <typename T>
+struct dsp_sample_traits;
+
+/* Coefficients Q13: |b0|+|b1|+|b2|+|a1|+|a2| below 8 keeps the sum of products of int16
+ * samples inside int32. */
+template <>
+struct dsp_sample_traits<int16_t> {
+    typedef int32_t acc_t;
+    typedef uint64_t square_sum_t;
+    static constexpr int coef_q = 13;
+    static constexpr int32_t min = INT16_MIN;
+    static constexpr int32_t max = INT16_MAX;
+};
+
+/* Coefficients Q28, same bound on an int64 accumulator. Sample squares are summed in 64 bits:
+ * keep samples within 24 bits for windows up to 32768 samples. */
+template <>
+struct dsp_sample_traits<int32_t> {
+    typedef int64_t acc_t;
+    typedef uint64_t square_sum_t;
+    static constexpr int coef_q = 28;
+    static constexpr int64_t min = INT32_MIN;
+    static constexpr int64_t max = INT32_MAX;
+};
+
+template <typename T, typename A>
+static inline T dsp_saturate(A value)
+{
+    return value > dsp_sample_traits<T>::max ? (T)dsp_sample_traits<T>::max
+           : value < dsp_sample_traits<T>::min ? (T)dsp_sample_traits<T>::min
+                                               : (T)value;
+}
+
+/** Biquad in floating point, as designed */
+typedef struct {
+    double b0, b1, b2, a1, a2; /* a0 normalized to 1 */
+} dsp_biquad_design_t;
+
+typedef enum {
+    DSP_BIQUAD_LOWPASS = 0,
+    DSP_BIQUAD_HIGHPASS,
+    DSP_BIQUAD_BANDPASS,
+} dsp_biquad_type_t;
+
+/** RBJ cookbook biquad
+ *
+ * @param[in] type Response.
+ * @param[in] fs_hz Sample rate.
+ * @param[in] f0_hz Cutoff, or center frequency of the band pass.
+ * @param[in] q Quality factor, 0.7071 for Butterworth.
+ */
+static inline dsp_biquad_design_t dsp_biquad_design(dsp_biquad_type_t type, double fs_hz, double f0_hz, double q)
+{
+    double w0 = 2.0 * M_PI * f0_hz / fs_hz;
+    double alpha = sin(w0) / (2.0 * q);
+    double cw = cos(w0);
+    double a0 = 1.0 + alpha;
+    dsp_biquad_design_t d;
+    switch (type) {
+    case DSP_BIQUAD_HIGHPASS:
+        d.b0 = (1.0 + cw) / 2.0;
+        d.b1 = -(1.0 + cw);
+        d.b2 = d.b0;
+        break;
+    case DSP_BIQUAD_BANDPASS:
+        d.b0 = alpha;
+        d.b1 = 0.0;
+        d.b2 = -alpha;
+        break;
+    default:
+        d.b0 = (1.0 - cw) / 2.0;
+        d.b1 = 1.0 - cw;
+        d.b2 = d.b0;
+        break;
+    }
+    d.b0 /= a0;
+    d.b1 /= a0;
+    d.b2 /= a0;
+    d.a1 = -2.0 * cw / a0;
+    d.a2 = (1.0 - alpha) / a0;
+    return d;
+}
+
+/** Second order IIR section on C channels, same coefficients on every channel
+ *
+ * Direct form I: the state is the last two inputs and outputs, all of sample width, and the
+ * output saturates instead of wrapping. The fraction dropped from every output is added back
+ * to the next one (first order error feedback): without it the output rounding is amplified
+ * by 1 / (1 + a1 + a2) at DC, hundreds of LSB for a pole close to DC. Cutoffs below about
+ * fs/50 also need the 32 bit variant for its coefficient resolution.
+ */
+template <typename T, size_t C>
+class dsp_biquad {
+    typedef typename dsp_sample_traits<T>::acc_t acc_t;
+    static constexpr int Q = dsp_sample_traits<T>::coef_q;
+
+public:
+    explicit dsp_biquad(const dsp_biquad_design_t &design)
+    {
+        m_b0 = quantize(design.b0);
+        m_b1 = quantize(design.b1);
+        m_b2 = quantize(design.b2);
+        m_a1 = quantize(design.a1);
+        m_a2 = quantize(design.a2);
+        reset();
+    }
+
+    void reset()
+    {
+        for (size_t c = 0; c < C; c++) {
+            m_x1[c] = m_x2[c] = m_y1[c] = m_y2[c] = 0;
+            m_err[c] = 0;
+        }
+    }
+
+    /** Filter a block, `out` may be `in` */
+    void process(const T *const in[C], T *const out[C], size_t n)
+    {
+        for (size_t c = 0; c < C; c++) {
+            acc_t x1 = m_x1[c], x2 = m_x2[c], y1 = m_y1[c], y2 = m_y2[c];
+            acc_t err = m_err[c];
+            const T *src = in[c];
+            T *dst = out[c];
+            for (size_t i = 0; i < n; i++) {
+                acc_t x0 = src[i];
+                acc_t acc = err + m_b0 * x0 + m_b1 * x1 + m_b2 * x2 - m_a1 * y1 - m_a2 * y2;
+                T y0 = dsp_saturate<T>(acc >> Q);
+                /* Nothing to carry out of a saturated output */
+                err = y0 == (acc >> Q) ? acc - ((acc_t)y0 << Q) : 0;
+                x2 = x1;
+                x1 = x0;
+                y2 = y1;
+                y1 = y0;
+                dst[i] = y0;
+            }
+            m_x1[c] = (T)x1;
+            m_x2[c] = (T)x2;
+            m_y1[c] = (T)y1;
+            m_y2[c] = (T)y2;
+            m_err[c] = err;
+        }
+    }
+
+private:
+    static acc_t quantize(double coef) { return (acc_t)lround(coef * (double)((acc_t)1 << Q)); }
+
+    acc_t m_b0, m_b1, m_b2, m_a1, m_a2;
+    T m_x1[C], m_x2[C], m_y1[C], m_y2[C];
+    acc_t m_err[C];
+};
+
+/** Integer square root, Newton's method from a guess
+ *
+ * Exact (floor) for any guess; a guess close to the result, such as the previous output of
+ * a slowly moving RMS, converges in one or two divisions.
+ */
+static inline uint32_t dsp_isqrt(uint64_t value, uint32_t guess)
+{
+    if (value < 2) {
+        return (uint32_t)value;
+    }
+    uint64_t x = guess ? guess : (value >> 32 ? 0xFFFFFFFFu : (uint32_t)value);
+    /* From below, one step lands at or above the root (AM-GM), then it only goes down */
+    if (x * x < value) {
+        x = (x + value / x) / 2 + 1;
+    }
+    uint64_t y = (x + value / x) / 2;
+    while (y < x) {
+        x = y;
+        y = (x + value / x) / 2;
+    }
+    return (uint32_t)x;
+}
+
+/** RMS of the last N samples of C channels
+ *
+ * A running sum of squares: one multiply, one add and one subtract per sample, plus the
+ * square root when `out` is given.
+ */
+template <typename T, size_t C, size_t N>
+class dsp_moving_rms {
+    static_assert(N > 0 && N <= 32768, "dsp_moving_rms window must be 1 to 32768 samples");
+    typedef typename dsp_sample_traits<T>::square_sum_t sum_t;
+
+public:
+    dsp_moving_rms() { reset(); }
+
+    void reset()
+    {
+        m_pos = 0;
+        for (size_t c = 0; c < C; c++) {
+            m_sum[c] = 0;
+            m_rms[c] = 0;
+            for (size_t i = 0; i < N; i++) {
+                m_history[c][i] = 0;
+            }
+        }
+    }
+
+    /** Feed a block; `out`, if not null, gets the RMS after every sample */
+    void process(const T *const in[C], T *const out[C], size_t n)
+    {
+        size_t pos = m_pos;
+        for (size_t c = 0; c < C; c++) {
+            sum_t sum = m_sum[c];
+            uint32_t rms = m_rms[c];
+            T *history = m_history[c];
+            const T *src = in[c];
+            pos = m_pos;
+            for (size_t i = 0; i < n; i++) {
+                int64_t old_sample = history[pos];
+                int64_t new_sample = src[i];
+                sum += (sum_t)(new_sample * new_sample);
+                sum -= (sum_t)(old_sample * old_sample);
+                history[pos] = src[i];
+                pos = pos + 1 == N ? 0 : pos + 1;
+                if (out) {
+                    rms = dsp_isqrt(sum / N, rms);
+                    out[c][i] = (T)rms;
+                }
+            }
+            m_sum[c] = sum;
+            m_rms[c] = out ? rms : dsp_isqrt(sum / N, rms);
+        }
+        m_pos = pos;
+    }
+
+    /** RMS at the end of the last block */
+    T rms(size_t channel) const { return (T)m_rms[channel]; }
+
+private:
+    size_t m_pos;
+    sum_t m_sum[C];
+    uint32_t m_rms[C];
+    T m_history[C][N];
+};
+
+/** Zero crossings of C channels, with hysteresis
+ *
+ * A half cycle ends when the signal crosses to beyond `-hysteresis` or `+hysteresis` on the
+ * other side of zero, so noise around zero does not count. For each channel the kernel
+ * keeps the number of half cycles, and the peak and length of the last complete one: a knock
+ * rings at a few hundred Hz and decays within a few half cycles, a building vibrates for a
+ * long time at a few Hz, a door swing is a single slow half cycle.
+ */
+template <typename T, size_t C>
+class dsp_crossings {
+public:
+    explicit dsp_crossings(T hysteresis) : m_hysteresis(hysteresis) { reset(); }
+
+    void reset()
+    {
+        for (size_t c = 0; c < C; c++) {
+            m_sign[c] = 0;
+            m_peak[c] = 0;
+            m_length[c] = 0;
+            half_cycles[c] = 0;
+            last_peak[c] = 0;
+            last_length[c] = 0;
+        }
+    }
+
+    /** Feed a block
+     *
+     * @return number of half cycles completed in the block, all channels.
+     */
+    uint32_t process(const T *const in[C], size_t n)
+    {
+        uint32_t completed = 0;
+        const int64_t hysteresis = m_hysteresis;
+        for (size_t c = 0; c < C; c++) {
+            int8_t sign = m_sign[c];
+            int64_t peak = m_peak[c];
+            uint32_t length = m_length[c];
+            const T *src = in[c];
+            for (size_t i = 0; i < n; i++) {
+                int64_t x = src[i];
+                int8_t side = x > hysteresis ? 1 : x < -hysteresis ? -1 : 0;
+                length++;
+                if (side != 0 && side != sign) {
+                    if (sign != 0) {
+                        half_cycles[c]++;
+                        last_peak[c] = (T)peak;
+                        last_length[c] = length;
+                        completed++;
+                    }
+                    sign = side;
+                    peak = 0;
+                    length = 0;
+                }
+                int64_t magnitude = x < 0 ? -x : x;
+                if (magnitude > peak) {
+                    peak = magnitude;
+                }
+            }
+            m_sign[c] = sign;
+            m_peak[c] = peak;
+            m_length[c] = length;
+        }
+        return completed;
+    }
+
+    /* Results per channel */
+    uint32_t half_cycles[C]; /* completed half cycles since reset */
+    T last_peak[C];          /* largest magnitude of the last complete half cycle */
+    uint32_t last_length[C]; /* its length in samples: fs / (2 * length) is its frequency */
+
+private:
+    T m_hysteresis;
+    int8_t m_sign[C];
+    int64_t m_peak[C];
+    uint32_t m_length[C];
+};
+
+/** Binary angle: a full turn is 2^32, so angle arithmetic wraps for free. Read as int32_t
+ * it is -180 to +180 degrees. */
+typedef uint32_t dsp_angle_t;
+
+#define DSP_ANGLE_PER_DEGREE (4294967296.0 / 360.0)
+
+/** atan2 on integers, about 0.1 degree worst case
+ *
+ * Octant reduction, then atan(z) ~ pi/4 z + z (1 - z) (0.2447 + 0.0663 z) on 0 <= z <= 1
+ * in Q15, one division.
+ */
+static inline dsp_angle_t dsp_atan2(int64_t y, int64_t x)
+{
+    uint64_t ax = x < 0 ? -x : x;
+    uint64_t ay = y < 0 ? -y : y;
+    if (ax == 0 && ay == 0) {
+        return 0;
+    }
+    bool swap = ay > ax;
+    uint64_t num = swap ? ax : ay;
+    uint64_t den = swap ? ay : ax;
+    /* Keep the Q15 shift inside 64 bits */
+    while (num >= (1ull << 47)) {
+        num >>= 1;
+        den >>= 1;
+    }
+    int32_t z = (int32_t)((num << 15) / den);
+    /* radians Q15 */
+    int32_t t = (int32_t)(((int64_t)z * (32768 - z)) >> 15);
+    int32_t rad = ((25736 * z) >> 15) + (int32_t)(((int64_t)t * (8019 + ((2173 * z) >> 15))) >> 15);
+    /* Q15 radians to binary angle: 2^32 / (2 pi) / 2^15 = 2^16 / pi */
+    dsp_angle_t angle = (dsp_angle_t)(((int64_t)rad * 1367130551) >> 16);
+    if (swap) {
+        angle = 0x40000000u - angle;
+    }
+    if (x < 0) {
+        angle = 0x80000000u - angle;
+    }
+    if (y < 0) {
+        angle = (dsp_angle_t)0 - angle;
+    }
+    return angle;
+}
+
+/** Complementary filter configuration */
+typedef struct {
+    uint16_t fs_hz;
+    uint16_t accel_weight_q15;  /* share of the accelerometer angle per sample, e.g. 2% */
+    uint32_t gyro_udps_per_lsb; /* gyro sensitivity in micro-degrees/s per count */
+} dsp_complementary_config_t;
+
+/** Tilt angle of C axis pairs
+ *
+ * angle += gyro rate * dt, then moves `accel_weight` of the way towards atan2(a, b) of the
+ * accelerometer pair. The gyro follows fast rotations without the accelerometer's
+ * sensitivity to shocks; the accelerometer removes the gyro drift. Without a gyro (`rate`
+ * null) it is a first order low-pass of the accelerometer angle, wrap aware.
+ */
+template <typename T, size_t C>
+class dsp_complementary {
+public:
+    explicit dsp_complementary(const dsp_complementary_config_t &config)
+    {
+        m_accel_weight = config.accel_weight_q15;
+        /* Binary angle per count per sample: udps / 1e6 / 360 * 2^32 / fs */
+        m_gyro_step = (int64_t)((((uint64_t)config.gyro_udps_per_lsb << 32) + 180000000ull * config.fs_hz) /
+                                (360000000ull * config.fs_hz));
+        reset();
+    }
+
+    void reset()
+    {
+        for (size_t c = 0; c < C; c++) {
+            m_angle[c] = 0;
+            m_started[c] = false;
+        }
+    }
+
+    /** Feed a block
+     *
+     * @param[in] a Accelerometer axis giving the sine of the angle, per channel.
+     * @param[in] b Accelerometer axis giving the cosine.
+     * @param[in] rate Gyro rate around the axis, per channel, or null.
+     * @param[out] out Angle after every sample, per channel, or null.
+     * @param[in] n Samples per channel.
+     */
+    void process(const T *const a[C], const T *const b[C], const T *const rate[C], dsp_angle_t *const out[C],
+                 size_t n)
+    {
+        const int64_t weight = m_accel_weight;
+        for (size_t c = 0; c < C; c++) {
+            dsp_angle_t angle = m_angle[c];
+            if (!m_started[c] && n > 0) {
+                /* Start from the accelerometer, not from zero */
+                angle = dsp_atan2(a[c][0], b[c][0]);
+                m_started[c] = true;
+            }
+            for (size_t i = 0; i < n; i++) {
+                if (rate) {
+                    angle += (dsp_angle_t)(rate[c][i] * m_gyro_step);
+                }
+                int32_t error = (int32_t)(dsp_atan2(a[c][i], b[c][i]) - angle);
+                angle += (dsp_angle_t)((error * weight) >> 15);
+                if (out) {
+                    out[c][i] = angle;
+                }
+            }
+            m_angle[c] = angle;
+        }
+    }
+
+    dsp_angle_t angle(size_t channel) const { return m_angle[channel]; }
+
+private:
+    int64_t m_accel_weight;
+    int64_t m_gyro_step;
+    dsp_angle_t m_angle[C];
+    bool m_started[C];
+};
@@ -0,0 +1,365 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "crc16.h"
+#include "event_log.h"
+
+#define EVENT_LOG_MAGIC 0x474C5645 /* "EVLG" */
+#define EVENT_LOG_VERSION 1
+
+#define EVENT_LOG_TYPE_EVENT 0x01
+#define EVENT_LOG_TYPE_ACK 0x02
+
+/* Records read per flash access while scanning */
+#define EVENT_LOG_SCAN_CHUNK 16
+
+/*
+ * Header: magic(4) sector_seq(4) version(2) reserved(4, 0xFF) crc(2)
+ * Record: seq(4) data(4) endpoint(2) type(1) value(1) reserved(2, 0xFF) crc(2)
+ *         `data` is the timestamp of an event, or the acknowledged seq of an ack.
+ * Fields are little endian, CRCs are CRC-16/CCITT-FALSE over the first 14 bytes.
+ */
+
+static inline void put_le16(uint8_t *dst, uint16_t v)
+{
+    dst[0] = (uint8_t)v;
+    dst[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_le32(uint8_t *dst, uint32_t v)
+{
+    put_le16(dst, (uint16_t)v);
+    put_le16(dst + 2, (uint16_t)(v >> 16));
+}
+
+static inline uint16_t get_le16(const uint8_t *src)
+{
+    return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+static inline uint32_t get_le32(const uint8_t *src)
+{
+    return get_le16(src) | ((uint32_t)get_le16(src + 2) << 16);
+}
+
+static bool event_log_is_erased(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void event_log_encode_header(uint8_t *dst, uint32_t sector_seq)
+{
+    memset(dst, 0xFF, EVENT_LOG_HEADER_SIZE);
+    put_le32(dst, EVENT_LOG_MAGIC);
+    put_le32(dst + 4, sector_seq);
+    put_le16(dst + 8, EVENT_LOG_VERSION);
+    put_le16(dst + 14, crc16_ccitt(dst, 14));
+}
+
+static bool event_log_decode_header(const uint8_t *src, uint32_t *sector_seq)
+{
+    if (get_le32(src) != EVENT_LOG_MAGIC || get_le16(src + 8) != EVENT_LOG_VERSION ||
+        get_le16(src + 14) != crc16_ccitt(src, 14)) {
+        return false;
+    }
+    *sector_seq = get_le32(src + 4);
+    return true;
+}
+
+static void event_log_encode_record(uint8_t *dst, uint8_t type, uint32_t seq, uint32_t data, uint16_t endpoint,
+                                    uint8_t value)
+{
+    memset(dst, 0xFF, EVENT_LOG_RECORD_SIZE);
+    put_le32(dst, seq);
+    put_le32(dst + 4, data);
+    put_le16(dst + 8, endpoint);
+    dst[10] = type;
+    dst[11] = value;
+    put_le16(dst + 14, crc16_ccitt(dst, 14));
+}
+
+static inline uint32_t event_log_sector_offset(const event_log_t *log, uint32_t sector)
+{
+    return sector * log->flash.sector_size;
+}
+
+typedef struct {
+    uint32_t index;
+    uint32_t seq;
+} event_log_sector_t;
+
+/* Valid sectors sorted oldest first, returns their count. Errors are only counted when mounting. */
+static uint32_t event_log_list_sectors(event_log_t *log, event_log_sector_t *sectors, event_log_stats_t *stats)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < log->sector_count; i++) {
+        uint8_t header[EVENT_LOG_HEADER_SIZE];
+        uint32_t seq;
+        if (log->flash.read(log->flash.ctx, event_log_sector_offset(log, i), header, sizeof(header)) != 0) {
+            continue;
+        }
+        if (!event_log_decode_header(header, &seq)) {
+            if (stats && !event_log_is_erased(header, sizeof(header))) {
+                stats->crc_errors++;
+            }
+            continue;
+        }
+        /* Insertion sort, there are only a handful of sectors */
+        uint32_t pos = count++;
+        while (pos > 0 && (int32_t)(sectors[pos - 1].seq - seq) > 0) {
+            sectors[pos] = sectors[pos - 1];
+            pos--;
+        }
+        sectors[pos].index = i;
+        sectors[pos].seq = seq;
+    }
+    return count;
+}
+
+/* Scan the records of one sector, returns the offset of the first erased slot */
+typedef void (*event_log_scan_cb_t)(event_log_t *log, const uint8_t *record, void *arg);
+
+static uint32_t event_log_scan_sector(event_log_t *log, uint32_t sector, event_log_scan_cb_t cb, void *arg,
+                                      event_log_stats_t *stats)
+{
+    uint8_t chunk[EVENT_LOG_SCAN_CHUNK * EVENT_LOG_RECORD_SIZE];
+    uint32_t base = event_log_sector_offset(log, sector);
+    uint32_t end = EVENT_LOG_HEADER_SIZE;
+    uint32_t offset = EVENT_LOG_HEADER_SIZE;
+
+    while (offset + EVENT_LOG_RECORD_SIZE <= log->flash.sector_size) {
+        uint32_t len = log->flash.sector_size - offset;
+        if (len > sizeof(chunk)) {
+            len = sizeof(chunk);
+        }
+        len -= len % EVENT_LOG_RECORD_SIZE;
+        if (log->flash.read(log->flash.ctx, base + offset, chunk, len) != 0) {
+            break;
+        }
+        for (uint32_t i = 0; i < len; i += EVENT_LOG_RECORD_SIZE) {
+            const uint8_t *record = chunk + i;
+            if (event_log_is_erased(record, EVENT_LOG_RECORD_SIZE)) {
+                continue;
+            }
+            end = offset + i + EVENT_LOG_RECORD_SIZE;
+            if (get_le16(record + 14) != crc16_ccitt(record, 14)) {
+                /* Torn write, e.g. power loss in the middle of a flush */
+                if (stats) {
+                    stats->crc_errors++;
+                }
+                continue;
+            }
+            cb(log, record, arg);
+        }
+        offset += len;
+    }
+    return end;
+}
+
+static void event_log_count_unacked_cb(event_log_t *log, const uint8_t *record, void *arg)
+{
+    if (record[10] == EVENT_LOG_TYPE_EVENT && (int32_t)(get_le32(record) - log->acked_seq) > 0) {
+        (*(uint32_t *)arg)++;
+    }
+}
+
+static int event_log_start_sector(event_log_t *log, uint32_t sector, uint32_t sector_seq)
+{
+    uint8_t header[EVENT_LOG_HEADER_SIZE];
+    uint32_t offset = event_log_sector_offset(log, sector);
+    uint32_t sector_seq_old;
+    if (event_log_unacked(log) != 0 && log->flash.read(log->flash.ctx, offset, header, sizeof(header)) == 0 &&
+        event_log_decode_header(header, &sector_seq_old)) {
+        /* The ring caught up with events never delivered upstream, they are lost */
+        event_log_scan_sector(log, sector, event_log_count_unacked_cb, &log->stats.overwritten, NULL);
+    }
+    if (log->flash.erase_sector(log->flash.ctx, offset) != 0) {
+        return EVENT_LOG_ERR_FLASH;
+    }
+    log->stats.erases++;
+    event_log_encode_header(header, sector_seq);
+    if (log->flash.write(log->flash.ctx, offset, header, sizeof(header)) != 0) {
+        return EVENT_LOG_ERR_FLASH;
+    }
+    log->stats.flash_writes++;
+    log->stats.bytes_written += sizeof(header);
+    log->cur_sector = sector;
+    log->cur_sector_seq = sector_seq;
+    log->write_offset = EVENT_LOG_HEADER_SIZE;
+
+    /* The previous ack may live in the sector about to be overwritten next, carry it over */
+    if (log->persisted_ack != 0) {
+        uint8_t record[EVENT_LOG_RECORD_SIZE];
+        event_log_encode_record(record, EVENT_LOG_TYPE_ACK, 0, log->persisted_ack, 0, 0);
+        if (log->flash.write(log->flash.ctx, offset + log->write_offset, record, sizeof(record)) != 0) {
+            return EVENT_LOG_ERR_FLASH;
+        }
+        log->stats.flash_writes++;
+        log->stats.bytes_written += sizeof(record);
+        log->write_offset += EVENT_LOG_RECORD_SIZE;
+    }
+    return EVENT_LOG_OK;
+}
+
+static void event_log_mount_cb(event_log_t *log, const uint8_t *record, void *arg)
+{
+    uint32_t seq = get_le32(record);
+    uint32_t data = get_le32(record + 4);
+    if (record[10] == EVENT_LOG_TYPE_EVENT) {
+        if ((int32_t)(seq + 1 - log->next_seq) > 0) {
+            log->next_seq = seq + 1;
+        }
+    } else if (record[10] == EVENT_LOG_TYPE_ACK) {
+        if ((int32_t)(data - log->acked_seq) > 0) {
+            log->acked_seq = data;
+        }
+    }
+}
+
+int event_log_mount(event_log_t *log, const event_log_flash_t *flash, uint8_t *buf, size_t buf_size)
+{
+    if (!flash || !buf || buf_size < 2 * EVENT_LOG_RECORD_SIZE || flash->sector_size < 2 * EVENT_LOG_HEADER_SIZE ||
+        flash->sector_size % EVENT_LOG_RECORD_SIZE != 0 || flash->size < 2 * flash->sector_size ||
+        flash->size > EVENT_LOG_MAX_SECTORS * flash->sector_size || flash->size % flash->sector_size != 0) {
+        return EVENT_LOG_ERR_ARG;
+    }
+    memset(log, 0, sizeof(*log));
+    log->flash = *flash;
+    log->sector_count = flash->size / flash->sector_size;
+    log->buf = buf;
+    log->buf_size = (buf_size / EVENT_LOG_RECORD_SIZE - 1) * EVENT_LOG_RECORD_SIZE;
+    log->next_seq = 1;
+
+    event_log_sector_t sectors[EVENT_LOG_MAX_SECTORS];
+    uint32_t count = event_log_list_sectors(log, sectors, &log->stats);
+    if (count == 0) {
+        return event_log_start_sector(log, 0, 1);
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t end = event_log_scan_sector(log, sectors[i].index, event_log_mount_cb, NULL, &log->stats);
+        if (i == count - 1) {
+            log->cur_sector = sectors[i].index;
+            log->cur_sector_seq = sectors[i].seq;
+            log->write_offset = end;
+        }
+    }
+    log->persisted_ack = log->acked_seq;
+    return EVENT_LOG_OK;
+}
+
+int event_log_flush(event_log_t *log)
+{
+    if (log->acked_seq != log->persisted_ack) {
+        /* Room for this record is reserved in the buffer */
+        event_log_encode_record(log->buf + log->buf_len, EVENT_LOG_TYPE_ACK, 0, log->acked_seq, 0, 0);
+        log->buf_len += EVENT_LOG_RECORD_SIZE;
+    }
+    if (log->buf_len == 0) {
+        return EVENT_LOG_OK;
+    }
+
+    size_t done = 0;
+    while (done < log->buf_len) {
+        if (log->write_offset + EVENT_LOG_RECORD_SIZE > log->flash.sector_size) {
+            uint32_t next = (log->cur_sector + 1) % log->sector_count;
+            int err = event_log_start_sector(log, next, log->cur_sector_seq + 1);
+            if (err != EVENT_LOG_OK) {
+                return err;
+            }
+        }
+        size_t room = log->flash.sector_size - log->write_offset;
+        room -= room % EVENT_LOG_RECORD_SIZE;
+        size_t len = log->buf_len - done < room ? log->buf_len - done : room;
+        uint32_t offset = event_log_sector_offset(log, log->cur_sector) + log->write_offset;
+        if (log->flash.write(log->flash.ctx, offset, log->buf + done, len) != 0) {
+            return EVENT_LOG_ERR_FLASH;
+        }
+        log->stats.flash_writes++;
+        log->stats.bytes_written += len;
+        log->write_offset += len;
+        done += len;
+    }
+    log->buf_len = 0;
+    log->persisted_ack = log->acked_seq;
+    log->stats.flushes++;
+    return EVENT_LOG_OK;
+}
+
+uint32_t event_log_append(event_log_t *log, uint32_t time_ms, uint16_t endpoint, uint8_t value)
+{
+    if (log->buf_len + EVENT_LOG_RECORD_SIZE > log->buf_size && event_log_flush(log) != EVENT_LOG_OK) {
+        return 0;
+    }
+    uint32_t seq = log->next_seq++;
+    event_log_encode_record(log->buf + log->buf_len, EVENT_LOG_TYPE_EVENT, seq, time_ms, endpoint, value);
+    log->buf_len += EVENT_LOG_RECORD_SIZE;
+    log->stats.appends++;
+    return seq;
+}
+
+void event_log_ack(event_log_t *log, uint32_t seq)
+{
+    if ((int32_t)(seq - log->acked_seq) > 0) {
+        log->acked_seq = seq;
+    }
+}
+
+typedef struct {
+    uint32_t after_seq;
+    event_log_cb_t cb;
+    void *arg;
+    bool stop;
+} event_log_iter_t;
+
+static void event_log_iter_record(const uint8_t *record, event_log_iter_t *iter)
+{
+    if (iter->stop || record[10] != EVENT_LOG_TYPE_EVENT) {
+        return;
+    }
+    event_log_entry_t entry = {
+        .seq = get_le32(record),
+        .time_ms = get_le32(record + 4),
+        .endpoint = get_le16(record + 8),
+        .value = record[11],
+    };
+    if ((int32_t)(entry.seq - iter->after_seq) > 0 && !iter->cb(&entry, iter->arg)) {
+        iter->stop = true;
+    }
+}
+
+static void event_log_iter_cb(event_log_t *log, const uint8_t *record, void *arg)
+{
+    event_log_iter_record(record, (event_log_iter_t *)arg);
+}
+
+int event_log_for_each(event_log_t *log, uint32_t after_seq, event_log_cb_t cb, void *arg)
+{
+    event_log_iter_t iter = {
+        .after_seq = after_seq,
+        .cb = cb,
+        .arg = arg,
+        .stop = false,
+    };
+    event_log_sector_t sectors[EVENT_LOG_MAX_SECTORS];
+    uint32_t count = event_log_list_sectors(log, sectors, NULL);
+    for (uint32_t i = 0; i < count && !iter.stop; i++) {
+        event_log_scan_sector(log, sectors[i].index, event_log_iter_cb, &iter, NULL);
+    }
+    for (size_t off = 0; off < log->buf_len && !iter.stop; off += EVENT_LOG_RECORD_SIZE) {
+        event_log_iter_record(log->buf + off, &iter);
+    }
+    return EVENT_LOG_OK;
+}
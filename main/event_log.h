@@ -0,0 +1,118 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Append-only contact event log on raw flash.
+ *
+ * The log area is split in sectors used as a ring. Each sector starts with a header carrying
+ * a sequence number, followed by fixed-size records, each with its own CRC. Records are
+ * batched in a RAM buffer and written in one go, and a sector is only erased when the ring
+ * wraps onto it, so every sector sees the same number of erase cycles. Events the ring wraps
+ * onto before they were acknowledged are lost, and counted in `overwritten`.
+ *
+ * Acknowledgements (the highest event sequence number delivered upstream) are stored as
+ * records in the same log, so replay state survives a reboot.
+ *
+ * Flash access goes through `event_log_flash_t`, which keeps this module free of ESP-IDF:
+ * on target it wraps esp_partition, on the host it can be a file.
+ */
+
+#define EVENT_LOG_RECORD_SIZE 16
+#define EVENT_LOG_HEADER_SIZE 16
+#define EVENT_LOG_MAX_SECTORS 64
+
+#define EVENT_LOG_OK 0
+#define EVENT_LOG_ERR_ARG -1
+#define EVENT_LOG_ERR_FLASH -2
+
+/** Flash backend, all functions return 0 on success */
+typedef struct {
+    int (*read)(void *ctx, uint32_t offset, void *dst, size_t len);
+    int (*write)(void *ctx, uint32_t offset, const void *src, size_t len);
+    int (*erase_sector)(void *ctx, uint32_t offset);
+    void *ctx;
+    uint32_t size;        /* log area size, 2 to EVENT_LOG_MAX_SECTORS sectors */
+    uint32_t sector_size;
+} event_log_flash_t;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t time_ms;
+    uint16_t endpoint;
+    uint8_t value;
+} event_log_entry_t;
+
+typedef struct {
+    uint32_t appends;
+    uint32_t flushes;
+    uint32_t flash_writes;
+    uint32_t bytes_written;
+    uint32_t erases;
+    uint32_t crc_errors;  /* records or headers skipped while scanning */
+    uint32_t overwritten; /* unacknowledged events erased when the ring wrapped onto them */
+} event_log_stats_t;
+
+typedef struct {
+    event_log_flash_t flash;
+    uint32_t sector_count;
+    uint32_t cur_sector;
+    uint32_t cur_sector_seq;
+    uint32_t write_offset;   /* within the current sector */
+    uint32_t next_seq;
+    uint32_t acked_seq;
+    uint32_t persisted_ack;
+    uint8_t *buf;
+    size_t buf_size;         /* usable bytes, one extra record is kept for the ack */
+    size_t buf_len;
+    event_log_stats_t stats;
+} event_log_t;
+
+/** Return false from the callback to stop iterating */
+typedef bool (*event_log_cb_t)(const event_log_entry_t *entry, void *arg);
+
+/** Mount the log, formatting it if no valid sector is found
+ *
+ * @param[out] log Log state.
+ * @param[in] flash Flash backend, copied.
+ * @param[in] buf RAM batch buffer, at least two records long.
+ * @param[in] buf_size Size of `buf` in bytes.
+ *
+ * @return EVENT_LOG_OK on success.
+ * @return EVENT_LOG_ERR_* in case of failure.
+ */
+int event_log_mount(event_log_t *log, const event_log_flash_t *flash, uint8_t *buf, size_t buf_size);
+
+/** Append an event to the RAM batch, flushing first if it is full
+ *
+ * @return the sequence number of the event (>= 1), 0 in case of failure.
+ */
+uint32_t event_log_append(event_log_t *log, uint32_t time_ms, uint16_t endpoint, uint8_t value);
+
+/** Write the RAM batch (and the ack if it moved) to flash */
+int event_log_flush(event_log_t *log);
+
+/** Mark every event up to `seq` as delivered, persisted with the next flush */
+void event_log_ack(event_log_t *log, uint32_t seq);
+
+/** Call `cb` for every event with a sequence number above `after_seq`, oldest first
+ *
+ * Covers flash and the RAM batch.
+ */
+int event_log_for_each(event_log_t *log, uint32_t after_seq, event_log_cb_t cb, void *arg);
+
+/** Number of appended events not acknowledged yet */
+static inline uint32_t event_log_unacked(const event_log_t *log)
+{
+    return log->next_seq - 1 - log->acked_seq;
+}
@@ -0,0 +1,79 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Flat, compile-time attribute dispatch.
+ *
+ * A dispatch table is a constexpr array of (key, handler) entries sorted by key. Sorting
+ * is checked at compile time with `dispatch_table_sorted()`, and lookups are a binary
+ * search over a few cache lines, with no allocation and no dependency on ESP-IDF.
+ */
+
+/** Dispatch key: endpoint role (app defined), cluster ID and attribute ID */
+typedef struct {
+    uint8_t role;
+    uint32_t cluster_id;
+    uint32_t attribute_id;
+} dispatch_key_t;
+
+template <typename Handler>
+struct dispatch_entry_t {
+    dispatch_key_t key;
+    Handler handler;
+};
+
+constexpr bool dispatch_key_less(const dispatch_key_t &a, const dispatch_key_t &b)
+{
+    if (a.role != b.role) {
+        return a.role < b.role;
+    }
+    if (a.cluster_id != b.cluster_id) {
+        return a.cluster_id < b.cluster_id;
+    }
+    return a.attribute_id < b.attribute_id;
+}
+
+/** Check that a table is strictly sorted, meant for static_assert */
+template <typename Handler, size_t N>
+constexpr bool dispatch_table_sorted(const dispatch_entry_t<Handler> (&table)[N])
+{
+    for (size_t i = 1; i < N; i++) {
+        if (!dispatch_key_less(table[i - 1].key, table[i].key)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Find the handler for a key
+ *
+ * @return the handler, or nullptr if the key is not in the table.
+ */
+template <typename Handler, size_t N>
+inline Handler dispatch_table_find(const dispatch_entry_t<Handler> (&table)[N], const dispatch_key_t &key)
+{
+    size_t lo = 0;
+    size_t hi = N;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (dispatch_key_less(table[mid].key, key)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < N && !dispatch_key_less(key, table[lo].key)) {
+        return table[lo].handler;
+    }
+    return nullptr;
+}
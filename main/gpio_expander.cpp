@@ -0,0 +1,228 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "gpio_expander.h"
+
+/* MCP23017 registers, IOCON.BANK = 0: A and B registers interleaved, so a two byte read
+ * from GPIOA returns GPIOA then GPIOB */
+#define MCP23017_IODIRA 0x00
+#define MCP23017_IPOLA 0x02
+#define MCP23017_GPINTENA 0x04
+#define MCP23017_INTCONA 0x08
+#define MCP23017_IOCON 0x0A
+#define MCP23017_GPPUA 0x0C
+#define MCP23017_GPIOA 0x12
+
+#define MCP23017_IOCON_MIRROR 0x40 /* INTA and INTB both follow any pin */
+#define MCP23017_IOCON_ODR 0x04    /* open drain, for a wired-OR line */
+
+/* PCA9555 registers, a read or write continues with the other port of the pair */
+#define PCA9555_INPUT0 0x00
+#define PCA9555_POLARITY0 0x04
+#define PCA9555_CONFIG0 0x06
+
+static expander_err_t mcp23017_configure(const expander_bus_t *bus, uint8_t address)
+{
+    /* IOCON first: the register layout below assumes BANK = 0, and IOCON sits at 0x0A
+     * in that layout (a chip left in BANK = 1 has it at 0x05 and ignores this write
+     * until it is power cycled) */
+    const uint8_t iocon[] = { MCP23017_IOCON_MIRROR | MCP23017_IOCON_ODR };
+    const uint8_t all_inputs[] = { 0xFF, 0xFF };
+    const uint8_t none[] = { 0x00, 0x00 };
+    const struct {
+        uint8_t reg;
+        const uint8_t *data;
+        size_t len;
+    } k_sequence[] = {
+        { MCP23017_IOCON, iocon, sizeof(iocon) },
+        { MCP23017_IODIRA, all_inputs, sizeof(all_inputs) },
+        { MCP23017_IPOLA, none, sizeof(none) },
+        { MCP23017_GPPUA, all_inputs, sizeof(all_inputs) },
+        { MCP23017_INTCONA, none, sizeof(none) }, /* interrupt on change from the previous value */
+        { MCP23017_GPINTENA, all_inputs, sizeof(all_inputs) },
+    };
+    for (size_t i = 0; i < sizeof(k_sequence) / sizeof(k_sequence[0]); i++) {
+        if (bus->write(bus->ctx, address, k_sequence[i].reg, k_sequence[i].data, k_sequence[i].len) != 0) {
+            return EXPANDER_ERR_BUS;
+        }
+    }
+    /* No identification register: check the configuration stuck */
+    uint8_t readback = 0;
+    if (bus->read(bus->ctx, address, MCP23017_IOCON, &readback, 1) != 0) {
+        return EXPANDER_ERR_BUS;
+    }
+    return readback == iocon[0] ? EXPANDER_OK : EXPANDER_ERR_DEVICE;
+}
+
+static expander_err_t mcp23017_read_inputs(const expander_bus_t *bus, uint8_t address, uint16_t *levels)
+{
+    uint8_t raw[2];
+    if (bus->read(bus->ctx, address, MCP23017_GPIOA, raw, sizeof(raw)) != 0) {
+        return EXPANDER_ERR_BUS;
+    }
+    *levels = raw[0] | (raw[1] << 8);
+    return EXPANDER_OK;
+}
+
+const expander_regmap_t expander_regmap_mcp23017 = {
+    .name = "mcp23017",
+    .configure = mcp23017_configure,
+    .read_inputs = mcp23017_read_inputs,
+};
+
+static expander_err_t pca9555_configure(const expander_bus_t *bus, uint8_t address)
+{
+    /* Inputs and interrupt on change are the power-on state, rewrite them anyway */
+    const uint8_t all_inputs[] = { 0xFF, 0xFF };
+    const uint8_t none[] = { 0x00, 0x00 };
+    if (bus->write(bus->ctx, address, PCA9555_CONFIG0, all_inputs, sizeof(all_inputs)) != 0 ||
+        bus->write(bus->ctx, address, PCA9555_POLARITY0, none, sizeof(none)) != 0) {
+        return EXPANDER_ERR_BUS;
+    }
+    uint8_t readback[2] = { 0, 0 };
+    if (bus->read(bus->ctx, address, PCA9555_CONFIG0, readback, sizeof(readback)) != 0) {
+        return EXPANDER_ERR_BUS;
+    }
+    return readback[0] == 0xFF && readback[1] == 0xFF ? EXPANDER_OK : EXPANDER_ERR_DEVICE;
+}
+
+static expander_err_t pca9555_read_inputs(const expander_bus_t *bus, uint8_t address, uint16_t *levels)
+{
+    uint8_t raw[2];
+    if (bus->read(bus->ctx, address, PCA9555_INPUT0, raw, sizeof(raw)) != 0) {
+        return EXPANDER_ERR_BUS;
+    }
+    *levels = raw[0] | (raw[1] << 8);
+    return EXPANDER_OK;
+}
+
+const expander_regmap_t expander_regmap_pca9555 = {
+    .name = "pca9555",
+    .configure = pca9555_configure,
+    .read_inputs = pca9555_read_inputs,
+};
+
+/* The register maps get a bus that counts the traffic on the way through */
+static int expander_counted_read(void *ctx, uint8_t address, uint8_t reg, uint8_t *buf, size_t len)
+{
+    expander_t *exp = (expander_t *)ctx;
+    exp->stats.transfers++;
+    int err = exp->bus.read(exp->bus.ctx, address, reg, buf, len);
+    if (err != 0) {
+        exp->stats.bus_errors++;
+    }
+    return err;
+}
+
+static int expander_counted_write(void *ctx, uint8_t address, uint8_t reg, const uint8_t *buf, size_t len)
+{
+    expander_t *exp = (expander_t *)ctx;
+    exp->stats.transfers++;
+    int err = exp->bus.write(exp->bus.ctx, address, reg, buf, len);
+    if (err != 0) {
+        exp->stats.bus_errors++;
+    }
+    return err;
+}
+
+static inline expander_bus_t expander_counted_bus(expander_t *exp)
+{
+    return { exp, expander_counted_read, expander_counted_write };
+}
+
+static inline bool expander_pin_closed(const expander_t *exp, uint16_t levels, uint8_t pin)
+{
+    return !(((levels ^ exp->closed_levels) >> pin) & 1);
+}
+
+expander_err_t expander_init(expander_t *exp, const expander_bus_t *bus, const expander_regmap_t *map,
+                             uint8_t address, uint8_t active_level, const contact_debounce_config_t *db_config,
+                             int64_t now_us)
+{
+    memset(exp, 0, sizeof(*exp));
+    exp->bus = *bus;
+    exp->map = map;
+    exp->address = address;
+    exp->closed_levels = active_level ? 0xFFFF : 0x0000;
+
+    expander_bus_t counted = expander_counted_bus(exp);
+    expander_err_t err = map->configure(&counted, address);
+    if (err != EXPANDER_OK) {
+        return err;
+    }
+    err = map->read_inputs(&counted, address, &exp->levels);
+    if (err != EXPANDER_OK) {
+        return err;
+    }
+    for (uint8_t pin = 0; pin < EXPANDER_PINS; pin++) {
+        contact_debounce_init(&exp->db[pin], db_config, expander_pin_closed(exp, exp->levels, pin));
+    }
+    return EXPANDER_OK;
+}
+
+bool expander_scan(expander_t *exp, int64_t now_us, expander_report_cb_t cb, void *cb_arg)
+{
+    expander_bus_t counted = expander_counted_bus(exp);
+    uint16_t levels = 0;
+    if (exp->map->read_inputs(&counted, exp->address, &levels) != EXPANDER_OK) {
+        /* Keep the deadline: the next scan retries */
+        return exp->settling != 0;
+    }
+    exp->stats.scans++;
+    uint16_t changed = levels ^ exp->levels;
+    exp->levels = levels;
+
+    /* Edges first: in leading edge mode they are due right away */
+    for (uint16_t bits = changed; bits; bits &= bits - 1) {
+        uint8_t pin = __builtin_ctz(bits);
+        exp->stats.changed_bits++;
+        if (contact_debounce_on_edge(&exp->db[pin], now_us, expander_pin_closed(exp, levels, pin)) &
+            CONTACT_DEBOUNCE_ARM) {
+            exp->settling |= 1u << pin;
+        }
+    }
+
+    /* Then every settling pin whose deadline has passed, sampled by the same read */
+    int64_t deadline = INT64_MAX;
+    for (uint16_t bits = exp->settling; bits; bits &= bits - 1) {
+        uint8_t pin = __builtin_ctz(bits);
+        contact_debounce_t *db = &exp->db[pin];
+        if (db->deadline_us <= now_us) {
+            uint8_t flags = contact_debounce_on_timer(db, now_us, expander_pin_closed(exp, levels, pin));
+            if (flags & CONTACT_DEBOUNCE_REPORT) {
+                exp->stats.reports++;
+                cb(cb_arg, pin, db->stable_level, db->first_edge_us);
+            }
+            if (!(flags & CONTACT_DEBOUNCE_ARM)) {
+                exp->settling &= ~(1u << pin);
+                continue;
+            }
+        }
+        if (db->deadline_us < deadline) {
+            deadline = db->deadline_us;
+        }
+    }
+    exp->deadline_us = deadline;
+    return exp->settling != 0;
+}
+
+const char *expander_err_name(expander_err_t err)
+{
+    switch (err) {
+    case EXPANDER_OK:
+        return "ok";
+    case EXPANDER_ERR_BUS:
+        return "bus error";
+    case EXPANDER_ERR_DEVICE:
+        return "configuration not kept";
+    default:
+        return "unknown";
+    }
+}
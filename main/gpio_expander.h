@@ -0,0 +1,119 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "contact_debounce.h"
+
+/*
+ * Contact inputs on I2C GPIO expanders (MCP23017, PCA9555: 16 pins each).
+ *
+ * Every pin is an input with its change interrupt enabled; the expanders share one open
+ * drain interrupt line. On an interrupt the caller scans each expander: one bus transaction
+ * reads all 16 pins (and clears the interrupt), the XOR with the previous read gives the
+ * changed pins, and only those are fed to their debounce state machine. A settle deadline per
+ * expander replaces the per-input timers of the GPIO contacts: at the deadline the caller
+ * scans again, which samples every settling pin at once.
+ *
+ * No ESP-IDF dependency: the bus is an interface, I2C on target and a simulated chip on the
+ * host.
+ */
+
+#define EXPANDER_PINS 16
+
+/** Register bus shared by several chips */
+typedef struct {
+    void *ctx;
+    /** Write the register address, then read `len` bytes in the same transaction */
+    int (*read)(void *ctx, uint8_t address, uint8_t reg, uint8_t *buf, size_t len);
+    /** Write `len` bytes from the register address on */
+    int (*write)(void *ctx, uint8_t address, uint8_t reg, const uint8_t *buf, size_t len);
+} expander_bus_t;
+
+typedef enum {
+    EXPANDER_OK = 0,
+    EXPANDER_ERR_BUS,    /* a bus transaction failed, or no chip at the address */
+    EXPANDER_ERR_DEVICE, /* the chip did not keep its configuration */
+} expander_err_t;
+
+/** Register map of one chip family */
+typedef struct {
+    const char *name;
+    /** All pins inputs, pull-ups on where the chip has them, interrupt on any change */
+    expander_err_t (*configure)(const expander_bus_t *bus, uint8_t address);
+    /** Read the 16 pin levels in one transaction, port 0 / A in the low byte */
+    expander_err_t (*read_inputs)(const expander_bus_t *bus, uint8_t address, uint16_t *levels);
+} expander_regmap_t;
+
+/** Microchip MCP23017, interrupt outputs mirrored and open drain */
+extern const expander_regmap_t expander_regmap_mcp23017;
+/** NXP / TI PCA9555 (also TCA9555), no configuration needed for the interrupt */
+extern const expander_regmap_t expander_regmap_pca9555;
+
+/** Called for every debounced change */
+typedef void (*expander_report_cb_t)(void *arg, uint8_t pin, bool closed, int64_t edge_us);
+
+typedef struct {
+    uint32_t scans;        /* successful bulk reads */
+    uint32_t transfers;    /* bus transactions, configuration included */
+    uint32_t bus_errors;   /* failed transactions */
+    uint32_t changed_bits; /* pin changes seen between two reads */
+    uint32_t reports;      /* debounced changes reported */
+} expander_stats_t;
+
+typedef struct {
+    expander_bus_t bus;
+    const expander_regmap_t *map;
+    uint8_t address;
+    uint16_t closed_levels; /* per pin, the level read while the contact is closed */
+    uint16_t levels;        /* last read */
+    uint16_t settling;      /* pins whose debounce waits for the deadline */
+    int64_t deadline_us;    /* earliest settle deadline, valid while `settling` is not 0 */
+    contact_debounce_t db[EXPANDER_PINS];
+    expander_stats_t stats;
+} expander_t;
+
+/** Configure a chip and latch its inputs
+ *
+ * @param[out] exp Expander state.
+ * @param[in] bus Register bus, copied.
+ * @param[in] map Register map of the chip.
+ * @param[in] address 7 bit I2C address.
+ * @param[in] active_level Level of a closed contact, the same for every pin.
+ * @param[in] db_config Debounce configuration of every pin.
+ * @param[in] now_us Current time.
+ *
+ * @return EXPANDER_OK on success.
+ */
+expander_err_t expander_init(expander_t *exp, const expander_bus_t *bus, const expander_regmap_t *map,
+                             uint8_t address, uint8_t active_level, const contact_debounce_config_t *db_config,
+                             int64_t now_us);
+
+/** Read the pins and run the debounce of the changed and the settling ones
+ *
+ * Call on the interrupt (with the interrupt timestamp) and at `deadline_us`.
+ *
+ * @param[in] exp Expander state.
+ * @param[in] now_us Time of the interrupt or deadline.
+ * @param[in] cb Called for every debounced change.
+ * @param[in] cb_arg Passed to `cb`.
+ *
+ * @return true if a deadline is pending: scan again at `deadline_us`.
+ */
+bool expander_scan(expander_t *exp, int64_t now_us, expander_report_cb_t cb, void *cb_arg);
+
+/** Last debounced state of a pin */
+static inline bool expander_get_closed(const expander_t *exp, uint8_t pin)
+{
+    return exp->db[pin].stable_level;
+}
+
+const char *expander_err_name(expander_err_t err);
@@ -0,0 +1,237 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "hall_sense.h"
+
+const hall_frame_format_t hall_frame_type1 = {
+    .word_bytes = 2,
+    .channel_shift = 12,
+    .channel_mask = 0xF,
+    .data_mask = 0xFFF,
+};
+
+static const char *const k_state_names[HALL_STATE_MAX] = {
+    "closed",
+    "ajar",
+    "open",
+    "tamper",
+};
+
+static inline int32_t abs32(int32_t v)
+{
+    return v < 0 ? -v : v;
+}
+
+/* floor(cbrt(x)), bit by bit */
+static uint32_t icbrt64(uint64_t x)
+{
+    uint32_t root = 0;
+    for (int bit = 20; bit >= 0; bit--) {
+        uint64_t candidate = root | (1u << bit);
+        if (candidate * candidate * candidate <= x) {
+            root = (uint32_t)candidate;
+        }
+    }
+    return root;
+}
+
+static void hall_sense_derive(hall_sense_t *hs)
+{
+    const hall_config_t *config = &hs->config;
+    uint64_t d0 = config->magnet_mm;
+    uint64_t d = d0 + config->open_mm;
+    hs->floor_ut = (int32_t)((uint64_t)abs32(config->closed_ut) * d0 * d0 * d0 / (d * d * d));
+    if (hs->floor_ut == 0) {
+        hs->floor_ut = 1;
+    }
+}
+
+bool hall_sense_init(hall_sense_t *hs, const hall_config_t *config)
+{
+    memset(hs, 0, sizeof(*hs));
+    if (config->decimation == 0 || config->decimation > HALL_MAX_DECIMATION || config->sample_hz == 0 ||
+        (config->format.word_bytes != 2 && config->format.word_bytes != 4) || config->ut_per_count_q8 == 0 ||
+        abs32(config->closed_ut) < HALL_MIN_CLOSED_UT || config->magnet_mm == 0 ||
+        config->closed_mm >= config->open_mm || config->tamper_pct <= 100 + HALL_TAMPER_HYSTERESIS_PCT) {
+        return false;
+    }
+    hs->config = *config;
+    uint32_t rate = config->sample_hz / config->decimation;
+    hs->dwell_samples = (uint32_t)config->dwell_ms * rate / 1000;
+    if (hs->dwell_samples == 0) {
+        hs->dwell_samples = 1;
+    }
+    hall_sense_derive(hs);
+    hs->state = HALL_STATE_OPEN;
+    hs->candidate = HALL_STATE_OPEN;
+    hs->gap_mm = HALL_GAP_UNKNOWN;
+    hs->reported_gap_mm = HALL_GAP_UNKNOWN;
+    return true;
+}
+
+uint16_t hall_sense_gap_mm(const hall_sense_t *hs, int32_t field_ut)
+{
+    int32_t closed = abs32(hs->config.closed_ut);
+    int32_t field = hs->config.closed_ut < 0 ? -field_ut : field_ut;
+    if (field < hs->floor_ut) {
+        return HALL_GAP_UNKNOWN;
+    }
+    if (field >= closed) {
+        return 0;
+    }
+    /* cbrt(B_closed / B) in Q8, from the ratio in Q24 */
+    uint32_t root_q8 = icbrt64(((uint64_t)closed << 24) / (uint32_t)field);
+    uint32_t gap = (hs->config.magnet_mm * (root_q8 - 256) + 128) >> 8;
+    return gap < HALL_GAP_UNKNOWN ? (uint16_t)gap : HALL_GAP_UNKNOWN - 1;
+}
+
+static hall_state_t hall_sense_classify(const hall_sense_t *hs, int32_t field_ut, uint16_t gap_mm)
+{
+    const hall_config_t *config = &hs->config;
+    int64_t closed = abs32(config->closed_ut);
+    int32_t field = config->closed_ut < 0 ? -field_ut : field_ut;
+
+    /* Hysteresis: a threshold moves away from the state it would leave */
+    uint32_t tamper_pct = config->tamper_pct;
+    int32_t reverse_ut = hs->floor_ut;
+    if (hs->state == HALL_STATE_TAMPER) {
+        tamper_pct -= HALL_TAMPER_HYSTERESIS_PCT;
+        reverse_ut /= 2;
+    }
+    if (field > closed * tamper_pct / 100 || -field > reverse_ut) {
+        return HALL_STATE_TAMPER;
+    }
+    uint32_t closed_limit = config->closed_mm;
+    uint32_t open_limit = config->open_mm;
+    if (hs->state == HALL_STATE_CLOSED) {
+        closed_limit += config->hysteresis_mm;
+    } else if (hs->state == HALL_STATE_OPEN) {
+        uint32_t band = config->open_mm - config->closed_mm;
+        open_limit -= config->hysteresis_mm < band ? config->hysteresis_mm : band;
+    }
+    if (gap_mm <= closed_limit) {
+        return HALL_STATE_CLOSED;
+    }
+    return gap_mm > open_limit ? HALL_STATE_OPEN : HALL_STATE_AJAR;
+}
+
+/* One field sample through the classifier */
+static uint8_t hall_sense_update(hall_sense_t *hs, int32_t field_ut)
+{
+    hs->samples++;
+    hs->field_ut = field_ut;
+    hs->gap_mm = hall_sense_gap_mm(hs, field_ut);
+    hall_state_t state = hall_sense_classify(hs, field_ut, hs->gap_mm);
+
+    uint8_t events = 0;
+    if (!hs->started) {
+        /* Nothing to debounce against yet */
+        hs->started = true;
+        hs->candidate = state;
+        hs->state = state;
+        events |= HALL_EVENT_STATE;
+    } else {
+        if (state != hs->candidate) {
+            hs->candidate = state;
+            hs->candidate_samples = 0;
+        }
+        hs->candidate_samples++;
+        uint32_t dwell = hs->dwell_samples;
+        if (hs->state == HALL_STATE_TAMPER) {
+            dwell *= HALL_TAMPER_CLEAR_DWELLS;
+        }
+        if (state != hs->state && hs->candidate_samples >= dwell) {
+            hs->state = state;
+            events |= HALL_EVENT_STATE;
+        }
+    }
+
+    uint16_t position = hs->gap_mm;
+    if (hs->state == HALL_STATE_OPEN) {
+        position = HALL_GAP_UNKNOWN;
+    } else if (hs->state == HALL_STATE_TAMPER) {
+        /* The field says nothing about the door */
+        position = hs->reported_gap_mm;
+    } else if (position == HALL_GAP_UNKNOWN) {
+        /* Closed or ajar for the debounce, not yet for the gap */
+        position = hs->reported_gap_mm;
+    }
+    if (position != hs->reported_gap_mm) {
+        uint16_t step = position > hs->reported_gap_mm ? position - hs->reported_gap_mm
+                                                       : hs->reported_gap_mm - position;
+        if ((events & HALL_EVENT_STATE) || position == HALL_GAP_UNKNOWN || hs->reported_gap_mm == HALL_GAP_UNKNOWN ||
+            step >= hs->config.report_step_mm) {
+            hs->reported_gap_mm = position;
+            events |= HALL_EVENT_POSITION;
+        }
+    }
+    return events;
+}
+
+/* Word parsing specialized per word size: this is the per-conversion loop */
+template <typename word_t>
+static uint8_t hall_sense_parse(hall_sense_t *hs, const uint8_t *frame, size_t words)
+{
+    const hall_config_t *config = &hs->config;
+    const uint32_t shift = config->format.channel_shift;
+    const uint32_t channel_mask = config->format.channel_mask;
+    const uint32_t data_mask = config->format.data_mask;
+    const uint32_t channel = config->channel;
+    const uint16_t decimation = config->decimation;
+    int32_t sum = hs->sum;
+    uint16_t summed = hs->summed;
+    uint32_t foreign = 0;
+    uint8_t events = 0;
+    for (size_t i = 0; i < words; i++) {
+        word_t word;
+        memcpy(&word, frame + i * sizeof(word_t), sizeof(word_t));
+        if (((word >> shift) & channel_mask) != channel) {
+            foreign++;
+            continue;
+        }
+        sum += word & data_mask;
+        if (++summed == decimation) {
+            int64_t centered = sum - (int64_t)config->zero_counts * decimation;
+            int32_t field_ut = (int32_t)(centered * config->ut_per_count_q8 / ((int64_t)decimation << 8));
+            sum = 0;
+            summed = 0;
+            events |= hall_sense_update(hs, field_ut);
+        }
+    }
+    hs->sum = sum;
+    hs->summed = summed;
+    hs->foreign += foreign;
+    hs->words += words;
+    return events;
+}
+
+uint8_t hall_sense_feed(hall_sense_t *hs, const uint8_t *frame, size_t len)
+{
+    /* Little-endian words, like the DMA writes them on every ESP32 */
+    if (hs->config.format.word_bytes == 2) {
+        return hall_sense_parse<uint16_t>(hs, frame, len / 2);
+    }
+    return hall_sense_parse<uint32_t>(hs, frame, len / 4);
+}
+
+bool hall_sense_calibrate(hall_sense_t *hs)
+{
+    if (!hs->started || abs32(hs->field_ut) < HALL_MIN_CLOSED_UT) {
+        return false;
+    }
+    hs->config.closed_ut = hs->field_ut;
+    hall_sense_derive(hs);
+    return true;
+}
+
+const char *hall_state_name(hall_state_t state)
+{
+    return state < HALL_STATE_MAX ? k_state_names[state] : "unknown";
+}
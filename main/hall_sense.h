@@ -0,0 +1,151 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Door position from an analog Hall sensor next to the door magnet, integer only.
+ *
+ * Input is what the ADC continuous driver leaves in its DMA frames: little-endian words
+ * holding a channel number and a 12-bit conversion. Words of the sensor channel are summed
+ * in blocks of `decimation` (boxcar, so the mains hum and the sensor noise average out) and
+ * each block becomes one field sample in microtesla.
+ *
+ * The field of the magnet falls off like a dipole, B(gap) = B_closed * (d0 / (d0 + gap))^3,
+ * so the gap is d0 * (cbrt(B_closed / B) - 1), with B_closed the field measured with the
+ * door shut and d0 a property of the magnet (`magnet_mm`). The gap is classified with
+ * hysteresis:
+ * - closed: gap up to `closed_mm`;
+ * - ajar: between `closed_mm` and `open_mm`, e.g. left open by 2 cm;
+ * - open: beyond `open_mm`, the field is down to the noise;
+ * - tamper: a field stronger than the door magnet can produce (`tamper_pct` of B_closed,
+ *   a magnet held against the sensor to fake a closed door), or one of the wrong polarity.
+ * A new state must hold for `dwell_ms` before it is reported, HALL_TAMPER_CLEAR_DWELLS times
+ * that to leave tamper.
+ */
+
+typedef enum {
+    HALL_STATE_CLOSED = 0,
+    HALL_STATE_AJAR,
+    HALL_STATE_OPEN,
+    HALL_STATE_TAMPER,
+    HALL_STATE_MAX,
+} hall_state_t;
+
+/* Gap beyond what the field can tell, reported while open */
+#define HALL_GAP_UNKNOWN 0xFFFF
+
+#define HALL_MAX_DECIMATION 4096
+
+/* Weakest closed field accepted, the gap estimate needs a field well above the noise */
+#define HALL_MIN_CLOSED_UT 500
+
+/* Field hysteresis of the tamper check, in percent of the closed field */
+#define HALL_TAMPER_HYSTERESIS_PCT 10
+
+/* Leaving the tamper state takes this many dwell times: a magnet pulled away sweeps the field
+ * through the closed and ajar bands on its way down */
+#define HALL_TAMPER_CLEAR_DWELLS 5
+
+/** Events raised by one hall_sense_feed() call */
+#define HALL_EVENT_STATE 0x01    /* `state` changed */
+#define HALL_EVENT_POSITION 0x02 /* `reported_gap_mm` changed: moved by `report_step_mm`, or in/out of range */
+
+/** Word layout of the DMA frames, see adc_digi_output_data_t */
+typedef struct {
+    uint8_t word_bytes;    /* 2 (TYPE1) or 4 (TYPE2) */
+    uint8_t channel_shift;
+    uint8_t channel_mask;  /* after the shift */
+    uint16_t data_mask;    /* conversion result, low bits */
+} hall_frame_format_t;
+
+/** TYPE1 words of the ESP32 and ESP32-S2: data(12) channel(4) */
+extern const hall_frame_format_t hall_frame_type1;
+
+typedef struct {
+    hall_frame_format_t format;
+    uint8_t channel;
+    uint32_t sample_hz;       /* ADC conversion rate */
+    uint16_t decimation;      /* conversions per field sample, 1 to HALL_MAX_DECIMATION */
+    int32_t zero_counts;      /* conversion result at zero field */
+    int32_t ut_per_count_q8;  /* sensor sensitivity, microtesla per count << 8; negative inverts */
+    int32_t closed_ut;        /* field with the door shut; its sign is the magnet polarity */
+    uint16_t magnet_mm;       /* d0 of the dipole model, about the magnet length */
+    uint16_t closed_mm;
+    uint16_t open_mm;
+    uint16_t hysteresis_mm;
+    uint16_t tamper_pct;      /* over 100 */
+    uint16_t dwell_ms;
+    uint16_t report_step_mm;
+} hall_config_t;
+
+typedef struct {
+    hall_config_t config;
+    uint32_t dwell_samples;   /* field samples a new state must hold */
+    int32_t floor_ut;         /* field at `open_mm`: weaker is open, reversed beyond is tamper */
+
+    /* Decimation */
+    int32_t sum;
+    uint16_t summed;
+
+    /* Classification */
+    hall_state_t candidate;
+    uint32_t candidate_samples;
+    bool started;             /* first field sample seen */
+
+    /* Results */
+    hall_state_t state;
+    int32_t field_ut;         /* last field sample, signed */
+    uint16_t gap_mm;          /* last estimate, HALL_GAP_UNKNOWN beyond the field floor */
+    uint16_t reported_gap_mm; /* position to publish: updated with HALL_EVENT_POSITION, held while tampered */
+
+    /* Counters */
+    uint32_t words;           /* DMA words parsed */
+    uint32_t foreign;         /* words of another channel */
+    uint32_t samples;         /* field samples */
+} hall_sense_t;
+
+/** Initialize a position detector
+ *
+ * @param[out] hs Detector state.
+ * @param[in] config Sensor, calibration and thresholds.
+ *
+ * @return false if the configuration is out of range (decimation, zero closed field or
+ *         thresholds not in order).
+ */
+bool hall_sense_init(hall_sense_t *hs, const hall_config_t *config);
+
+/** Run the detector on a DMA frame
+ *
+ * @param[in,out] hs Detector state.
+ * @param[in] frame Conversion words, oldest first; a trailing partial word is ignored.
+ * @param[in] len Length of `frame` in bytes.
+ *
+ * @return HALL_EVENT_* flags.
+ */
+uint8_t hall_sense_feed(hall_sense_t *hs, const uint8_t *frame, size_t len);
+
+/** Use the field being measured as the closed reference
+ *
+ * To be called with the door shut. Thresholds are recomputed, the state is kept.
+ *
+ * @return false if no field sample was taken yet, or the field is too weak.
+ */
+bool hall_sense_calibrate(hall_sense_t *hs);
+
+/** Gap for a field, with the configured calibration
+ *
+ * @return gap in millimeters, HALL_GAP_UNKNOWN below the field floor or reversed.
+ */
+uint16_t hall_sense_gap_mm(const hall_sense_t *hs, int32_t field_ut);
+
+const char *hall_state_name(hall_state_t state);
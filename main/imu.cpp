@@ -0,0 +1,233 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "imu.h"
+
+/* LIS3DH / LIS2DH12 registers */
+#define LIS3DH_WHO_AM_I 0x0F
+#define LIS3DH_WHO_AM_I_VALUE 0x33
+#define LIS3DH_CTRL_REG1 0x20
+#define LIS3DH_CTRL_REG3 0x22
+#define LIS3DH_CTRL_REG4 0x23
+#define LIS3DH_CTRL_REG5 0x24
+#define LIS3DH_OUT_X_L 0x28
+#define LIS3DH_FIFO_CTRL_REG 0x2E
+#define LIS3DH_FIFO_SRC_REG 0x2F
+
+/* Set in the sub-address for multi-byte reads. With the FIFO enabled the address rolls back
+ * from OUT_Z_H to OUT_X_L, so one read returns consecutive samples. */
+#define LIS3DH_AUTO_INCREMENT 0x80
+
+#define LIS3DH_CTRL_REG1_XYZ_EN 0x07
+#define LIS3DH_CTRL_REG3_I1_WTM 0x04
+#define LIS3DH_CTRL_REG4_BDU 0x80
+#define LIS3DH_CTRL_REG4_HR 0x08
+#define LIS3DH_CTRL_REG5_FIFO_EN 0x40
+#define LIS3DH_FIFO_MODE_STREAM 0x80
+#define LIS3DH_FIFO_SRC_OVRN 0x40
+#define LIS3DH_FIFO_SRC_FSS 0x1F
+#define LIS3DH_FIFO_DEPTH 32
+
+static imu_err_t lis3dh_probe(const imu_bus_t *bus)
+{
+    uint8_t id = 0;
+    if (bus->read(bus->ctx, LIS3DH_WHO_AM_I, &id, 1) != 0) {
+        return IMU_ERR_BUS;
+    }
+    return id == LIS3DH_WHO_AM_I_VALUE ? IMU_OK : IMU_ERR_ID;
+}
+
+static imu_err_t lis3dh_configure(const imu_bus_t *bus, imu_config_t *config, uint16_t *mg_per_lsb)
+{
+    static const uint16_t k_odr_hz[] = { 1, 10, 25, 50, 100, 200, 400 };
+    /* High resolution (12 bit) sensitivity per full scale */
+    static const struct {
+        uint8_t range_g;
+        uint8_t fs_bits;
+        uint16_t mg_per_lsb;
+    } k_ranges[] = { { 2, 0x00, 1 }, { 4, 0x10, 2 }, { 8, 0x20, 4 }, { 16, 0x30, 12 } };
+
+    size_t odr = 0;
+    while (odr < sizeof(k_odr_hz) / sizeof(k_odr_hz[0]) - 1 && k_odr_hz[odr] < config->odr_hz) {
+        odr++;
+    }
+    size_t range = 0;
+    while (range < sizeof(k_ranges) / sizeof(k_ranges[0]) - 1 && k_ranges[range].range_g < config->range_g) {
+        range++;
+    }
+    if (config->watermark == 0 || config->watermark >= LIS3DH_FIFO_DEPTH) {
+        return IMU_ERR_CONFIG;
+    }
+
+    /* Power down and empty the FIFO (bypass mode), then enable the FIFO before switching the
+     * sensor back on. Every register the driver relies on is written, whatever a previous
+     * boot left in them. */
+    const uint8_t k_sequence[][2] = {
+        { LIS3DH_CTRL_REG1, 0 },
+        { LIS3DH_FIFO_CTRL_REG, 0 },
+        { LIS3DH_CTRL_REG4, (uint8_t)(LIS3DH_CTRL_REG4_BDU | LIS3DH_CTRL_REG4_HR | k_ranges[range].fs_bits) },
+        { LIS3DH_CTRL_REG5, LIS3DH_CTRL_REG5_FIFO_EN },
+        { LIS3DH_FIFO_CTRL_REG, (uint8_t)(LIS3DH_FIFO_MODE_STREAM | config->watermark) },
+        { LIS3DH_CTRL_REG3, LIS3DH_CTRL_REG3_I1_WTM },
+        { LIS3DH_CTRL_REG1, (uint8_t)(((odr + 1) << 4) | LIS3DH_CTRL_REG1_XYZ_EN) },
+    };
+    for (size_t i = 0; i < sizeof(k_sequence) / sizeof(k_sequence[0]); i++) {
+        if (bus->write(bus->ctx, k_sequence[i][0], k_sequence[i][1]) != 0) {
+            return IMU_ERR_BUS;
+        }
+    }
+    config->odr_hz = k_odr_hz[odr];
+    config->range_g = k_ranges[range].range_g;
+    *mg_per_lsb = k_ranges[range].mg_per_lsb;
+    return IMU_OK;
+}
+
+static imu_err_t lis3dh_fifo_level(const imu_bus_t *bus, uint8_t *level, bool *overrun)
+{
+    uint8_t src = 0;
+    if (bus->read(bus->ctx, LIS3DH_FIFO_SRC_REG, &src, 1) != 0) {
+        return IMU_ERR_BUS;
+    }
+    /* FSS counts up to 31 unread samples, a full FIFO also sets OVRN */
+    *overrun = src & LIS3DH_FIFO_SRC_OVRN;
+    *level = *overrun ? LIS3DH_FIFO_DEPTH : src & LIS3DH_FIFO_SRC_FSS;
+    return IMU_OK;
+}
+
+static imu_err_t lis3dh_fifo_read(const imu_bus_t *bus, uint8_t *raw, uint8_t count)
+{
+    if (bus->read(bus->ctx, LIS3DH_OUT_X_L | LIS3DH_AUTO_INCREMENT, raw, (size_t)count * 6) != 0) {
+        return IMU_ERR_BUS;
+    }
+    return IMU_OK;
+}
+
+static void lis3dh_decode(const uint8_t *raw, int16_t counts[3])
+{
+    /* Left justified 12 bit, little endian */
+    for (int axis = 0; axis < 3; axis++) {
+        counts[axis] = (int16_t)(raw[2 * axis] | (raw[2 * axis + 1] << 8)) >> 4;
+    }
+}
+
+const imu_regmap_t imu_regmap_lis3dh = {
+    .name = "lis3dh",
+    .fifo_depth = LIS3DH_FIFO_DEPTH,
+    .sample_bytes = 6,
+    .max_burst = LIS3DH_FIFO_DEPTH,
+    .probe = lis3dh_probe,
+    .configure = lis3dh_configure,
+    .fifo_level = lis3dh_fifo_level,
+    .fifo_read = lis3dh_fifo_read,
+    .decode = lis3dh_decode,
+};
+
+/* The register maps get a bus that counts the traffic on the way through */
+static int imu_counted_read(void *ctx, uint8_t reg, uint8_t *buf, size_t len)
+{
+    imu_t *imu = (imu_t *)ctx;
+    imu->stats.transfers++;
+    int err = imu->bus.read(imu->bus.ctx, reg, buf, len);
+    if (err != 0) {
+        imu->stats.bus_errors++;
+        return err;
+    }
+    imu->stats.bytes += len;
+    return 0;
+}
+
+static int imu_counted_write(void *ctx, uint8_t reg, uint8_t value)
+{
+    imu_t *imu = (imu_t *)ctx;
+    imu->stats.transfers++;
+    int err = imu->bus.write(imu->bus.ctx, reg, value);
+    if (err != 0) {
+        imu->stats.bus_errors++;
+    }
+    return err;
+}
+
+static inline imu_bus_t imu_counted_bus(imu_t *imu)
+{
+    return { imu, imu_counted_read, imu_counted_write };
+}
+
+imu_err_t imu_init(imu_t *imu, const imu_bus_t *bus, const imu_regmap_t *map, const imu_config_t *config)
+{
+    memset(imu, 0, sizeof(*imu));
+    imu->bus = *bus;
+    imu->map = map;
+    imu->config = *config;
+    if (map->sample_bytes * map->max_burst > IMU_MAX_BURST_BYTES) {
+        return IMU_ERR_CONFIG;
+    }
+
+    imu_bus_t counted = imu_counted_bus(imu);
+    imu_err_t err = map->probe(&counted);
+    if (err != IMU_OK) {
+        return err;
+    }
+    return map->configure(&counted, &imu->config, &imu->mg_per_lsb);
+}
+
+size_t imu_drain(imu_t *imu, imu_sample_t *samples, size_t max)
+{
+    const imu_regmap_t *map = imu->map;
+    imu_bus_t counted = imu_counted_bus(imu);
+    uint8_t level = 0;
+    bool overrun = false;
+    if (map->fifo_level(&counted, &level, &overrun) != IMU_OK) {
+        return 0;
+    }
+    if (overrun) {
+        imu->stats.overruns++;
+    }
+
+    size_t count = level < max ? level : max;
+    size_t done = 0;
+    uint8_t raw[IMU_MAX_BURST_BYTES];
+    while (done < count) {
+        uint8_t burst = count - done < map->max_burst ? count - done : map->max_burst;
+        if (map->fifo_read(&counted, raw, burst) != IMU_OK) {
+            break;
+        }
+        imu->stats.bursts++;
+        for (uint8_t i = 0; i < burst; i++) {
+            int16_t counts[3];
+            map->decode(raw + i * map->sample_bytes, counts);
+            imu_sample_t *sample = &samples[done + i];
+            sample->x = counts[0] * imu->mg_per_lsb;
+            sample->y = counts[1] * imu->mg_per_lsb;
+            sample->z = counts[2] * imu->mg_per_lsb;
+        }
+        done += burst;
+    }
+    if (done > 0) {
+        imu->stats.drains++;
+        imu->stats.samples += done;
+    }
+    return done;
+}
+
+const char *imu_err_name(imu_err_t err)
+{
+    switch (err) {
+    case IMU_OK:
+        return "ok";
+    case IMU_ERR_BUS:
+        return "bus error";
+    case IMU_ERR_ID:
+        return "unexpected chip ID";
+    case IMU_ERR_CONFIG:
+        return "unsupported configuration";
+    default:
+        return "unknown";
+    }
+}
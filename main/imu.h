@@ -0,0 +1,123 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Accelerometer FIFO driver.
+ *
+ * The driver reaches the device through two interfaces: a register bus (I2C on target, a
+ * simulated device on the host) and a register map (the chip specific registers and
+ * sequences). The chip buffers samples in its hardware FIFO and raises its interrupt at the
+ * watermark; a drain is then one FIFO level read plus one burst read of every stored sample,
+ * instead of polling the output registers sample by sample.
+ */
+
+/** Register bus */
+typedef struct {
+    void *ctx;
+    /** Write the register address, then read `len` bytes in the same transaction */
+    int (*read)(void *ctx, uint8_t reg, uint8_t *buf, size_t len);
+    /** Write one register */
+    int (*write)(void *ctx, uint8_t reg, uint8_t value);
+} imu_bus_t;
+
+typedef enum {
+    IMU_OK = 0,
+    IMU_ERR_BUS,    /* a bus transaction failed */
+    IMU_ERR_ID,     /* the identification register does not match the register map */
+    IMU_ERR_CONFIG, /* unsupported configuration */
+} imu_err_t;
+
+/** One accelerometer sample, in milli-g */
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} imu_sample_t;
+
+typedef struct {
+    uint16_t odr_hz;   /* output data rate, rounded up to one the chip supports */
+    uint8_t range_g;   /* full scale, rounded up to one the chip supports */
+    uint8_t watermark; /* FIFO level that raises the interrupt */
+} imu_config_t;
+
+/** Register map of one chip family */
+typedef struct {
+    const char *name;
+    uint8_t fifo_depth;       /* samples */
+    uint8_t sample_bytes;     /* bytes per sample in a FIFO burst */
+    uint8_t max_burst;        /* largest burst read, in samples */
+    /** Check the identification register */
+    imu_err_t (*probe)(const imu_bus_t *bus);
+    /** Reset the chip and start sampling into the FIFO, interrupt at the watermark
+     *
+     * @param[in,out] config Requested configuration, updated with the one applied.
+     * @param[out] mg_per_lsb Scale of the decoded samples, in milli-g per count.
+     */
+    imu_err_t (*configure)(const imu_bus_t *bus, imu_config_t *config, uint16_t *mg_per_lsb);
+    /** Read the FIFO level and overrun flag */
+    imu_err_t (*fifo_level)(const imu_bus_t *bus, uint8_t *level, bool *overrun);
+    /** Read `count` samples (up to max_burst) in one transaction into `raw` */
+    imu_err_t (*fifo_read)(const imu_bus_t *bus, uint8_t *raw, uint8_t count);
+    /** Convert one raw sample to counts */
+    void (*decode)(const uint8_t *raw, int16_t counts[3]);
+} imu_regmap_t;
+
+/** ST LIS3DH / LIS2DH12, 32 sample FIFO, high resolution mode */
+extern const imu_regmap_t imu_regmap_lis3dh;
+
+/** Largest burst of any register map, in bytes */
+#define IMU_MAX_BURST_BYTES (32 * 6)
+
+typedef struct {
+    uint32_t samples;    /* samples drained */
+    uint32_t drains;     /* imu_drain() calls that read samples */
+    uint32_t bursts;     /* FIFO burst reads */
+    uint32_t transfers;  /* bus transactions, reads and writes */
+    uint32_t bytes;      /* bytes read */
+    uint32_t overruns;   /* drains that found the FIFO overrun (samples lost) */
+    uint32_t bus_errors; /* failed transactions */
+} imu_stats_t;
+
+typedef struct {
+    imu_bus_t bus;
+    const imu_regmap_t *map;
+    imu_config_t config; /* as applied */
+    uint16_t mg_per_lsb;
+    imu_stats_t stats;
+} imu_t;
+
+/** Probe and configure the chip
+ *
+ * @param[out] imu Driver state.
+ * @param[in] bus Register bus, copied.
+ * @param[in] map Register map of the chip.
+ * @param[in] config Requested configuration.
+ *
+ * @return IMU_OK on success.
+ */
+imu_err_t imu_init(imu_t *imu, const imu_bus_t *bus, const imu_regmap_t *map, const imu_config_t *config);
+
+/** Drain the FIFO
+ *
+ * Reads the FIFO level, then every stored sample (up to `max`) in as few bursts as the
+ * register map allows: one for a FIFO of up to 32 samples.
+ *
+ * @param[in] imu Driver state.
+ * @param[out] samples Samples, oldest first.
+ * @param[in] max Capacity of `samples`.
+ *
+ * @return number of samples read, 0 on an empty FIFO or a bus error.
+ */
+size_t imu_drain(imu_t *imu, imu_sample_t *samples, size_t max);
+
+const char *imu_err_name(imu_err_t err);
@@ -0,0 +1,118 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <atomic>
+
+#include "latency_trace.h"
+
+typedef struct {
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> min_us;
+    std::atomic<uint32_t> max_us;
+    std::atomic<uint32_t> buckets[LATENCY_TRACE_BUCKETS];
+} latency_hist_t;
+
+static latency_hist_t s_hists[TRACE_SPAN_MAX];
+
+static const char *const k_span_names[TRACE_SPAN_MAX] = {
+    "edge->confirm",
+    "confirm->update",
+    "update",
+    "update->report",
+    "edge->report",
+    "edge->command",
+    "edge->response",
+    "timer late",
+};
+
+static inline uint32_t latency_bucket(uint32_t us)
+{
+    if (us < 2) {
+        return 0;
+    }
+    uint32_t bucket = 31 - __builtin_clz(us);
+    return bucket < LATENCY_TRACE_BUCKETS ? bucket : LATENCY_TRACE_BUCKETS - 1;
+}
+
+void latency_trace_record(trace_span_t span, int64_t start_us, int64_t end_us)
+{
+    if (span >= TRACE_SPAN_MAX || end_us < start_us) {
+        return;
+    }
+    int64_t duration = end_us - start_us;
+    uint32_t us = duration > UINT32_MAX ? UINT32_MAX : (uint32_t)duration;
+    latency_hist_t *hist = &s_hists[span];
+
+    hist->buckets[latency_bucket(us)].fetch_add(1, std::memory_order_relaxed);
+    uint32_t cur = hist->max_us.load(std::memory_order_relaxed);
+    while (us > cur && !hist->max_us.compare_exchange_weak(cur, us, std::memory_order_relaxed)) {
+    }
+    /* min_us is stored inverted so that a zeroed histogram means "no minimum yet" */
+    uint32_t inv = ~us;
+    cur = hist->min_us.load(std::memory_order_relaxed);
+    while (inv > cur && !hist->min_us.compare_exchange_weak(cur, inv, std::memory_order_relaxed)) {
+    }
+    hist->count.fetch_add(1, std::memory_order_release);
+}
+
+void latency_trace_snapshot(trace_span_t span, latency_hist_snapshot_t *snapshot)
+{
+    const latency_hist_t *hist = &s_hists[span];
+    snapshot->count = hist->count.load(std::memory_order_acquire);
+    snapshot->min_us = snapshot->count ? ~hist->min_us.load(std::memory_order_relaxed) : 0;
+    snapshot->max_us = hist->max_us.load(std::memory_order_relaxed);
+    for (int i = 0; i < LATENCY_TRACE_BUCKETS; i++) {
+        snapshot->buckets[i] = hist->buckets[i].load(std::memory_order_relaxed);
+    }
+}
+
+void latency_trace_reset()
+{
+    for (int span = 0; span < TRACE_SPAN_MAX; span++) {
+        latency_hist_t *hist = &s_hists[span];
+        hist->count.store(0, std::memory_order_relaxed);
+        hist->min_us.store(0, std::memory_order_relaxed);
+        hist->max_us.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < LATENCY_TRACE_BUCKETS; i++) {
+            hist->buckets[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+uint32_t latency_trace_percentile(const latency_hist_snapshot_t *snapshot, uint32_t percent)
+{
+    uint32_t total = 0;
+    for (int i = 0; i < LATENCY_TRACE_BUCKETS; i++) {
+        total += snapshot->buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = ((uint64_t)total * percent + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_TRACE_BUCKETS; i++) {
+        seen += snapshot->buckets[i];
+        if (seen >= rank) {
+            if (i == LATENCY_TRACE_BUCKETS - 1) {
+                /* Open ended, the max is the only bound */
+                return snapshot->max_us;
+            }
+            uint32_t upper = (2u << i) - 1;
+            return upper < snapshot->max_us ? upper : snapshot->max_us;
+        }
+    }
+    return snapshot->max_us;
+}
+
+const char *latency_trace_span_name(trace_span_t span)
+{
+    return span < TRACE_SPAN_MAX ? k_span_names[span] : "unknown";
+}
@@ -0,0 +1,69 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Edge-to-report latency tracing.
+ *
+ * Each span of the contact reporting path has a fixed-size histogram with power-of-two
+ * microsecond buckets. Recording is a few relaxed atomic operations, so it can be done from
+ * any task without a lock, and reading never stops the writers. Callers pass timestamps
+ * from esp_timer_get_time(), which the host build backs with the fake clock below.
+ */
+
+typedef enum {
+    TRACE_SPAN_EDGE_TO_CONFIRM = 0, /* edge interrupt -> debounced level confirmed */
+    TRACE_SPAN_CONFIRM_TO_UPDATE,   /* confirmed -> attribute::update() called on the Matter thread */
+    TRACE_SPAN_UPDATE,              /* attribute::update() duration */
+    TRACE_SPAN_UPDATE_TO_REPORT,    /* update returned -> report engine turn done */
+    TRACE_SPAN_EDGE_TO_REPORT,      /* end to end */
+    TRACE_SPAN_EDGE_TO_COMMAND,     /* edge interrupt -> OnOff command sent to a bound device or group */
+    TRACE_SPAN_EDGE_TO_RESPONSE,    /* edge interrupt -> bound device answered the command */
+    TRACE_SPAN_TIMER_LATE,          /* debounce timer due -> its callback running (esp_timer task scheduling) */
+    TRACE_SPAN_MAX,
+} trace_span_t;
+
+/* Bucket i holds samples in [2^i, 2^(i+1)) us, bucket 0 also holds 0; the last one is open ended */
+#define LATENCY_TRACE_BUCKETS 24
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t buckets[LATENCY_TRACE_BUCKETS];
+} latency_hist_snapshot_t;
+
+/** Record one span
+ *
+ * Negative durations (e.g. a missing start timestamp) are ignored.
+ */
+void latency_trace_record(trace_span_t span, int64_t start_us, int64_t end_us);
+
+/** Copy the histogram of a span
+ *
+ * Counters are read one by one, a snapshot taken while samples are recorded can be off by
+ * the samples in flight.
+ */
+void latency_trace_snapshot(trace_span_t span, latency_hist_snapshot_t *snapshot);
+
+/** Clear every histogram */
+void latency_trace_reset();
+
+/** Upper bound of the bucket holding the given percentile, in microseconds
+ *
+ * @param[in] snapshot Histogram snapshot.
+ * @param[in] percent Percentile, 0-100.
+ *
+ * @return bucket upper bound, capped at the max seen; 0 if the histogram is empty.
+ */
+uint32_t latency_trace_percentile(const latency_hist_snapshot_t *snapshot, uint32_t percent);
+
+const char *latency_trace_span_name(trace_span_t span);
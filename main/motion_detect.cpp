@@ -0,0 +1,179 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "motion_detect.h"
+
+/* cos(5 * i degrees) in Q15, i = 0..18 */
+static const int32_t k_cos_q15[] = {
+    32768, 32643, 32270, 31651, 30792, 29697, 28378, 26842, 25080, 23170,
+    21063, 18795, 16384, 13848, 11207, 8481, 5690, 2856, 0,
+};
+
+static uint8_t shift_for_samples(uint32_t samples)
+{
+    uint8_t shift = 0;
+    while ((2u << shift) <= samples && shift < 16) {
+        shift++;
+    }
+    return shift;
+}
+
+static uint64_t isqrt64(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ull << 62;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+static inline int32_t clamp16(int32_t value)
+{
+    return value > INT16_MAX ? INT16_MAX : value < -INT16_MAX ? -INT16_MAX : value;
+}
+
+void motion_detect_init(motion_detect_t *md, const motion_config_t *config)
+{
+    memset(md, 0, sizeof(*md));
+    uint32_t odr = config->odr_hz ? config->odr_hz : 1;
+    md->knock_sq = (uint32_t)config->knock_mg * config->knock_mg;
+    md->vibration_sq = (uint32_t)config->vibration_mg * config->vibration_mg;
+    md->quiet_sq = md->vibration_sq / 4;
+    md->knock_max_samples = (config->knock_max_ms * odr + 999) / 1000;
+    md->vibration_samples = (config->vibration_ms * odr + 999) / 1000;
+    md->gravity_shift = shift_for_samples(odr);
+    md->baseline_shift = shift_for_samples(odr * 20 / 1000);
+    /* Below ~100 Hz the baseline would follow the samples themselves */
+    if (md->baseline_shift == 0) {
+        md->baseline_shift = 1;
+    }
+    md->envelope_shift = shift_for_samples(odr * 40 / 1000);
+    /* About four gravity time constants */
+    md->settle_samples = 4u << md->gravity_shift;
+
+    uint32_t step = (config->tilt_deg + 2) / 5;
+    step = step < 1 ? 1 : step > 17 ? 17 : step;
+    md->tilt_cos_q15 = k_cos_q15[step];
+}
+
+/* Whether the gravity direction is more than the threshold away from the reference. Untilt
+ * needs to come back within one 5 degree step less, so a slow drift does not flap. */
+static bool motion_tilted(const motion_detect_t *md, const int32_t gravity[3])
+{
+    int64_t dot = 0;
+    uint64_t norm_g = 0;
+    uint64_t norm_r = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        dot += (int64_t)gravity[axis] * md->reference[axis];
+        norm_g += (int64_t)gravity[axis] * gravity[axis];
+        norm_r += (int64_t)md->reference[axis] * md->reference[axis];
+    }
+    if (norm_g == 0 || norm_r == 0) {
+        return md->tilted;
+    }
+    int32_t cos_q15 = md->tilt_cos_q15;
+    if (md->tilted) {
+        for (size_t i = 1; i < sizeof(k_cos_q15) / sizeof(k_cos_q15[0]); i++) {
+            if (k_cos_q15[i] == cos_q15) {
+                cos_q15 = k_cos_q15[i - 1];
+                break;
+            }
+        }
+    }
+    /* |g| |r| cos(threshold) against g.r, both well inside 64 bits for milli-g inputs */
+    int64_t norms = (int64_t)isqrt64(norm_g) * (int64_t)isqrt64(norm_r);
+    return dot * 32768 < norms * cos_q15;
+}
+
+uint8_t motion_detect_feed(motion_detect_t *md, const imu_sample_t *samples, size_t count)
+{
+    uint8_t events = 0;
+    for (size_t i = 0; i < count; i++) {
+        const int32_t accel[3] = { samples[i].x, samples[i].y, samples[i].z };
+        uint32_t magnitude_sq = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            if (md->seen == 0) {
+                md->gravity_q8[axis] = accel[axis] * 256;
+                md->baseline_q8[axis] = accel[axis] * 256;
+            }
+            md->gravity_q8[axis] += (accel[axis] * 256 - md->gravity_q8[axis]) >> md->gravity_shift;
+            int32_t dynamic = clamp16(accel[axis] - (md->baseline_q8[axis] >> 8));
+            md->baseline_q8[axis] += (accel[axis] * 256 - md->baseline_q8[axis]) >> md->baseline_shift;
+            magnitude_sq += (uint32_t)(dynamic * dynamic);
+        }
+        md->envelope += ((int64_t)magnitude_sq - md->envelope) >> md->envelope_shift;
+        md->seen++;
+        if (md->seen < md->settle_samples) {
+            continue;
+        }
+
+        if (!md->active && md->envelope > md->vibration_sq) {
+            md->active = true;
+            md->active_samples = 0;
+            md->loud_samples = 0;
+            md->ring_samples = 0;
+            md->peak_sq = 0;
+        }
+        if (!md->active) {
+            continue;
+        }
+        md->active_samples++;
+        if (md->envelope > md->vibration_sq) {
+            md->loud_samples++;
+        }
+        if (magnitude_sq > md->vibration_sq) {
+            md->ring_samples++;
+        }
+        if (magnitude_sq > md->peak_sq) {
+            md->peak_sq = magnitude_sq;
+        }
+        if (!md->vibrating && md->loud_samples >= md->vibration_samples) {
+            md->vibrating = true;
+            events |= MOTION_EVENT_VIBRATION;
+        }
+        if (md->envelope < md->quiet_sq) {
+            md->active = false;
+            md->peak_mg = (uint16_t)isqrt64(md->peak_sq);
+            if (md->vibrating) {
+                md->vibrating = false;
+                events |= MOTION_EVENT_VIBRATION;
+            } else if (md->ring_samples <= md->knock_max_samples && md->peak_sq >= md->knock_sq) {
+                md->knocks++;
+                events |= MOTION_EVENT_KNOCK;
+            }
+        }
+    }
+
+    /* Gravity moves slowly, once per batch is enough; impacts bend it, so wait for quiet */
+    if (md->seen >= md->settle_samples && !md->active) {
+        int32_t gravity[3];
+        for (int axis = 0; axis < 3; axis++) {
+            gravity[axis] = md->gravity_q8[axis] >> 8;
+        }
+        if (!md->have_reference) {
+            memcpy(md->reference, gravity, sizeof(gravity));
+            md->have_reference = true;
+        } else if (motion_tilted(md, gravity) != md->tilted) {
+            md->tilted = !md->tilted;
+            events |= MOTION_EVENT_TILT;
+        }
+    }
+    return events;
+}
@@ -0,0 +1,93 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "imu.h"
+
+/*
+ * Knock, vibration and tilt detection on accelerometer samples, integer only.
+ *
+ * A slow low-pass per axis tracks gravity for the tilt check. A short one (about 20 ms) is
+ * the baseline of the dynamic acceleration, so turning the sensor over does not read as
+ * vibration. The squared magnitude of the dynamic acceleration feeds an energy envelope:
+ * - knock: the envelope rises above the vibration level, and the dynamic acceleration itself
+ *   rings above that level for no more than `knock_max_ms`, with a peak above `knock_mg`
+ *   (the envelope decay would make a hard knock look long);
+ * - vibration: the envelope stays above the vibration level for `vibration_ms`
+ *   (drilling, sawing, a door being forced);
+ * - tilt: the gravity direction moved more than `tilt_deg` away from the reference taken
+ *   once the sensor settled after start (the sensor or the door leaf being removed).
+ */
+
+typedef struct {
+    uint16_t odr_hz;
+    uint16_t knock_mg;     /* dynamic acceleration peak of a knock */
+    uint16_t knock_max_ms; /* a knock is over within this */
+    uint16_t vibration_mg; /* envelope level of vibration (RMS of the dynamic acceleration) */
+    uint16_t vibration_ms; /* vibration lasting this long is reported */
+    uint16_t tilt_deg;     /* 5 to 85, rounded to a multiple of 5 */
+} motion_config_t;
+
+/** Events raised by one motion_detect_feed() call */
+#define MOTION_EVENT_KNOCK 0x01     /* one or more knocks, see `knocks` */
+#define MOTION_EVENT_VIBRATION 0x02 /* `vibrating` changed */
+#define MOTION_EVENT_TILT 0x04      /* `tilted` changed */
+
+typedef struct {
+    /* Configuration, in samples and squared milli-g */
+    uint32_t knock_sq;
+    uint32_t vibration_sq;
+    uint32_t quiet_sq;        /* envelope level that ends an activity, vibration_sq / 4 */
+    uint32_t knock_max_samples;
+    uint32_t vibration_samples;
+    uint32_t settle_samples;  /* samples before the gravity reference is taken */
+    int32_t tilt_cos_q15;     /* cosine of the tilt threshold */
+    uint8_t gravity_shift;    /* gravity low-pass, time constant about 1 s */
+    uint8_t baseline_shift;   /* dynamic acceleration baseline, time constant about 20 ms */
+    uint8_t envelope_shift;   /* energy envelope, time constant about 40 ms */
+
+    /* State */
+    int32_t gravity_q8[3];    /* low-passed acceleration, milli-g << 8 */
+    int32_t baseline_q8[3];   /* same, short time constant */
+    int32_t reference[3];     /* gravity at reference time, milli-g */
+    bool have_reference;
+    uint32_t envelope;        /* low-passed squared dynamic acceleration */
+    bool active;              /* envelope went above the vibration level, not quiet yet */
+    uint32_t active_samples;
+    uint32_t loud_samples;    /* samples of the activity with the envelope above the vibration level */
+    uint32_t ring_samples;    /* samples of the activity with the acceleration above the vibration level */
+    uint32_t peak_sq;         /* largest squared dynamic acceleration of the activity */
+    uint32_t seen;            /* samples fed */
+
+    /* Results */
+    bool vibrating;
+    bool tilted;
+    uint32_t knocks;          /* knocks since init */
+    uint16_t peak_mg;         /* peak of the last activity */
+} motion_detect_t;
+
+/** Initialize a detector
+ *
+ * @param[out] md Detector state.
+ * @param[in] config Thresholds.
+ */
+void motion_detect_init(motion_detect_t *md, const motion_config_t *config);
+
+/** Run the detector on a batch of samples
+ *
+ * @param[in,out] md Detector state.
+ * @param[in] samples Samples, oldest first.
+ * @param[in] count Number of samples.
+ *
+ * @return MOTION_EVENT_* flags.
+ */
+uint8_t motion_detect_feed(motion_detect_t *md, const imu_sample_t *samples, size_t count);
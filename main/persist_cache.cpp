@@ -0,0 +1,220 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "persist_cache.h"
+
+void persist_cache_init(persist_cache_t *pc, const persist_backend_t *backend, persist_entry_t *entries,
+                        uint16_t capacity, uint32_t max_delay_ms)
+{
+    memset(pc, 0, sizeof(*pc));
+    pc->backend = *backend;
+    pc->entries = entries;
+    pc->capacity = capacity;
+    pc->max_delay_ms = max_delay_ms;
+    memset(entries, 0, capacity * sizeof(*entries));
+}
+
+static bool persist_name_ok(const char *name)
+{
+    return name[0] != '\0' && strnlen(name, PERSIST_NAME_MAX) < PERSIST_NAME_MAX;
+}
+
+static persist_entry_t *persist_cache_find(const persist_cache_t *pc, const char *ns, const char *key)
+{
+    for (uint16_t i = 0; i < pc->count; i++) {
+        persist_entry_t *entry = &pc->entries[i];
+        if (strcmp(entry->key, key) == 0 && strcmp(entry->ns, ns) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/* A free slot, or the least recently set clean one; NULL if all are dirty */
+static persist_entry_t *persist_cache_slot(persist_cache_t *pc)
+{
+    if (pc->count < pc->capacity) {
+        return &pc->entries[pc->count++];
+    }
+    persist_entry_t *victim = NULL;
+    for (uint16_t i = 0; i < pc->count; i++) {
+        persist_entry_t *entry = &pc->entries[i];
+        if (!entry->dirty && (!victim || entry->used < victim->used)) {
+            victim = entry;
+        }
+    }
+    return victim;
+}
+
+static void persist_cache_fill(persist_entry_t *entry, const char *ns, const char *key, const void *data, size_t len)
+{
+    strcpy(entry->ns, ns);
+    strcpy(entry->key, key);
+    entry->len = (uint8_t)len;
+    memcpy(entry->data, data, len);
+}
+
+void persist_cache_preload(persist_cache_t *pc, const char *ns, const char *key, const void *data, size_t len)
+{
+    if (!persist_name_ok(ns) || !persist_name_ok(key) || len > PERSIST_VALUE_MAX ||
+        persist_cache_find(pc, ns, key)) {
+        return;
+    }
+    persist_entry_t *entry = persist_cache_slot(pc);
+    if (entry) {
+        persist_cache_fill(entry, ns, key, data, len);
+        entry->dirty = false;
+        entry->used = pc->sequence++;
+    }
+}
+
+int persist_cache_set(persist_cache_t *pc, const char *ns, const char *key, const void *data, size_t len,
+                      int64_t now_us)
+{
+    if (!persist_name_ok(ns) || !persist_name_ok(key) || len > PERSIST_VALUE_MAX) {
+        return -1;
+    }
+    pc->stats.sets++;
+    int result = 0;
+    persist_entry_t *entry = persist_cache_find(pc, ns, key);
+    if (entry) {
+        bool same = entry->len == len && memcmp(entry->data, data, len) == 0;
+        entry->used = pc->sequence++;
+        if (same) {
+            if (entry->dirty) {
+                pc->stats.coalesced++;
+            } else {
+                pc->stats.unchanged++;
+            }
+            return 0;
+        }
+        if (entry->dirty) {
+            pc->stats.coalesced++;
+        }
+    } else {
+        entry = persist_cache_slot(pc);
+        if (!entry) {
+            /* Every slot dirty: write the batch now rather than lose a value */
+            pc->stats.early++;
+            if (persist_cache_flush(pc, now_us) != 0) {
+                result = -2;
+            }
+            entry = persist_cache_slot(pc);
+            if (!entry) {
+                return -2;
+            }
+        }
+    }
+    persist_cache_fill(entry, ns, key, data, len);
+    entry->used = pc->sequence++;
+    if (!entry->dirty) {
+        entry->dirty = true;
+        if (pc->dirty++ == 0) {
+            pc->dirty_since_us = now_us;
+        }
+    }
+    if (pc->max_delay_ms == 0 && persist_cache_flush(pc, now_us) != 0) {
+        result = -2;
+    }
+    return result;
+}
+
+bool persist_cache_get(const persist_cache_t *pc, const char *ns, const char *key, void *data, size_t *len)
+{
+    const persist_entry_t *entry = persist_cache_find(pc, ns, key);
+    if (!entry || entry->len > *len) {
+        return false;
+    }
+    memcpy(data, entry->data, entry->len);
+    *len = entry->len;
+    return true;
+}
+
+int64_t persist_cache_deadline(const persist_cache_t *pc)
+{
+    if (pc->dirty == 0) {
+        return INT64_MAX;
+    }
+    return pc->dirty_since_us + (int64_t)pc->max_delay_ms * 1000;
+}
+
+int persist_cache_flush(persist_cache_t *pc, int64_t now_us)
+{
+    if (pc->dirty == 0) {
+        return 0;
+    }
+    int errors = 0;
+    uint32_t batch = 0;
+    for (uint16_t i = 0; i < pc->count; i++) {
+        if (!pc->entries[i].dirty) {
+            continue;
+        }
+        /* Everything of this namespace, then its commit */
+        const char *ns = pc->entries[i].ns;
+        bool wrote = false;
+        for (uint16_t j = i; j < pc->count; j++) {
+            persist_entry_t *entry = &pc->entries[j];
+            if (!entry->dirty || strcmp(entry->ns, ns) != 0) {
+                continue;
+            }
+            if (pc->backend.write(pc->backend.ctx, entry->ns, entry->key, entry->data, entry->len) != 0) {
+                /* Keep it dirty, skipped for the rest of this flush */
+                errors++;
+                continue;
+            }
+            entry->dirty = false;
+            pc->dirty--;
+            pc->stats.writes++;
+            pc->stats.nvs_entries += persist_nvs_blob_entries(entry->len);
+            batch++;
+            wrote = true;
+        }
+        if (wrote) {
+            pc->stats.commits++;
+            if (pc->backend.commit(pc->backend.ctx, ns) != 0) {
+                errors++;
+            }
+        }
+        if (errors) {
+            break;
+        }
+    }
+    pc->stats.flushes++;
+    if (batch > pc->stats.max_batch) {
+        pc->stats.max_batch = batch;
+    }
+    pc->stats.errors += errors;
+    /* What failed waits for the next deadline */
+    pc->dirty_since_us = now_us;
+    return errors;
+}
+
+void persist_cache_set_delay(persist_cache_t *pc, uint32_t max_delay_ms)
+{
+    pc->max_delay_ms = max_delay_ms;
+}
+
+uint32_t persist_nvs_blob_entries(size_t len)
+{
+    return 2 + (uint32_t)((len + PERSIST_NVS_ENTRY_BYTES - 1) / PERSIST_NVS_ENTRY_BYTES);
+}
+
+uint32_t persist_projected_days(uint64_t nvs_entries, uint64_t elapsed_s, uint32_t partition_bytes)
+{
+    uint32_t pages = partition_bytes / PERSIST_NVS_PAGE_BYTES;
+    if (nvs_entries == 0 || pages == 0) {
+        return UINT32_MAX;
+    }
+    /* Entries the partition takes before every page went through one erase, times the
+     * endurance, at the observed rate */
+    double entries_per_day = (double)nvs_entries * 86400.0 / (elapsed_s ? elapsed_s : 1);
+    double days = (double)PERSIST_FLASH_ENDURANCE * pages * PERSIST_NVS_PAGE_ENTRIES / entries_per_day;
+    return days >= UINT32_MAX ? UINT32_MAX : (uint32_t)days;
+}
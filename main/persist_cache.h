@@ -0,0 +1,141 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Write-behind cache in front of NVS for small settings (report policies, binding actions,
+ * calibration).
+ *
+ * Values are held in RAM with the namespace and key they belong to:
+ * - a set of the value already on flash costs nothing;
+ * - a set of a value not flushed yet replaces it in RAM (coalesced);
+ * - dirty values are written in one batch, one commit per namespace, once the oldest has
+ *   waited `max_delay_ms`, which bounds what a power cut can lose. 0 writes every set
+ *   through.
+ * A full table flushes early to make room.
+ *
+ * Flash wear is counted in NVS entries of 32 bytes: a blob takes an index entry, a data
+ * header entry and its data rounded up to whole entries. A 4 KB page holds 126 entries and,
+ * the pages taking turns, is erased once per 126 entries written to the partition.
+ *
+ * Like report_policy, no ESP-IDF dependency: the caller passes the time and the NVS calls
+ * behind `persist_backend_t`. Not thread safe.
+ */
+
+#define PERSIST_NAME_MAX 16  /* namespace or key, terminator included, as NVS */
+#define PERSIST_VALUE_MAX 32
+
+#define PERSIST_NVS_ENTRY_BYTES 32
+#define PERSIST_NVS_PAGE_BYTES 4096
+#define PERSIST_NVS_PAGE_ENTRIES 126
+#define PERSIST_FLASH_ENDURANCE 100000 /* erase cycles per sector */
+
+/** Storage under the cache, 0 on success */
+typedef struct {
+    void *ctx;
+    int (*write)(void *ctx, const char *ns, const char *key, const void *data, size_t len);
+    int (*commit)(void *ctx, const char *ns);
+} persist_backend_t;
+
+typedef struct {
+    char ns[PERSIST_NAME_MAX];
+    char key[PERSIST_NAME_MAX];
+    uint8_t len;
+    bool dirty;           /* newer than flash */
+    uint32_t used;        /* sequence of the last set, for eviction */
+    uint8_t data[PERSIST_VALUE_MAX];
+} persist_entry_t;
+
+typedef struct {
+    uint32_t sets;
+    uint32_t unchanged;   /* sets of the value already on flash */
+    uint32_t coalesced;   /* sets replacing a value not flushed yet */
+    uint32_t flushes;     /* batches written */
+    uint32_t early;       /* batches written before the deadline to make room */
+    uint32_t writes;      /* values written to the backend */
+    uint32_t commits;
+    uint32_t errors;      /* failed writes and commits, the values stay dirty */
+    uint32_t max_batch;   /* most values in one batch */
+    uint64_t nvs_entries; /* NVS entries the writes took */
+} persist_stats_t;
+
+typedef struct {
+    persist_backend_t backend;
+    persist_entry_t *entries;
+    uint16_t capacity;
+    uint16_t count;
+    uint16_t dirty;
+    uint32_t max_delay_ms;
+    int64_t dirty_since_us; /* when the oldest dirty value was set */
+    uint32_t sequence;
+    persist_stats_t stats;
+} persist_cache_t;
+
+/** Initialize a cache
+ *
+ * @param[out] pc Cache state.
+ * @param[in] backend Storage, called from persist_cache_set() and persist_cache_flush().
+ * @param[in] entries Table of `capacity` entries, owned by the caller.
+ * @param[in] max_delay_ms Longest a value stays in RAM only, 0 to write through.
+ */
+void persist_cache_init(persist_cache_t *pc, const persist_backend_t *backend, persist_entry_t *entries,
+                        uint16_t capacity, uint32_t max_delay_ms);
+
+/** Record a value read from flash, so setting it again costs nothing
+ *
+ * A dirty value of the same key is kept. Nothing is recorded when the table is full of dirty
+ * values.
+ */
+void persist_cache_preload(persist_cache_t *pc, const char *ns, const char *key, const void *data, size_t len);
+
+/** Set a value
+ *
+ * @return 0 on success, -1 on a name or value too long, -2 if a write-through or an early
+ *         flush failed (the value is kept dirty if it could be).
+ */
+int persist_cache_set(persist_cache_t *pc, const char *ns, const char *key, const void *data, size_t len,
+                      int64_t now_us);
+
+/** Look a value up in RAM
+ *
+ * @param[out] data Value, `*len` bytes at most.
+ * @param[in,out] len Buffer size in, value length out.
+ *
+ * @return false if the key is not cached or the buffer too small.
+ */
+bool persist_cache_get(const persist_cache_t *pc, const char *ns, const char *key, void *data, size_t *len);
+
+/** When persist_cache_flush() is due, INT64_MAX with nothing dirty */
+int64_t persist_cache_deadline(const persist_cache_t *pc);
+
+/** Write every dirty value, grouped by namespace
+ *
+ * @return number of failed writes and commits.
+ */
+int persist_cache_flush(persist_cache_t *pc, int64_t now_us);
+
+/** Change the delay, a pending batch gets the new deadline */
+void persist_cache_set_delay(persist_cache_t *pc, uint32_t max_delay_ms);
+
+/** NVS entries a blob of `len` bytes takes */
+uint32_t persist_nvs_blob_entries(size_t len);
+
+/** Days until the most worn sector of an NVS partition reaches PERSIST_FLASH_ENDURANCE
+ *
+ * @param[in] nvs_entries Entries written over `elapsed_s`.
+ * @param[in] elapsed_s Observation time.
+ * @param[in] partition_bytes Size of the NVS partition.
+ *
+ * @return days, UINT32_MAX with nothing written.
+ */
+uint32_t persist_projected_days(uint64_t nvs_entries, uint64_t elapsed_s, uint32_t partition_bytes);
@@ -0,0 +1,105 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Power state accounting.
+ *
+ * Accumulates the time spent in each power state from timestamped transitions, so the
+ * duty cycle of a sleepy node can be checked from the device itself. Transitions are fed
+ * from the light sleep hooks, which run with interrupts disabled, so everything here is
+ * forced inline and does not depend on ESP-IDF.
+ */
+
+typedef enum {
+    POWER_STATE_ACTIVE = 0,
+    POWER_STATE_LIGHT_SLEEP,
+    POWER_STATE_MAX,
+} power_state_t;
+
+typedef struct {
+    power_state_t state;
+    int64_t since_us;                  /* start of the current interval */
+    int64_t start_us;                  /* start of accounting */
+    int64_t time_us[POWER_STATE_MAX];  /* closed intervals only */
+    uint32_t entries[POWER_STATE_MAX]; /* times each state was entered */
+} power_account_t;
+
+#define POWER_ACCOUNT_INLINE static inline __attribute__((always_inline))
+
+POWER_ACCOUNT_INLINE void power_account_init(power_account_t *pa, int64_t now_us, power_state_t state)
+{
+    memset(pa, 0, sizeof(*pa));
+    pa->state = state;
+    pa->since_us = now_us;
+    pa->start_us = now_us;
+    pa->entries[state] = 1;
+}
+
+/** Close the current interval and enter `state` */
+POWER_ACCOUNT_INLINE void power_account_transition(power_account_t *pa, int64_t now_us, power_state_t state)
+{
+    if (now_us > pa->since_us) {
+        pa->time_us[pa->state] += now_us - pa->since_us;
+    }
+    pa->since_us = now_us;
+    if (state != pa->state) {
+        pa->state = state;
+        pa->entries[state]++;
+    }
+}
+
+/** Account an interval of known length spent in `state` that ended at `now_us`
+ *
+ * Used when the clock did not run across the interval (e.g. light sleep), the time is
+ * moved from the current state to `state`.
+ */
+POWER_ACCOUNT_INLINE void power_account_add(power_account_t *pa, int64_t now_us, power_state_t state,
+                                            int64_t duration_us)
+{
+    power_account_transition(pa, now_us, pa->state);
+    if (state != pa->state) {
+        int64_t moved = duration_us < pa->time_us[pa->state] ? duration_us : pa->time_us[pa->state];
+        pa->time_us[pa->state] -= moved;
+    }
+    pa->time_us[state] += duration_us;
+    pa->entries[state]++;
+}
+
+/** Time per state including the running interval
+ *
+ * @param[in] pa Accounting state.
+ * @param[in] now_us Current time.
+ * @param[out] time_us Time per state, POWER_STATE_MAX entries.
+ *
+ * @return Total accounted time.
+ */
+static inline int64_t power_account_snapshot(const power_account_t *pa, int64_t now_us, int64_t *time_us)
+{
+    int64_t total = 0;
+    for (int i = 0; i < POWER_STATE_MAX; i++) {
+        time_us[i] = pa->time_us[i];
+        if (i == pa->state && now_us > pa->since_us) {
+            time_us[i] += now_us - pa->since_us;
+        }
+        total += time_us[i];
+    }
+    return total;
+}
+
+/** Share of `state` in the accounted time, in per mille */
+static inline uint32_t power_account_permille(const power_account_t *pa, int64_t now_us, power_state_t state)
+{
+    int64_t time_us[POWER_STATE_MAX];
+    int64_t total = power_account_snapshot(pa, now_us, time_us);
+    return total > 0 ? (uint32_t)(time_us[state] * 1000 / total) : 0;
+}
@@ -0,0 +1,118 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "report_policy.h"
+
+static inline int64_t max64(int64_t a, int64_t b)
+{
+    return a > b ? a : b;
+}
+
+void report_policy_init(report_policy_t *rp, const report_policy_config_t *config, bool level)
+{
+    memset(rp, 0, sizeof(*rp));
+    rp->config = *config;
+    rp->level = level;
+    rp->reported = level;
+}
+
+static inline int64_t report_policy_window_end(const report_policy_t *rp)
+{
+    return rp->window_start_us + (int64_t)rp->config.window_ms * 1000;
+}
+
+static uint8_t report_policy_evaluate(report_policy_t *rp, int64_t now_us)
+{
+    /* The first report opens the first window */
+    bool window_over = !rp->have_report || now_us >= report_policy_window_end(rp);
+    bool change = rp->level != rp->reported;
+    if (!change && !(rp->window_held && window_over)) {
+        /* Back to the reported level: what happened since was for nothing. A summary is
+         * still due if the cap held transitions back. */
+        rp->suppressed += rp->unreported;
+        rp->unreported = 0;
+        rp->armed = rp->window_held != 0;
+        rp->deadline_us = report_policy_window_end(rp);
+        return rp->armed ? REPORT_POLICY_ARM : REPORT_POLICY_NONE;
+    }
+
+    if (change) {
+        int64_t allowed = rp->last_change_us + (int64_t)rp->config.holdoff_ms * 1000;
+        if (rp->have_report) {
+            allowed = max64(allowed, rp->last_report_us + (int64_t)rp->config.min_interval_ms * 1000);
+        }
+        if (rp->config.max_reports && rp->window_reports >= rp->config.max_reports && !window_over) {
+            allowed = max64(allowed, report_policy_window_end(rp));
+        }
+        if (now_us < allowed) {
+            rp->armed = true;
+            rp->deadline_us = allowed;
+            return REPORT_POLICY_ARM;
+        }
+    }
+
+    uint8_t flags = REPORT_POLICY_NONE;
+    if (rp->window_held && window_over) {
+        flags |= REPORT_POLICY_SUMMARY;
+        rp->summary_held = rp->window_held;
+        rp->window_held = 0;
+        rp->summaries++;
+    }
+    rp->report_transitions = rp->unreported;
+    if (change) {
+        flags |= REPORT_POLICY_REPORT;
+        if (window_over) {
+            rp->window_start_us = now_us;
+            rp->window_reports = 0;
+        }
+        rp->window_reports++;
+        rp->reported = rp->level;
+        rp->last_report_us = now_us;
+        rp->have_report = true;
+        rp->reports++;
+        rp->suppressed += rp->unreported - 1;
+    } else {
+        rp->suppressed += rp->unreported;
+    }
+    rp->unreported = 0;
+    rp->armed = false;
+    return flags;
+}
+
+uint8_t report_policy_configure(report_policy_t *rp, const report_policy_config_t *config, int64_t now_us)
+{
+    rp->config = *config;
+    return report_policy_evaluate(rp, now_us);
+}
+
+uint8_t report_policy_on_change(report_policy_t *rp, int64_t now_us, bool level, uint32_t transitions)
+{
+    bool capped = rp->config.max_reports && rp->window_reports >= rp->config.max_reports &&
+                  now_us < report_policy_window_end(rp);
+    if (capped) {
+        rp->window_held += transitions;
+    }
+    rp->transitions += transitions;
+    rp->unreported += transitions;
+    rp->level = level;
+    rp->last_change_us = now_us;
+    return report_policy_evaluate(rp, now_us);
+}
+
+uint8_t report_policy_on_timer(report_policy_t *rp, int64_t now_us)
+{
+    if (!rp->armed) {
+        return REPORT_POLICY_NONE;
+    }
+    if (now_us < rp->deadline_us) {
+        return REPORT_POLICY_ARM;
+    }
+    return report_policy_evaluate(rp, now_us);
+}
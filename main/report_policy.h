@@ -0,0 +1,106 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Report policy of one endpoint, between the debounced sensor transitions and the data
+ * model: every attribute change becomes a subscription report over Thread, so a chattering
+ * contact (loose strike plate, window rattling in the wind) is throttled here.
+ *
+ * - hold-off: a new level is reported once it held for `holdoff_ms`;
+ * - minimum interval: two reports are at least `min_interval_ms` apart;
+ * - cap: at most `max_reports` reports per `window_ms` window (the window opens with its
+ *   first report). Transitions past the cap are held back; when the window ends the latest
+ *   level is reported with a summary of what was held back.
+ *
+ * A level that went back to the reported one before it could be reported costs nothing.
+ * Transitions that do not make it into the data model one by one are counted.
+ *
+ * Like contact_debounce, no ESP-IDF dependency: the caller feeds transitions and timer
+ * expiries and gets told what to report and when to call back.
+ */
+
+/** Returned by the event functions, OR-ed together */
+#define REPORT_POLICY_NONE 0x00
+#define REPORT_POLICY_REPORT 0x01  /* report `level`, it differs from the data model */
+#define REPORT_POLICY_SUMMARY 0x02 /* a capped window closed, `summary_held` transitions were held back */
+#define REPORT_POLICY_ARM 0x04     /* call report_policy_on_timer() at `deadline_us` */
+
+typedef struct {
+    uint32_t min_interval_ms; /* 0: no minimum */
+    uint32_t holdoff_ms;      /* 0: report right away */
+    uint16_t max_reports;     /* per window, 0: no cap */
+    uint32_t window_ms;
+} report_policy_config_t;
+
+typedef struct {
+    report_policy_config_t config;
+    bool level;              /* latest level from the sensor */
+    bool reported;           /* level in the data model */
+    bool armed;              /* `deadline_us` is valid */
+    int64_t deadline_us;
+    int64_t last_change_us;
+    int64_t last_report_us;
+    bool have_report;        /* `last_report_us` is valid */
+    int64_t window_start_us;
+    uint16_t window_reports;
+    uint32_t window_held;    /* transitions past the cap in the current window */
+    uint32_t unreported;     /* transitions since the last report */
+
+    /* Set with REPORT_POLICY_REPORT / REPORT_POLICY_SUMMARY */
+    uint32_t report_transitions; /* transitions the report stands for */
+    uint32_t summary_held;
+
+    /* Counters since init */
+    uint32_t transitions;
+    uint32_t reports;
+    uint32_t suppressed; /* transitions not reported on their own */
+    uint32_t summaries;
+} report_policy_t;
+
+/** Initialize the policy of an endpoint
+ *
+ * @param[out] rp Policy state.
+ * @param[in] config Policy configuration.
+ * @param[in] level Level in the data model.
+ */
+void report_policy_init(report_policy_t *rp, const report_policy_config_t *config, bool level);
+
+/** Change the configuration, the state is kept
+ *
+ * @param[in] rp Policy state.
+ * @param[in] config New configuration.
+ * @param[in] now_us Current time.
+ *
+ * @return REPORT_POLICY_* flags: a held back level may be due under the new configuration.
+ */
+uint8_t report_policy_configure(report_policy_t *rp, const report_policy_config_t *config, int64_t now_us);
+
+/** Feed debounced transitions
+ *
+ * @param[in] rp Policy state.
+ * @param[in] now_us Time of the last transition.
+ * @param[in] level Level after the transitions.
+ * @param[in] transitions Number of transitions merged into this call, at least 1.
+ *
+ * @return REPORT_POLICY_* flags.
+ */
+uint8_t report_policy_on_change(report_policy_t *rp, int64_t now_us, bool level, uint32_t transitions);
+
+/** Feed a timer expiry
+ *
+ * @param[in] rp Policy state.
+ * @param[in] now_us Current time.
+ *
+ * @return REPORT_POLICY_* flags.
+ */
+uint8_t report_policy_on_timer(report_policy_t *rp, int64_t now_us);
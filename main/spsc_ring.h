@@ -0,0 +1,79 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+/*
+ * Lock-free single-producer/single-consumer ring buffer.
+ *
+ * `push()` must only be called from one context and `pop()` from one other context.
+ * Neither blocks nor allocates, so the producer side can run in an ISR or the esp_timer
+ * task. Items are copied in and out, keep `T` small and trivially copyable.
+ */
+template <typename T, size_t N>
+class spsc_ring {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "spsc_ring size must be a power of two");
+
+public:
+    /** Producer side. Returns false and counts a drop if the ring is full. */
+    bool push(const T &item)
+    {
+        uint32_t head = m_head.load(std::memory_order_relaxed);
+        uint32_t tail = m_tail.load(std::memory_order_acquire);
+        if (head - tail >= N) {
+            m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        m_items[head & (N - 1)] = item;
+        m_head.store(head + 1, std::memory_order_release);
+
+        uint32_t depth = head + 1 - tail;
+        if (depth > m_high_water.load(std::memory_order_relaxed)) {
+            m_high_water.store(depth, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    /** Consumer side. Returns false if the ring is empty. */
+    bool pop(T *item)
+    {
+        uint32_t tail = m_tail.load(std::memory_order_relaxed);
+        uint32_t head = m_head.load(std::memory_order_acquire);
+        if (tail == head) {
+            return false;
+        }
+        *item = m_items[tail & (N - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Approximate number of queued items, exact when called from either side */
+    size_t size() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+    /** Items pushed since creation, drops excluded */
+    uint32_t pushed() const { return m_head.load(std::memory_order_relaxed); }
+    uint32_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    uint32_t high_water() const { return m_high_water.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> m_head{0};
+    std::atomic<uint32_t> m_tail{0};
+    std::atomic<uint32_t> m_dropped{0};
+    std::atomic<uint32_t> m_high_water{0};
+    T m_items[N];
+};
@@ -0,0 +1,87 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "storm_gen.h"
+
+static uint32_t storm_rand(storm_gen_t *gen)
+{
+    /* xorshift32 */
+    uint32_t x = gen->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    gen->rng = x;
+    return x;
+}
+
+/* Time of transition number `gen->emitted` */
+static int64_t storm_gen_schedule(storm_gen_t *gen, int64_t prev_us)
+{
+    const storm_config_t *config = &gen->config;
+    int64_t at;
+    switch (config->pattern) {
+    case STORM_BURST: {
+        uint64_t burst = gen->emitted / config->burst_len;
+        at = gen->start_us + (int64_t)(burst * config->burst_len * 1000000 / config->rate_hz);
+        break;
+    }
+    case STORM_RANDOM: {
+        /* Uniform in (0, 1], never 0 for the log */
+        double u = ((double)(storm_rand(gen) >> 8) + 1.0) / 16777216.0;
+        at = prev_us + (int64_t)(-log(u) * 1000000.0 / config->rate_hz);
+        break;
+    }
+    default:
+        at = gen->start_us + (int64_t)(gen->emitted * 1000000 / config->rate_hz);
+        break;
+    }
+    return at < gen->end_us ? at : INT64_MAX;
+}
+
+bool storm_gen_init(storm_gen_t *gen, const storm_config_t *config, int64_t now_us)
+{
+    if (config->rate_hz == 0 || config->rate_hz > STORM_MAX_RATE_HZ || config->duration_ms == 0 ||
+        config->pattern >= STORM_PATTERN_MAX || (config->pattern == STORM_BURST && config->burst_len == 0)) {
+        return false;
+    }
+    memset(gen, 0, sizeof(*gen));
+    gen->config = *config;
+    gen->start_us = now_us;
+    gen->end_us = now_us + (int64_t)config->duration_ms * 1000;
+    gen->rng = config->seed ? config->seed : 1;
+    gen->next_us = storm_gen_schedule(gen, now_us);
+    return true;
+}
+
+bool storm_gen_pop(storm_gen_t *gen, int64_t now_us, int64_t *at_us)
+{
+    if (gen->next_us > now_us) {
+        return false;
+    }
+    *at_us = gen->next_us;
+    gen->emitted++;
+    gen->next_us = storm_gen_schedule(gen, *at_us);
+    return true;
+}
+
+const char *storm_pattern_name(storm_pattern_t pattern)
+{
+    switch (pattern) {
+    case STORM_STEADY:
+        return "steady";
+    case STORM_BURST:
+        return "burst";
+    case STORM_RANDOM:
+        return "random";
+    default:
+        return "?";
+    }
+}
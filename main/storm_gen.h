@@ -0,0 +1,75 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Schedule of synthetic contact transitions, to load the contact path until it saturates.
+ *
+ * Transitions come at `rate_hz` on average over `duration_ms`, in one of three patterns:
+ * - steady: evenly spaced;
+ * - burst: `burst_len` transitions at the same instant, then silence for as long as the
+ *   rate allows;
+ * - random: exponential gaps (Poisson arrivals), from `seed`.
+ *
+ * The caller decides which channel each transition goes to. Like report_policy, no ESP-IDF
+ * dependency: the caller passes the time and polls storm_gen_pop().
+ */
+
+#define STORM_MAX_RATE_HZ 100000
+
+typedef enum {
+    STORM_STEADY = 0,
+    STORM_BURST,
+    STORM_RANDOM,
+    STORM_PATTERN_MAX,
+} storm_pattern_t;
+
+typedef struct {
+    uint32_t rate_hz;        /* transitions per second, all channels together */
+    uint32_t duration_ms;
+    storm_pattern_t pattern;
+    uint16_t burst_len;      /* STORM_BURST */
+    uint32_t seed;           /* STORM_RANDOM, not 0 */
+} storm_config_t;
+
+typedef struct {
+    storm_config_t config;
+    int64_t start_us;
+    int64_t end_us;
+    int64_t next_us;         /* time of the next transition, INT64_MAX once done */
+    uint64_t emitted;
+    uint32_t rng;
+} storm_gen_t;
+
+/** Start a schedule at `now_us`
+ *
+ * @return false on a rate of 0 or above STORM_MAX_RATE_HZ, a duration of 0, an unknown
+ *         pattern or a burst of 0.
+ */
+bool storm_gen_init(storm_gen_t *gen, const storm_config_t *config, int64_t now_us);
+
+/** Take the next transition if it is due at `now_us`
+ *
+ * @param[out] at_us When it was due, for the edge timestamp.
+ *
+ * @return false if none is due.
+ */
+bool storm_gen_pop(storm_gen_t *gen, int64_t now_us, int64_t *at_us);
+
+/** Time of the next transition, INT64_MAX once the schedule is over */
+static inline int64_t storm_gen_next(const storm_gen_t *gen)
+{
+    return gen->next_us;
+}
+
+/** "steady", "burst" or "random" */
+const char *storm_pattern_name(storm_pattern_t pattern);
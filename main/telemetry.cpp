@@ -0,0 +1,349 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "crc16.h"
+#include "telemetry.h"
+
+/* Payload length of each record type, indexed by telemetry_type_t */
+static const uint8_t k_payload_len[TELEMETRY_TYPE_MAX] = {
+    0,  /* unused */
+    6,  /* TELEMETRY_CONTACT_EDGE */
+    5,  /* TELEMETRY_LATENCY */
+    12, /* TELEMETRY_HEAP */
+    12, /* TELEMETRY_QUEUE */
+    1,  /* TELEMETRY_THREAD_ROLE */
+    9,  /* TELEMETRY_LOG, plus the argument words */
+    9,  /* TELEMETRY_WATERMARK */
+};
+
+static inline void put_le16(uint8_t *dst, uint16_t v)
+{
+    dst[0] = (uint8_t)v;
+    dst[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_le32(uint8_t *dst, uint32_t v)
+{
+    put_le16(dst, (uint16_t)v);
+    put_le16(dst + 2, (uint16_t)(v >> 16));
+}
+
+static inline uint16_t get_le16(const uint8_t *src)
+{
+    return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+static inline uint32_t get_le32(const uint8_t *src)
+{
+    return get_le16(src) | ((uint32_t)get_le16(src + 2) << 16);
+}
+
+/* COBS encoder writing in place into the ring, `pos` is a free running index */
+typedef struct {
+    uint8_t *buf;
+    uint32_t mask;
+    uint32_t pos;
+    uint32_t code_pos;
+    uint8_t code;
+} cobs_writer_t;
+
+static inline void cobs_begin(cobs_writer_t *w)
+{
+    w->code_pos = w->pos++;
+    w->code = 1;
+}
+
+static inline void cobs_put(cobs_writer_t *w, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == 0) {
+            w->buf[w->code_pos & w->mask] = w->code;
+            cobs_begin(w);
+            continue;
+        }
+        w->buf[w->pos++ & w->mask] = data[i];
+        if (++w->code == 0xFF) {
+            w->buf[w->code_pos & w->mask] = w->code;
+            cobs_begin(w);
+        }
+    }
+}
+
+static inline void cobs_end(cobs_writer_t *w)
+{
+    w->buf[w->code_pos & w->mask] = w->code;
+    w->buf[w->pos++ & w->mask] = 0;
+}
+
+int telemetry_init(telemetry_t *tm, uint8_t *buf, uint32_t size)
+{
+    if (!buf || size < TELEMETRY_MAX_FRAME || (size & (size - 1)) != 0) {
+        return TELEMETRY_ERR_FRAME;
+    }
+    tm->buf = buf;
+    tm->size = size;
+    tm->head.store(0, std::memory_order_relaxed);
+    tm->tail.store(0, std::memory_order_relaxed);
+    tm->seq = 0;
+    tm->frames = 0;
+    tm->dropped = 0;
+    return TELEMETRY_OK;
+}
+
+bool telemetry_write(telemetry_t *tm, telemetry_type_t type, uint32_t timestamp_us, const uint8_t *payload, size_t len)
+{
+    uint16_t seq = tm->seq++;
+    size_t raw_len = TELEMETRY_HEADER_SIZE + len + 2;
+    uint32_t head = tm->head.load(std::memory_order_relaxed);
+    uint32_t tail = tm->tail.load(std::memory_order_acquire);
+    if (len > TELEMETRY_MAX_PAYLOAD || tm->size - (head - tail) < raw_len + raw_len / 254 + 2) {
+        tm->dropped++;
+        return false;
+    }
+
+    uint8_t header[TELEMETRY_HEADER_SIZE];
+    header[0] = type;
+    put_le16(header + 1, seq);
+    put_le32(header + 3, timestamp_us);
+    uint8_t crc[2];
+    put_le16(crc, crc16_ccitt_update(crc16_ccitt(header, sizeof(header)), payload, len));
+
+    cobs_writer_t w = { .buf = tm->buf, .mask = tm->size - 1, .pos = head, .code_pos = 0, .code = 0 };
+    cobs_begin(&w);
+    cobs_put(&w, header, sizeof(header));
+    cobs_put(&w, payload, len);
+    cobs_put(&w, crc, sizeof(crc));
+    cobs_end(&w);
+
+    tm->head.store(w.pos, std::memory_order_release);
+    tm->frames++;
+    return true;
+}
+
+bool telemetry_contact_edge(telemetry_t *tm, uint32_t timestamp_us, uint8_t channel, bool closed, uint32_t edge_us)
+{
+    uint8_t payload[6];
+    payload[0] = channel;
+    payload[1] = closed;
+    put_le32(payload + 2, edge_us);
+    return telemetry_write(tm, TELEMETRY_CONTACT_EDGE, timestamp_us, payload, sizeof(payload));
+}
+
+bool telemetry_latency(telemetry_t *tm, uint32_t timestamp_us, uint8_t span, uint32_t value_us)
+{
+    uint8_t payload[5];
+    payload[0] = span;
+    put_le32(payload + 1, value_us);
+    return telemetry_write(tm, TELEMETRY_LATENCY, timestamp_us, payload, sizeof(payload));
+}
+
+bool telemetry_heap(telemetry_t *tm, uint32_t timestamp_us, uint32_t free_bytes, uint32_t min_free_bytes,
+                    uint32_t largest_block)
+{
+    uint8_t payload[12];
+    put_le32(payload, free_bytes);
+    put_le32(payload + 4, min_free_bytes);
+    put_le32(payload + 8, largest_block);
+    return telemetry_write(tm, TELEMETRY_HEAP, timestamp_us, payload, sizeof(payload));
+}
+
+bool telemetry_queue(telemetry_t *tm, uint32_t timestamp_us, uint16_t depth, uint16_t high_water, uint32_t pushed,
+                     uint32_t dropped)
+{
+    uint8_t payload[12];
+    put_le16(payload, depth);
+    put_le16(payload + 2, high_water);
+    put_le32(payload + 4, pushed);
+    put_le32(payload + 8, dropped);
+    return telemetry_write(tm, TELEMETRY_QUEUE, timestamp_us, payload, sizeof(payload));
+}
+
+bool telemetry_thread_role(telemetry_t *tm, uint32_t timestamp_us, uint8_t role)
+{
+    return telemetry_write(tm, TELEMETRY_THREAD_ROLE, timestamp_us, &role, sizeof(role));
+}
+
+bool telemetry_log(telemetry_t *tm, uint32_t timestamp_us, uint32_t format_id, uint32_t tag, const uint32_t *words,
+                   uint8_t nwords)
+{
+    uint8_t payload[9 + 4 * TELEMETRY_LOG_MAX_WORDS];
+    if (nwords > TELEMETRY_LOG_MAX_WORDS) {
+        nwords = TELEMETRY_LOG_MAX_WORDS;
+    }
+    put_le32(payload, format_id);
+    put_le32(payload + 4, tag);
+    payload[8] = nwords;
+    for (uint8_t i = 0; i < nwords; i++) {
+        put_le32(payload + 9 + 4 * i, words[i]);
+    }
+    return telemetry_write(tm, TELEMETRY_LOG, timestamp_us, payload, 9 + 4 * nwords);
+}
+
+bool telemetry_watermark(telemetry_t *tm, uint32_t timestamp_us, uint8_t metric, uint32_t min, uint32_t max)
+{
+    uint8_t payload[9];
+    payload[0] = metric;
+    put_le32(payload + 1, min);
+    put_le32(payload + 5, max);
+    return telemetry_write(tm, TELEMETRY_WATERMARK, timestamp_us, payload, sizeof(payload));
+}
+
+size_t telemetry_peek(telemetry_t *tm, const uint8_t **data)
+{
+    uint32_t tail = tm->tail.load(std::memory_order_relaxed);
+    uint32_t head = tm->head.load(std::memory_order_acquire);
+    uint32_t offset = tail & (tm->size - 1);
+    uint32_t len = head - tail;
+    if (len > tm->size - offset) {
+        len = tm->size - offset;
+    }
+    *data = tm->buf + offset;
+    return len;
+}
+
+void telemetry_consume(telemetry_t *tm, size_t len)
+{
+    tm->tail.store(tm->tail.load(std::memory_order_relaxed) + (uint32_t)len, std::memory_order_release);
+}
+
+int telemetry_decode(const uint8_t *frame, size_t len, telemetry_record_t *record)
+{
+    uint8_t raw[TELEMETRY_MAX_RAW];
+    size_t raw_len = 0;
+    size_t i = 0;
+    while (i < len) {
+        uint8_t code = frame[i++];
+        if (code == 0 || i + code - 1 > len) {
+            return TELEMETRY_ERR_FRAME;
+        }
+        for (uint8_t n = 1; n < code; n++) {
+            if (frame[i] == 0 || raw_len == sizeof(raw)) {
+                return TELEMETRY_ERR_FRAME;
+            }
+            raw[raw_len++] = frame[i++];
+        }
+        if (code != 0xFF && i < len) {
+            if (raw_len == sizeof(raw)) {
+                return TELEMETRY_ERR_FRAME;
+            }
+            raw[raw_len++] = 0;
+        }
+    }
+
+    if (raw_len < TELEMETRY_HEADER_SIZE + 2) {
+        return TELEMETRY_ERR_FRAME;
+    }
+    if (get_le16(raw + raw_len - 2) != crc16_ccitt(raw, raw_len - 2)) {
+        return TELEMETRY_ERR_CRC;
+    }
+    size_t payload_len = raw_len - TELEMETRY_HEADER_SIZE - 2;
+    if (raw[0] == 0 || raw[0] >= TELEMETRY_TYPE_MAX || payload_len < k_payload_len[raw[0]]) {
+        return TELEMETRY_ERR_TYPE;
+    }
+
+    memset(record, 0, sizeof(*record));
+    record->type = (telemetry_type_t)raw[0];
+    record->seq = get_le16(raw + 1);
+    record->timestamp_us = get_le32(raw + 3);
+    const uint8_t *payload = raw + TELEMETRY_HEADER_SIZE;
+    switch (record->type) {
+    case TELEMETRY_CONTACT_EDGE:
+        record->contact.channel = payload[0];
+        record->contact.closed = payload[1] != 0;
+        record->contact.edge_us = get_le32(payload + 2);
+        break;
+    case TELEMETRY_LATENCY:
+        record->latency.span = payload[0];
+        record->latency.value_us = get_le32(payload + 1);
+        break;
+    case TELEMETRY_HEAP:
+        record->heap.free_bytes = get_le32(payload);
+        record->heap.min_free_bytes = get_le32(payload + 4);
+        record->heap.largest_block = get_le32(payload + 8);
+        break;
+    case TELEMETRY_QUEUE:
+        record->queue.depth = get_le16(payload);
+        record->queue.high_water = get_le16(payload + 2);
+        record->queue.pushed = get_le32(payload + 4);
+        record->queue.dropped = get_le32(payload + 8);
+        break;
+    case TELEMETRY_THREAD_ROLE:
+        record->thread.role = payload[0];
+        break;
+    case TELEMETRY_LOG:
+        record->log.format_id = get_le32(payload);
+        record->log.tag = get_le32(payload + 4);
+        record->log.nwords = payload[8];
+        if (record->log.nwords > TELEMETRY_LOG_MAX_WORDS || payload_len < 9 + 4 * (size_t)record->log.nwords) {
+            return TELEMETRY_ERR_FRAME;
+        }
+        for (uint8_t i = 0; i < record->log.nwords; i++) {
+            record->log.words[i] = get_le32(payload + 9 + 4 * i);
+        }
+        break;
+    case TELEMETRY_WATERMARK:
+        record->watermark.metric = payload[0];
+        record->watermark.min = get_le32(payload + 1);
+        record->watermark.max = get_le32(payload + 5);
+        break;
+    default:
+        break;
+    }
+    return TELEMETRY_OK;
+}
+
+void telemetry_deframer_init(telemetry_deframer_t *deframer)
+{
+    memset(deframer, 0, sizeof(*deframer));
+}
+
+bool telemetry_deframer_push(telemetry_deframer_t *deframer, uint8_t byte, const uint8_t **frame, size_t *len)
+{
+    if (byte != 0) {
+        if (deframer->len == sizeof(deframer->buf)) {
+            deframer->overflow = true;
+        } else {
+            deframer->buf[deframer->len++] = byte;
+        }
+        return false;
+    }
+
+    bool complete = !deframer->overflow && deframer->len > 0;
+    if (deframer->overflow) {
+        deframer->oversized++;
+    }
+    *frame = deframer->buf;
+    *len = deframer->len;
+    deframer->len = 0;
+    deframer->overflow = false;
+    return complete;
+}
+
+const char *telemetry_type_name(telemetry_type_t type)
+{
+    switch (type) {
+    case TELEMETRY_CONTACT_EDGE:
+        return "contact";
+    case TELEMETRY_LATENCY:
+        return "latency";
+    case TELEMETRY_HEAP:
+        return "heap";
+    case TELEMETRY_QUEUE:
+        return "queue";
+    case TELEMETRY_THREAD_ROLE:
+        return "thread-role";
+    case TELEMETRY_LOG:
+        return "log";
+    case TELEMETRY_WATERMARK:
+        return "watermark";
+    default:
+        return "unknown";
+    }
+}
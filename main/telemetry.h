@@ -0,0 +1,182 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+/*
+ * Binary telemetry stream.
+ *
+ * Each record is a fixed little-endian layout:
+ *
+ *     type(1) seq(2) timestamp_us(4) payload(0-TELEMETRY_MAX_PAYLOAD) crc16(2)
+ *
+ * COBS encoded and terminated by a 0x00 byte, so a reader can resync on any delimiter.
+ * The encoder writes straight into a byte ring, there is no frame buffer and no text
+ * formatting on the device. The sequence number advances for dropped records too, which
+ * lets the decoder count losses from the gaps.
+ *
+ * The ring has one consumer (the UART pump) that reads contiguous spans in place. Writers
+ * must be serialized by the caller.
+ */
+
+typedef enum : uint8_t {
+    TELEMETRY_CONTACT_EDGE = 1, /* channel(1) closed(1) edge_us(4) */
+    TELEMETRY_LATENCY = 2,      /* span(1) value_us(4) */
+    TELEMETRY_HEAP = 3,         /* free(4) min_free(4) largest_block(4) */
+    TELEMETRY_QUEUE = 4,        /* depth(2) high_water(2) pushed(4) dropped(4) */
+    TELEMETRY_THREAD_ROLE = 5,  /* role(1), otDeviceRole */
+    TELEMETRY_LOG = 6,          /* format_id(4) tag(4) nwords(1) words(4 * nwords), see dlog.h */
+    TELEMETRY_WATERMARK = 7,    /* metric(1) min(4) max(4), see watermark.h */
+    TELEMETRY_TYPE_MAX,
+} telemetry_type_t;
+
+#define TELEMETRY_HEADER_SIZE 7
+#define TELEMETRY_LOG_MAX_WORDS 6
+#define TELEMETRY_MAX_PAYLOAD (9 + 4 * TELEMETRY_LOG_MAX_WORDS)
+#define TELEMETRY_MAX_RAW (TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + 2)
+/* COBS adds one byte per 254, plus the delimiter */
+#define TELEMETRY_MAX_FRAME (TELEMETRY_MAX_RAW + TELEMETRY_MAX_RAW / 254 + 2)
+
+#define TELEMETRY_OK 0
+#define TELEMETRY_ERR_FRAME -1
+#define TELEMETRY_ERR_CRC -2
+#define TELEMETRY_ERR_TYPE -3
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t size; /* power of two */
+    std::atomic<uint32_t> head; /* written by the producer */
+    std::atomic<uint32_t> tail; /* written by the consumer */
+    uint16_t seq;
+    uint32_t frames;
+    uint32_t dropped;
+} telemetry_t;
+
+/** Decoded record */
+typedef struct {
+    telemetry_type_t type;
+    uint16_t seq;
+    uint32_t timestamp_us;
+    union {
+        struct {
+            uint8_t channel;
+            bool closed;
+            uint32_t edge_us;
+        } contact;
+        struct {
+            uint8_t span;
+            uint32_t value_us;
+        } latency;
+        struct {
+            uint32_t free_bytes;
+            uint32_t min_free_bytes;
+            uint32_t largest_block;
+        } heap;
+        struct {
+            uint16_t depth;
+            uint16_t high_water;
+            uint32_t pushed;
+            uint32_t dropped;
+        } queue;
+        struct {
+            uint8_t role;
+        } thread;
+        struct {
+            uint32_t format_id;
+            uint32_t tag;
+            uint8_t nwords;
+            uint32_t words[TELEMETRY_LOG_MAX_WORDS];
+        } log;
+        struct {
+            uint8_t metric;
+            uint32_t min;
+            uint32_t max;
+        } watermark;
+    };
+} telemetry_record_t;
+
+/** Streaming frame splitter for the receiving side */
+typedef struct {
+    uint8_t buf[TELEMETRY_MAX_FRAME];
+    size_t len;
+    bool overflow;  /* current frame too long, skipped up to the next delimiter */
+    uint32_t oversized;
+} telemetry_deframer_t;
+
+/** Initialize a telemetry ring
+ *
+ * @param[out] tm Telemetry state.
+ * @param[in] buf Ring storage.
+ * @param[in] size Size of `buf`, a power of two of at least TELEMETRY_MAX_FRAME bytes.
+ *
+ * @return TELEMETRY_OK on success, TELEMETRY_ERR_FRAME if `size` is unusable.
+ */
+int telemetry_init(telemetry_t *tm, uint8_t *buf, uint32_t size);
+
+/** Encode one record into the ring
+ *
+ * @param[in] tm Telemetry state.
+ * @param[in] type Record type.
+ * @param[in] timestamp_us Record time, truncated to 32 bits.
+ * @param[in] payload Payload bytes, already in wire layout.
+ * @param[in] len Payload length, up to TELEMETRY_MAX_PAYLOAD.
+ *
+ * @return true if the record was queued, false if it was dropped for lack of space.
+ */
+bool telemetry_write(telemetry_t *tm, telemetry_type_t type, uint32_t timestamp_us, const uint8_t *payload, size_t len);
+
+bool telemetry_contact_edge(telemetry_t *tm, uint32_t timestamp_us, uint8_t channel, bool closed, uint32_t edge_us);
+bool telemetry_latency(telemetry_t *tm, uint32_t timestamp_us, uint8_t span, uint32_t value_us);
+bool telemetry_heap(telemetry_t *tm, uint32_t timestamp_us, uint32_t free_bytes, uint32_t min_free_bytes,
+                    uint32_t largest_block);
+bool telemetry_queue(telemetry_t *tm, uint32_t timestamp_us, uint16_t depth, uint16_t high_water, uint32_t pushed,
+                     uint32_t dropped);
+bool telemetry_thread_role(telemetry_t *tm, uint32_t timestamp_us, uint8_t role);
+bool telemetry_log(telemetry_t *tm, uint32_t timestamp_us, uint32_t format_id, uint32_t tag, const uint32_t *words,
+                   uint8_t nwords);
+bool telemetry_watermark(telemetry_t *tm, uint32_t timestamp_us, uint8_t metric, uint32_t min, uint32_t max);
+
+/** Consumer side: contiguous span of encoded bytes ready to send
+ *
+ * @param[in] tm Telemetry state.
+ * @param[out] data Start of the span, valid until `telemetry_consume()`.
+ *
+ * @return span length, 0 if the ring is empty.
+ */
+size_t telemetry_peek(telemetry_t *tm, const uint8_t **data);
+
+/** Consumer side: release `len` bytes returned by `telemetry_peek()` */
+void telemetry_consume(telemetry_t *tm, size_t len);
+
+/** Decode one frame, delimiter excluded
+ *
+ * @return TELEMETRY_OK on success.
+ * @return TELEMETRY_ERR_* if the frame is malformed, fails its CRC or has an unknown type.
+ */
+int telemetry_decode(const uint8_t *frame, size_t len, telemetry_record_t *record);
+
+void telemetry_deframer_init(telemetry_deframer_t *deframer);
+
+/** Feed one received byte
+ *
+ * @param[in] deframer Splitter state.
+ * @param[in] byte Received byte.
+ * @param[out] frame Complete frame, delimiter excluded, valid until the next call.
+ * @param[out] len Frame length.
+ *
+ * @return true when `byte` completed a non-empty frame.
+ */
+bool telemetry_deframer_push(telemetry_deframer_t *deframer, uint8_t byte, const uint8_t **frame, size_t *len);
+
+const char *telemetry_type_name(telemetry_type_t type);
@@ -0,0 +1,142 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "watermark.h"
+
+static const char *const k_metric_names[WATERMARK_METRIC_MAX] = {
+#define WATERMARK_NAME(id, name, shift) name,
+    WATERMARK_METRICS(WATERMARK_NAME)
+#undef WATERMARK_NAME
+};
+
+static const uint8_t k_metric_shifts[WATERMARK_METRIC_MAX] = {
+#define WATERMARK_SHIFT(id, name, shift) shift,
+    WATERMARK_METRICS(WATERMARK_SHIFT)
+#undef WATERMARK_SHIFT
+};
+
+static void watermark_slot_reset(watermark_slot_t *slot, uint32_t start_ms)
+{
+    slot->start_ms = start_ms;
+    slot->samples = 0;
+    slot->seen = 0;
+    memset(slot->min, 0xFF, sizeof(slot->min));
+    memset(slot->max, 0, sizeof(slot->max));
+}
+
+static void watermark_slot_add(watermark_slot_t *slot, int metric, uint16_t value)
+{
+    if (value < slot->min[metric]) {
+        slot->min[metric] = value;
+    }
+    if (value > slot->max[metric]) {
+        slot->max[metric] = value;
+    }
+    slot->seen |= 1u << metric;
+}
+
+static void watermark_slot_merge(watermark_slot_t *dst, const watermark_slot_t *src)
+{
+    for (int i = 0; i < WATERMARK_METRIC_MAX; i++) {
+        if (src->seen & (1u << i)) {
+            watermark_slot_add(dst, i, src->min[i]);
+            watermark_slot_add(dst, i, src->max[i]);
+        }
+    }
+    dst->samples = dst->samples + src->samples > UINT16_MAX ? UINT16_MAX : dst->samples + src->samples;
+}
+
+void watermark_init(watermark_t *wm, watermark_slot_t *slots, uint16_t slot_count, uint32_t slot_ms, uint32_t now_ms)
+{
+    memset(wm, 0, sizeof(*wm));
+    wm->slots = slots;
+    wm->slot_count = slot_count;
+    wm->slot_ms = slot_ms;
+    watermark_slot_reset(&wm->slots[0], now_ms);
+    watermark_slot_reset(&wm->total, now_ms);
+}
+
+bool watermark_sample(watermark_t *wm, uint32_t now_ms, const uint32_t *values, watermark_slot_t *closed)
+{
+    watermark_slot_t *slot = &wm->slots[wm->head];
+    bool rolled = false;
+    if (now_ms - slot->start_ms >= wm->slot_ms) {
+        if (closed) {
+            *closed = *slot;
+        }
+        /* Slots stay aligned on the first one; a gap in the samples leaves no empty slots */
+        uint32_t start_ms = now_ms - (now_ms - slot->start_ms) % wm->slot_ms;
+        wm->head = (wm->head + 1) % wm->slot_count;
+        if (wm->closed < wm->slot_count - 1) {
+            wm->closed++;
+        }
+        slot = &wm->slots[wm->head];
+        watermark_slot_reset(slot, start_ms);
+        rolled = true;
+    }
+
+    wm->last_seen = 0;
+    for (int i = 0; i < WATERMARK_METRIC_MAX; i++) {
+        if (values[i] == WATERMARK_ABSENT) {
+            continue;
+        }
+        uint32_t scaled = values[i] >> k_metric_shifts[i];
+        uint16_t stored = scaled > UINT16_MAX ? UINT16_MAX : (uint16_t)scaled;
+        wm->last[i] = stored;
+        wm->last_seen |= 1u << i;
+        watermark_slot_add(slot, i, stored);
+        watermark_slot_add(&wm->total, i, stored);
+    }
+    if (slot->samples < UINT16_MAX) {
+        slot->samples++;
+    }
+    if (wm->total.samples < UINT16_MAX) {
+        wm->total.samples++;
+    }
+    return rolled;
+}
+
+bool watermark_history(const watermark_t *wm, uint16_t age, watermark_slot_t *slot)
+{
+    if (age > wm->closed) {
+        return false;
+    }
+    *slot = wm->slots[(wm->head + wm->slot_count - age) % wm->slot_count];
+    return true;
+}
+
+void watermark_window(const watermark_t *wm, watermark_slot_t *slot)
+{
+    const watermark_slot_t *oldest = &wm->slots[(wm->head + wm->slot_count - wm->closed) % wm->slot_count];
+    watermark_slot_reset(slot, oldest->start_ms);
+    for (uint16_t age = 0; age <= wm->closed; age++) {
+        watermark_slot_merge(slot, &wm->slots[(wm->head + wm->slot_count - age) % wm->slot_count]);
+    }
+}
+
+uint32_t watermark_value(watermark_metric_t metric, uint16_t stored)
+{
+    return (uint32_t)stored << k_metric_shifts[metric];
+}
+
+const char *watermark_metric_name(watermark_metric_t metric)
+{
+    return metric < WATERMARK_METRIC_MAX ? k_metric_names[metric] : "unknown";
+}
+
+watermark_metric_t watermark_metric_find(const char *name)
+{
+    for (int i = 0; i < WATERMARK_METRIC_MAX; i++) {
+        if (strcmp(name, k_metric_names[i]) == 0) {
+            return (watermark_metric_t)i;
+        }
+    }
+    return WATERMARK_METRIC_MAX;
+}
@@ -0,0 +1,123 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Resource watermarks: heap, task stacks and queues sampled periodically, kept as a ring of
+ * fixed-length time slots holding the min and max of every metric over the slot, plus the
+ * min and max since start.
+ *
+ * Values are stored as 16 bits, right-shifted by a per-metric scale (heap in 16 byte units,
+ * delays in 16 us units) and saturated, so a slot of every metric fits in a few hundred
+ * bytes. The metric set is fixed here so that the telemetry decoder can name them.
+ */
+
+/* id, name, shift */
+#define WATERMARK_METRICS(X)                                   \
+    X(HEAP_INTERNAL_FREE, "heap.internal.free", 4)             \
+    X(HEAP_INTERNAL_MIN_FREE, "heap.internal.min-free", 4)     \
+    X(HEAP_INTERNAL_LARGEST, "heap.internal.largest", 4)       \
+    X(HEAP_DMA_FREE, "heap.dma.free", 4)                       \
+    X(HEAP_DMA_LARGEST, "heap.dma.largest", 4)                 \
+    X(HEAP_SPIRAM_FREE, "heap.spiram.free", 4)                 \
+    X(HEAP_SPIRAM_LARGEST, "heap.spiram.largest", 4)           \
+    X(STACK_CHIP, "stack.CHIP", 0)                             \
+    X(STACK_OPENTHREAD, "stack.ot_task", 0)                    \
+    X(STACK_NIMBLE, "stack.nimble_host", 0)                    \
+    X(STACK_ESP_TIMER, "stack.esp_timer", 0)                   \
+    X(STACK_TELEMETRY, "stack.telemetry", 0)                   \
+    X(STACK_DLOG, "stack.dlog", 0)                             \
+    X(STACK_IMU, "stack.imu", 0)                               \
+    X(STACK_WATERMARK, "stack.watermark", 0)                   \
+    X(QUEUE_CONTACT, "queue.contact", 0)                       \
+    X(QUEUE_MATTER_DELAY_US, "queue.matter.delay-us", 4)       \
+    X(QUEUE_OPENTHREAD_WAIT_US, "queue.openthread.wait-us", 4)
+
+typedef enum {
+#define WATERMARK_ENUM(id, name, shift) WATERMARK_##id,
+    WATERMARK_METRICS(WATERMARK_ENUM)
+#undef WATERMARK_ENUM
+    WATERMARK_METRIC_MAX,
+} watermark_metric_t;
+
+static_assert(WATERMARK_METRIC_MAX <= 32, "watermark_slot_t::seen is a 32 bit mask");
+
+/** Value of a metric not available in a sample, e.g. a task that does not exist */
+#define WATERMARK_ABSENT UINT32_MAX
+
+typedef struct {
+    uint32_t start_ms;
+    uint16_t samples;
+    uint32_t seen; /* metrics sampled at least once in the slot */
+    uint16_t min[WATERMARK_METRIC_MAX];
+    uint16_t max[WATERMARK_METRIC_MAX];
+} watermark_slot_t;
+
+typedef struct {
+    watermark_slot_t *slots;
+    uint16_t slot_count;
+    uint16_t head;           /* slot being filled */
+    uint16_t closed;         /* slots closed so far, up to slot_count - 1 kept */
+    uint32_t slot_ms;
+    uint16_t last[WATERMARK_METRIC_MAX];
+    uint32_t last_seen;
+    watermark_slot_t total;  /* since init */
+} watermark_t;
+
+/** Initialize a watermark ring
+ *
+ * @param[out] wm Ring state.
+ * @param[in] slots Slot storage, at least 2.
+ * @param[in] slot_count Number of slots.
+ * @param[in] slot_ms Slot length.
+ * @param[in] now_ms Start of the first slot.
+ */
+void watermark_init(watermark_t *wm, watermark_slot_t *slots, uint16_t slot_count, uint32_t slot_ms, uint32_t now_ms);
+
+/** Add a sample of every metric
+ *
+ * @param[in,out] wm Ring state.
+ * @param[in] now_ms Sample time.
+ * @param[in] values One value per metric, WATERMARK_ABSENT for the ones not sampled.
+ * @param[out] closed Copy of the slot this sample closed, if any; may be NULL.
+ *
+ * @return true if the sample started a new slot.
+ */
+bool watermark_sample(watermark_t *wm, uint32_t now_ms, const uint32_t *values, watermark_slot_t *closed);
+
+/** Get a slot by age
+ *
+ * @param[in] wm Ring state.
+ * @param[in] age 0 for the slot being filled, 1 for the last closed one...
+ * @param[out] slot Copy of the slot.
+ *
+ * @return false if the ring does not go back that far.
+ */
+bool watermark_history(const watermark_t *wm, uint16_t age, watermark_slot_t *slot);
+
+/** Merge every slot still in the ring
+ *
+ * @param[in] wm Ring state.
+ * @param[out] slot Min and max over the ring, `start_ms` of the oldest slot.
+ */
+void watermark_window(const watermark_t *wm, watermark_slot_t *slot);
+
+/** Stored value back to the metric unit, a saturated value reads as the largest one */
+uint32_t watermark_value(watermark_metric_t metric, uint16_t stored);
+
+const char *watermark_metric_name(watermark_metric_t metric);
+
+/** Look a metric up by name
+ *
+ * @return metric, WATERMARK_METRIC_MAX if unknown.
+ */
+watermark_metric_t watermark_metric_find(const char *name);
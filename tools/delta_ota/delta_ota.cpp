@@ -0,0 +1,482 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Delta OTA image generator, see main/delta_patch.h for the format.
+ *
+ *     delta_ota diff [-w window_bits] <old.bin> <new.bin> <patch.bin>
+ *     delta_ota apply <old.bin> <patch.bin> <new.bin>
+ *
+ * `old.bin` must be the exact image running on the devices (build/light.bin of the release
+ * they run), the firmware refuses a patch whose source CRC does not match. `diff` checks the
+ * patch by applying it with the firmware applier before writing it. The patch then goes
+ * through the usual OTA image steps: esp_enc_img_gen.py for CONFIG_ENABLE_ENCRYPTED_OTA,
+ * then ota_image_tool.py from connectedhomeip for the Matter OTA header.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "crc32.h"
+#include "delta_patch.h"
+
+typedef std::vector<uint8_t> bytes_t;
+
+/* Shortest exact match that starts a DIFF run */
+#define DIFF_MIN_MATCH 12
+#define DIFF_SEED 8
+#define DIFF_HASH_BITS 20
+#define DIFF_CHAIN_DEPTH 64
+/* A DIFF run ends where its score (2 * equal bytes - length) fell this far below its best */
+#define DIFF_SCORE_SLACK 64
+
+#define LZ_HASH_BITS 16
+#define LZ_CHAIN_DEPTH 128
+
+typedef struct {
+    uint32_t diff_ops;
+    uint32_t diff_bytes;
+    uint32_t diff_equal;
+    uint32_t insert_ops;
+    uint32_t insert_bytes;
+} diff_stats_t;
+
+static double now_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int read_file(const char *path, bytes_t *data)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    uint8_t buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        data->insert(data->end(), buf, buf + n);
+    }
+    fclose(f);
+    return 0;
+}
+
+static int write_file(const char *path, const bytes_t &data)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f || fwrite(data.data(), 1, data.size(), f) != data.size()) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        if (f) {
+            fclose(f);
+        }
+        return -1;
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static void put_varint(bytes_t *out, uint32_t v)
+{
+    while (v >= 0x80) {
+        out->push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out->push_back((uint8_t)v);
+}
+
+static inline uint32_t seed_hash(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return (uint32_t)((v * 0x9E3779B97F4A7C15ull) >> (64 - DIFF_HASH_BITS));
+}
+
+static size_t match_len(const bytes_t &old_image, size_t o, const bytes_t &new_image, size_t p)
+{
+    size_t n = 0;
+    while (o + n < old_image.size() && p + n < new_image.size() && old_image[o + n] == new_image[p + n]) {
+        n++;
+    }
+    return n;
+}
+
+/* Length of the DIFF run from (o, p) with the best score, and its equal bytes */
+static size_t fuzzy_len(const bytes_t &old_image, size_t o, const bytes_t &new_image, size_t p, size_t *equal)
+{
+    long score = 0, best_score = 0;
+    size_t best = 0, count = 0, best_count = 0;
+    for (size_t i = 0; o + i < old_image.size() && p + i < new_image.size(); i++) {
+        bool same = old_image[o + i] == new_image[p + i];
+        score += same ? 1 : -1;
+        count += same;
+        if (score > best_score) {
+            best_score = score;
+            best = i + 1;
+            best_count = count;
+        } else if (score < best_score - DIFF_SCORE_SLACK) {
+            break;
+        }
+    }
+    *equal = best_count;
+    return best;
+}
+
+/* Operation stream: greedy matching of the new image against the old one, bsdiff style */
+static bytes_t diff_ops(const bytes_t &old_image, const bytes_t &new_image, diff_stats_t *stats)
+{
+    std::vector<int32_t> head(1u << DIFF_HASH_BITS, -1);
+    std::vector<int32_t> chain(old_image.size(), -1);
+    for (size_t i = 0; i + DIFF_SEED <= old_image.size(); i++) {
+        uint32_t h = seed_hash(&old_image[i]);
+        chain[i] = head[h];
+        head[h] = (int32_t)i;
+    }
+
+    bytes_t ops;
+    size_t pos = 0, literal = 0;
+    size_t old_pos = 0;   /* where the source position of the applier is */
+    long shift = 0;       /* old - new offset of the last DIFF run */
+    auto flush_insert = [&](size_t end) {
+        if (end > literal) {
+            ops.push_back(DELTA_OP_INSERT);
+            put_varint(&ops, (uint32_t)(end - literal));
+            ops.insert(ops.end(), new_image.begin() + literal, new_image.begin() + end);
+            stats->insert_ops++;
+            stats->insert_bytes += end - literal;
+        }
+    };
+
+    while (pos < new_image.size()) {
+        size_t best_len = 0, best_old = 0;
+        long aligned = (long)pos + shift;
+        if (aligned >= 0 && (size_t)aligned < old_image.size()) {
+            best_len = match_len(old_image, aligned, new_image, pos);
+            best_old = aligned;
+        }
+        if (best_len < DIFF_MIN_MATCH && pos + DIFF_SEED <= new_image.size()) {
+            int depth = 0;
+            for (int32_t c = head[seed_hash(&new_image[pos])]; c >= 0 && depth < DIFF_CHAIN_DEPTH;
+                 c = chain[c], depth++) {
+                size_t len = match_len(old_image, c, new_image, pos);
+                if (len > best_len) {
+                    best_len = len;
+                    best_old = c;
+                }
+            }
+        }
+
+        size_t equal = 0;
+        size_t run = 0;
+        if (best_len >= DIFF_MIN_MATCH) {
+            /* Grow back over the literal bytes that match too */
+            while (pos > literal && best_old > 0 && old_image[best_old - 1] == new_image[pos - 1]) {
+                pos--;
+                best_old--;
+            }
+            run = fuzzy_len(old_image, best_old, new_image, pos, &equal);
+        } else if (aligned >= 0 && (size_t)aligned < old_image.size()) {
+            /* No exact match: keep the previous alignment if it still mostly holds, as for
+             * code that moved with a few addresses changed inside */
+            run = fuzzy_len(old_image, aligned, new_image, pos, &equal);
+            if (run < DIFF_MIN_MATCH * 2) {
+                run = 0;
+            }
+            best_old = aligned;
+        }
+        if (run == 0) {
+            pos++;
+            continue;
+        }
+
+        flush_insert(pos);
+        ops.push_back(DELTA_OP_DIFF);
+        put_varint(&ops, (uint32_t)run);
+        int32_t seek = (int32_t)((long)best_old - (long)old_pos);
+        put_varint(&ops, ((uint32_t)seek << 1) ^ (uint32_t)(seek >> 31));
+        for (size_t i = 0; i < run; i++) {
+            ops.push_back((uint8_t)(new_image[pos + i] - old_image[best_old + i]));
+        }
+        stats->diff_ops++;
+        stats->diff_bytes += run;
+        stats->diff_equal += equal;
+        old_pos = best_old + run;
+        shift = (long)best_old - (long)pos;
+        pos += run;
+        literal = pos;
+    }
+    flush_insert(new_image.size());
+    ops.push_back(DELTA_OP_END);
+    return ops;
+}
+
+/* LZSS with hash chains and one step of lazy matching, see delta_patch.h for the layout */
+static bytes_t lz_compress(const bytes_t &in, uint8_t window_bits)
+{
+    const size_t window = (size_t)1 << window_bits;
+    const uint32_t len_bits = 16 - window_bits;
+    const size_t len_max = ((size_t)1 << len_bits) - 1;
+    const size_t match_max = len_max + DELTA_PATCH_MIN_MATCH + 255;
+    std::vector<int32_t> head(1u << LZ_HASH_BITS, -1);
+    std::vector<int32_t> chain(in.size(), -1);
+
+    auto hash3 = [&](size_t i) {
+        return ((uint32_t)in[i] << 16 | (uint32_t)in[i + 1] << 8 | in[i + 2]) * 2654435761u >> (32 - LZ_HASH_BITS);
+    };
+    auto insert = [&](size_t i) {
+        if (i + DELTA_PATCH_MIN_MATCH <= in.size()) {
+            uint32_t h = hash3(i);
+            chain[i] = head[h];
+            head[h] = (int32_t)i;
+        }
+    };
+    auto find = [&](size_t i, size_t *distance) {
+        size_t best = 0;
+        if (i + DELTA_PATCH_MIN_MATCH > in.size()) {
+            return best;
+        }
+        int depth = 0;
+        for (int32_t c = head[hash3(i)]; c >= 0 && i - c <= window && depth < LZ_CHAIN_DEPTH; c = chain[c], depth++) {
+            size_t n = 0;
+            while (n < match_max && i + n < in.size() && in[c + n] == in[i + n]) {
+                n++;
+            }
+            if (n > best) {
+                best = n;
+                *distance = i - c;
+                if (n == match_max) {
+                    break;
+                }
+            }
+        }
+        return best >= DELTA_PATCH_MIN_MATCH ? best : 0;
+    };
+
+    bytes_t out;
+    size_t flags_at = 0;
+    int items = 8;
+    auto item = [&](bool literal) {
+        if (items == 8) {
+            flags_at = out.size();
+            out.push_back(0);
+            items = 0;
+        }
+        if (literal) {
+            out[flags_at] |= 1 << items;
+        }
+        items++;
+    };
+
+    size_t i = 0;
+    while (i < in.size()) {
+        size_t distance = 0;
+        size_t len = find(i, &distance);
+        insert(i);
+        if (len > 0 && len < match_max) {
+            /* Lazy: a longer match one byte later is worth a literal */
+            size_t next_distance = 0;
+            size_t next = find(i + 1, &next_distance);
+            if (next > len + 1) {
+                item(true);
+                out.push_back(in[i]);
+                i++;
+                insert(i);
+                len = next;
+                distance = next_distance;
+            }
+        }
+        if (len == 0) {
+            item(true);
+            out.push_back(in[i]);
+            i++;
+            continue;
+        }
+        item(false);
+        size_t code = len - DELTA_PATCH_MIN_MATCH;
+        uint16_t token = (uint16_t)((distance - 1) << len_bits | (code < len_max ? code : len_max));
+        out.push_back((uint8_t)token);
+        out.push_back((uint8_t)(token >> 8));
+        if (code >= len_max) {
+            out.push_back((uint8_t)(code - len_max));
+        }
+        for (size_t k = 1; k < len; k++) {
+            insert(i + k);
+        }
+        i += len;
+    }
+    return out;
+}
+
+typedef struct {
+    const bytes_t *source;
+    bytes_t *target;
+} memory_io_t;
+
+static int memory_read(void *ctx, uint32_t offset, uint8_t *dst, size_t len)
+{
+    const memory_io_t *io = (const memory_io_t *)ctx;
+    if (offset + len > io->source->size()) {
+        return -1;
+    }
+    memcpy(dst, io->source->data() + offset, len);
+    return 0;
+}
+
+static int memory_write(void *ctx, const uint8_t *src, size_t len)
+{
+    memory_io_t *io = (memory_io_t *)ctx;
+    io->target->insert(io->target->end(), src, src + len);
+    return 0;
+}
+
+/* Apply with the firmware applier, fed in BDX sized blocks */
+static int apply(const bytes_t &old_image, const bytes_t &patch, bytes_t *new_image, double *seconds)
+{
+    delta_patch_header_t header;
+    if (patch.size() < DELTA_PATCH_HEADER_SIZE || delta_patch_header_parse(patch.data(), &header) != DELTA_PATCH_OK) {
+        fprintf(stderr, "not a delta patch\n");
+        return -1;
+    }
+    if (header.source_size != old_image.size() ||
+        crc32_update(0, old_image.data(), old_image.size()) != header.source_crc) {
+        fprintf(stderr, "patch made for another source image\n");
+        return -1;
+    }
+    static uint8_t window[1 << DELTA_PATCH_MAX_WINDOW_BITS];
+    static uint8_t cache[256];
+    static uint8_t out[1024];
+    memory_io_t ctx = { &old_image, new_image };
+    delta_patch_io_t io = { memory_read, memory_write, &ctx };
+    delta_patch_buffers_t buffers = { window, DELTA_PATCH_MAX_WINDOW_BITS, cache, sizeof(cache), out, sizeof(out) };
+    delta_patch_t dp;
+    new_image->clear();
+    double start = now_s();
+    int err = delta_patch_init(&dp, &header, &io, &buffers);
+    for (size_t off = DELTA_PATCH_HEADER_SIZE; err == DELTA_PATCH_OK && off < patch.size(); off += 1024) {
+        size_t len = patch.size() - off < 1024 ? patch.size() - off : 1024;
+        err = delta_patch_feed(&dp, patch.data() + off, len);
+    }
+    if (err == DELTA_PATCH_OK) {
+        err = delta_patch_finish(&dp);
+    }
+    *seconds = now_s() - start;
+    if (err != DELTA_PATCH_OK) {
+        fprintf(stderr, "patch failed, err:%d\n", err);
+        return -1;
+    }
+    return 0;
+}
+
+static int cmd_diff(const char *old_path, const char *new_path, const char *patch_path, uint8_t window_bits)
+{
+    bytes_t old_image, new_image;
+    if (read_file(old_path, &old_image) != 0 || read_file(new_path, &new_image) != 0) {
+        return 1;
+    }
+    double start = now_s();
+    diff_stats_t stats = {};
+    bytes_t ops = diff_ops(old_image, new_image, &stats);
+    bytes_t body = lz_compress(ops, window_bits);
+    double elapsed = now_s() - start;
+
+    delta_patch_header_t header = {
+        .window_bits = window_bits,
+        .source_size = (uint32_t)old_image.size(),
+        .source_crc = crc32_update(0, old_image.data(), old_image.size()),
+        .target_size = (uint32_t)new_image.size(),
+        .target_crc = crc32_update(0, new_image.data(), new_image.size()),
+        .body_size = (uint32_t)body.size(),
+    };
+    bytes_t patch(DELTA_PATCH_HEADER_SIZE);
+    delta_patch_header_write(&header, patch.data());
+    patch.insert(patch.end(), body.begin(), body.end());
+
+    bytes_t check;
+    double apply_s = 0;
+    if (apply(old_image, patch, &check, &apply_s) != 0 || check != new_image) {
+        fprintf(stderr, "patch does not rebuild %s\n", new_path);
+        return 1;
+    }
+    if (write_file(patch_path, patch) != 0) {
+        return 1;
+    }
+
+    printf("old %zu bytes, new %zu bytes, patch %zu bytes (%.1f%% of new), window %u bytes\n", old_image.size(),
+           new_image.size(), patch.size(), 100.0 * patch.size() / new_image.size(), 1u << window_bits);
+    printf("diff runs %" PRIu32 " (%" PRIu32 " bytes, %.1f%% equal) inserts %" PRIu32 " (%" PRIu32
+           " bytes), ops %zu bytes before compression\n",
+           stats.diff_ops, stats.diff_bytes, stats.diff_bytes ? 100.0 * stats.diff_equal / stats.diff_bytes : 0.0,
+           stats.insert_ops, stats.insert_bytes, ops.size());
+    printf("generated in %.2f s, applied in %.3f s (%.1f MB/s of image)\n", elapsed, apply_s,
+           new_image.size() / apply_s / 1e6);
+    return 0;
+}
+
+static int cmd_apply(const char *old_path, const char *patch_path, const char *new_path)
+{
+    bytes_t old_image, patch, new_image;
+    if (read_file(old_path, &old_image) != 0 || read_file(patch_path, &patch) != 0) {
+        return 1;
+    }
+    double seconds = 0;
+    if (apply(old_image, patch, &new_image, &seconds) != 0 || write_file(new_path, new_image) != 0) {
+        return 1;
+    }
+    printf("%zu bytes rebuilt in %.3f s (%.1f MB/s)\n", new_image.size(), seconds, new_image.size() / seconds / 1e6);
+    return 0;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "Usage: %s diff [-w window_bits] <old.bin> <new.bin> <patch.bin>\n", argv0);
+    fprintf(stderr, "       %s apply <old.bin> <patch.bin> <new.bin>\n", argv0);
+    fprintf(stderr, "  -w bits   LZSS window, %d to %d (default 12), must fit CONFIG_APP_DELTA_OTA_WINDOW_BITS\n",
+            DELTA_PATCH_MIN_WINDOW_BITS, DELTA_PATCH_MAX_WINDOW_BITS);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *cmd = argv[1];
+    optind = 2;
+    long window_bits = 12;
+    int opt;
+    while ((opt = getopt(argc, argv, "w:h")) != -1) {
+        switch (opt) {
+        case 'w':
+            window_bits = strtol(optarg, NULL, 10);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (argc - optind != 3 || window_bits < DELTA_PATCH_MIN_WINDOW_BITS || window_bits > DELTA_PATCH_MAX_WINDOW_BITS) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (strcmp(cmd, "diff") == 0) {
+        return cmd_diff(argv[optind], argv[optind + 1], argv[optind + 2], (uint8_t)window_bits);
+    }
+    if (strcmp(cmd, "apply") == 0) {
+        return cmd_apply(argv[optind], argv[optind + 1], argv[optind + 2]);
+    }
+    usage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,115 @@
+#!/usr/bin/env python
+#
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# Unless required by applicable law or agreed to in writing, this
+# software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied.
+#
+# Extract the deferred log string table from the firmware ELF.
+#
+# Every APP_LOGx call site owns a local static `_dlog_desc` (see main/dlog.h) holding a
+# pointer to its format string and its level; the address of the descriptor is the format
+# ID sent on the telemetry stream. Tags and `%s` arguments travel as raw pointers, so the
+# table also lists the NUL terminated strings found in the read-only data sections.
+#
+# Output, one entry per line, tab separated, strings backslash escaped:
+#     fmt <id> <level> <format>
+#     str <address> <string>
+#
+# Usage: dlog_strings.py <firmware.elf> [-o <table>]
+
+import argparse
+import struct
+import sys
+
+from elftools.elf.elffile import ELFFile
+from elftools.elf.sections import SymbolTableSection
+
+DESC_SYMBOL = '_dlog_desc'
+MIN_STRING_LEN = 2
+
+
+def escape(text):
+    return text.replace('\\', '\\\\').replace('\t', '\\t').replace('\n', '\\n').replace('\r', '\\r')
+
+
+class Image:
+    """Loadable, non-executable sections of the ELF, addressable by target address"""
+
+    def __init__(self, elf):
+        self.sections = []
+        for section in elf.iter_sections():
+            flags = section['sh_flags']
+            if section['sh_type'] != 'SHT_PROGBITS' or not (flags & 0x2) or (flags & 0x4):
+                continue
+            self.sections.append((section['sh_addr'], section.data(), not (flags & 0x1)))
+
+    def read(self, addr, size):
+        for base, data, _ in self.sections:
+            if base <= addr and addr + size <= base + len(data):
+                return data[addr - base:addr - base + size]
+        return None
+
+    def string(self, addr):
+        for base, data, _ in self.sections:
+            if base <= addr < base + len(data):
+                end = data.find(b'\0', addr - base)
+                if end < 0:
+                    return None
+                return data[addr - base:end].decode('utf-8', 'replace')
+        return None
+
+    def rodata_strings(self):
+        for base, data, read_only in self.sections:
+            if not read_only:
+                continue
+            start = 0
+            while start < len(data):
+                end = data.find(b'\0', start)
+                if end < 0:
+                    break
+                chunk = data[start:end]
+                if len(chunk) >= MIN_STRING_LEN and all(0x20 <= b < 0x7f or b in (9, 10, 13) for b in chunk):
+                    yield base + start, chunk.decode('ascii')
+                start = end + 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Extract the deferred log string table from an ELF')
+    parser.add_argument('elf')
+    parser.add_argument('-o', '--output', help='output file, stdout by default')
+    args = parser.parse_args()
+
+    with open(args.elf, 'rb') as f:
+        elf = ELFFile(f)
+        endian = '<' if elf.little_endian else '>'
+        ptr_size = elf.elfclass // 8
+        image = Image(elf)
+
+        entries = []
+        for section in elf.iter_sections():
+            if not isinstance(section, SymbolTableSection):
+                continue
+            for symbol in section.iter_symbols():
+                if DESC_SYMBOL not in symbol.name or symbol['st_info']['type'] != 'STT_OBJECT':
+                    continue
+                raw = image.read(symbol['st_value'], ptr_size + 1)
+                if raw is None:
+                    continue
+                fmt_addr = struct.unpack(endian + ('I' if ptr_size == 4 else 'Q'), raw[:ptr_size])[0]
+                fmt = image.string(fmt_addr)
+                if fmt is not None:
+                    entries.append('fmt\t0x%x\t%d\t%s' % (symbol['st_value'], raw[ptr_size], escape(fmt)))
+        entries.extend('str\t0x%x\t%s' % (addr, escape(text)) for addr, text in image.rodata_strings())
+
+    out = open(args.output, 'w') if args.output else sys.stdout
+    out.write('# dlog string table for %s\n' % args.elf)
+    out.write('\n'.join(entries) + '\n')
+    if args.output:
+        out.close()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
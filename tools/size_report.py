@@ -0,0 +1,90 @@
+#!/usr/bin/env python
+#
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# Unless required by applicable law or agreed to in writing, this
+# software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied.
+#
+# Build every endpoint profile (sdkconfig.defaults.profile_*) on top of a base defaults
+# file and compare the image sizes.
+#
+# Static RAM comes from `idf.py size`. Free heap depends on the commissioned state, so it
+# is reported at runtime instead: the boot log prints it after Matter starts, and the
+# telemetry stream carries it periodically.
+#
+# Usage: size_report.py [--base sdkconfig.defaults.c6_thread] [--profiles contact_only ...]
+
+import argparse
+import glob
+import json
+import os
+import subprocess
+import sys
+
+PROJECT_DIR = os.path.abspath(os.path.join(os.path.dirname(__file__), '..'))
+PROFILE_PREFIX = 'sdkconfig.defaults.profile_'
+COLUMNS = [
+    ('flash_code', 'flash code'),
+    ('flash_rodata', 'flash rodata'),
+    ('used_dram', 'DRAM'),
+    ('used_iram', 'IRAM'),
+    ('total_size', 'total'),
+]
+
+
+def available_profiles():
+    return sorted(os.path.basename(path)[len(PROFILE_PREFIX):]
+                  for path in glob.glob(os.path.join(PROJECT_DIR, PROFILE_PREFIX + '*')))
+
+
+def build_profile(profile, base, build_root):
+    build_dir = os.path.join(build_root, 'build_profile_' + profile)
+    defaults = ';'.join([base, PROFILE_PREFIX + profile])
+    idf = ['idf.py', '-C', PROJECT_DIR, '-B', build_dir, '-D', 'SDKCONFIG=' + os.path.join(build_dir, 'sdkconfig'),
+           '-D', 'SDKCONFIG_DEFAULTS=' + defaults]
+    subprocess.check_call(idf + ['build'])
+    output = subprocess.check_output(idf + ['size', '--format', 'json'])
+    # idf.py prints its own progress lines before the JSON document
+    text = output.decode()
+    sizes = json.loads(text[text.index('{'):])
+
+    binaries = [path for path in glob.glob(os.path.join(build_dir, '*.bin')) if 'bootloader' not in path]
+    sizes['app_bin'] = max((os.path.getsize(path) for path in binaries), default=0)
+    return sizes
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare image sizes of the endpoint profiles')
+    parser.add_argument('--base', default='sdkconfig.defaults.c6_thread', help='base defaults file')
+    parser.add_argument('--profiles', nargs='*', default=available_profiles(), help='profiles to build')
+    parser.add_argument('--build-root', default=PROJECT_DIR, help='where the build_profile_* directories go')
+    args = parser.parse_args()
+
+    results = {}
+    for profile in args.profiles:
+        results[profile] = build_profile(profile, args.base, args.build_root)
+
+    header = ['profile', 'app bin'] + [title for _, title in COLUMNS]
+    rows = [[profile, str(sizes['app_bin'])] + [str(sizes.get(key, '?')) for key, _ in COLUMNS]
+            for profile, sizes in results.items()]
+    widths = [max(len(row[i]) for row in [header] + rows) for i in range(len(header))]
+    for row in [header] + rows:
+        print('  '.join(cell.ljust(width) for cell, width in zip(row, widths)))
+
+    if len(results) > 1:
+        reference = max(results, key=lambda profile: results[profile]['app_bin'])
+        print('\nsaved against %s:' % reference)
+        for profile, sizes in results.items():
+            if profile == reference:
+                continue
+            saved = ['app bin %d' % (results[reference]['app_bin'] - sizes['app_bin'])]
+            for key, title in COLUMNS:
+                if isinstance(sizes.get(key), int) and isinstance(results[reference].get(key), int):
+                    saved.append('%s %d' % (title, results[reference][key] - sizes[key]))
+            print('  %s: %s' % (profile, ', '.join(saved)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,387 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/*
+ * Decoder for the firmware binary telemetry stream.
+ *
+ *     telemetry_decode [-s] [-b baud] [-t table] <capture file | serial device>
+ *
+ * Prints one line per record, or with -s only a summary once the input ends (EOF or
+ * Ctrl-C on a serial device): counts per record type, records lost (sequence gaps),
+ * corrupted frames, latency statistics per span and the resource watermarks over the whole
+ * capture.
+ *
+ * Deferred log records are formatted with the string table generated next to the
+ * firmware ELF (build/<project>.dlog, see tools/dlog/dlog_strings.py).
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <string>
+#include <unordered_map>
+
+#include "dlog.h"
+#include "latency_trace.h"
+#include "telemetry.h"
+#include "watermark.h"
+
+/* Firmware targets are ILP32 */
+static const dlog_abi_t k_target_abi = { 1, 1 };
+
+typedef struct {
+    uint8_t level;
+    std::string fmt;
+} dlog_entry_t;
+
+static std::unordered_map<uint32_t, dlog_entry_t> s_formats;
+static std::unordered_map<uint32_t, std::string> s_strings;
+
+typedef struct {
+    uint32_t records[TELEMETRY_TYPE_MAX];
+    uint32_t lost;
+    uint32_t bad_frames;
+    uint32_t bad_crc;
+    uint32_t unknown_type;
+    bool have_seq;
+    uint16_t next_seq;
+    uint32_t latency_count[TRACE_SPAN_MAX];
+    uint64_t latency_sum[TRACE_SPAN_MAX];
+    uint32_t latency_min[TRACE_SPAN_MAX];
+    uint32_t latency_max[TRACE_SPAN_MAX];
+    telemetry_record_t last_heap;
+    telemetry_record_t last_queue;
+    uint32_t watermark_slots[WATERMARK_METRIC_MAX];
+    uint32_t watermark_min[WATERMARK_METRIC_MAX];
+    uint32_t watermark_max[WATERMARK_METRIC_MAX];
+} decode_summary_t;
+
+static volatile sig_atomic_t s_stop = 0;
+
+static void on_signal(int sig)
+{
+    s_stop = 1;
+}
+
+static const char *thread_role_name(uint8_t role)
+{
+    static const char *const k_names[] = { "disabled", "detached", "child", "router", "leader" };
+    return role < sizeof(k_names) / sizeof(k_names[0]) ? k_names[role] : "unknown";
+}
+
+static std::string unescape(const char *src)
+{
+    std::string out;
+    for (; *src; src++) {
+        if (*src != '\\' || !src[1]) {
+            out += *src;
+            continue;
+        }
+        src++;
+        out += *src == 'n' ? '\n' : *src == 't' ? '\t' : *src == 'r' ? '\r' : *src;
+    }
+    return out;
+}
+
+static int load_table(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return -1;
+    }
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\n")] = '\0';
+        char *kind = strtok(line, "\t");
+        char *addr = strtok(NULL, "\t");
+        if (!kind || !addr || kind[0] == '#') {
+            continue;
+        }
+        if (strcmp(kind, "fmt") == 0) {
+            char *level = strtok(NULL, "\t");
+            char *fmt = strtok(NULL, "");
+            if (level) {
+                s_formats[(uint32_t)strtoul(addr, NULL, 0)] = { (uint8_t)atoi(level), unescape(fmt ? fmt : "") };
+            }
+        } else if (strcmp(kind, "str") == 0) {
+            char *text = strtok(NULL, "");
+            s_strings[(uint32_t)strtoul(addr, NULL, 0)] = unescape(text ? text : "");
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static const char *resolve_string(uint64_t addr, void *ctx)
+{
+    auto it = s_strings.find((uint32_t)addr);
+    return it == s_strings.end() ? NULL : it->second.c_str();
+}
+
+static speed_t baud_to_speed(long baud)
+{
+    switch (baud) {
+    case 115200:
+        return B115200;
+    case 230400:
+        return B230400;
+    case 460800:
+        return B460800;
+    case 921600:
+        return B921600;
+    case 1000000:
+        return B1000000;
+    case 2000000:
+        return B2000000;
+    default:
+        return B0;
+    }
+}
+
+static int configure_tty(int fd, long baud)
+{
+    speed_t speed = baud_to_speed(baud);
+    struct termios tio;
+    if (speed == B0 || tcgetattr(fd, &tio) != 0) {
+        return -1;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    return tcsetattr(fd, TCSANOW, &tio);
+}
+
+static void print_record(const telemetry_record_t *record)
+{
+    printf("%10" PRIu32 " #%-5u %-11s ", record->timestamp_us, record->seq, telemetry_type_name(record->type));
+    switch (record->type) {
+    case TELEMETRY_CONTACT_EDGE:
+        printf("channel %u %s edge %" PRIu32 " (+%" PRIu32 " us)\n", record->contact.channel,
+               record->contact.closed ? "closed" : "open", record->contact.edge_us,
+               record->timestamp_us - record->contact.edge_us);
+        break;
+    case TELEMETRY_LATENCY:
+        printf("%s %" PRIu32 " us\n", latency_trace_span_name((trace_span_t)record->latency.span),
+               record->latency.value_us);
+        break;
+    case TELEMETRY_HEAP:
+        printf("free %" PRIu32 " min %" PRIu32 " largest %" PRIu32 "\n", record->heap.free_bytes,
+               record->heap.min_free_bytes, record->heap.largest_block);
+        break;
+    case TELEMETRY_QUEUE:
+        printf("depth %u high-water %u pushed %" PRIu32 " dropped %" PRIu32 "\n", record->queue.depth,
+               record->queue.high_water, record->queue.pushed, record->queue.dropped);
+        break;
+    case TELEMETRY_THREAD_ROLE:
+        printf("%s\n", thread_role_name(record->thread.role));
+        break;
+    case TELEMETRY_LOG: {
+        auto it = s_formats.find(record->log.format_id);
+        const char *tag = resolve_string(record->log.tag, NULL);
+        if (it == s_formats.end()) {
+            printf("format 0x%08" PRIx32 " (%u words), no string table entry\n", record->log.format_id,
+                   record->log.nwords);
+            break;
+        }
+        char text[512];
+        dlog_format(&k_target_abi, it->second.fmt.c_str(), record->log.words, record->log.nwords, resolve_string,
+                    NULL, text, sizeof(text));
+        printf("%s %s: %s\n", dlog_level_letter(it->second.level), tag ? tag : "?", text);
+        break;
+    }
+    case TELEMETRY_WATERMARK:
+        printf("%s min %" PRIu32 " max %" PRIu32 "\n",
+               watermark_metric_name((watermark_metric_t)record->watermark.metric), record->watermark.min,
+               record->watermark.max);
+        break;
+    default:
+        printf("\n");
+        break;
+    }
+}
+
+static void account_record(decode_summary_t *summary, const telemetry_record_t *record)
+{
+    if (summary->have_seq) {
+        summary->lost += (uint16_t)(record->seq - summary->next_seq);
+    }
+    summary->have_seq = true;
+    summary->next_seq = record->seq + 1;
+    summary->records[record->type]++;
+
+    if (record->type == TELEMETRY_LATENCY && record->latency.span < TRACE_SPAN_MAX) {
+        uint8_t span = record->latency.span;
+        uint32_t value = record->latency.value_us;
+        if (summary->latency_count[span] == 0 || value < summary->latency_min[span]) {
+            summary->latency_min[span] = value;
+        }
+        if (value > summary->latency_max[span]) {
+            summary->latency_max[span] = value;
+        }
+        summary->latency_count[span]++;
+        summary->latency_sum[span] += value;
+    } else if (record->type == TELEMETRY_HEAP) {
+        summary->last_heap = *record;
+    } else if (record->type == TELEMETRY_QUEUE) {
+        summary->last_queue = *record;
+    } else if (record->type == TELEMETRY_WATERMARK && record->watermark.metric < WATERMARK_METRIC_MAX) {
+        uint8_t metric = record->watermark.metric;
+        if (summary->watermark_slots[metric] == 0 || record->watermark.min < summary->watermark_min[metric]) {
+            summary->watermark_min[metric] = record->watermark.min;
+        }
+        if (record->watermark.max > summary->watermark_max[metric]) {
+            summary->watermark_max[metric] = record->watermark.max;
+        }
+        summary->watermark_slots[metric]++;
+    }
+}
+
+static void print_summary(const decode_summary_t *summary)
+{
+    printf("records:");
+    for (int type = 1; type < TELEMETRY_TYPE_MAX; type++) {
+        printf(" %s %" PRIu32, telemetry_type_name((telemetry_type_t)type), summary->records[type]);
+    }
+    printf("\nlost %" PRIu32 " bad-frames %" PRIu32 " bad-crc %" PRIu32 " unknown-type %" PRIu32 "\n",
+           summary->lost, summary->bad_frames, summary->bad_crc, summary->unknown_type);
+
+    for (int span = 0; span < TRACE_SPAN_MAX; span++) {
+        uint32_t count = summary->latency_count[span];
+        if (count == 0) {
+            continue;
+        }
+        printf("%-16s count %" PRIu32 " min %" PRIu32 " avg %" PRIu64 " max %" PRIu32 " us\n",
+               latency_trace_span_name((trace_span_t)span), count, summary->latency_min[span],
+               summary->latency_sum[span] / count, summary->latency_max[span]);
+    }
+    if (summary->records[TELEMETRY_HEAP]) {
+        printf("last ");
+        print_record(&summary->last_heap);
+    }
+    if (summary->records[TELEMETRY_QUEUE]) {
+        printf("last ");
+        print_record(&summary->last_queue);
+    }
+    for (int metric = 0; metric < WATERMARK_METRIC_MAX; metric++) {
+        if (summary->watermark_slots[metric] == 0) {
+            continue;
+        }
+        printf("%-26s slots %" PRIu32 " min %" PRIu32 " max %" PRIu32 "\n",
+               watermark_metric_name((watermark_metric_t)metric), summary->watermark_slots[metric],
+               summary->watermark_min[metric], summary->watermark_max[metric]);
+    }
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "Usage: %s [-s] [-b baud] [-t table] <capture file | serial device>\n", argv0);
+    fprintf(stderr, "  -s        print a summary instead of every record\n");
+    fprintf(stderr, "  -b baud   serial device baud rate (default 921600)\n");
+    fprintf(stderr, "  -t table  deferred log string table (build/<project>.dlog)\n");
+}
+
+int main(int argc, char **argv)
+{
+    bool summary_only = false;
+    long baud = 921600;
+    int opt;
+    while ((opt = getopt(argc, argv, "sb:t:h")) != -1) {
+        switch (opt) {
+        case 's':
+            summary_only = true;
+            break;
+        case 'b':
+            baud = strtol(optarg, NULL, 10);
+            break;
+        case 't':
+            if (load_table(optarg) != 0) {
+                fprintf(stderr, "%s: %s\n", optarg, strerror(errno));
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+        return 1;
+    }
+    if (isatty(fd) && configure_tty(fd, baud) != 0) {
+        fprintf(stderr, "%s: cannot set %ld baud\n", argv[optind], baud);
+        close(fd);
+        return 1;
+    }
+    signal(SIGINT, on_signal);
+
+    static decode_summary_t summary;
+    telemetry_deframer_t deframer;
+    telemetry_deframer_init(&deframer);
+    uint8_t chunk[4096];
+    while (!s_stop) {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            const uint8_t *frame;
+            size_t len;
+            if (!telemetry_deframer_push(&deframer, chunk[i], &frame, &len)) {
+                continue;
+            }
+            telemetry_record_t record;
+            switch (telemetry_decode(frame, len, &record)) {
+            case TELEMETRY_OK:
+                account_record(&summary, &record);
+                if (!summary_only) {
+                    print_record(&record);
+                }
+                break;
+            case TELEMETRY_ERR_CRC:
+                summary.bad_crc++;
+                break;
+            case TELEMETRY_ERR_TYPE:
+                summary.unknown_type++;
+                break;
+            default:
+                summary.bad_frames++;
+                break;
+            }
+        }
+    }
+    close(fd);
+
+    summary.bad_frames += deframer.oversized;
+    if (summary_only) {
+        print_summary(&summary);
+    } else {
+        fflush(stdout);
+        fprintf(stderr, "lost %" PRIu32 " bad-frames %" PRIu32 " bad-crc %" PRIu32 "\n", summary.lost,
+                summary.bad_frames, summary.bad_crc);
+    }
+    return 0;
+}